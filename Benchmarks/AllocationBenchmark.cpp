@@ -0,0 +1,113 @@
+//
+// The canonical loops of testXLAllocations.cpp as benchmarks, reporting the allocations made per item next to the time.
+// This executable replaces the global operator new and delete (see Tests/XLAllocationCounter.cpp), which is why it is separate
+// from OpenXLSXBenchmark.
+//
+
+#ifdef _MSC_VER    // conditionally enable MSVC specific pragmas to avoid other compilers warning about unknown pragmas
+#   pragma warning(push)
+#   pragma warning(disable : 4244)
+#endif // _MSC_VER
+
+#include "XLAllocationCounter.hpp"
+
+#include <OpenXLSX.hpp>
+#include <benchmark/benchmark.h>
+#include <cstdint>
+#include <vector>
+
+using namespace OpenXLSX;
+
+namespace
+{
+    constexpr uint32_t rows = 100000;
+    constexpr uint16_t cols = 10;
+
+    /**
+     * @brief Report the allocations and allocated bytes per processed item
+     */
+    void reportAllocations(benchmark::State& state, XLAllocationScope const& scope)
+    {
+        const auto items                  = static_cast<double>(state.items_processed());
+        state.counters["allocs_per_item"] = static_cast<double>(scope.count()) / items;
+        state.counters["bytes_per_item"]  = static_cast<double>(scope.bytes()) / items;
+    }
+}    // namespace
+
+/**
+ * @brief Assign 1M numeric values through a range iterator
+ * @param state
+ */
+static void BM_AllocSetValues(benchmark::State& state)    // NOLINT
+{
+    XLDocument doc;
+    doc.create("./benchmark_allocations.xlsx", XLForceOverwrite);
+    auto range = doc.workbook().worksheet("Sheet1").range(XLCellReference(1, 1), XLCellReference(rows, cols));
+
+    XLAllocationScope scope;
+    for (auto _ : state)    // NOLINT
+        for (auto& cell : range) cell.value() = 1.5;
+
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * rows * cols);
+    reportAllocations(state, scope);
+    doc.close();
+}
+
+BENCHMARK(BM_AllocSetValues)->Unit(benchmark::kMillisecond);    // NOLINT
+
+/**
+ * @brief Read the type of every cell of a 1M cell range
+ * @param state
+ */
+static void BM_AllocIterateRange(benchmark::State& state)    // NOLINT
+{
+    XLDocument doc;
+    doc.create("./benchmark_allocations.xlsx", XLForceOverwrite);
+    auto range = doc.workbook().worksheet("Sheet1").range(XLCellReference(1, 1), XLCellReference(rows, cols));
+    for (auto& cell : range) cell.value() = 1.5;
+
+    uint64_t          result = 0;
+    XLAllocationScope scope;
+    for (auto _ : state) {    // NOLINT
+        for (auto& cell : range) result += cell.value().type() == XLValueType::Float;
+        benchmark::DoNotOptimize(result);
+    }
+
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * rows * cols);
+    reportAllocations(state, scope);
+    doc.close();
+}
+
+BENCHMARK(BM_AllocIterateRange)->Unit(benchmark::kMillisecond);    // NOLINT
+
+/**
+ * @brief Read every row into a std::vector<XLCellValue>
+ * @param state
+ */
+static void BM_AllocReadRows(benchmark::State& state)    // NOLINT
+{
+    XLDocument doc;
+    doc.create("./benchmark_allocations.xlsx", XLForceOverwrite);
+    auto wks = doc.workbook().worksheet("Sheet1");
+    for (auto& cell : wks.range(XLCellReference(1, 1), XLCellReference(rows, cols))) cell.value() = 1.5;
+
+    size_t            result = 0;
+    XLAllocationScope scope;
+    for (auto _ : state) {    // NOLINT
+        for (auto& row : wks.rows(rows)) {
+            std::vector<XLCellValue> values = row.values();
+            result += values.size();
+        }
+        benchmark::DoNotOptimize(result);
+    }
+
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * rows);
+    reportAllocations(state, scope);
+    doc.close();
+}
+
+BENCHMARK(BM_AllocReadRows)->Unit(benchmark::kMillisecond);    // NOLINT
+
+#ifdef _MSC_VER    // conditionally enable MSVC specific pragmas to avoid other compilers warning about unknown pragmas
+#   pragma warning(pop)
+#endif // _MSC_VER
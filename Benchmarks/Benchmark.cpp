@@ -5,18 +5,61 @@
 #pragma warning(push)
 #pragma warning(disable : 4244)
 
+#include "BenchmarkUtilities.hpp"
+
 #include <OpenXLSX.hpp>
+#include <atomic>
 #include <benchmark/benchmark.h>
+#include <cstddef>
 #include <cstdint>
+#include <cstdlib>
 #include <numeric>
 #include <deque>
 #include <list>
+#include <string>
+#include <vector>
 
 using namespace OpenXLSX;
 
 constexpr uint64_t rowCount = 1048576;
 constexpr uint8_t  colCount = 8;
 
+namespace
+{
+    /**
+     * @brief Tracks the bytes currently allocated by pugixml (i.e. the memory held by parsed XML parts)
+     * @details The allocation functions are installed during static initialization, before any XML document exists. Each block
+     *  carries its size in a header, as the pugixml deallocation function is not passed the size. The functions chain to the
+     *  ones installed before, so that OpenXLSX's XLXmlArena stays in effect.
+     */
+    size_t                      xmlBytes           = 0;
+    pugi::allocation_function   upstreamAllocate   = nullptr;
+    pugi::deallocation_function upstreamDeallocate = nullptr;
+
+    void* countingAllocate(size_t size)
+    {
+        constexpr size_t header = alignof(std::max_align_t);
+        auto*            block  = static_cast<char*>(upstreamAllocate(size + header));
+        if (block == nullptr) return nullptr;
+        *reinterpret_cast<size_t*>(block) = size;
+        xmlBytes += size;
+        return block + header;
+    }
+
+    void countingDeallocate(void* ptr)
+    {
+        constexpr size_t header = alignof(std::max_align_t);
+        auto*            block  = static_cast<char*>(ptr) - header;
+        xmlBytes -= *reinterpret_cast<size_t*>(block);
+        upstreamDeallocate(block);
+    }
+
+    const bool countingInstalled = (upstreamAllocate   = pugi::get_memory_allocation_function(),
+                                    upstreamDeallocate = pugi::get_memory_deallocation_function(),
+                                    pugi::set_memory_management_functions(countingAllocate, countingDeallocate),
+                                    true);
+}    // namespace
+
 /**
  * @brief
  * @param state
@@ -213,6 +256,89 @@ static void BM_ReadFloats(benchmark::State& state)    // NOLINT
 
 BENCHMARK(BM_ReadFloats)->Unit(benchmark::kMillisecond);    // NOLINT
 
+/**
+ * @brief Same workload as BM_ReadFloats, using XLCellRange::aggregate instead of the row iterator
+ * @param state
+ */
+static void BM_ReadFloatsAggregate(benchmark::State& state)    // NOLINT
+{
+    XLDocument doc;
+    doc.open("./benchmark_floats.xlsx");
+    auto        wks    = doc.workbook().worksheet("Sheet1");
+    long double result = 0;
+
+    for (auto _ : state) {    // NOLINT
+        result += wks.range().aggregate().sum;
+
+        benchmark::DoNotOptimize(result);
+        benchmark::ClobberMemory();
+    }
+
+    state.SetItemsProcessed(rowCount * colCount);
+    state.counters["items"] = state.items_processed();
+
+    doc.close();
+}
+
+BENCHMARK(BM_ReadFloatsAggregate)->Unit(benchmark::kMillisecond);    // NOLINT
+
+/**
+ * @brief Same workload as BM_ReadFloats, summed with XLWorksheet::parallelForRows on state.range(0) threads
+ * @param state
+ */
+static void BM_ReadFloatsParallel(benchmark::State& state)    // NOLINT
+{
+    XLDocument doc;
+    doc.open("./benchmark_floats.xlsx");
+    auto                wks    = doc.workbook().worksheet("Sheet1");
+    std::atomic<double> result = 0;
+
+    for (auto _ : state) {    // NOLINT
+        wks.parallelForRows(1, rowCount, [&](XLRowView& row) {
+            double sum = 0;
+            for (const auto& cell : row) sum += cell.number();
+            double expected = result.load(std::memory_order_relaxed);
+            while (not result.compare_exchange_weak(expected, expected + sum, std::memory_order_relaxed)) {}
+        }, static_cast<unsigned>(state.range(0)));
+
+        benchmark::DoNotOptimize(result);
+        benchmark::ClobberMemory();
+    }
+
+    state.SetItemsProcessed(rowCount * colCount);
+    state.counters["items"] = state.items_processed();
+
+    doc.close();
+}
+
+BENCHMARK(BM_ReadFloatsParallel)->Arg(1)->Arg(2)->Arg(4)->Arg(8)->Unit(benchmark::kMillisecond)->UseRealTime();    // NOLINT
+
+/**
+ * @brief Doubles every value of the float sheet in place with XLParallelMode::UpdateValues, on state.range(0) threads
+ * @param state
+ */
+static void BM_UpdateFloatsParallel(benchmark::State& state)    // NOLINT
+{
+    XLDocument doc;
+    doc.open("./benchmark_floats.xlsx");
+    auto wks = doc.workbook().worksheet("Sheet1");
+
+    for (auto _ : state) {    // NOLINT
+        wks.parallelForRows(1, rowCount, [&](XLRowView& row) {
+            for (const auto& cell : row) XLCellView(cell).setValue(cell.number() * 2);
+        }, static_cast<unsigned>(state.range(0)), XLParallelMode::UpdateValues);
+
+        benchmark::ClobberMemory();
+    }
+
+    state.SetItemsProcessed(rowCount * colCount);
+    state.counters["items"] = state.items_processed();
+
+    doc.close();
+}
+
+BENCHMARK(BM_UpdateFloatsParallel)->Arg(1)->Arg(2)->Arg(4)->Arg(8)->Unit(benchmark::kMillisecond)->UseRealTime();    // NOLINT
+
 /**
  * @brief
  * @param state
@@ -246,4 +372,168 @@ static void BM_ReadBools(benchmark::State& state)    // NOLINT
 
 BENCHMARK(BM_ReadBools)->Unit(benchmark::kMillisecond);    // NOLINT
 
+/**
+ * @brief Open a workbook and parse its worksheet, in the given mode
+ * @param state
+ * @param mode
+ * @note The xml_bytes counter reports the memory held by the parsed XML parts while the document is open
+ */
+static void openAndParse(benchmark::State& state, XLOpenMode mode)
+{
+    double result = 0;
+    size_t bytes  = 0;
+
+    for (auto _ : state) {    // NOLINT
+        XLDocument doc;
+        doc.open("./benchmark_floats.xlsx", mode);
+        result += doc.workbook().worksheet("Sheet1").cell("A1").value().get<double>();
+        bytes = xmlBytes;
+        doc.close();
+
+        benchmark::DoNotOptimize(result);
+        benchmark::ClobberMemory();
+    }
+
+    state.counters["xml_bytes"] = static_cast<double>(bytes);
+}
+
+static void BM_OpenReadWrite(benchmark::State& state) { openAndParse(state, XLOpenMode::ReadWrite); }    // NOLINT
+static void BM_OpenReadOnly(benchmark::State& state) { openAndParse(state, XLOpenMode::ReadOnly); }      // NOLINT
+
+BENCHMARK(BM_OpenReadWrite)->Unit(benchmark::kMillisecond);    // NOLINT
+BENCHMARK(BM_OpenReadOnly)->Unit(benchmark::kMillisecond);     // NOLINT
+
+/**
+ * @brief Create (once) a workbook whose worksheet is indented like the output of other producers
+ * @return the path of the workbook
+ */
+static std::string const& indentedWorkbook()
+{
+    static const std::string path = [] {
+        const std::string plain = "./benchmark_indented_plain.xlsx";
+        {
+            XLDocument doc;
+            doc.create(plain, XLForceOverwrite);
+            auto                     wks = doc.workbook().worksheet("Sheet1");
+            std::vector<XLCellValue> values(colCount, 3.14);
+            for (auto& row : wks.rows(rowCount / 16)) row.values() = values;
+            doc.save();
+            doc.close();
+        }
+
+        XLZipArchive archive;
+        archive.open(plain);
+        const std::string sheet = archive.getEntry("xl/worksheets/sheet1.xml");
+        std::string       indented;
+        indented.reserve(sheet.size() * 2);
+        for (size_t pos = 0; pos < sheet.size(); ++pos) {
+            if (sheet.compare(pos, 4, "<row") == 0 || sheet.compare(pos, 5, "</row") == 0) indented += "\n    ";
+            else if (sheet.compare(pos, 3, "<c ") == 0) indented += "\n        ";
+            indented += sheet[pos];
+        }
+        archive.addEntry("xl/worksheets/sheet1.xml", indented);
+        archive.save("./benchmark_indented.xlsx");
+        archive.close();
+        return std::string("./benchmark_indented.xlsx");
+    }();
+    return path;
+}
+
+/**
+ * @brief Visit every cell of an indented worksheet, parsed with or without the whitespace between elements
+ * @param state
+ * @param lean
+ */
+static void traverseIndented(benchmark::State& state, bool lean)
+{
+    XLDocument doc;
+    doc.setLeanXmlParsing(lean);
+    doc.open(indentedWorkbook());
+    auto     wks    = doc.workbook().worksheet("Sheet1");
+    uint64_t result = 0;
+
+    for (auto _ : state) {    // NOLINT
+        for (auto& row : wks.rows())
+            for (auto& cell : row.cells()) result += cell.value().type() == XLValueType::Float;
+
+        benchmark::DoNotOptimize(result);
+        benchmark::ClobberMemory();
+    }
+
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * (rowCount / 16) * colCount);
+    state.counters["items"]     = state.items_processed();
+    state.counters["xml_bytes"] = static_cast<double>(xmlBytes);
+
+    doc.close();
+}
+
+static void BM_TraverseIndented(benchmark::State& state) { traverseIndented(state, false); }        // NOLINT
+static void BM_TraverseIndentedLean(benchmark::State& state) { traverseIndented(state, true); }     // NOLINT
+
+BENCHMARK(BM_TraverseIndented)->Unit(benchmark::kMillisecond);        // NOLINT
+BENCHMARK(BM_TraverseIndentedLean)->Unit(benchmark::kMillisecond);    // NOLINT
+
+/**
+ * @brief Create (once) a set of small workbooks of different sizes, like the input of a batch converter
+ * @return the paths of the workbooks
+ */
+static std::vector<std::string> const& smallWorkbooks()
+{
+    static const std::vector<std::string> paths = [] {
+        std::vector<std::string> result;
+        for (int file = 0; file < 16; ++file) {
+            result.push_back("./benchmark_small_" + std::to_string(file) + ".xlsx");
+            XLDocument doc;
+            doc.create(result.back(), XLForceOverwrite);
+            auto wks = doc.workbook().worksheet("Sheet1");
+            for (int row = 1; row <= 20 + file * 40; ++row) {
+                wks.cell(row, 1).value() = row * 1.5;
+                wks.cell(row, 2).value() = "Item " + std::to_string(file * 1000 + row);
+            }
+            doc.save();
+            doc.close();
+        }
+        return result;
+    }();
+    return paths;
+}
+
+/**
+ * @brief Open, read and close many small workbooks with one XLDocument, with or without the XML arena
+ * @param state
+ * @param arena
+ * @note Run each variant in its own process to compare the peak_rss_mib counter
+ */
+static void manySmallFiles(benchmark::State& state, bool arena)
+{
+    auto const& files  = smallWorkbooks();
+    double      result = 0;
+
+    XLDocument doc;
+    doc.setXmlArena(arena);
+    for (auto _ : state) {    // NOLINT
+        for (auto const& file : files) {
+            doc.open(file);
+            auto wks = doc.workbook().worksheet("Sheet1");
+            result += wks.range().aggregate().sum;
+            result += static_cast<double>(wks.cell("B1").value().get<std::string>().size());
+            doc.close();
+        }
+
+        benchmark::DoNotOptimize(result);
+        benchmark::ClobberMemory();
+    }
+
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * files.size()));
+    state.counters["files_per_s"]   = benchmark::Counter(static_cast<double>(state.items_processed()), benchmark::Counter::kIsRate);
+    state.counters["peak_rss_mib"]  = peakRssMiB();
+    state.counters["retained_kib"]  = static_cast<double>(doc.xmlArenaRetainedSize()) / 1024.0;
+}
+
+static void BM_ManySmallFiles(benchmark::State& state) { manySmallFiles(state, false); }         // NOLINT
+static void BM_ManySmallFilesArena(benchmark::State& state) { manySmallFiles(state, true); }     // NOLINT
+
+BENCHMARK(BM_ManySmallFiles)->Unit(benchmark::kMillisecond);         // NOLINT
+BENCHMARK(BM_ManySmallFilesArena)->Unit(benchmark::kMillisecond);    // NOLINT
+
 #pragma warning(pop)
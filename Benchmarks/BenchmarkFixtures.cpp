@@ -0,0 +1,343 @@
+//
+// Deterministic workbooks for the large-workbook benchmarks
+//
+
+#include "BenchmarkFixtures.hpp"
+
+#include <OpenXLSX.hpp>
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+using namespace OpenXLSX;
+using namespace OpenXLSX::Benchmark;
+
+namespace
+{
+    constexpr int fixtureVersion = 1;    // bump whenever the generator output changes
+
+    /**
+     * @brief Scale a row count, keeping at least one row
+     */
+    uint32_t scaled(uint32_t rows) { return std::max<uint32_t>(1, static_cast<uint32_t>(rows * fixtureScale())); }
+
+    bool fileExists(std::string const& path) { return std::ifstream(path).good(); }
+
+    /**
+     * @brief Build the cell reference of a row and column, e.g. "AB12"
+     */
+    void appendReference(std::string& xml, uint32_t row, uint16_t column)
+    {
+        xml += XLCellReference::columnAsString(column);
+        xml += std::to_string(row);
+    }
+
+    /**
+     * @brief Append a numeric cell
+     */
+    void appendNumber(std::string& xml, uint32_t row, uint16_t column, std::string const& value)
+    {
+        xml += "<c r=\"";
+        appendReference(xml, row, column);
+        xml += "\"><v>";
+        xml += value;
+        xml += "</v></c>";
+    }
+
+    /**
+     * @brief Append a cell of the given type (t attribute) and raw value
+     */
+    void appendTyped(std::string& xml, uint32_t row, uint16_t column, char const* type, std::string const& value)
+    {
+        xml += "<c r=\"";
+        appendReference(xml, row, column);
+        xml += "\" t=\"";
+        xml += type;
+        xml += "\"><v>";
+        xml += value;
+        xml += "</v></c>";
+    }
+
+    /**
+     * @brief Format a double with enough digits to round trip, without depending on the locale of iostreams
+     */
+    std::string number(double value)
+    {
+        std::array<char, 32> buffer {};
+        std::snprintf(buffer.data(), buffer.size(), "%.17g", value);
+        return buffer.data();
+    }
+
+    /**
+     * @brief Replace the sheetData element of a worksheet part with the given content
+     */
+    std::string replaceSheetData(std::string const& sheetXml, std::string const& rows)
+    {
+        const size_t begin = sheetXml.find("<sheetData");
+        if (begin == std::string::npos) throw std::runtime_error("fixture generator: worksheet without sheetData");
+        const size_t close = sheetXml.find('>', begin);
+        size_t       end   = close + 1;
+        if (sheetXml[close - 1] != '/') {
+            end = sheetXml.find("</sheetData>", close);
+            if (end == std::string::npos) throw std::runtime_error("fixture generator: unterminated sheetData");
+            end += std::string("</sheetData>").size();
+        }
+        return sheetXml.substr(0, begin) + "<sheetData>" + rows + "</sheetData>" + sheetXml.substr(end);
+    }
+
+    /**
+     * @brief Build a shared strings part from a list of (XML safe) strings
+     */
+    std::string sharedStringsXml(std::vector<std::string> const& strings, uint64_t references)
+    {
+        std::string xml = R"(<?xml version="1.0" encoding="UTF-8" standalone="yes"?>)"
+                          R"(<sst xmlns="http://schemas.openxmlformats.org/spreadsheetml/2006/main" count=")" +
+                          std::to_string(references) + "\" uniqueCount=\"" + std::to_string(strings.size()) + "\">";
+        for (auto const& str : strings) xml += "<si><t>" + str + "</t></si>";
+        xml += "</sst>";
+        return xml;
+    }
+
+    /**
+     * @brief Generate the rows of a Tall fixture sheet: an id, numbers, a boolean and two low cardinality strings
+     */
+    std::string tallRows(XLFixtureShape const& shape, XLBenchmarkRandom& random, uint32_t poolSize)
+    {
+        std::string xml;
+        xml.reserve(static_cast<size_t>(shape.rows) * 256);
+        for (uint32_t row = 1; row <= shape.rows; ++row) {
+            xml += "<row r=\"" + std::to_string(row) + "\">";
+            appendNumber(xml, row, 1, std::to_string(row));
+            appendNumber(xml, row, 2, number(random.real() * 1000.0));
+            appendNumber(xml, row, 3, number(random.real()));
+            appendTyped(xml, row, 4, "b", random.below(2) != 0 ? "1" : "0");
+            appendTyped(xml, row, 5, "s", std::to_string(random.below(poolSize)));
+            appendNumber(xml, row, 6, std::to_string(random.below(100000)));
+            appendNumber(xml, row, 7, number(random.real() * -50.0));
+            appendTyped(xml, row, 8, "s", std::to_string(random.below(poolSize)));
+            xml += "</row>";
+        }
+        return xml;
+    }
+
+    /**
+     * @brief Generate the rows of a sheet of numbers only
+     */
+    std::string numberRows(XLFixtureShape const& shape, XLBenchmarkRandom& random)
+    {
+        std::string xml;
+        xml.reserve(static_cast<size_t>(shape.rows) * shape.columns * 40);
+        for (uint32_t row = 1; row <= shape.rows; ++row) {
+            xml += "<row r=\"" + std::to_string(row) + "\">";
+            for (uint16_t column = 1; column <= shape.columns; ++column) appendNumber(xml, row, column, number(random.real() * 1e6));
+            xml += "</row>";
+        }
+        return xml;
+    }
+
+    /**
+     * @brief Generate the rows of a SharedStrings fixture sheet: an id followed by string cells that all have their own entry
+     */
+    std::string uniqueStringRows(XLFixtureShape const& shape, std::vector<std::string>& strings, XLBenchmarkRandom& random)
+    {
+        std::string xml;
+        xml.reserve(static_cast<size_t>(shape.rows) * shape.columns * 48);
+        std::array<char, 40> buffer {};
+        for (uint32_t row = 1; row <= shape.rows; ++row) {
+            xml += "<row r=\"" + std::to_string(row) + "\">";
+            appendNumber(xml, row, 1, std::to_string(row));
+            for (uint16_t column = 2; column <= shape.columns; ++column) {
+                std::snprintf(buffer.data(), buffer.size(), "Customer %08u-%u %016llx", row, column,
+                              static_cast<unsigned long long>(random.next()));
+                appendTyped(xml, row, column, "s", std::to_string(strings.size()));
+                strings.emplace_back(buffer.data());
+            }
+            xml += "</row>";
+        }
+        return xml;
+    }
+
+    /**
+     * @brief Create a workbook with the given number of (empty) worksheets
+     */
+    void createWorkbook(std::string const& path, uint32_t sheets)
+    {
+        XLDocument doc;
+        doc.create(path, XLForceOverwrite);
+        for (uint32_t sheet = 2; sheet <= sheets; ++sheet) doc.workbook().addWorksheet("Sheet" + std::to_string(sheet));
+        doc.save();
+        doc.close();
+    }
+
+    /**
+     * @brief Generate a fixture whose sheets are written as raw XML
+     * @details Going through the cell API would make the generation of the large fixtures as slow as the code being measured.
+     *  The package is created through XLDocument, so that all relationships and content types are in place, and the
+     *  worksheet and shared strings parts are then replaced in the archive.
+     */
+    void generateRaw(XLFixture fixture, std::string const& path)
+    {
+        XLFixtureShape const shape = fixtureShape(fixture);
+        createWorkbook(path, shape.sheets);
+
+        XLBenchmarkRandom        random(0x5EED0000u + static_cast<uint64_t>(fixture));
+        std::vector<std::string> strings;
+        uint64_t                 references = 0;
+
+        XLZipArchive archive;
+        archive.open(path);
+        for (uint32_t sheet = 1; sheet <= shape.sheets; ++sheet) {
+            const std::string part = "xl/worksheets/sheet" + std::to_string(sheet) + ".xml";
+            if (not archive.hasEntry(part)) throw std::runtime_error("fixture generator: missing " + part);
+
+            std::string rows;
+            switch (fixture) {
+                case XLFixture::Tall:
+                    rows = tallRows(shape, random, 64);
+                    references += 2ull * shape.rows;
+                    break;
+                case XLFixture::SharedStrings:
+                    rows = uniqueStringRows(shape, strings, random);
+                    references += static_cast<uint64_t>(shape.rows) * (shape.columns - 1u);
+                    break;
+                default:
+                    rows = numberRows(shape, random);
+                    break;
+            }
+            archive.addEntry(part, replaceSheetData(archive.getEntry(part), rows));
+        }
+
+        if (fixture == XLFixture::Tall)
+            for (int index = 0; index < 64; ++index) strings.push_back("Category " + std::to_string(index));
+        if (not strings.empty()) {
+            if (not archive.hasEntry("xl/sharedStrings.xml")) throw std::runtime_error("fixture generator: missing shared strings part");
+            archive.addEntry("xl/sharedStrings.xml", sharedStringsXml(strings, references));
+        }
+
+        archive.save(path);
+        archive.close();
+    }
+
+    /**
+     * @brief Generate the Styles fixture through the style API: cells with hundreds of distinct formats, and many merged ranges
+     */
+    void generateStyles(std::string const& path)
+    {
+        XLFixtureShape const shape = fixtureShape(XLFixture::Styles);
+        XLBenchmarkRandom    random(0x5EED0000u + static_cast<uint64_t>(XLFixture::Styles));
+
+        XLDocument doc;
+        doc.create(path, XLForceOverwrite);
+        XLStyles&   styles = doc.styles();
+        XLWorksheet wks    = doc.workbook().worksheet("Sheet1");
+
+        std::vector<XLStyleIndex> formats;
+        for (uint32_t font = 0; font < 16; ++font) {
+            XLStyleIndex fontIndex = styles.fonts().findOrCreate(styles.fonts()[0], [&](XLFont& entry) {
+                entry.setFontSize(8 + font / 2);
+                entry.setBold(font % 2 == 1);
+            });
+            for (uint32_t fill = 0; fill < 32; ++fill) {
+                XLStyleIndex fillIndex = styles.fills().findOrCreate(styles.fills()[0], [&](XLFill& entry) {
+                    entry.setPatternType(XLPatternSolid);
+                    entry.setColor(XLColor(static_cast<uint8_t>(fill * 8), static_cast<uint8_t>(255 - fill * 8), 128));
+                });
+                formats.push_back(styles.cellFormats().findOrCreate(styles.cellFormats()[0], [&](XLCellFormat& entry) {
+                    entry.setFontIndex(fontIndex);
+                    entry.setApplyFont(true);
+                    entry.setFillIndex(fillIndex);
+                    entry.setApplyFill(true);
+                }));
+            }
+        }
+
+        for (uint32_t row = 1; row <= shape.rows; ++row) {
+            for (uint16_t column = 1; column <= shape.columns; ++column) {
+                XLCell cell    = wks.cell(row, column);
+                cell.value()   = random.real() * 100.0;
+                cell.setCellFormat(formats[random.below(formats.size())]);
+            }
+            if (row % 2 == 0) wks.merges().appendMerge("K" + std::to_string(row - 1) + ":L" + std::to_string(row));
+        }
+
+        doc.save();
+        doc.close();
+    }
+}    // namespace
+
+namespace OpenXLSX::Benchmark
+{
+    double fixtureScale()
+    {
+        static const double scale = [] {
+            char const* value = std::getenv("OPENXLSX_BENCHMARK_SCALE");
+            if (value == nullptr) return 1.0;
+            const double result = std::strtod(value, nullptr);
+            return result > 0 ? result : 1.0;
+        }();
+        return scale;
+    }
+
+    std::string fixtureName(XLFixture fixture)
+    {
+        switch (fixture) {
+            case XLFixture::Tall:
+                return "tall";
+            case XLFixture::Wide:
+                return "wide";
+            case XLFixture::SharedStrings:
+                return "sst";
+            case XLFixture::Styles:
+                return "styles";
+            case XLFixture::ManyParts:
+                return "parts";
+        }
+        return "unknown";
+    }
+
+    XLFixtureShape fixtureShape(XLFixture fixture)
+    {
+        switch (fixture) {
+            case XLFixture::Tall:
+                return { 1, scaled(100000), 8 };
+            case XLFixture::Wide:
+                return { 1, scaled(1000), 256 };
+            case XLFixture::SharedStrings:
+                return { 1, scaled(50000), 3 };
+            case XLFixture::Styles:
+                return { 1, scaled(2000), 10 };
+            case XLFixture::ManyParts:
+                return { 64, scaled(500), 4 };
+        }
+        return { 0, 0, 0 };
+    }
+
+    std::string const& fixturePath(XLFixture fixture)
+    {
+        static std::mutex                         mutex;
+        static std::map<XLFixture, std::string> paths;
+
+        std::lock_guard<std::mutex> lock(mutex);
+        auto                        iter = paths.find(fixture);
+        if (iter != paths.end()) return iter->second;
+
+        const std::string stem = "./benchmark_fixture_v" + std::to_string(fixtureVersion) + "_" + fixtureName(fixture) + "_s" +
+                                 std::to_string(static_cast<int>(fixtureScale() * 1000));    // the scale in thousandths
+        const std::string path = stem + ".xlsx";
+        if (not fileExists(path)) {
+            const std::string partial = stem + "_partial.xlsx";    // never leave a truncated fixture behind under the final name
+            if (fixture == XLFixture::Styles)
+                generateStyles(partial);
+            else
+                generateRaw(fixture, partial);
+            std::rename(partial.c_str(), path.c_str());
+        }
+        return paths.emplace(fixture, path).first->second;
+    }
+}    // namespace OpenXLSX::Benchmark
@@ -0,0 +1,91 @@
+//
+// Deterministic workbooks for the large-workbook benchmarks
+//
+
+#ifndef OPENXLSX_BENCHMARKFIXTURES_HPP
+#define OPENXLSX_BENCHMARKFIXTURES_HPP
+
+#include <cstdint>
+#include <string>
+
+namespace OpenXLSX::Benchmark
+{
+    /**
+     * @brief The kinds of generated workbooks
+     */
+    enum class XLFixture : uint8_t {
+        Tall,             // one sheet, many rows of 8 columns of numbers, booleans and (low cardinality) shared strings
+        Wide,             // one sheet, 256 columns of numbers
+        SharedStrings,    // one sheet, every string cell refers to its own shared string
+        Styles,           // one sheet, hundreds of distinct cell formats and many merged ranges
+        ManyParts         // 64 small sheets
+    };
+
+    /**
+     * @brief The dimensions of a generated workbook
+     */
+    struct XLFixtureShape
+    {
+        uint32_t sheets;
+        uint32_t rows;     // per sheet
+        uint16_t columns;
+    };
+
+    /**
+     * @brief A small, fast and portable pseudo random number generator (SplitMix64)
+     * @details Unlike the std::uniform_*_distribution classes, its output does not depend on the standard library
+     *  implementation, so the fixtures and the access patterns are the same on every platform.
+     */
+    class XLBenchmarkRandom
+    {
+    public:
+        explicit XLBenchmarkRandom(uint64_t seed) : m_state(seed) {}
+
+        uint64_t next()
+        {
+            uint64_t z = (m_state += 0x9E3779B97F4A7C15ull);
+            z          = (z ^ (z >> 30u)) * 0xBF58476D1CE4E5B9ull;
+            z          = (z ^ (z >> 27u)) * 0x94D049BB133111EBull;
+            return z ^ (z >> 31u);
+        }
+
+        /**
+         * @brief Get a number in [0, bound)
+         */
+        uint64_t below(uint64_t bound) { return next() % bound; }
+
+        /**
+         * @brief Get a number in [0, 1)
+         */
+        double real() { return static_cast<double>(next() >> 11u) * (1.0 / 9007199254740992.0); }
+
+    private:
+        uint64_t m_state;
+    };
+
+    /**
+     * @brief Get the scale factor of the fixtures, from the OPENXLSX_BENCHMARK_SCALE environment variable
+     * @return the factor the row counts are multiplied by; 1 when the variable is not set or not a positive number
+     */
+    double fixtureScale();
+
+    /**
+     * @brief Get the name of a fixture, as used in benchmark and file names
+     */
+    std::string fixtureName(XLFixture fixture);
+
+    /**
+     * @brief Get the dimensions of a fixture at the current scale
+     */
+    XLFixtureShape fixtureShape(XLFixture fixture);
+
+    /**
+     * @brief Get the path of a fixture, generating it if it does not exist yet
+     * @details The files are written to the working directory and reused across runs. Their names contain a format version
+     *  and the scale, so a change to the generator or to OPENXLSX_BENCHMARK_SCALE never picks up a stale file.
+     * @return the path of the workbook
+     */
+    std::string const& fixturePath(XLFixture fixture);
+}    // namespace OpenXLSX::Benchmark
+
+#endif    // OPENXLSX_BENCHMARKFIXTURES_HPP
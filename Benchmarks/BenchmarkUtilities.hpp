@@ -0,0 +1,32 @@
+//
+// Helpers shared by the benchmark translation units
+//
+
+#ifndef OPENXLSX_BENCHMARKUTILITIES_HPP
+#define OPENXLSX_BENCHMARKUTILITIES_HPP
+
+#if defined(__unix__) || defined(__APPLE__)
+#    include <sys/resource.h>
+#endif
+
+/**
+ * @brief Get the peak resident set size of the process
+ * @return the peak RSS in MiB, 0 where getrusage is not available
+ * @note the value is process-wide: compare benchmarks by running each in its own process (--benchmark_filter)
+ */
+inline double peakRssMiB()
+{
+#if defined(__unix__) || defined(__APPLE__)
+    struct rusage usage {};
+    getrusage(RUSAGE_SELF, &usage);
+#    if defined(__APPLE__)
+    return static_cast<double>(usage.ru_maxrss) / (1024.0 * 1024.0);    // bytes
+#    else
+    return static_cast<double>(usage.ru_maxrss) / 1024.0;               // KiB
+#    endif
+#else
+    return 0;
+#endif
+}
+
+#endif    // OPENXLSX_BENCHMARKUTILITIES_HPP
@@ -0,0 +1,360 @@
+//
+// Benchmarks of whole workbooks: open, save, random access, iteration, shared strings, styles, merges and template forks, on generated fixtures.
+// The fixture sizes scale with the OPENXLSX_BENCHMARK_SCALE environment variable, see BenchmarkFixtures.hpp.
+//
+
+#ifdef _MSC_VER    // conditionally enable MSVC specific pragmas to avoid other compilers warning about unknown pragmas
+#   pragma warning(push)
+#   pragma warning(disable : 4244)
+#endif // _MSC_VER
+
+#include "BenchmarkFixtures.hpp"
+#include "BenchmarkUtilities.hpp"
+
+#include <OpenXLSX.hpp>
+#include <benchmark/benchmark.h>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace OpenXLSX;
+using namespace OpenXLSX::Benchmark;
+
+namespace
+{
+    constexpr double   bytesPerMiB    = 1024.0 * 1024.0;
+    constexpr uint32_t randomAccesses = 10000;    // cells visited per iteration of the random access benchmarks
+
+    /**
+     * @brief Load every worksheet of a document, so that all worksheet parts are parsed
+     * @return the number of worksheets
+     */
+    uint32_t loadWorksheets(XLDocument& doc)
+    {
+        auto names = doc.workbook().worksheetNames();
+        for (auto const& name : names) benchmark::DoNotOptimize(doc.workbook().worksheet(name).lastCell());
+        return static_cast<uint32_t>(names.size());
+    }
+
+    /**
+     * @brief Draw random cell coordinates within the used range of a fixture
+     */
+    std::vector<std::pair<uint32_t, uint16_t>> randomCells(XLFixture fixture, uint64_t seed)
+    {
+        XLFixtureShape const                       shape = fixtureShape(fixture);
+        XLBenchmarkRandom                          random(seed);
+        std::vector<std::pair<uint32_t, uint16_t>> cells;
+        cells.reserve(randomAccesses);
+        for (uint32_t index = 0; index < randomAccesses; ++index)
+            cells.emplace_back(static_cast<uint32_t>(random.below(shape.rows) + 1), static_cast<uint16_t>(random.below(shape.columns) + 1));
+        return cells;
+    }
+
+    /**
+     * @brief Report the counters shared by all benchmarks of this file
+     */
+    void reportMemory(benchmark::State& state, XLDocument const& doc)
+    {
+        state.counters["memory_mib"]   = static_cast<double>(doc.memoryUsage().total()) / bytesPerMiB;
+        state.counters["peak_rss_mib"] = peakRssMiB();
+    }
+}    // namespace
+
+/**
+ * @brief Open a fixture and parse all of its worksheets
+ * @param state
+ * @param fixture
+ */
+static void BM_Open(benchmark::State& state, XLFixture fixture)    // NOLINT
+{
+    auto const& path   = fixturePath(fixture);
+    uint32_t    sheets = 0;
+
+    XLDocument doc;
+    for (auto _ : state) {    // NOLINT
+        doc.open(path);
+        sheets += loadWorksheets(doc);
+
+        state.PauseTiming();
+        reportMemory(state, doc);
+        doc.close();
+        state.ResumeTiming();
+    }
+
+    benchmark::DoNotOptimize(sheets);
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * fixtureShape(fixture).sheets * fixtureShape(fixture).rows);
+}
+
+BENCHMARK_CAPTURE(BM_Open, tall, XLFixture::Tall)->Unit(benchmark::kMillisecond);                      // NOLINT
+BENCHMARK_CAPTURE(BM_Open, wide, XLFixture::Wide)->Unit(benchmark::kMillisecond);                      // NOLINT
+BENCHMARK_CAPTURE(BM_Open, sst, XLFixture::SharedStrings)->Unit(benchmark::kMillisecond);              // NOLINT
+BENCHMARK_CAPTURE(BM_Open, styles, XLFixture::Styles)->Unit(benchmark::kMillisecond);                  // NOLINT
+BENCHMARK_CAPTURE(BM_Open, parts, XLFixture::ManyParts)->Unit(benchmark::kMillisecond);                // NOLINT
+
+/**
+ * @brief Save a copy of a fixture whose worksheets have all been parsed
+ * @param state
+ * @param fixture
+ */
+static void BM_Save(benchmark::State& state, XLFixture fixture)    // NOLINT
+{
+    const std::string target = "./benchmark_save_" + fixtureName(fixture) + ".xlsx";
+
+    XLDocument doc;
+    doc.open(fixturePath(fixture));
+    loadWorksheets(doc);
+
+    for (auto _ : state) doc.saveAs(target, XLForceOverwrite);    // NOLINT
+
+    reportMemory(state, doc);
+    doc.close();
+}
+
+BENCHMARK_CAPTURE(BM_Save, tall, XLFixture::Tall)->Unit(benchmark::kMillisecond);                      // NOLINT
+BENCHMARK_CAPTURE(BM_Save, wide, XLFixture::Wide)->Unit(benchmark::kMillisecond);                      // NOLINT
+BENCHMARK_CAPTURE(BM_Save, sst, XLFixture::SharedStrings)->Unit(benchmark::kMillisecond);              // NOLINT
+BENCHMARK_CAPTURE(BM_Save, styles, XLFixture::Styles)->Unit(benchmark::kMillisecond);                  // NOLINT
+BENCHMARK_CAPTURE(BM_Save, parts, XLFixture::ManyParts)->Unit(benchmark::kMillisecond);                // NOLINT
+
+/**
+ * @brief Read the values of randomly chosen cells
+ * @param state
+ * @param fixture
+ */
+static void BM_RandomRead(benchmark::State& state, XLFixture fixture)    // NOLINT
+{
+    auto const cells  = randomCells(fixture, 1);
+    double     result = 0;
+
+    XLDocument doc;
+    doc.open(fixturePath(fixture));
+    auto wks = doc.workbook().worksheet("Sheet1");
+
+    for (auto _ : state) {    // NOLINT
+        for (auto const& [row, column] : cells) {
+            XLCellValue value = wks.cell(row, column).value();
+            result += value.type() == XLValueType::Float ? value.get<double>() : static_cast<double>(value.type());
+        }
+        benchmark::DoNotOptimize(result);
+    }
+
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * randomAccesses);
+    reportMemory(state, doc);
+    doc.close();
+}
+
+BENCHMARK_CAPTURE(BM_RandomRead, tall, XLFixture::Tall)->Unit(benchmark::kMillisecond);                // NOLINT
+BENCHMARK_CAPTURE(BM_RandomRead, wide, XLFixture::Wide)->Unit(benchmark::kMillisecond);                // NOLINT
+
+/**
+ * @brief Overwrite randomly chosen cells with numbers
+ * @param state
+ * @param fixture
+ */
+static void BM_RandomWrite(benchmark::State& state, XLFixture fixture)    // NOLINT
+{
+    auto const cells = randomCells(fixture, 2);
+    double     value = 0;
+
+    XLDocument doc;
+    doc.open(fixturePath(fixture));
+    auto wks = doc.workbook().worksheet("Sheet1");
+
+    for (auto _ : state) {    // NOLINT
+        for (auto const& [row, column] : cells) wks.cell(row, column).value() = (value += 0.5);
+        benchmark::ClobberMemory();
+    }
+
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * randomAccesses);
+    reportMemory(state, doc);
+    doc.close();
+}
+
+BENCHMARK_CAPTURE(BM_RandomWrite, tall, XLFixture::Tall)->Unit(benchmark::kMillisecond);               // NOLINT
+BENCHMARK_CAPTURE(BM_RandomWrite, wide, XLFixture::Wide)->Unit(benchmark::kMillisecond);               // NOLINT
+
+/**
+ * @brief Visit every cell of the first worksheet of a fixture, row by row
+ * @param state
+ * @param fixture
+ */
+static void BM_Iterate(benchmark::State& state, XLFixture fixture)    // NOLINT
+{
+    uint64_t result = 0;
+
+    XLDocument doc;
+    doc.open(fixturePath(fixture));
+    auto wks = doc.workbook().worksheet("Sheet1");
+
+    for (auto _ : state) {    // NOLINT
+        for (auto& row : wks.rows())
+            for (auto& cell : row.cells()) result += static_cast<uint64_t>(cell.value().type());
+        benchmark::DoNotOptimize(result);
+    }
+
+    XLFixtureShape const shape = fixtureShape(fixture);
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * shape.rows * shape.columns);
+    reportMemory(state, doc);
+    doc.close();
+}
+
+BENCHMARK_CAPTURE(BM_Iterate, tall, XLFixture::Tall)->Unit(benchmark::kMillisecond);                   // NOLINT
+BENCHMARK_CAPTURE(BM_Iterate, wide, XLFixture::Wide)->Unit(benchmark::kMillisecond);                   // NOLINT
+BENCHMARK_CAPTURE(BM_Iterate, sst, XLFixture::SharedStrings)->Unit(benchmark::kMillisecond);           // NOLINT
+
+/**
+ * @brief Write string cells into a new workbook, drawing from a pool of state.range(0) distinct strings
+ * @param state
+ * @note the time is dominated by the lookup of each string in the shared strings table
+ */
+static void BM_InternStrings(benchmark::State& state)    // NOLINT
+{
+    constexpr uint32_t rows   = 10000;
+    constexpr uint16_t cols   = 2;
+    const auto         unique = static_cast<uint64_t>(state.range(0));
+
+    std::vector<std::string> pool;
+    for (uint64_t index = 0; index < unique; ++index) pool.push_back("Value " + std::to_string(index * 7919));
+    XLBenchmarkRandom random(3);
+
+    for (auto _ : state) {    // NOLINT
+        state.PauseTiming();
+        XLDocument doc;
+        doc.create("./benchmark_intern.xlsx", XLForceOverwrite);
+        auto wks = doc.workbook().worksheet("Sheet1");
+        state.ResumeTiming();
+
+        for (uint32_t row = 1; row <= rows; ++row)
+            for (uint16_t col = 1; col <= cols; ++col) wks.cell(row, col).value() = pool[random.below(unique)];
+
+        state.PauseTiming();
+        reportMemory(state, doc);
+        doc.close();
+        state.ResumeTiming();
+    }
+
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * rows * cols);
+}
+
+BENCHMARK(BM_InternStrings)->Arg(16)->Arg(1024)->Arg(16384)->Unit(benchmark::kMillisecond);    // NOLINT
+
+/**
+ * @brief Create state.range(0) distinct cell formats (each with its own font and fill), then look each of them up again
+ * @param state
+ */
+static void BM_CreateStyles(benchmark::State& state)    // NOLINT
+{
+    const auto formats = static_cast<uint32_t>(state.range(0));
+
+    for (auto _ : state) {    // NOLINT
+        state.PauseTiming();
+        XLDocument doc;
+        doc.create("./benchmark_styles.xlsx", XLForceOverwrite);
+        XLStyles& styles = doc.styles();
+        state.ResumeTiming();
+
+        for (uint32_t pass = 0; pass < 2; ++pass) {
+            for (uint32_t index = 0; index < formats; ++index) {
+                XLStyleIndex font = styles.fonts().findOrCreate(styles.fonts()[0], [&](XLFont& entry) {
+                    entry.setFontSize(8 + index % 16);
+                    entry.setBold(index % 32 >= 16);
+                });
+                XLStyleIndex fill = styles.fills().findOrCreate(styles.fills()[0], [&](XLFill& entry) {
+                    entry.setPatternType(XLPatternSolid);
+                    entry.setColor(XLColor(static_cast<uint8_t>(index), static_cast<uint8_t>(index >> 8u), 64));
+                });
+                benchmark::DoNotOptimize(styles.cellFormats().findOrCreate(styles.cellFormats()[0], [&](XLCellFormat& entry) {
+                    entry.setFontIndex(font);
+                    entry.setFillIndex(fill);
+                    entry.setApplyFill(true);
+                }));
+            }
+        }
+
+        state.PauseTiming();
+        reportMemory(state, doc);
+        doc.close();
+        state.ResumeTiming();
+    }
+
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * formats * 2);
+}
+
+BENCHMARK(BM_CreateStyles)->Arg(256)->Arg(4096)->Unit(benchmark::kMillisecond);    // NOLINT
+
+/**
+ * @brief Append state.range(0) merges of two rows and state.range(1) columns each, look up a cell of each, then delete them from the front
+ * @param state
+ * @note the time per merge should grow logarithmically with the merge count, and not at all with the merge width
+ */
+static void BM_MergeCells(benchmark::State& state)    // NOLINT
+{
+    const auto merges = static_cast<uint32_t>(state.range(0));
+    const auto width  = static_cast<uint16_t>(state.range(1));
+
+    std::vector<std::string> references;
+    references.reserve(merges);
+    const std::string lastColumn = XLCellReference::columnAsString(width);
+    for (uint32_t index = 0; index < merges; ++index)
+        references.push_back("A" + std::to_string(2 * index + 1) + ":" + lastColumn + std::to_string(2 * index + 2));
+
+    for (auto _ : state) {    // NOLINT
+        state.PauseTiming();
+        XLDocument doc;
+        doc.create("./benchmark_merges.xlsx", XLForceOverwrite);
+        auto          wks   = doc.workbook().worksheet("Sheet1");
+        XLMergeCells& cells = wks.merges();
+        state.ResumeTiming();
+
+        for (auto const& reference : references) cells.appendMerge(reference);
+        for (uint32_t index = 0; index < merges; ++index) benchmark::DoNotOptimize(cells.findMergeByCell(XLCellReference(2 * index + 2, width)));
+        for (uint32_t index = 0; index < merges; ++index) cells.deleteMerge(0);
+
+        state.PauseTiming();
+        doc.close();
+        state.ResumeTiming();
+    }
+
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * merges);
+}
+
+BENCHMARK(BM_MergeCells)->Args({1000, 2})->Args({16000, 2})->Args({1000, 16384})->Unit(benchmark::kMillisecond);    // NOLINT
+
+/**
+ * @brief Produce a report from a fixture: open it (or fork it from an XLTemplate), fill a block of cells on the first sheet and save a copy
+ * @param state
+ * @param fixture
+ * @param fork true to fork each document from a template that is opened once, false to open the file each time
+ */
+static void BM_Stamp(benchmark::State& state, XLFixture fixture, bool fork)    // NOLINT
+{
+    const std::string target = "./benchmark_stamp_" + fixtureName(fixture) + ".xlsx";
+    const XLTemplate  source = fork ? XLTemplate(fixturePath(fixture)) : XLTemplate();
+
+    XLDocument doc;
+    for (auto _ : state) {    // NOLINT
+        if (fork)
+            doc.open(source);
+        else
+            doc.open(fixturePath(fixture));
+        auto wks = doc.workbook().worksheet("Sheet1");
+        for (uint32_t row = 1; row <= 100; ++row)
+            for (uint16_t col = 1; col <= 4; ++col) wks.cell(row, col).value() = row * col;
+        doc.saveAs(target, XLForceOverwrite);
+
+        state.PauseTiming();
+        reportMemory(state, doc);
+        doc.close();
+        state.ResumeTiming();
+    }
+}
+
+BENCHMARK_CAPTURE(BM_Stamp, open_tall, XLFixture::Tall, false)->Unit(benchmark::kMillisecond);        // NOLINT
+BENCHMARK_CAPTURE(BM_Stamp, fork_tall, XLFixture::Tall, true)->Unit(benchmark::kMillisecond);         // NOLINT
+BENCHMARK_CAPTURE(BM_Stamp, open_parts, XLFixture::ManyParts, false)->Unit(benchmark::kMillisecond);  // NOLINT
+BENCHMARK_CAPTURE(BM_Stamp, fork_parts, XLFixture::ManyParts, true)->Unit(benchmark::kMillisecond);   // NOLINT
+
+#ifdef _MSC_VER    // conditionally enable MSVC specific pragmas to avoid other compilers warning about unknown pragmas
+#   pragma warning(pop)
+#endif // _MSC_VER
@@ -0,0 +1,81 @@
+#!/usr/bin/env python3
+"""
+Compare two google-benchmark JSON result files and fail on regressions.
+
+    python3 compare_benchmarks.py baseline.json current.json [--threshold 0.10] [--counter peak_rss_mib ...]
+
+The results are produced by the OpenXLSXBenchmarkJson target, or by running OpenXLSXBenchmark with
+--benchmark_out=<file> --benchmark_out_format=json. A benchmark regresses when its time (or one of the selected
+counters, where larger is worse) grows by more than the threshold, relative to the baseline. When the results contain
+repetitions, the median aggregate is compared. The exit status is 1 when any benchmark regressed, 0 otherwise.
+"""
+
+import argparse
+import json
+import sys
+
+TIME_UNITS = {"ns": 1e-9, "us": 1e-6, "ms": 1e-3, "s": 1.0}
+
+
+def load(path):
+    """Map each benchmark name to its entry, preferring the median aggregate over the individual repetitions."""
+    with open(path, encoding="utf-8") as file:
+        entries = json.load(file)["benchmarks"]
+
+    results = {}
+    for entry in entries:
+        if entry.get("error_occurred"):
+            continue
+        name = entry.get("run_name", entry["name"])
+        if entry.get("run_type") == "aggregate":
+            if entry.get("aggregate_name") == "median":
+                results[name] = entry
+        elif name not in results or results[name].get("run_type") != "aggregate":
+            results[name] = entry
+    return results
+
+
+def seconds(entry, metric):
+    return entry[metric] * TIME_UNITS[entry.get("time_unit", "ns")]
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("baseline", help="the reference results")
+    parser.add_argument("current", help="the results to check")
+    parser.add_argument("--threshold", type=float, default=0.10, help="the tolerated relative increase (default 0.10)")
+    parser.add_argument("--metric", choices=["real_time", "cpu_time"], default="real_time", help="the time to compare")
+    parser.add_argument("--counter", action="append", default=[],
+                        help="a counter to compare as well, where larger is worse (e.g. peak_rss_mib); may be repeated")
+    args = parser.parse_args()
+
+    baseline = load(args.baseline)
+    current = load(args.current)
+    regressions = 0
+
+    print(f"{'benchmark':<40} {'measure':<14} {'baseline':>12} {'current':>12} {'change':>8}")
+    for name in sorted(baseline.keys() & current.keys()):
+        measures = [(args.metric, seconds(baseline[name], args.metric), seconds(current[name], args.metric))]
+        for counter in args.counter:
+            if counter in baseline[name] and counter in current[name]:
+                measures.append((counter, float(baseline[name][counter]), float(current[name][counter])))
+
+        for measure, old, new in measures:
+            change = (new - old) / old if old > 0 else 0.0
+            failed = change > args.threshold
+            regressions += failed
+            print(f"{name:<40} {measure:<14} {old:>12.6g} {new:>12.6g} {change:>+7.1%}{'  REGRESSION' if failed else ''}")
+
+    for name in sorted(baseline.keys() - current.keys()):
+        print(f"{name:<40} missing from the current results")
+    for name in sorted(current.keys() - baseline.keys()):
+        print(f"{name:<40} not in the baseline")
+
+    if regressions:
+        print(f"\n{regressions} regression(s) beyond {args.threshold:.0%}")
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -15,6 +15,7 @@
 #endif // _MSC_VER
 
 #include <algorithm>
+#include <chrono>
 #include <cstddef>
 #include <cstdio>
 #include <fstream>
@@ -23,6 +24,8 @@
 #include <random>
 #include <stdexcept>
 #include <string>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
 #ifdef _WIN32
@@ -10014,12 +10017,17 @@ namespace Zippy
              */
             std::string GetDataAsString() const
             {
-                std::string result;
-                for (const auto& ch : m_EntryData) {
-                    result += static_cast<char>(ch);
-                }    // TODO: Should this use reinterpret_cast instead?
+                return std::string(reinterpret_cast<const char*>(m_EntryData.data()), m_EntryData.size());
+            }
 
-                return result;
+            /**
+             * @brief Release the extracted data of an entry that has not been modified.
+             * @details The data will be extracted again from the archive when needed, and ZipArchive::Save copies the
+             * compressed data of unmodified entries without extracting them. Modified entries keep their data.
+             */
+            void ReleaseData()
+            {
+                if (!m_IsModified) ZipEntryData().swap(m_EntryData);
             }
 
             /**
@@ -10295,6 +10303,15 @@ namespace Zippy
             return m_ZipEntry->GetDataAsString();
         }
 
+        /**
+         * @brief Release the extracted data of the entry, if it has not been modified.
+         * @details The data is extracted again by the next ZipArchive::GetEntry call for the entry.
+         */
+        void ReleaseData()
+        {
+            m_ZipEntry->ReleaseData();
+        }
+
         /**
          * @brief Set the data for the entry.
          * @param data A std::string with the file data.
@@ -10603,6 +10620,7 @@ namespace Zippy
             std::reverse(m_ZipEntries.begin(), m_ZipEntries.end());
             m_ZipEntries.erase(std::unique(m_ZipEntries.begin(), m_ZipEntries.end(), isEqual), m_ZipEntries.end());
             std::reverse(m_ZipEntries.begin(), m_ZipEntries.end());
+            RebuildEntryIndex();
 
             // ===== Add folder entries if they don't exist
             for (auto& entry : GetEntryNames(false, true)) {
@@ -10624,6 +10642,7 @@ namespace Zippy
             m_ArchivePath = "";
             m_IsOpen = false;       // 2024-12-18: minor bugfix, m_IsOpen was not set to false
             m_ZipEntries.clear();
+            m_EntryIndex.clear();
         }
 
         /**
@@ -10811,8 +10830,7 @@ namespace Zippy
         {
             if (!IsOpen()) throw ZipLogicError("Cannot call HasEntry on empty ZipArchive object!");
 
-            auto result = GetEntryNames(true, true);
-            return std::find(result.begin(), result.end(), entryName) != result.end();
+            return m_EntryIndex.find(entryName) != m_EntryIndex.end();
         }
 
         /**
@@ -10824,6 +10842,7 @@ namespace Zippy
         void Save(std::string filename = "")
         {
             if (!IsOpen()) throw ZipLogicError("Cannot call Save on empty ZipArchive object!");
+            const auto writeStart = std::chrono::steady_clock::now();
 
             if (filename.empty()) {
                 filename = m_ArchivePath;
@@ -10877,6 +10896,7 @@ namespace Zippy
             // ===== Finalize and close the temporary archive
             mz_zip_writer_finalize_archive(&tempArchive);
             mz_zip_writer_end(&tempArchive);
+            const auto validateStart = std::chrono::steady_clock::now();
 
             // ===== Validate the temporary file
             mz_zip_error errordata;
@@ -10889,6 +10909,28 @@ namespace Zippy
             MZ_DELETE_FILE(filename.c_str());
             MZ_RENAME_FILE(tempPath.c_str(), filename.c_str());
             Open(filename);
+
+            m_LastSaveDurations = { std::chrono::duration_cast<std::chrono::nanoseconds>(validateStart - writeStart).count(),
+                                    std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - validateStart).count() };
+        }
+
+        /**
+         * @brief Get the durations of the steps of the last successful call to Save.
+         * @return The nanoseconds spent compressing and writing the entries (first), and validating the written file, replacing
+         * the original file and reopening it (second).
+         */
+        std::pair<int64_t, int64_t> LastSaveDurations() const { return m_LastSaveDurations; }
+
+        /**
+         * @brief Get the size of the entry data held in memory.
+         * @return The number of bytes allocated for the data of entries added since the archive was opened, and of entries whose
+         * data was extracted and not released.
+         */
+        size_t CachedDataSize() const
+        {
+            size_t result = 0;
+            for (const auto& entry : m_ZipEntries) result += entry.m_EntryData.capacity();
+            return result;
         }
 
         /**
@@ -10910,10 +10952,12 @@ namespace Zippy
         {
             if (!IsOpen()) throw ZipLogicError("Cannot call DeleteEntry on empty ZipArchive object!");
 
-            m_ZipEntries.erase(std::remove_if(m_ZipEntries.begin(),
-                                              m_ZipEntries.end(),
-                                              [&](const Impl::ZipEntry& entry) { return name == entry.GetName(); }),
-                               m_ZipEntries.end());
+            auto result = m_EntryIndex.find(name);
+            if (result == m_EntryIndex.end()) return;
+
+            // ===== Entry names are unique, so only one element is erased; the positions of all later entries shift down by one.
+            m_ZipEntries.erase(m_ZipEntries.begin() + static_cast<std::ptrdiff_t>(result->second));
+            RebuildEntryIndex();
         }
 
         /**
@@ -10926,9 +10970,9 @@ namespace Zippy
             if (!IsOpen()) throw ZipLogicError("Cannot call GetEntry on empty ZipArchive object!");
 
             // ===== Look up ZipEntry object.
-            auto result = std::find_if(m_ZipEntries.begin(), m_ZipEntries.end(), [&](const Impl::ZipEntry& entry) {
-                return name == entry.GetName();
-            });
+            auto position = m_EntryIndex.find(name);
+            if (position == m_EntryIndex.end()) throw ZipLogicError("Entry " + name + " does not exist in ZipArchive!");
+            auto result = m_ZipEntries.begin() + static_cast<std::ptrdiff_t>(position->second);
 
             // ===== If data has not been extracted from the archive (i.e., m_EntryData is empty),
             // ===== extract the data from the archive to the ZipEntry object.
@@ -10937,7 +10981,10 @@ namespace Zippy
                     result->m_EntryData.resize(result->UncompressedSize());
                 else
                     result->m_EntryData.resize(1); // 2024-06-03 BUFIX: std::vector::data() can be nullptr when ::size() is 0, leading to a failure to load an empty file
-                mz_zip_reader_extract_file_to_mem(&m_Archive, name.c_str(), result->m_EntryData.data(), result->m_EntryData.size(), 0);
+                // ===== Entries read from the archive know their file index: avoid a second name lookup inside miniz.
+                //       Entries added since opening hold their own data and are not present in the archive file.
+                if (!result->IsModified())
+                    mz_zip_reader_extract_to_mem(&m_Archive, result->Index(), result->m_EntryData.data(), result->m_EntryData.size(), 0);
             }
 
             // ===== Check that the operation was successful
@@ -11060,40 +11107,49 @@ namespace Zippy
             if (!IsOpen()) throw ZipLogicError("Cannot call AddEntry on empty ZipArchive object!");
 
             // ===== Ensure that all folders and subfolders have an entry in the archive
-            auto folders = GetEntryNames(true, false);
-            auto pos     = 0;
+            size_t pos = 0;
             while (name.find('/', pos) != std::string::npos) {
                 pos         = name.find('/', pos) + 1;
                 auto folder = name.substr(0, pos);
 
                 // ===== If folder isn't registered in the archive, add it.
-                if (std::find(folders.begin(), folders.end(), folder) == folders.end()) {
+                if (m_EntryIndex.find(folder) == m_EntryIndex.end()) {
+                    m_EntryIndex.emplace(folder, m_ZipEntries.size());
                     m_ZipEntries.emplace_back(Impl::ZipEntry(folder, ""));
-                    folders.emplace_back(folder);
                 }
             }
 
-            // ===== Check if an entry with the given name already exists in the archive.
-            auto result = std::find_if(m_ZipEntries.begin(), m_ZipEntries.end(), [&](const Impl::ZipEntry& entry) {
-                return name == entry.GetName();
-            });
-
-            // ===== If the entry exists, replace the existing data with the new data, and return the ZipEntry object.
-            if (result != m_ZipEntries.end()) {
-                result->SetData(data);
-                return ZipEntry(&*result);
+            // ===== If an entry with the given name already exists, replace the existing data with the new data, and return the ZipEntry object.
+            auto result = m_EntryIndex.find(name);
+            if (result != m_EntryIndex.end()) {
+                Impl::ZipEntry& entry = m_ZipEntries[result->second];
+                entry.SetData(data);
+                return ZipEntry(&entry);
             }
 
             // ===== Finally, add a new entry with the given name and data, and return the object.
+            m_EntryIndex.emplace(name, m_ZipEntries.size());
             return ZipEntry(&m_ZipEntries.emplace_back(Impl::ZipEntry(name, data)));
         }
 
+        /**
+         * @brief Recreate the name -> position lookup for all entries, after m_ZipEntries was reordered or shrunk.
+         */
+        void RebuildEntryIndex()
+        {
+            m_EntryIndex.clear();
+            m_EntryIndex.reserve(m_ZipEntries.size());
+            for (size_t i = 0; i < m_ZipEntries.size(); ++i) m_EntryIndex.emplace(m_ZipEntries[i].GetName(), i);
+        }
+
     private:
         mz_zip_archive m_Archive     = mz_zip_archive(); /**< The struct used by miniz, to handle archive files. */
         std::string    m_ArchivePath = "";               /**< The path of the archive file. */
         bool           m_IsOpen      = false;            /**< A flag indicating if the file is currently open for reading and writing. */
 
         std::vector<Impl::ZipEntry> m_ZipEntries = std::vector<Impl::ZipEntry>(); /**< Data structure for all entries in the archive. */
+        std::unordered_map<std::string, size_t> m_EntryIndex = std::unordered_map<std::string, size_t>(); /**< Position in m_ZipEntries by entry name. */
+        std::pair<int64_t, int64_t> m_LastSaveDurations = { 0, 0 }; /**< See LastSaveDurations. */
     };
 }    // namespace Zippy
 
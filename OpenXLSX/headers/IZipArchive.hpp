@@ -57,6 +57,8 @@ YM      M9  MM    MM MM       MM    MM   d'  `MM.    MM            MM   d'  `MM.
 
 #include <memory>
 #include <string>
+#include <type_traits>
+#include <utility>
 
 namespace OpenXLSX
 {
@@ -65,6 +67,7 @@ namespace OpenXLSX
      * a zip archive.
      * @details This class works by applying 'type erasure'. This enables the use of objects of any class, the only
      * requirement being that it provides the right interface. No inheritance from a base class is needed.
+     * @note The member function cachedDataSize is optional: archives that do not provide it report 0.
      */
     class OPENXLSX_EXPORT IZipArchive
     {
@@ -143,12 +146,11 @@ namespace OpenXLSX
         }
 
         inline bool isValid() const {
-            return m_zipArchive->isValid();
-
+            return m_zipArchive && m_zipArchive->isValid();    // a moved-from archive (e.g. of a moved-from XLDocument) is not valid
         }
 
         inline bool isOpen() const {
-            return m_zipArchive->isOpen();
+            return m_zipArchive && m_zipArchive->isOpen();
         }
 
         inline void open(const std::string& fileName) {
@@ -179,7 +181,20 @@ namespace OpenXLSX
             return m_zipArchive->hasEntry(entryName);
         }
 
+        inline size_t cachedDataSize() const {
+            return m_zipArchive->cachedDataSize();
+        }
+
     private:
+        /**
+         * @brief Detects whether T provides the optional size_t cachedDataSize() const
+         */
+        template<typename T, typename = void>
+        struct HasCachedDataSize : std::false_type {};
+
+        template<typename T>
+        struct HasCachedDataSize<T, std::void_t<decltype(std::declval<const T&>().cachedDataSize())>> : std::true_type {};
+
         /**
          * @brief
          */
@@ -242,6 +257,8 @@ namespace OpenXLSX
 
             inline virtual bool hasEntry(const std::string& entryName) const = 0;
 
+            inline virtual size_t cachedDataSize() const = 0;
+
         };
 
         /**
@@ -334,6 +351,11 @@ namespace OpenXLSX
                 return ZipType.hasEntry(entryName);
             }
 
+            inline size_t cachedDataSize() const override {
+                if constexpr (HasCachedDataSize<T>::value) return ZipType.cachedDataSize();
+                else return 0;
+            }
+
         private:
             T ZipType;
         };
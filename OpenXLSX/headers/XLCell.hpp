@@ -84,6 +84,8 @@ namespace OpenXLSX
         friend class XLCellIterator;
         friend class XLCellValueProxy;
         friend class XLRowDataIterator;
+        friend class XLFormulaEngine;
+        friend class XLFormulaProxy;
         friend bool operator==(const XLCell& lhs, const XLCell& rhs);
         friend bool operator!=(const XLCell& lhs, const XLCell& rhs);
 
@@ -207,6 +209,12 @@ namespace OpenXLSX
          */
         const XLFormulaProxy& formula() const;
 
+        /**
+         * @brief Get the calculated value of the cell
+         * @return For formula cells, the cached result stored in <v>; for all other cells, the cell value
+         */
+        XLCellValue calculatedValue() const;
+
         /**
          * @brief
          */
@@ -226,6 +234,25 @@ namespace OpenXLSX
          */
         bool setCellFormat(XLStyleIndex cellFormatIndex);
 
+        /**
+         * @brief Test whether the cell holds a number that its number format displays as a date and / or time
+         * @param styles The styles of the document containing the cell (XLDocument::styles)
+         * @returns True if the cell value is numeric and the cell format is classified as date, time or datetime
+         * @note O(1) per cell, using the classification precomputed by XLStyles::cellFormatType
+         */
+        bool isDateTime(XLStyles const& styles) const;
+
+        /**
+         * @brief Get the cell value as a date / time, based on the cell number format
+         * @param styles The styles of the document containing the cell (XLDocument::styles)
+         * @returns The cell value converted to XLDateTime. A time of day without date (a value in [0, 1) with a time only format,
+         *          e.g. h:mm) is returned on 1900-01-01, as XLDateTime can not represent serials below 1.0: tm() then yields the
+         *          time of day, and serial() is the cell value + 1.0
+         * @throw XLValueTypeError if isDateTime(styles) is false
+         * @throw XLDateTimeError if the value is below 1.0 with a date or datetime format (or negative), which XLDateTime can not represent
+         */
+        XLDateTime dateTimeValue(XLStyles const& styles) const;
+
         /**
          * @brief Print the XML contents of the XLCell using the underlying XMLNode print function
          */
@@ -260,6 +287,7 @@ namespace OpenXLSX
          * @param other the cell to construct from
          */
         XLCellAssignable (XLCell const & other);
+        XLCellAssignable (XLCellAssignable const & other) : XLCell(other) {}
 
         /**
          * @brief Move constructor. Constructs an assignable XLCell from a temporary (r)value
@@ -219,6 +219,7 @@ namespace OpenXLSX
         uint32_t                 m_currentRow;
         uint16_t                 m_currentColumn;
         std::vector<XLStyleIndex> const * m_colStyles;
+        bool                     m_readOnly;             /**< If true, missing cells are never created (see XLOpenMode::ReadOnly) */
     };
 
     /**
@@ -53,6 +53,7 @@ YM      M9  MM    MM MM       MM    MM   d'  `MM.    MM            MM   d'  `MM.
 #endif // _MSC_VER
 
 // ===== External Includes ===== //
+#include <cstdint>
 #include <memory>
 
 // ===== OpenXLSX Includes ===== //
@@ -64,6 +65,25 @@ YM      M9  MM    MM MM       MM    MM   d'  `MM.    MM            MM   d'  `MM.
 
 namespace OpenXLSX
 {
+    /**
+     * @brief The result of XLCellRange::aggregate: aggregates over the numeric cells of a range
+     * @note min and max are 0 if the range holds no numeric cells
+     */
+    struct OPENXLSX_EXPORT XLRangeAggregate
+    {
+        double   sum {0.0};           /**< sum of the numeric cells */
+        double   min {0.0};           /**< smallest numeric cell value */
+        double   max {0.0};           /**< largest numeric cell value */
+        uint64_t count {0};           /**< number of numeric cells */
+        uint64_t nonNumericCount {0}; /**< number of non-empty cells that are not numeric (strings, booleans, errors) */
+
+        /**
+         * @brief the average of the numeric cells
+         * @return sum / count, or 0.0 if there are no numeric cells
+         */
+        double mean() const { return count > 0 ? sum / static_cast<double>(count) : 0.0; }
+    };
+
     /**
      * @brief This class encapsulates the concept of a cell range, i.e. a square area
      * (or subset) of cells in a spreadsheet.
@@ -206,9 +226,43 @@ namespace OpenXLSX
          * @brief Set cell format for a range of cells
          * @param cellFormatIndex The style to set, corresponding to the nidex of XLStyles::cellStyles()
          * @returns true on success, false on failure
+         * @note Ranges that cover whole rows or whole columns are formatted through the row format or column style,
+         *        without creating the cells. Otherwise all cells are formatted in a single pass per row.
          */
         bool setFormat(XLStyleIndex cellFormatIndex);
 
+        /**
+         * @brief Compute sum, min, max and count of the numeric cells, and count the non-numeric cells, in a single pass
+         * @return an XLRangeAggregate with the results
+         * @note The cached values of formula cells are used. Numeric cell values are decoded straight from the XML text without
+         *        creating XLCell or XLCellValue objects, so this is much faster than iterating the range.
+         */
+        XLRangeAggregate aggregate() const;
+
+        /**
+         * @brief Get the sum of the numeric cells in the range
+         * @return the sum, 0.0 if there are no numeric cells
+         */
+        double sum() const;
+
+        /**
+         * @brief Get the number of numeric cells in the range (like the spreadsheet function COUNT)
+         * @return the number of numeric cells
+         */
+        uint64_t count() const;
+
+        /**
+         * @brief Get the average of the numeric cells in the range
+         * @return the average, 0.0 if there are no numeric cells
+         */
+        double mean() const;
+
+        /**
+         * @brief Get the number of non-empty cells in the range that are not numeric
+         * @return the number of string, boolean and error cells
+         */
+        uint64_t countNonNumeric() const;
+
         //----------------------------------------------------------------------------------------------------------------------
         //           Private Member Variables
         //----------------------------------------------------------------------------------------------------------------------
@@ -70,6 +70,7 @@ namespace OpenXLSX
         SetSheetIndex,
         SetSheetActive,
         ResetCalcChain,
+        UpdateCalcChain,
         CheckAndFixCoreProperties,
         CheckAndFixExtendedProperties,
         AddSharedStrings,
@@ -142,7 +143,8 @@ namespace OpenXLSX
         QuerySheetRelsID,
         QuerySheetRelsTarget,
         QuerySharedStrings,
-        QueryXmlData
+        QueryXmlData,
+        QueryXmlDataOfNode
     };
 
     /**
@@ -48,10 +48,14 @@ YM      M9  MM    MM MM       MM    MM   d'  `MM.    MM            MM   d'  `MM.
 
 // ===== External Includes ===== //
 #include <cstdint>    // uint8_t, uint16_t, uint32_t
+#include <map>        // std::map
 #include <ostream>    // std::basic_ostream
+#include <string>
+#include <vector>
 
 // ===== OpenXLSX Includes ===== //
 #include "OpenXLSX-Exports.hpp"
+#include "XLCellReference.hpp"
 // #include "XLDocument.hpp"
 #include "XLDrawing.hpp"   // XLVmlDrawing
 #include "XLException.hpp"
@@ -141,8 +145,21 @@ namespace OpenXLSX
         std::unique_ptr<XMLNode> m_commentNode;      /**< An XMLNode object with the comment item */
      };
 
+    /**
+     * @brief A comment to be set by XLComments::setMany
+     */
+    struct XLCommentData
+    {
+        std::string cellRef;   /**< the cell address to set */
+        std::string text;      /**< the comment text */
+        uint16_t authorId{0};  /**< the author index */
+    };
+
     /**
      * @brief The XLComments class is the base class for worksheet comments
+     * @note Comment nodes and their VML shapes are looked up through an index ordered by (row, column), which is built on first use and
+     *  kept in sync by set, setMany and deleteComment. Changes made to the same comments XML through another XLComments object are not
+     *  seen by the index - as with m_hintNode, use one XLComments object per worksheet (XLWorksheet::comments()) for modifications.
      */
     class OPENXLSX_EXPORT XLComments : public XLXmlFile
     {
@@ -201,6 +218,10 @@ namespace OpenXLSX
         XMLNode authorNode(uint16_t index) const;
         XMLNode commentNode(size_t index) const;
         XMLNode commentNode(const std::string& cellRef) const;
+        void buildCommentIndex() const;
+        void buildShapeIndex() const;
+        void setComment(XLCellReference const& destRef, std::string const& commentText, uint16_t authorId_,
+                        std::map<uint64_t, XMLNode>::iterator& next);
 
     public:
 
@@ -245,6 +266,14 @@ namespace OpenXLSX
          */
         bool set(std::string const& cellRef, std::string const& comment, uint16_t authorId_ = 0);
 
+        /**
+         * @brief set the comments for many cells at once
+         * @param comments the cell addresses, texts and authors to set, in any order - if a cell is listed more than once, the last entry wins
+         * @return true upon success, false on failure
+         * @note the comments are sorted once and then merged into the (sorted) comment list in a single pass
+         */
+        bool setMany(std::vector<XLCommentData> const& comments);
+
         /**
          * @brief get the XLShape object for this comment
          */
@@ -261,6 +290,10 @@ namespace OpenXLSX
         std::unique_ptr<XLVmlDrawing> m_vmlDrawing;
         mutable XMLNode m_hintNode{};                 // the last comment XML Node accessed by index is stored here, if any - will be reset when comments are inserted or deleted
         mutable size_t m_hintIndex{0};                // this has the index at which m_hintNode was accessed, only valid if not m_hintNode.empty()
+        mutable std::map<uint64_t, XMLNode> m_commentIndex{}; // comment nodes by (row << 16 | column), built on first use
+        mutable std::map<uint64_t, XMLNode> m_shapeIndex{};   // VML shape nodes by (row << 16 | column), built on first use
+        mutable bool m_commentIndexValid{false};      // false until m_commentIndex has been built
+        mutable bool m_shapeIndexValid{false};        // false until m_shapeIndex has been built for the current m_vmlDrawing
         inline static const std::vector< std::string_view > m_nodeOrder = {      // comments XML node required child sequence
             "authors",
             "commentList"
@@ -54,8 +54,15 @@ YM      M9  MM    MM MM       MM    MM   d'  `MM.    MM            MM   d'  `MM.
 
 // ===== External Includes ===== //
 #include <algorithm> // std::find_if
+#include <atomic>
+#include <functional>
+#include <future>
 #include <list>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <unordered_map>
+#include <utility>
 
 // ===== OpenXLSX Includes ===== //
 #include "IZipArchive.hpp"
@@ -67,19 +74,145 @@ YM      M9  MM    MM MM       MM    MM   d'  `MM.    MM            MM   d'  `MM.
 #include "XLProperties.hpp"
 #include "XLRelationships.hpp"
 #include "XLSharedStrings.hpp"
+#include "XLStats.hpp"
 #include "XLStyles.hpp"
 #include "XLTables.hpp"
+#include "XLTemplate.hpp"
 #include "XLWorkbook.hpp"
+#include "XLXmlArena.hpp"
 #include "XLXmlData.hpp"
 #include "XLZipArchive.hpp"
 
 namespace OpenXLSX
 {
     constexpr const unsigned int pugi_parse_settings = pugi::parse_default | pugi::parse_ws_pcdata; // TBD: | pugi::parse_comments
+    // lean parsing: drop the whitespace (indentation) between elements, but keep whitespace-only element text such as <t> </t>
+    constexpr const unsigned int pugi_lean_parse_settings = pugi::parse_default | pugi::parse_ws_pcdata_single;
 
     constexpr const bool XLForceOverwrite = true;    // readability constant for 2nd parameter of XLDocument::saveAs
     constexpr const bool XLDoNotOverwrite = false;   //  "
 
+    /**
+     * @brief The mode in which XLDocument::open opens a document
+     */
+    enum class XLOpenMode : uint8_t {
+        ReadWrite,    /**< Default: the document is prepared for editing and saving */
+        ReadOnly      /**< The document is only read: nothing is repaired or added, XML is parsed with
+                           pugi_lean_parse_settings, and save / saveAs throw */
+    };
+
+    /**
+     * @brief The stages reported to the progress callback of XLDocument::openAsync and XLDocument::saveAsync
+     */
+    enum class XLProgressStage : uint8_t {
+        Parse,        /**< An XML part was inflated from the archive and parsed */
+        Serialize,    /**< An XML part was serialized */
+        Compress      /**< The package was compressed and written to disk */
+    };
+
+    /**
+     * @brief A progress report of an asynchronous open or save
+     */
+    struct XLProgress
+    {
+        XLProgressStage stage;        /**< The stage the report belongs to */
+        std::string     part;         /**< The path of the part in the package, or the file name for XLProgressStage::Compress */
+        uint64_t        bytes;        /**< The size of the part's XML text, or the size of the written file */
+        size_t          partIndex;    /**< The number of parts of this stage processed so far, including this one */
+        size_t          partCount;    /**< The number of parts of this stage */
+    };
+
+    /**
+     * @brief The progress callback of XLDocument::openAsync and XLDocument::saveAsync
+     * @note The callback is called on the worker threads, one call at a time.
+     */
+    using XLProgressCallback = std::function<void(const XLProgress&)>;
+
+    /**
+     * @brief The outcome of an asynchronous operation that did not throw
+     */
+    enum class XLAsyncStatus : uint8_t {
+        Completed,    /**< The operation ran to completion */
+        Cancelled     /**< The operation was cancelled, see XLAsyncResult::cancel */
+    };
+
+    /**
+     * @brief A handle on an asynchronous XLDocument operation, similar to std::shared_future
+     */
+    class OPENXLSX_EXPORT XLAsyncResult
+    {
+        friend class XLDocument;
+
+    public:
+        /**
+         * @brief Default constructor: a handle without an operation
+         */
+        XLAsyncResult() = default;
+
+        /**
+         * @brief Test whether the handle refers to an operation
+         */
+        bool valid() const;
+
+        /**
+         * @brief Test whether the operation has finished, without blocking
+         */
+        bool ready() const;
+
+        /**
+         * @brief Block until the operation has finished
+         */
+        void wait() const;
+
+        /**
+         * @brief Block until the operation has finished, and get its outcome
+         * @return XLAsyncStatus::Completed or XLAsyncStatus::Cancelled
+         * @throw the exception thrown by the operation, if any
+         */
+        XLAsyncStatus get() const;
+
+        /**
+         * @brief Request the operation to stop at the next part boundary
+         * @details Cancellation is cooperative: an operation that is past its last check point (for saveAsync: once the package
+         *          is being compressed) completes normally, and get() returns XLAsyncStatus::Completed.
+         */
+        void cancel();
+
+    private:
+        XLAsyncResult(std::shared_future<XLAsyncStatus> future, std::shared_ptr<std::atomic<bool>> cancelFlag);
+
+        std::shared_future<XLAsyncStatus>  m_future {};    /**< The outcome of the operation */
+        std::shared_ptr<std::atomic<bool>> m_cancel {};    /**< Set by cancel(), polled by the operation */
+    };
+
+    /**
+     * @brief The memory held by one XML part of a document, see XLDocument::memoryUsage
+     */
+    struct XLPartMemoryUsage
+    {
+        std::string part;           /**< The path of the part in the package */
+        size_t      dom {0};        /**< The estimated size of the parsed DOM (see XLDocument::residentSize), 0 if not parsed */
+        size_t      spilled {0};    /**< The size of the compressed XML held for an evicted, modified part */
+    };
+
+    /**
+     * @brief The memory held by an open document, returned by XLDocument::memoryUsage
+     */
+    struct XLMemoryUsage
+    {
+        std::vector<XLPartMemoryUsage> parts {};    /**< The parts that hold memory, in package order */
+        size_t xmlParts {0};            /**< The sum of XLPartMemoryUsage::dom and XLPartMemoryUsage::spilled over all parts */
+        size_t zipEntries {0};          /**< The entry data cached by the zip archive, 0 for archives that do not report it */
+        size_t sharedStrings {0};       /**< The shared string cache */
+        size_t styles {0};              /**< The style objects and decoded tables, see XLStyles::memoryUsage */
+        size_t xmlArenaRetained {0};    /**< The unused XML pages retained for reuse, see XLDocument::xmlArenaRetainedSize */
+
+        /**
+         * @brief Get the sum of all categories
+         */
+        size_t total() const { return xmlParts + zipEntries + sharedStrings + styles + xmlArenaRetained; }
+    };
+
     /**
      * @brief The XLDocumentProperties class is an enumeration of the possible properties (metadata) that can be set
      * for a XLDocument object (and .xlsx file)
@@ -161,11 +294,13 @@ namespace OpenXLSX
         XLDocument& operator=(const XLDocument& other) = delete;
 
         /**
-         * @brief
+         * @brief Move assignment operator
          * @param other
          * @return
+         * @details An open document is closed first, so that its XML parts are released into its own XML arena before the
+         *          arena is replaced by the one of other
          */
-        XLDocument& operator=(XLDocument&& other) noexcept = default;
+        XLDocument& operator=(XLDocument&& other) noexcept;
 
         /**
          * @brief ensure that warnings are shown (default setting)
@@ -177,11 +312,118 @@ namespace OpenXLSX
          */
         void suppressWarnings();
 
+        /**
+         * @brief parse XML parts without the whitespace text nodes between elements (pugi_lean_parse_settings)
+         * @param lean true to enable lean parsing, false to restore the default (pugi_parse_settings)
+         * @details Indentation in pretty-printed parts from other producers otherwise becomes a DOM node between each pair of
+         *          elements, which roughly doubles the node count and has to be stepped over by every sibling traversal. With lean
+         *          parsing, a saved part loses its original indentation, and entries added to it are not indented either.
+         * @note The setting applies to XML parts parsed after the call, and is retained across close() / open() like the
+         *       warnings setting. Documents opened with XLOpenMode::ReadOnly are always parsed lean.
+         */
+        void setLeanXmlParsing(bool lean = true);
+
+        /**
+         * @brief limit the memory held by parsed worksheets
+         * @param bytes the budget for the estimated resident size of all parsed XML parts (see residentSize), 0 for no limit
+         * @details When a worksheet part is parsed and the budget is exceeded, the least recently used worksheets are evicted until
+         *          the total fits (or no evictable worksheet is left). In a read-write document, an evicted worksheet is serialized and
+         *          compressed in memory first, in a read-only document it is simply dropped. Either way, it is re-parsed transparently
+         *          on the next access. A worksheet is never evicted while an XLWorksheet / XLSheet object for it exists.
+         * @note The setting is retained across close() / open(). Setting a budget applies it immediately.
+         * @warning While a budget is set, cells, rows, ranges and iterators must not be used after the last XLWorksheet object
+         *          for their sheet has gone out of scope.
+         */
+        void setMemoryBudget(size_t bytes);
+
+        /**
+         * @brief get the memory budget set with setMemoryBudget
+         * @return the budget in bytes, 0 for no limit
+         */
+        size_t memoryBudget() const;
+
+        /**
+         * @brief get the estimated memory held by an XML part of the document
+         * @param path the path of the part in the archive, e.g. "xl/worksheets/sheet1.xml"
+         * @return the estimated size of the parsed DOM, the size of the compressed XML if the part was evicted with changes,
+         *         or 0 if the part is not in memory
+         * @throw XLInternalError if path is not a part of the document
+         */
+        size_t residentSize(const std::string& path) const;
+
+        /**
+         * @brief enable or disable the reuse of XML memory pages across close() / open() (see XLXmlArena)
+         * @param enable true (the default) to parse XML parts into pages of the document's arena, which are retained on close()
+         *        and reused by the next open(); false to use pugixml's allocation functions and free the retained pages
+         * @note The setting is retained across close() / open(). The retained pages are freed when the XLDocument is destroyed.
+         */
+        void setXmlArena(bool enable = true);
+
+        /**
+         * @brief get the size of the XML memory pages retained for reuse by this document
+         * @return the size in bytes of the unused pages held by the document's arena
+         */
+        size_t xmlArenaRetainedSize() const;
+
+        /**
+         * @brief get the memory held by the document
+         * @return the bytes held by each parsed (or evicted) XML part, the zip entry data cached by the archive, the shared string
+         *         cache, the style tables and the retained XML pages
+         * @details The DOM sizes are the estimates used by setMemoryBudget: pugixml does not report its page usage, so each parsed
+         *          part is measured by one pass over its nodes and attributes. The other figures are computed from the sizes and
+         *          capacities of the containers involved.
+         * @note Like any other access, the call must not overlap with modifications of the document.
+         */
+        XLMemoryUsage memoryUsage() const;
+
+        /**
+         * @brief get the phase timings and counters recorded since the document was opened (or since resetStats)
+         * @details Each inflate, parse, serialize, deflate and validate step is recorded with its part, duration and size, together
+         *          with the shared string lookups, row / cell node creations and parsed-part cache hits, see XLStats.
+         * @note The instrumentation is only compiled in with the CMake option OPENXLSX_ENABLE_STATS, otherwise the returned
+         *       statistics are empty (XLStats::enabled() returns false) and recording costs nothing.
+         */
+        XLStats stats() const;
+
+        /**
+         * @brief drop the recorded phase timings and restart the counters at zero
+         */
+        void resetStats();
+
         /**
          * @brief Open the .xlsx file with the given path
          * @param fileName The path of the .xlsx file to open
-         */
-        void open(const std::string& fileName);
+         * @param mode XLOpenMode::ReadOnly skips every write-oriented setup step: missing styles, shared strings and
+         *        document properties are not added to the package, the optional shared strings count attributes are kept,
+         *        app.xml is not aligned with the worksheets and worksheet column ranges are not split. XML parts are parsed
+         *        with pugi_lean_parse_settings (see setLeanXmlParsing), and save / saveAs throw an XLException.
+         * @note Concurrent read contract: a document opened with XLOpenMode::ReadOnly can be read from several threads at once,
+         *       each thread using its own XLWorksheet objects (obtained from workbook().worksheet() in that thread) and iterators.
+         *       XML parts are parsed once, under a per-part lock, on first access from any thread. Read paths do not modify the
+         *       document: cell() behaves like findCell(), row() returns an empty XLRow for a missing row,
+         *       column() does not split column ranges, and cell / row iterators never create nodes. Reads include cell values,
+         *       formulas, findCell, cell and row iteration (rows(), XLCellRange and its aggregates) and the shared strings.
+         *       Not covered: XLRow::cells() (use XLRow::values() or an XLCellRange instead), the lazily built XLStyles tables
+         *       (build them before starting the threads), and anything that writes. Document settings (memory budget, lean
+         *       parsing, XML arena) must not be changed while readers are running. With a memory budget, an evicted worksheet
+         *       is re-parsed on demand, and a worksheet is never evicted while a thread holds an XLWorksheet for it.
+         * @throw XLInputError if the document structure can not be read
+         */
+        void open(const std::string& fileName, XLOpenMode mode = XLOpenMode::ReadWrite);
+
+        /**
+         * @brief Open a new document as a fork of a template
+         * @param source The template to fork. The document keeps the template's package alive until it is closed.
+         * @details The parts the template has parsed are copied from its DOMs, and all other parts are read from the template's
+         *          in-memory package when first accessed. The new document has no file name: use saveAs to write it. Parts
+         *          that were never accessed are written with the template's compressed bytes, so the cost of saving a fork
+         *          grows with the parts it touched rather than with the size of the template.
+         * @note Forking only reads the template, so documents can be forked from the same template on several threads at once.
+         *       The archive passed to the constructor is set aside while the fork is open, and is used again by the next
+         *       open(const std::string&) or create().
+         * @throw XLInputError if source is not a valid template
+         */
+        void open(const XLTemplate& source);
 
         /**
          * @brief Create a new .xlsx file with the given name.
@@ -207,7 +449,7 @@ namespace OpenXLSX
 
         /**
          * @brief Save the current document using the current filename, overwriting the existing file.
-         * @throw XLException (OpenXLSX failed checks)
+         * @throw XLException (OpenXLSX failed checks, or the document is a template fork that was never saved with saveAs)
          * @throw ZipRuntimeError (zippy failed archive / file access)
          */
         void save();
@@ -229,6 +471,42 @@ namespace OpenXLSX
          */
         [[deprecated]] void saveAs(const std::string& fileName);
 
+        /**
+         * @brief Open a document on a background thread
+         * @param fileName The path of the .xlsx file to open
+         * @param mode The open mode, see open()
+         * @param progress Called for each parsed part (XLProgressStage::Parse)
+         * @return a handle on the operation
+         * @details Runs open(), then parses all worksheets and chartsheets up front, on several threads, so that the first access
+         *          to a sheet does not block. Without a memory budget only: with one, the sheets are parsed on access as usual.
+         *          If the operation is cancelled or throws, the document is closed. Until the operation has finished, the
+         *          document must not be used or moved (the destructor waits for it).
+         * @throw XLException if another asynchronous operation on this document is still running
+         */
+        XLAsyncResult openAsync(const std::string& fileName, XLOpenMode mode = XLOpenMode::ReadWrite, XLProgressCallback progress = {});
+
+        /**
+         * @brief Save the document on a background thread, using the current filename
+         * @param progress Called for each serialized part (XLProgressStage::Serialize), and once the file is written
+         *        (XLProgressStage::Compress)
+         * @return a handle on the operation
+         * @details See saveAsAsync
+         */
+        XLAsyncResult saveAsync(XLProgressCallback progress = {});
+
+        /**
+         * @brief Save the document with a new name on a background thread
+         * @param fileName The path of the file
+         * @param forceOverwrite If not true (XLForceOverwrite) and fileName exists, the operation throws
+         * @param progress See saveAsync
+         * @return a handle on the operation
+         * @details The modified parts are serialized on several threads (on one with a memory budget). A cancelled save leaves the
+         *          document and the file on disk as they were, apart from the calculation chain update (see saveAs). Until
+         *          the operation has finished, the document must not be used or moved (the destructor waits for it).
+         * @throw XLException if another asynchronous operation on this document is still running
+         */
+        XLAsyncResult saveAsAsync(const std::string& fileName, bool forceOverwrite, XLProgressCallback progress = {});
+
         /**
          * @brief Get the filename of the current document, e.g. "spreadsheet.xlsx".
          * @return A std::string with the filename.
@@ -281,6 +559,18 @@ namespace OpenXLSX
          */
         bool isOpen() const;
 
+        /**
+         * @brief determine whether the document was opened with XLOpenMode::ReadOnly
+         * @return true if the document is read-only
+         */
+        bool isReadOnly() const;
+
+        /**
+         * @brief get the pugixml parse options used to load the XML parts of this document
+         * @return pugi_lean_parse_settings for a read-only document or if lean parsing is enabled, otherwise pugi_parse_settings
+         */
+        unsigned int xmlParseOptions() const;
+
         /**
          * @brief return a handle on the workbook's styles
          * @return a reference to m_styles
@@ -392,6 +682,17 @@ namespace OpenXLSX
          */
         void cleanupSharedStrings();
 
+        /**
+         * @brief drop all cell formats and differential formats that are not referenced from any worksheet, together with the fonts, fills,
+         *        borders and number formats that are only used by them, and renumber the style references of all cells, rows, columns
+         *        and conditional formatting rules accordingly
+         * @note potentially time-intensive (on documents with many cells). Previously obtained style entry objects become invalid.
+         * @note if the document contains tables or pivot tables, which may reference differential formats, all differential formats are kept
+         * @note with a memory budget (see setMemoryBudget), all worksheets are held parsed for the duration of the call
+         * @throw XLException if the document was opened with XLOpenMode::ReadOnly
+         */
+        void compactStyles();
+
         //----------------------------------------------------------------------------------------------------------------------
         //           Protected Member Functions
         //----------------------------------------------------------------------------------------------------------------------
@@ -427,18 +728,120 @@ namespace OpenXLSX
          */
         bool hasXmlData(const std::string& path) const;
 
+        /**
+         * @brief append an XLXmlData object to m_data and register it in the path index
+         * @param args the XLXmlData constructor arguments
+         * @return a reference to the newly stored XLXmlData object
+         * @note m_data shall only grow through this function, so that lookups by path never scan the list
+         */
+        template<typename... Args>
+        XLXmlData& addXmlData(Args&&... args)
+        {
+            XLXmlData& xmlData = m_data.emplace_back(std::forward<Args>(args)...);
+            m_xmlDataIndex.emplace(xmlData.getXmlPath(), &xmlData);    // first entry for a path wins, as with the former linear search
+            if (xmlData.valid()) m_xmlDataByRoot.emplace(xmlData.m_xmlDoc->internal_object(), &xmlData);
+            return xmlData;
+        }
+
+        /**
+         * @brief remove the XLXmlData object for path from m_data and from the indexes
+         * @param path The relative path of the file.
+         * @return true if an object was removed, false if path was not managed
+         */
+        bool eraseXmlData(const std::string& path);
+
+        /**
+         * @brief bring xl/calcChain.xml in line with the formula cells of the workbook, so that it can be kept on save
+         * @details Worksheets that were never parsed can not have changed, and their chain entries are kept as they are. For each parsed
+         *  worksheet, one sweep over sheetData collects the formula cells: chain entries for cells that no longer hold a formula are
+         *  dropped (in the existing calculation order), and formula cells without an entry are appended. Entries for deleted worksheets
+         *  are dropped. A missing or unreadable chain is rebuilt from all worksheets, and a chain without entries is removed.
+         */
+        void updateCalcChain();
+
+        /**
+         * @brief evict least recently used worksheet parts until the parsed parts fit into m_memoryBudget
+         * @param keep a part that must stay loaded (the one that was just parsed)
+         * @note While a BudgetHold exists, the parts used since the outermost one was created are not evicted either
+         */
+        void enforceMemoryBudget(const XLXmlData* keep);
+
+        /**
+         * @brief Keeps the parts that are used during an internal whole-document operation from being evicted until it is done
+         * @details pin() only protects parts referred to by an XLXmlFile object. An operation that sweeps m_data and keeps DOM
+         *  handles of one part while further parts are loaded must create a hold for its duration. Holds nest: the memory budget
+         *  is enforced again when the outermost hold is destroyed.
+         */
+        class BudgetHold
+        {
+        public:
+            explicit BudgetHold(XLDocument& document);
+            ~BudgetHold();
+            BudgetHold(const BudgetHold&)            = delete;
+            BudgetHold& operator=(const BudgetHold&) = delete;
+
+        private:
+            XLDocument& m_document;
+        };
+
+        /**
+         * @brief get the arena to parse XML parts into
+         * @return the document's arena, or nullptr if setXmlArena(false) was called
+         */
+        XLXmlArena* xmlArena() const;
+
+        /**
+         * @brief the implementation of saveAs and saveAsAsync
+         * @param threads the number of threads to serialize the parts with
+         * @return XLAsyncStatus::Cancelled if cancel was set before the package was written
+         */
+        XLAsyncStatus saveParts(const std::string&        fileName,
+                                bool                      forceOverwrite,
+                                const XLProgressCallback& progress,
+                                const std::atomic<bool>&  cancel,
+                                unsigned                  threads);
+
+        /**
+         * @brief run operation on a background thread, and register it as the pending operation of this document
+         */
+        XLAsyncResult startAsync(std::function<XLAsyncStatus(const std::atomic<bool>&)> operation);
+
         //----------------------------------------------------------------------------------------------------------------------
         //           Private Member Variables
         //----------------------------------------------------------------------------------------------------------------------
 
     private:
+        /**
+         * @brief The state shared by concurrent readers, see the concurrent read contract of open()
+         */
+        struct SyncState
+        {
+            std::mutex            archive {};     /**< Serializes the extraction of XML parts from m_archive */
+            std::mutex            budget {};      /**< Serializes enforceMemoryBudget */
+            std::atomic<uint64_t> useCount {0};   /**< Access counter for the least recently used eviction */
+            unsigned              holdDepth {0};  /**< The number of existing BudgetHold objects, guarded by budget */
+            uint64_t              holdStart {0};  /**< The first useCount value protected by the outermost BudgetHold */
+        };
+
         bool m_suppressWarnings {true}; /**< If true, will suppress output of warnings where supported */
+        bool m_leanXmlParsing {false};  /**< If true, XML parts are parsed with pugi_lean_parse_settings */
+        XLOpenMode   m_openMode {XLOpenMode::ReadWrite};            /**< The mode the current document was opened with */
+        unsigned int m_xmlParseOptions {pugi_parse_settings};       /**< The pugixml parse options for the XML parts */
+        size_t       m_memoryBudget {0};                            /**< The limit for the resident size of parsed parts, 0 = none */
 
         std::string m_filePath {};      /**< The path to the original file*/
 
+        bool                        m_xmlArenaEnabled {true};                             /**< If false, m_xmlArena is bypassed */
+        std::unique_ptr<XLXmlArena> m_xmlArena {std::make_unique<XLXmlArena>()};          /**< Must be declared before m_data, which it outlives (see operator=) */
+        std::unique_ptr<SyncState>  m_sync {std::make_unique<SyncState>()};               /**< Held by pointer so that XLDocument remains movable */
+        std::shared_future<XLAsyncStatus> m_pendingAsync {};                              /**< The last asynchronous operation, awaited by the destructor */
+        std::unique_ptr<XLStatsCollector> m_stats {std::make_unique<XLStatsCollector>()}; /**< The instrumentation, see stats() */
+
         XLXmlSavingDeclaration m_xmlSavingDeclaration;  /**< The xml saving declaration that will be passed to pugixml before generating the XML output data*/
 
         mutable std::list<XLXmlData>    m_data {};              /**<  */
+        std::unordered_map<std::string, XLXmlData*> m_xmlDataIndex {}; /**< m_data items by XML path - std::list keeps item addresses stable */
+        std::unordered_map<const void*, XLXmlData*> m_xmlDataByRoot {}; /**< m_data items by the root of their XML document, see QueryXmlDataOfNode */
         mutable std::deque<std::string> m_sharedStringCache {}; /**<  */
         mutable XLSharedStrings         m_sharedStrings {};     /**<  */
 
@@ -450,6 +853,7 @@ namespace OpenXLSX
         XLStyles        m_styles {};           /**< A pointer to the document styles object*/
         XLWorkbook      m_workbook {};         /**< A pointer to the workbook object */
         IZipArchive     m_archive {};          /**<  */
+        std::unique_ptr<IZipArchive> m_fileArchive {}; /**< The archive set aside while a template fork is open, see open(const XLTemplate&) */
     };
 
 
@@ -271,6 +271,7 @@ namespace OpenXLSX
 
     class OPENXLSX_EXPORT XLShape {
         friend class XLVmlDrawing;    // for access to m_shapeNode in XLVmlDrawing::addShape
+        friend class XLComments;      // for access to m_shapeNode when indexing shapes created by XLComments::set
     public:    // ---------- Public Member Functions ---------- //
         /**
          * @brief
@@ -412,6 +413,7 @@ namespace OpenXLSX
         XMLNode firstShapeNode() const;
         XMLNode lastShapeNode() const;
         XMLNode shapeNode(uint32_t index) const;
+        bool deleteShapeNode(XMLNode node);
 
     public:
 
@@ -54,6 +54,7 @@ YM      M9  MM    MM MM       MM    MM   d'  `MM.    MM            MM   d'  `MM.
 
 // ===== External Includes ===== //
 #include <iostream>
+#include <memory>
 #include <string>
 #include <variant>
 #include <cstdint>
@@ -79,6 +80,7 @@ namespace OpenXLSX
     //---------- Forward Declarations ----------//
     class XLFormulaProxy;
     class XLCell;
+    struct XLSharedFormulaCache;
 
     /**
      * @brief The XLFormula class encapsulates the concept of an Excel formula. The class is essentially
@@ -368,6 +370,12 @@ namespace OpenXLSX
          *        Shared formulas are expanded to the actual formula for this cell.
          */
         XLFormula getFormula() const;
+
+        /**
+         * @brief Get the shared formula master table of the worksheet that holds the cell
+         * @return the table, which is held by the XLXmlData of the worksheet - or nullptr for a cell that is not part of a document
+         */
+        std::shared_ptr<XLSharedFormulaCache> sharedFormulaCache() const;
 
         //---------- Private Member Variables ---------- //
         XLCell*  m_cell;     /**< Pointer to the owning XLCell object. */
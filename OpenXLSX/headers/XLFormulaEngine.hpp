@@ -0,0 +1,162 @@
+/*
+
+   ____                               ____      ___ ____       ____  ____      ___
+  6MMMMb                              `MM(      )M' `MM'      6MMMMb\`MM(      )M'
+ 8P    Y8                              `MM.     d'   MM      6M'    ` `MM.     d'
+6M      Mb __ ____     ____  ___  __    `MM.   d'    MM      MM        `MM.   d'
+MM      MM `M6MMMMb   6MMMMb `MM 6MMb    `MM. d'     MM      YM.        `MM. d'
+MM      MM  MM'  `Mb 6M'  `Mb MMM9 `Mb    `MMd       MM       YMMMMb     `MMd
+MM      MM  MM    MM MM    MM MM'   MM     dMM.      MM           `Mb     dMM.
+MM      MM  MM    MM MMMMMMMM MM    MM    d'`MM.     MM            MM    d'`MM.
+YM      M9  MM    MM MM       MM    MM   d'  `MM.    MM            MM   d'  `MM.
+ 8b    d8   MM.  ,M9 YM    d9 MM    MM  d'    `MM.   MM    / L    ,M9  d'    `MM.
+  YMMMM9    MMYMMM9   YMMMM9 _MM_  _MM_M(_    _)MM_ _MMMMMMM MYMMMM9 _M(_    _)MM_
+            MM
+            MM
+           _MM_
+
+  Copyright (c) 2018, Kenneth Troldal Balslev
+
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+  - Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+  - Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+  - Neither the name of the author nor the
+    names of any contributors may be used to endorse or promote products
+    derived from this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+  DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+  DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+  ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ */
+
+#ifndef OPENXLSX_XLFORMULAENGINE_HPP
+#define OPENXLSX_XLFORMULAENGINE_HPP
+
+#ifdef _MSC_VER    // conditionally enable MSVC specific pragmas to avoid other compilers warning about unknown pragmas
+#   pragma warning(push)
+#   pragma warning(disable : 4251)
+#   pragma warning(disable : 4275)
+#endif // _MSC_VER
+
+// ===== External Includes ===== //
+#include <cstddef>    // size_t
+#include <memory>     // std::unique_ptr
+#include <string>
+
+// ===== OpenXLSX Includes ===== //
+#include "OpenXLSX-Exports.hpp"
+#include "XLCellValue.hpp"
+
+namespace OpenXLSX
+{
+    class XLDocument;
+
+    /**
+     * @brief The XLFormulaEngine class evaluates the formulas of a workbook and writes the results into the cached cell values (<v>),
+     *  so that documents carry up-to-date results without being opened in a spreadsheet application.
+     * @details On construction, all worksheets are swept once: each formula is compiled into a postfix program, and the cells and ranges
+     *  it reads are entered into a dependency graph (across worksheets). Shared formulas are compiled once per master and shifted for the
+     *  dependent cells. recalculateAll() evaluates every formula; recalculate() only evaluates the formulas that depend, directly or
+     *  indirectly, on cells changed through setValue, setFormula or markDirty since the last calculation. Formulas are evaluated in
+     *  dependency order and formulas on a circular reference evaluate to 0, as Excel does without iterative calculation.
+     *
+     *  Supported are number, string, boolean and error constants, cell and range references (also to other worksheets and whole columns
+     *  like A:A), the operators + - * / ^ & % = <> < <= > >= and the functions SUM, AVERAGE, MIN, MAX, COUNT, IF, VLOOKUP, INDEX and MATCH.
+     *  Formulas using anything else (other functions, defined names, array formulas) are left untouched: their cached value is kept and
+     *  used by the formulas that depend on them.
+     * @warning The engine keeps handles to the worksheet XML. Cell edits made while an engine exists should go through setValue and
+     *  setFormula, or be announced with markDirty, so that the dependency graph sees them. Worksheets added after construction are not known.
+     */
+    class OPENXLSX_EXPORT XLFormulaEngine
+    {
+    public:
+        /**
+         * @brief Constructor. Compiles all formulas of the document's worksheets and builds the dependency graph.
+         * @param document the open document to evaluate - must outlive the engine
+         */
+        explicit XLFormulaEngine(XLDocument& document);
+
+        /**
+         * @brief Destructor
+         */
+        ~XLFormulaEngine();
+
+        /**
+         * @brief The engine holds a dependency graph that can not be shared
+         */
+        XLFormulaEngine(const XLFormulaEngine& other)            = delete;
+        XLFormulaEngine& operator=(const XLFormulaEngine& other) = delete;
+
+        /**
+         * @brief Move constructor and assignment
+         */
+        XLFormulaEngine(XLFormulaEngine&& other) noexcept;
+        XLFormulaEngine& operator=(XLFormulaEngine&& other) noexcept;
+
+        /**
+         * @brief get the amount of formulas the engine evaluates
+         * @return the count of compiled formula cells, not including formulas that are left untouched
+         */
+        size_t formulaCount() const;
+
+        /**
+         * @brief set a cell value and mark the formulas depending on the cell for recalculation
+         * @param sheetName the worksheet name
+         * @param cellRef the cell address, e.g. B3
+         * @param value the new value - a formula in the cell is removed
+         */
+        void setValue(const std::string& sheetName, const std::string& cellRef, const XLCellValue& value);
+
+        /**
+         * @brief set a cell formula, compile it and mark it and the formulas depending on the cell for recalculation
+         * @param sheetName the worksheet name
+         * @param cellRef the cell address, e.g. B3
+         * @param formula the formula, without leading '='
+         */
+        void setFormula(const std::string& sheetName, const std::string& cellRef, const std::string& formula);
+
+        /**
+         * @brief announce a cell that was modified directly (e.g. through XLCell::value() or XLCell::formula()): re-reads its formula, if
+         *  any, and marks it and the formulas depending on it for recalculation
+         * @param sheetName the worksheet name
+         * @param cellRef the cell address, e.g. B3
+         */
+        void markDirty(const std::string& sheetName, const std::string& cellRef);
+
+        /**
+         * @brief evaluate the formulas affected by the changes since the last calculation and write their results to the cells
+         * @return the count of evaluated formulas
+         */
+        size_t recalculate();
+
+        /**
+         * @brief evaluate all formulas and write their results to the cells
+         * @return the count of evaluated formulas
+         */
+        size_t recalculateAll();
+
+    private:
+        class Impl;
+        std::unique_ptr<Impl> m_impl; /**< the compiled formulas and the dependency graph */
+    };
+}    // namespace OpenXLSX
+
+#ifdef _MSC_VER    // conditionally enable MSVC specific pragmas to avoid other compilers warning about unknown pragmas
+#   pragma warning(pop)
+#endif // _MSC_VER
+
+#endif    // OPENXLSX_XLFORMULAENGINE_HPP
@@ -52,13 +52,16 @@ YM      M9  MM    MM MM       MM    MM   d'  `MM.    MM            MM   d'  `MM.
 #   pragma warning(disable : 4275)
 #endif // _MSC_VER
 
-#include <deque>
 #include <limits>     // std::numeric_limits
+#include <map>        // std::map
 #include <memory>     // std::unique_ptr
 #include <ostream>    // std::basic_ostream
+#include <set>        // std::set
 #include <string>
-#include <string_view>  // std::string_view
-#include <vector>       // std::vector
+#include <string_view>    // std::string_view
+#include <unordered_map>  // std::unordered_map
+#include <utility>        // std::pair
+#include <vector>         // std::vector
 
 // ===== OpenXLSX Includes ===== //
 #include "OpenXLSX-Exports.hpp"
@@ -78,6 +81,10 @@ namespace OpenXLSX
      * (empty) <mergeCell> elements within that array, with a sole attribute ref="..." with ... being a range reference, e.g. A1:B5
      * Unfortunately, since an empty <mergeCells> element is not allowed, the class must have access to the worksheet root node and
      *  delete the <mergeCells> element each time the merge count is zero
+     * @note Merges are kept by a stable id in document order, and indexed as parsed rectangles in segment trees over the rows and
+     *  columns: as merges never overlap, the merges stored at one tree node form a set of disjoint intervals, so that cell lookups,
+     *  overlap checks, appends and deletes take a logarithmic number of std::map operations, independent of the merge sizes.
+     *  A Fenwick tree over the stable ids translates between ids and merge indexes, so that deleting a merge needs no renumbering.
      */
     class OPENXLSX_EXPORT XLMergeCells
     {
@@ -202,10 +209,72 @@ namespace OpenXLSX
         void print(std::basic_ostream<char>& ostr) const;
 
     private:
+        /**
+         * @brief the parsed rectangle of a merge reference
+         */
+        struct XLMergeRange
+        {
+            uint32_t topRow;
+            uint16_t firstCol;
+            uint32_t bottomRow;
+            uint16_t lastCol;
+        };
+
+        /**
+         * @brief a merge: its reference, parsed rectangle and <mergeCell> element
+         */
+        struct XLMergeEntry
+        {
+            std::string  reference;
+            XLMergeRange range;
+            XMLNode      node;
+        };
+
+        /**
+         * @brief an interval of a merge stored at a segment tree node - the first row or column of the interval is the map key
+         */
+        struct XLMergeSpan
+        {
+            uint32_t last;    /**< the last row or column of the interval */
+            uint32_t mergeId; /**< the stable id of the merge */
+        };
+        using XLMergeSpans = std::map<uint32_t, XLMergeSpan>;
+
+        /**
+         * @brief find a merge that overlaps with range
+         * @return the stable id of the first overlapping merge found, or XLMergeNoId if range does not overlap any merge
+         */
+        uint32_t findOverlap(const XLMergeRange& range) const;
+
+        /**
+         * @brief add range to, or remove range from, the segment trees
+         */
+        void indexMerge(const XLMergeRange& range, uint32_t mergeId);
+        void unindexMerge(const XLMergeRange& range, uint32_t mergeId);
+
+        /**
+         * @brief add a merge with the next stable id to m_merges and to the id ranks, and index its range
+         */
+        void insertMerge(const std::string& reference, const XLMergeRange& range, const XMLNode& node);
+
+        /**
+         * @brief translate a stable merge id into the current merge index, and vice versa
+         */
+        XLMergeIndex mergePosition(uint32_t mergeId) const;
+        uint32_t     mergeIdAt(XLMergeIndex index) const;
+
+        static constexpr uint32_t XLMergeNoId = (std::numeric_limits< uint32_t >::max)();
+
         std::unique_ptr<XMLNode> m_rootNode;         /**< An XMLNode object with the worksheet root node (document element) */
         std::vector< std::string_view > m_nodeOrder; /**< worksheet XML root node required child sequence as passed into constructor */
         std::unique_ptr<XMLNode> m_mergeCellsNode; /**< An XMLNode object with the mergeCells item */
-        std::deque<std::string> m_referenceCache;
+        std::map<uint32_t, XLMergeEntry> m_merges;   /**< all merges by stable id - ids ascend in document order */
+        std::vector<uint32_t> m_mergeRanks;          /**< Fenwick tree over the stable ids, counting the ids still in use */
+        uint32_t m_nextMergeId {0};                  /**< the id to assign to the next appended merge */
+        std::unordered_map<uint32_t, XLMergeSpans> m_rowTree;    /**< row tree node -> column spans of the merges covering its rows */
+        std::unordered_map<uint32_t, XLMergeSpans> m_columnTree; /**< column tree node -> row spans of the merges covering its columns */
+        std::unordered_map<uint32_t, std::set< std::pair<uint32_t, uint32_t> > > m_cornerTree; /**< column tree node -> (top row, id)
+                                                                                                     of the merges starting in its columns */
     };
 }    // namespace OpenXLSX
 
@@ -409,6 +409,7 @@ namespace OpenXLSX
         static constexpr const int XLLoaded     = 2;    //   "
         int                      m_currentRowStatus;    /**< Status of m_currentRow: XLNotLoaded, XLNoSuchRow or XLLoaded */
         uint32_t                 m_currentRowNumber;
+        bool                     m_readOnly;             /**< If true, missing rows are never created (see XLOpenMode::ReadOnly) */
     };
 
     /**
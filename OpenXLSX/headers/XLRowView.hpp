@@ -0,0 +1,259 @@
+/*
+
+   ____                               ____      ___ ____       ____  ____      ___
+  6MMMMb                              `MM(      )M' `MM'      6MMMMb\`MM(      )M'
+ 8P    Y8                              `MM.     d'   MM      6M'    ` `MM.     d'
+6M      Mb __ ____     ____  ___  __    `MM.   d'    MM      MM        `MM.   d'
+MM      MM `M6MMMMb   6MMMMb `MM 6MMb    `MM. d'     MM      YM.        `MM. d'
+MM      MM  MM'  `Mb 6M'  `Mb MMM9 `Mb    `MMd       MM       YMMMMb     `MMd
+MM      MM  MM    MM MM    MM MM'   MM     dMM.      MM           `Mb     dMM.
+MM      MM  MM    MM MMMMMMMM MM    MM    d'`MM.     MM            MM    d'`MM.
+YM      M9  MM    MM MM       MM    MM   d'  `MM.    MM            MM   d'  `MM.
+ 8b    d8   MM.  ,M9 YM    d9 MM    MM  d'    `MM.   MM    / L    ,M9  d'    `MM.
+  YMMMM9    MMYMMM9   YMMMM9 _MM_  _MM_M(_    _)MM_ _MMMMMMM MYMMMM9 _M(_    _)MM_
+            MM
+            MM
+           _MM_
+
+  Copyright (c) 2018, Kenneth Troldal Balslev
+
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+  - Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+  - Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+  - Neither the name of the author nor the
+    names of any contributors may be used to endorse or promote products
+    derived from this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+  DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+  DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+  ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ */
+
+#ifndef OPENXLSX_XLROWVIEW_HPP
+#define OPENXLSX_XLROWVIEW_HPP
+
+#ifdef _MSC_VER    // conditionally enable MSVC specific pragmas to avoid other compilers warning about unknown pragmas
+#   pragma warning(push)
+#   pragma warning(disable : 4251)
+#   pragma warning(disable : 4275)
+#endif // _MSC_VER
+
+// ===== External Includes ===== //
+#include <cstdint>
+#include <iterator>
+#include <mutex>
+
+// ===== OpenXLSX Includes ===== //
+#include "OpenXLSX-Exports.hpp"
+#include "XLCellValue.hpp"
+#include "XLSharedStrings.hpp"
+#include "XLXmlParser.hpp"
+
+namespace OpenXLSX
+{
+    class XLRowView;
+    class XLWorksheet;
+
+    /**
+     * @brief How the rows handed out by XLWorksheet::parallelForRows may be accessed
+     */
+    enum class XLParallelMode : uint8_t {
+        Read,            /**< The rows are only read */
+        UpdateValues     /**< Existing cells may be given new numeric / boolean values with XLCellView::setValue */
+    };
+
+    /**
+     * @brief A lightweight view on an existing cell, handed out by XLRowView
+     * @details Unlike XLCell, an XLCellView does not allocate: it holds the cell node and a pointer to its row view. The typed
+     *  getters read the XML text directly, XLCellView::value is provided for convenience and allocates for string values.
+     *  A view on a missing cell is empty() and reads as XLValueType::Empty.
+     */
+    class OPENXLSX_EXPORT XLCellView
+    {
+        friend class XLRowView;
+
+    public:
+        /**
+         * @brief Default constructor: an empty view
+         */
+        XLCellView() = default;
+
+        /**
+         * @brief Test whether the view refers to an existing cell
+         * @return true if the cell does not exist
+         */
+        bool empty() const { return m_cellNode.empty(); }
+
+        /**
+         * @brief Get the row number of the cell
+         */
+        uint32_t row() const;
+
+        /**
+         * @brief Get the column number of the cell
+         */
+        uint16_t column() const { return m_column; }
+
+        /**
+         * @brief Get the value type of the cell, with the same rules as XLCellValueProxy::type
+         */
+        XLValueType type() const;
+
+        /**
+         * @brief Get the value of an Integer or Float cell
+         * @throw XLValueTypeError if the cell is not numeric
+         */
+        double number() const;
+
+        /**
+         * @brief Get the value of a Boolean cell
+         * @throw XLValueTypeError if the cell is not a boolean
+         */
+        bool boolean() const;
+
+        /**
+         * @brief Get the text of a String cell (shared, inline or formula string)
+         * @return a pointer into the shared strings table or the worksheet XML, valid as long as the cell is not modified
+         * @throw XLValueTypeError if the cell is not a string
+         */
+        const char* text() const;
+
+        /**
+         * @brief Get the value of the cell as an XLCellValue
+         * @note This allocates for string values, prefer the typed getters in tight loops
+         */
+        XLCellValue value() const;
+
+        /**
+         * @brief Assign a new value to the cell, in a parallelForRows call with XLParallelMode::UpdateValues
+         * @param value an Integer, Float or Boolean value
+         * @details Only the value of the cell is replaced: no row or cell nodes are inserted, and the shared strings table is not
+         *  touched. Because pugixml manages the string storage of a document in a single allocator, the update itself is
+         *  serialized with the other workers; reading, computing and locating cells is not.
+         * @throw XLException if the view is not writable or the cell does not exist
+         * @throw XLInputError if value is not numeric or boolean
+         */
+        void setValue(const XLCellValue& value);
+
+    private:
+        /**
+         * @brief Constructor used by XLRowView
+         */
+        XLCellView(const XMLNode& cellNode, uint16_t column, const XLRowView* row) : m_cellNode(cellNode), m_column(column), m_row(row) {}
+
+        XMLNode          m_cellNode {};      /**< The <c> node, empty if the cell does not exist */
+        uint16_t         m_column {0};       /**< The column number of the cell */
+        const XLRowView* m_row {nullptr};    /**< The row the view was obtained from */
+    };
+
+    /**
+     * @brief A lightweight view on an existing row, handed to the function called by XLWorksheet::parallelForRows
+     * @details The view gives access to the cells of the row, by column number or by iterating over the existing cells, without
+     *  allocating and without creating nodes. Lookups by column continue from the previously found cell, so that columns are
+     *  found in a single pass when they are requested in ascending order.
+     */
+    class OPENXLSX_EXPORT XLRowView
+    {
+        friend class XLCellView;
+        friend class XLWorksheet;
+
+    public:
+        /**
+         * @brief Forward iterator over the existing cells of a row
+         */
+        class OPENXLSX_EXPORT Iterator
+        {
+        public:
+            using iterator_category = std::forward_iterator_tag;
+            using value_type        = XLCellView;
+            using difference_type   = int64_t;
+            using pointer           = const XLCellView*;
+            using reference         = const XLCellView&;
+
+            Iterator() = default;
+            reference operator*() const { return m_cell; }
+            pointer   operator->() const { return &m_cell; }
+            Iterator& operator++();
+            Iterator  operator++(int)
+            {
+                Iterator previous = *this;
+                ++(*this);
+                return previous;
+            }
+            bool operator==(const Iterator& other) const { return m_cell.m_cellNode == other.m_cell.m_cellNode; }
+            bool operator!=(const Iterator& other) const { return not(*this == other); }
+
+        private:
+            friend class XLRowView;
+            explicit Iterator(const XLCellView& cell) : m_cell(cell) {}
+            XLCellView m_cell {};
+        };
+
+        /**
+         * @brief Get the row number
+         */
+        uint32_t rowNumber() const { return m_rowNumber; }
+
+        /**
+         * @brief Get the cell in the given column
+         * @param column the column number
+         * @return a view on the cell, empty if the cell does not exist
+         */
+        XLCellView cell(uint16_t column) const;
+
+        /**
+         * @brief Get the column number of the last cell of the row
+         * @return 0 if the row has no cells
+         */
+        uint16_t cellCount() const;
+
+        /**
+         * @brief Iterate over the existing cells of the row, in column order
+         */
+        Iterator begin() const;
+        Iterator end() const { return Iterator(); }
+
+    private:
+        /**
+         * @brief Constructor used by XLWorksheet::parallelForRows
+         * @param writeMutex the lock serializing value updates, nullptr for a read-only view
+         */
+        XLRowView(const XMLNode& rowNode, uint32_t rowNumber, const XLSharedStrings* sharedStrings, std::mutex* writeMutex)
+            : m_rowNode(rowNode),
+              m_rowNumber(rowNumber),
+              m_sharedStrings(sharedStrings),
+              m_writeMutex(writeMutex)
+        {}
+
+        /**
+         * @brief Make a view on a cell node whose predecessor has the column number previousColumn
+         */
+        XLCellView makeCell(const XMLNode& cellNode, uint16_t previousColumn) const;
+
+        XMLNode                m_rowNode {};                /**< The <row> node */
+        uint32_t               m_rowNumber {0};             /**< The row number */
+        const XLSharedStrings* m_sharedStrings {nullptr};   /**< The shared strings of the document */
+        std::mutex*            m_writeMutex {nullptr};      /**< Serializes value updates, nullptr for XLParallelMode::Read */
+        mutable XLCellView     m_hint {};                   /**< The cell found by the previous call to cell() */
+    };
+}    // namespace OpenXLSX
+
+#ifdef _MSC_VER    // conditionally enable MSVC specific pragmas to avoid other compilers warning about unknown pragmas
+#   pragma warning(pop)
+#endif // _MSC_VER
+
+#endif    // OPENXLSX_XLROWVIEW_HPP
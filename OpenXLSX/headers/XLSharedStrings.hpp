@@ -80,6 +80,7 @@ namespace OpenXLSX
     {
         //---------- Friend Declarations ----------//
         friend class XLDocument; // for access to protected function rewriteXmlFromCache
+        friend class XLFormulaProxy; // for access to protected function parentDoc, to find the worksheet of a cell
 
         //----------------------------------------------------------------------------------------------------------------------
         //           Public Member Functions
@@ -54,6 +54,7 @@ YM      M9  MM    MM MM       MM    MM   d'  `MM.    MM            MM   d'  `MM.
 
 // ===== External Includes ===== //
 #include <cstdint>      // uint8_t, uint16_t, uint32_t
+#include <functional>   // std::function
 #include <ostream>      // std::basic_ostream
 #include <string_view>  // std::string_view
 #include <type_traits>
@@ -73,6 +74,7 @@ YM      M9  MM    MM MM       MM    MM   d'  `MM.    MM            MM   d'  `MM.
 #include "XLException.hpp"
 #include "XLMergeCells.hpp"
 #include "XLRow.hpp"
+#include "XLRowView.hpp" // XLRowView, XLParallelMode
 #include "XLStyles.hpp"   // XLStyleIndex
 #include "XLTables.hpp"   // XLTables
 #include "XLXmlFile.hpp"
@@ -864,6 +866,7 @@ namespace OpenXLSX
     class OPENXLSX_EXPORT XLWorksheet final : public XLSheetBase<XLWorksheet>
     {
         friend class XLCell;
+        friend class XLFormulaEngine;
         friend class XLRow;
         friend class XLWorkbook;
         friend class XLSheetBase<XLWorksheet>;
@@ -1030,6 +1033,29 @@ namespace OpenXLSX
          */
         XLRowRange rows(uint32_t firstRow, uint32_t lastRow) const;
 
+        /**
+         * @brief Call a function for each existing row of a row band, on several threads
+         * @param firstRow the first row of the band
+         * @param lastRow the last row of the band
+         * @param fn the function to call, once per existing row node (missing rows are skipped). It is called concurrently from
+         *        the worker threads, for disjoint rows.
+         * @param threads the number of threads to use, including the calling thread. 0 uses std::thread::hardware_concurrency()
+         * @param mode XLParallelMode::Read (default) for read-only access, XLParallelMode::UpdateValues to allow assigning
+         *        numeric / boolean values to existing cells with XLCellView::setValue
+         * @details The sheet is parsed and the row nodes of the band are indexed in a single pass before any worker starts. The
+         *          index is then handed out in blocks of consecutive rows, so that a worker that gets cheap rows takes more
+         *          blocks. Each row is passed as an XLRowView, which does not allocate and never creates nodes. The function
+         *          must not use other accessors of the worksheet (cell(), row(), iterators, ...) that may modify the document.
+         *          If fn throws, the remaining blocks are skipped and the first exception is rethrown after all workers finished.
+         * @throw XLInputError if the row numbers are invalid
+         * @throw XLException if mode is XLParallelMode::UpdateValues and the document is read-only
+         */
+        void parallelForRows(uint32_t                               firstRow,
+                             uint32_t                               lastRow,
+                             const std::function<void(XLRowView&)>& fn,
+                             unsigned                               threads = 0,
+                             XLParallelMode                         mode    = XLParallelMode::Read) const;
+
         /**
          * @brief Get the row with the given row number.
          * @param rowNumber The number of the row to retrieve.
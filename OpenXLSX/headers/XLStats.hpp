@@ -0,0 +1,242 @@
+/*
+
+   ____                               ____      ___ ____       ____  ____      ___
+  6MMMMb                              `MM(      )M' `MM'      6MMMMb\`MM(      )M'
+ 8P    Y8                              `MM.     d'   MM      6M'    ` `MM.     d'
+6M      Mb __ ____     ____  ___  __    `MM.   d'    MM      MM        `MM.   d'
+MM      MM `M6MMMMb   6MMMMb `MM 6MMb    `MM. d'     MM      YM.        `MM. d'
+MM      MM  MM'  `Mb 6M'  `Mb MMM9 `Mb    `MMd       MM       YMMMMb     `MMd
+MM      MM  MM    MM MM    MM MM'   MM     dMM.      MM           `Mb     dMM.
+MM      MM  MM    MM MMMMMMMM MM    MM    d'`MM.     MM            MM    d'`MM.
+YM      M9  MM    MM MM       MM    MM   d'  `MM.    MM            MM   d'  `MM.
+ 8b    d8   MM.  ,M9 YM    d9 MM    MM  d'    `MM.   MM    / L    ,M9  d'    `MM.
+  YMMMM9    MMYMMM9   YMMMM9 _MM_  _MM_M(_    _)MM_ _MMMMMMM MYMMMM9 _M(_    _)MM_
+            MM
+            MM
+           _MM_
+
+  Copyright (c) 2018, Kenneth Troldal Balslev
+
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+  - Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+  - Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+  - Neither the name of the author nor the
+    names of any contributors may be used to endorse or promote products
+    derived from this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+  DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+  DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+  ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ */
+
+#ifndef OPENXLSX_XLSTATS_HPP
+#define OPENXLSX_XLSTATS_HPP
+
+#ifdef _MSC_VER    // conditionally enable MSVC specific pragmas to avoid other compilers warning about unknown pragmas
+#   pragma warning(push)
+#   pragma warning(disable : 4251)
+#   pragma warning(disable : 4275)
+#endif // _MSC_VER
+
+// ===== External Includes ===== //
+#include <array>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// ===== OpenXLSX Includes ===== //
+#include "OpenXLSX-Exports.hpp"
+
+namespace OpenXLSX
+{
+    /**
+     * @brief The phases of opening and saving a document that are timed by the instrumentation, see XLDocument::stats()
+     */
+    enum class XLStatsPhase : uint8_t {
+        Cleanup,      /**< The shared strings were rewritten by cleanupSharedStrings, or the calculation chain was updated by a save */
+        Inflate,      /**< An XML part was extracted (decompressed) from the archive */
+        Parse,        /**< An XML part was parsed into a DOM */
+        Serialize,    /**< An XML part was serialized to text for saving */
+        Deflate,      /**< The package was compressed and written (or an evicted part was compressed in memory) */
+        Validate      /**< The written package was validated and reopened by the zip archive */
+    };
+
+    constexpr const size_t XLStatsPhaseCount = 6;    // the number of XLStatsPhase values
+
+    /**
+     * @brief Get the name of a phase, as used in the Chrome trace output
+     */
+    OPENXLSX_EXPORT const char* XLStatsPhaseName(XLStatsPhase phase);
+
+    /**
+     * @brief The accumulated time and size of one phase
+     */
+    struct XLPhaseStats
+    {
+        uint64_t nanoseconds {0};    /**< The wall clock time spent in the phase */
+        uint64_t bytes {0};          /**< The size of the XML text (or, for XLStatsPhase::Deflate of the package, the file) processed */
+        uint64_t count {0};          /**< The number of times the phase ran */
+    };
+
+    /**
+     * @brief The phases of one part of the package
+     */
+    struct XLPartStats
+    {
+        std::string                                part {};      /**< The path of the part in the package, or the file name */
+        std::array<XLPhaseStats, XLStatsPhaseCount> phases {};    /**< Indexed by XLStatsPhase */
+
+        const XLPhaseStats& phase(XLStatsPhase p) const { return phases[static_cast<size_t>(p)]; }
+    };
+
+    /**
+     * @brief A single timed run of a phase, in the order the runs ended
+     */
+    struct XLStatsEvent
+    {
+        XLStatsPhase phase;       /**< The phase */
+        std::string  part;        /**< The path of the part, or the file name */
+        uint64_t     start;       /**< Nanoseconds since the statistics were reset */
+        uint64_t     duration;    /**< Nanoseconds */
+        uint64_t     bytes;       /**< See XLPhaseStats::bytes */
+        uint32_t     thread;      /**< A small number identifying the thread the phase ran on, 0 for the first thread seen */
+    };
+
+    /**
+     * @brief The counters of frequent operations
+     * @note The counters are incremented in code that does not know its document (e.g. when a row or cell node is created),
+     *       and are therefore counted for the whole process: with several documents in use at the same time, the counters
+     *       of each document include the operations on the others.
+     */
+    struct XLStatsCounters
+    {
+        uint64_t sharedStringLookups {0};    /**< Calls of XLSharedStrings::getString and XLSharedStrings::getStringIndex */
+        uint64_t rowNodesCreated {0};        /**< <row> nodes inserted into a worksheet */
+        uint64_t cellNodesCreated {0};       /**< <c> nodes inserted into a worksheet */
+        uint64_t cacheHits {0};              /**< Accesses to an XML part that found it already parsed (a parse is a miss) */
+    };
+
+    /**
+     * @brief A snapshot of the instrumentation of a document, returned by XLDocument::stats()
+     * @details The instrumentation is only compiled in when the library is built with the CMake option OPENXLSX_ENABLE_STATS
+     *  (see enabled()). Otherwise, all statistics are zero and empty.
+     */
+    class OPENXLSX_EXPORT XLStats
+    {
+        friend class XLStatsCollector;
+
+    public:
+        /**
+         * @brief Test whether the library was built with the instrumentation
+         */
+        static bool enabled();
+
+        /**
+         * @brief Get the totals of a phase over all parts
+         */
+        const XLPhaseStats& phase(XLStatsPhase p) const { return m_phases[static_cast<size_t>(p)]; }
+
+        /**
+         * @brief Get the totals per part, in the order the parts were first seen
+         */
+        const std::vector<XLPartStats>& parts() const { return m_parts; }
+
+        /**
+         * @brief Get the totals of one part
+         * @return a pointer to the entry in parts(), nullptr if no phase ran for the part
+         */
+        const XLPartStats* part(const std::string& path) const;
+
+        /**
+         * @brief Get the counters
+         */
+        const XLStatsCounters& counters() const { return m_counters; }
+
+        /**
+         * @brief Get the individual phase runs
+         */
+        const std::vector<XLStatsEvent>& events() const { return m_events; }
+
+        /**
+         * @brief Format the phase runs and counters in the Chrome trace event format
+         * @return a JSON document that can be loaded into chrome://tracing or https://ui.perfetto.dev
+         */
+        std::string chromeTrace() const;
+
+    private:
+        std::array<XLPhaseStats, XLStatsPhaseCount> m_phases {};      /**< Totals per phase */
+        std::vector<XLPartStats>                     m_parts {};       /**< Totals per part */
+        XLStatsCounters                              m_counters {};    /**< Counter deltas since the last reset */
+        std::vector<XLStatsEvent>                    m_events {};      /**< All phase runs */
+    };
+
+    /**
+     * @brief Collects the phase runs of a document, see XLDocument::stats()
+     * @details Phases may be recorded from several threads at once. The counters are process wide, the collector remembers their
+     *  values at the last reset().
+     */
+    class OPENXLSX_EXPORT XLStatsCollector
+    {
+    public:
+        /**
+         * @brief Constructor: calls reset()
+         */
+        XLStatsCollector();
+
+        /**
+         * @brief Record a phase run
+         * @param start the start time, as returned by now()
+         */
+        void record(XLStatsPhase phase, const std::string& part, uint64_t start, uint64_t duration, uint64_t bytes);
+
+        /**
+         * @brief Drop all recorded phase runs and restart the counters at zero
+         */
+        void reset();
+
+        /**
+         * @brief Get the statistics recorded since the last reset()
+         */
+        XLStats snapshot() const;
+
+        /**
+         * @brief Get a monotonic time stamp in nanoseconds
+         */
+        static uint64_t now();
+
+        /**
+         * @brief Get the current values of the process wide counters
+         */
+        static XLStatsCounters counters();
+
+    private:
+        mutable std::mutex                  m_mutex {};         /**< Serializes record() */
+        uint64_t                            m_origin {0};       /**< The time of the last reset() */
+        XLStatsCounters                     m_baseline {};      /**< The counters at the last reset() */
+        std::vector<XLStatsEvent>           m_events {};        /**< The phase runs since the last reset() */
+        std::map<std::thread::id, uint32_t> m_threads {};       /**< Numbers the threads in the order they were seen */
+    };
+}    // namespace OpenXLSX
+
+#ifdef _MSC_VER    // conditionally enable MSVC specific pragmas to avoid other compilers warning about unknown pragmas
+#   pragma warning(pop)
+#endif // _MSC_VER
+
+#endif    // OPENXLSX_XLSTATS_HPP
@@ -54,8 +54,11 @@ YM      M9  MM    MM MM       MM    MM   d'  `MM.    MM            MM   d'  `MM.
 
 // ===== External Includes ===== //
 #include <cstdint>   // uint32_t etc
+#include <functional>     // std::function
+#include <memory>         // std::shared_ptr
 #include <string>
 #include <string_view>  // std::string_view
+#include <unordered_map>  // std::unordered_multimap
 #include <vector>
 
 // ===== OpenXLSX Includes ===== //
@@ -117,6 +120,132 @@ namespace OpenXLSX
     class XLCellStyles;
     class XLStyles;
 
+    /**
+     * @brief A content hash index over the entries of a style collection, used by the findOrCreate functions to locate
+     *        an existing entry with XML content identical to a requested entry
+     * @note The index is built on the first findOrCreate call and extended as entries are appended. Entries that are modified
+     *       through a handle (see XLStyleEntryOwner) are re-hashed before the next lookup.
+     */
+    struct XLStyleHashIndex
+    {
+        std::unordered_multimap<size_t, XLStyleIndex> buckets; // content hash -> entry index
+        std::vector<size_t>       hashes;                      // content hash for each indexed entry
+        std::vector<bool>         touched;                     // true for each indexed entry that is listed in stale
+        std::vector<XLStyleIndex> stale;                       // indexed entries that need to be re-hashed before the next lookup
+
+        /**
+         * @brief Flag an entry as potentially modified, so that it will be re-hashed before the next lookup
+         * @param index the entry index within the style collection
+         */
+        void touch(XLStyleIndex index);
+
+        /**
+         * @brief Discard the index - it will be rebuilt on next use
+         */
+        void clear();
+    };
+
+    /**
+     * @brief A list of style collection entries that were modified (see XLStyleEntryOwner) since the list was last cleared
+     */
+    struct XLStyleTouchList
+    {
+        std::vector<bool>         flagged; // true for each entry that is listed in entries
+        std::vector<XLStyleIndex> entries; // the touched entries, each listed once
+
+        /**
+         * @brief Flag an entry as potentially modified
+         * @param index the entry index within the style collection
+         */
+        void touch(XLStyleIndex index);
+
+        /**
+         * @brief Empty the list
+         */
+        void clear();
+    };
+
+    /**
+     * @brief The caches of a style collection that depend on the XML content of one of its entries. The collection sets it on the
+     *        entry handles that it holds, all copies of these handles and the sub-objects obtained from them (e.g. the XLLine of an
+     *        XLBorder) inherit it, and all member functions that may modify the entry XML (setters, as well as getters that insert
+     *        a default value) flag the entry through it
+     * @note The caches are shared with the collection, so that a handle that outlives its collection (e.g. after
+     *       XLStyles::compact) flags an orphaned cache instead of freed memory
+     */
+    struct XLStyleEntryOwner
+    {
+        std::shared_ptr<XLStyleHashIndex> hashIndex  {};                    // content hash index of the collection, if it has one
+        std::shared_ptr<XLStyleTouchList> tableStale {};                    // entries to be re-decoded into an XLStyles table, if any
+        XLStyleIndex                      index      {XLInvalidStyleIndex}; // the entry index within the collection
+
+        /**
+         * @brief Flag the entry as modified in the caches of its collection - does nothing for entries without a collection
+         */
+        void touch() const;
+    };
+
+    /**
+     * @brief The kind of value that a number format displays, as determined from its (built-in or custom) format code
+     */
+    enum class XLNumberFormatType : uint8_t {
+        General  = 0,    // General format, or a format code that displays no number
+        Number   = 1,    // any other numeric format (decimals, thousands separators, currency, scientific, fractions)
+        Percent  = 2,    // numeric format with a percent sign
+        Date     = 3,    // date without time of day
+        Time     = 4,    // time of day or elapsed time without date
+        DateTime = 5,    // date and time of day
+        Text     = 6     // text format "@"
+    };
+
+    /**
+     * @brief Decoded struct-of-arrays copy of the <cellXfs> entries, one array element per cell format index
+     * @note Obtained through XLStyles::cellFormatTable, which brings the arrays up to date with the XML before returning them
+     */
+    struct XLCellFormatTable
+    {
+        std::vector<uint32_t> numberFormatId; // numFmtId, XLInvalidUInt32 if not set
+        std::vector<uint32_t> fontIndex;      // fontId, XLInvalidUInt32 if not set
+        std::vector<uint32_t> fillIndex;      // fillId, XLInvalidUInt32 if not set
+        std::vector<uint32_t> borderIndex;    // borderId, XLInvalidUInt32 if not set
+        std::vector<uint32_t> xfId;           // xfId, XLInvalidUInt32 if not set
+
+        size_t size() const { return numberFormatId.size(); }
+        void resize(size_t newSize);
+    };
+
+    /**
+     * @brief Decoded copy of the <numFmts> entries with a lookup by numFmtId
+     * @note Obtained through XLStyles::numberFormatTable, which brings the arrays up to date with the XML before returning them
+     */
+    struct XLNumberFormatTable
+    {
+        std::vector<uint32_t>                      numberFormatId; // numFmtId for each number format index
+        std::vector<std::string>                   formatCode;     // formatCode for each number format index
+        std::vector<XLNumberFormatType>            numberFormatType; // classification of formatCode for each number format index
+        std::unordered_map<uint32_t, XLStyleIndex> indexById;      // numFmtId -> number format index
+
+        size_t size() const { return numberFormatId.size(); }
+        void resize(size_t newSize);
+
+        /**
+         * @brief Look up a custom number format by its id
+         * @param id the numFmtId
+         * @return the number format index, or XLInvalidStyleIndex if no custom number format has this id
+         */
+        XLStyleIndex indexOf(uint32_t id) const;
+    };
+
+    /**
+     * @brief The renumbering applied by XLStyles::compact: for each original index, the new index of the entry,
+     *        or XLInvalidStyleIndex if the entry was dropped
+     */
+    struct XLStyleCompactionMap
+    {
+        std::vector<XLStyleIndex> cellFormats;     // <cellXfs> old index -> new index
+        std::vector<XLStyleIndex> diffCellFormats; // <dxfs> old index -> new index
+    };
+
     enum XLUnderlineStyle : uint8_t {
         XLUnderlineNone    = 0,
         XLUnderlineSingle  = 1,
@@ -236,7 +365,7 @@ namespace OpenXLSX
      */
     class OPENXLSX_EXPORT XLNumberFormat
     {
-        friend class XLNumberFormats;    // for access to m_numberFormatNode in XLNumberFormats::create
+        friend class XLNumberFormats;    // for access to m_numberFormatNode in XLNumberFormats::create, and to m_owner
     public:    // ---------- Public Member Functions ---------- //
         /**
          * @brief
@@ -308,6 +437,7 @@ namespace OpenXLSX
 
     private:                                         // ---------- Private Member Variables ---------- //
         std::unique_ptr<XMLNode> m_numberFormatNode; /**< An XMLNode object with the number format item */
+        XLStyleEntryOwner m_owner {};                /**< the caches of the collection holding this entry, see XLStyleEntryOwner */
     };
 
 
@@ -316,6 +446,7 @@ namespace OpenXLSX
      */
     class OPENXLSX_EXPORT XLNumberFormats
     {
+        friend class XLStyles;    // for access to m_numberFormats and m_tableStale in XLStyles::numberFormatTable
     public:    // ---------- Public Member Functions ---------- //
         /**
          * @brief
@@ -409,6 +540,7 @@ namespace OpenXLSX
     private:                                         // ---------- Private Member Variables ---------- //
         std::unique_ptr<XMLNode> m_numberFormatsNode; /**< An XMLNode object with the number formats item */
         std::vector<XLNumberFormat> m_numberFormats;
+        std::shared_ptr<XLStyleTouchList> m_tableStale {std::make_shared<XLStyleTouchList>()};    /**< entries to be re-decoded by XLStyles::numberFormatTable */
     };
 
 
@@ -589,6 +721,7 @@ namespace OpenXLSX
 
     private:                                         // ---------- Private Member Variables ---------- //
         std::unique_ptr<XMLNode> m_fontNode;         /**< An XMLNode object with the font item */
+        XLStyleEntryOwner m_owner {};                /**< the caches of the collection holding this entry, see XLStyleEntryOwner */
     };
 
 
@@ -597,6 +730,7 @@ namespace OpenXLSX
      */
     class OPENXLSX_EXPORT XLFonts
     {
+        friend class XLStyles;    // for access to m_hashIndex in XLStyles::memoryUsage
     public:    // ---------- Public Member Functions ---------- //
         /**
          * @brief
@@ -668,9 +802,28 @@ namespace OpenXLSX
          */
         XLStyleIndex create(XLFont copyFrom = XLFont{}, std::string styleEntriesPrefix = XLDefaultStyleEntriesPrefix);
 
+        /**
+         * @brief Find an existing XLFont with XML content identical to copyFrom, or append a new one based on copyFrom
+         * @param copyFrom The XLFont to look up, and to use as template if no identical font exists
+         * @param styleEntriesPrefix Prefix a newly created font XMLNode with this pugi::node_pcdata text
+         * @returns The index of the existing or newly created font as used by operator[]
+         */
+        XLStyleIndex findOrCreate(XLFont copyFrom, std::string styleEntriesPrefix = XLDefaultStyleEntriesPrefix);
+
+        /**
+         * @brief Append a new XLFont based on copyFrom, apply modify to it, and discard it again if an identical font already exists
+         * @param copyFrom Can provide an XLFont to use as template for the new style
+         * @param modify A function that will be invoked with the new XLFont before looking for an identical entry
+         * @param styleEntriesPrefix Prefix the newly created font XMLNode with this pugi::node_pcdata text
+         * @returns The index of the existing or newly created font as used by operator[]
+         */
+        XLStyleIndex findOrCreate(XLFont copyFrom, std::function<void(XLFont&)> const& modify,
+        /**/                      std::string styleEntriesPrefix = XLDefaultStyleEntriesPrefix);
+
     private:                                         // ---------- Private Member Variables ---------- //
         std::unique_ptr<XMLNode> m_fontsNode;        /**< An XMLNode object with the fonts item */
         std::vector<XLFont> m_fonts;
+        std::shared_ptr<XLStyleHashIndex> m_hashIndex {std::make_shared<XLStyleHashIndex>()};    /**< content hash index used by findOrCreate */
     };
 
 
@@ -683,6 +836,8 @@ namespace OpenXLSX
      */
     class OPENXLSX_EXPORT XLDataBarColor
     {
+        friend class XLGradientStop;    // for access to m_owner in XLGradientStop::color
+        friend class XLLine;            // for access to m_owner in XLLine::color
     public:
         /**
          * @brief
@@ -765,6 +920,7 @@ namespace OpenXLSX
 
     private:                                         // ---------- Private Member Variables ---------- //
         std::unique_ptr<XMLNode> m_colorNode;        /**< An XMLNode object with the color item */
+        XLStyleEntryOwner m_owner {};                /**< the caches of the collection holding this entry, see XLStyleEntryOwner */
     };
 
 
@@ -777,7 +933,7 @@ namespace OpenXLSX
      */
     class OPENXLSX_EXPORT XLGradientStop
     {
-        friend class XLGradientStops;    // for access to m_stopNode in XLGradientStops::create
+        friend class XLGradientStops;    // for access to m_stopNode in XLGradientStops::create, and to m_owner
     public:                                          // ---------- Public Member Functions ----------- //
         /**
          * @brief
@@ -844,6 +1000,7 @@ namespace OpenXLSX
 
     private:                                         // ---------- Private Member Variables ---------- //
         std::unique_ptr<XMLNode> m_stopNode;         /**< An XMLNode object with the stop item */
+        XLStyleEntryOwner m_owner {};                /**< the caches of the collection holding this entry, see XLStyleEntryOwner */
     };
 
     /**
@@ -851,6 +1008,7 @@ namespace OpenXLSX
      */
     class OPENXLSX_EXPORT XLGradientStops
     {
+        friend class XLFill;    // for access to setOwner in XLFill::stops
     public:    // ---------- Public Member Functions ---------- //
         /**
          * @brief
@@ -925,8 +1083,14 @@ namespace OpenXLSX
         std::string summary() const;
 
     private:
+        /**
+         * @brief Set the owner of the gradient fill and of all its stops
+         */
+        void setOwner(const XLStyleEntryOwner& owner);
+
         std::unique_ptr<XMLNode> m_gradientNode;        /**< An XMLNode object with the gradientFill item */
         std::vector<XLGradientStop> m_gradientStops;
+        XLStyleEntryOwner m_owner {};                   /**< the caches of the collection holding the fill, see XLStyleEntryOwner */
     };
 
     /**
@@ -1062,6 +1226,7 @@ namespace OpenXLSX
 
     private:                                         // ---------- Private Member Variables ---------- //
         std::unique_ptr<XMLNode> m_fillNode;         /**< An XMLNode object with the fill item */
+        XLStyleEntryOwner m_owner {};                /**< the caches of the collection holding this entry, see XLStyleEntryOwner */
     };
 
 
@@ -1070,6 +1235,7 @@ namespace OpenXLSX
      */
     class OPENXLSX_EXPORT XLFills
     {
+        friend class XLStyles;    // for access to m_hashIndex in XLStyles::memoryUsage
     public:    // ---------- Public Member Functions ---------- //
         /**
          * @brief
@@ -1141,9 +1307,28 @@ namespace OpenXLSX
          */
         XLStyleIndex create(XLFill copyFrom = XLFill{}, std::string styleEntriesPrefix = XLDefaultStyleEntriesPrefix);
 
+        /**
+         * @brief Find an existing XLFill with XML content identical to copyFrom, or append a new one based on copyFrom
+         * @param copyFrom The XLFill to look up, and to use as template if no identical fill exists
+         * @param styleEntriesPrefix Prefix a newly created fill XMLNode with this pugi::node_pcdata text
+         * @returns The index of the existing or newly created fill as used by operator[]
+         */
+        XLStyleIndex findOrCreate(XLFill copyFrom, std::string styleEntriesPrefix = XLDefaultStyleEntriesPrefix);
+
+        /**
+         * @brief Append a new XLFill based on copyFrom, apply modify to it, and discard it again if an identical fill already exists
+         * @param copyFrom Can provide an XLFill to use as template for the new style
+         * @param modify A function that will be invoked with the new XLFill before looking for an identical entry
+         * @param styleEntriesPrefix Prefix the newly created fill XMLNode with this pugi::node_pcdata text
+         * @returns The index of the existing or newly created fill as used by operator[]
+         */
+        XLStyleIndex findOrCreate(XLFill copyFrom, std::function<void(XLFill&)> const& modify,
+        /**/                      std::string styleEntriesPrefix = XLDefaultStyleEntriesPrefix);
+
     private:                                         // ---------- Private Member Variables ---------- //
         std::unique_ptr<XMLNode> m_fillsNode;        /**< An XMLNode object with the fills item */
         std::vector<XLFill> m_fills;
+        std::shared_ptr<XLStyleHashIndex> m_hashIndex {std::make_shared<XLStyleHashIndex>()};    /**< content hash index used by findOrCreate */
     };
 
 
@@ -1157,6 +1342,7 @@ namespace OpenXLSX
     class OPENXLSX_EXPORT XLLine
     {
         // friend class TBD: XLBorder or XLBorders;    // for access to m_lineNode in TBD
+        friend class XLBorder;    // for access to m_owner in the XLBorder line getters
     public:    // ---------- Public Member Functions ---------- //
         /**
          * @brief
@@ -1228,6 +1414,7 @@ namespace OpenXLSX
 
     private:                                         // ---------- Private Member Variables ---------- //
         std::unique_ptr<XMLNode> m_lineNode;         /**< An XMLNode object with the line item */
+        XLStyleEntryOwner m_owner {};                /**< the caches of the collection holding this entry, see XLStyleEntryOwner */
      };
 
 
@@ -1366,6 +1553,7 @@ namespace OpenXLSX
 
     private:                                         // ---------- Private Member Variables ---------- //
         std::unique_ptr<XMLNode> m_borderNode;       /**< An XMLNode object with the font item */
+        XLStyleEntryOwner m_owner {};                /**< the caches of the collection holding this entry, see XLStyleEntryOwner */
         inline static const std::vector< std::string_view > m_nodeOrder = { "left", "right", "top", "bottom", "diagonal", "vertical", "horizontal" };
     };
 
@@ -1375,6 +1563,7 @@ namespace OpenXLSX
      */
     class OPENXLSX_EXPORT XLBorders
     {
+        friend class XLStyles;    // for access to m_hashIndex in XLStyles::memoryUsage
     public:    // ---------- Public Member Functions ---------- //
         /**
          * @brief
@@ -1446,9 +1635,28 @@ namespace OpenXLSX
          */
         XLStyleIndex create(XLBorder copyFrom = XLBorder{}, std::string styleEntriesPrefix = XLDefaultStyleEntriesPrefix);
 
+        /**
+         * @brief Find an existing XLBorder with XML content identical to copyFrom, or append a new one based on copyFrom
+         * @param copyFrom The XLBorder to look up, and to use as template if no identical border exists
+         * @param styleEntriesPrefix Prefix a newly created border XMLNode with this pugi::node_pcdata text
+         * @returns The index of the existing or newly created border as used by operator[]
+         */
+        XLStyleIndex findOrCreate(XLBorder copyFrom, std::string styleEntriesPrefix = XLDefaultStyleEntriesPrefix);
+
+        /**
+         * @brief Append a new XLBorder based on copyFrom, apply modify to it, and discard it again if an identical border already exists
+         * @param copyFrom Can provide an XLBorder to use as template for the new style
+         * @param modify A function that will be invoked with the new XLBorder before looking for an identical entry
+         * @param styleEntriesPrefix Prefix the newly created border XMLNode with this pugi::node_pcdata text
+         * @returns The index of the existing or newly created border as used by operator[]
+         */
+        XLStyleIndex findOrCreate(XLBorder copyFrom, std::function<void(XLBorder&)> const& modify,
+        /**/                      std::string styleEntriesPrefix = XLDefaultStyleEntriesPrefix);
+
     private:                                         // ---------- Private Member Variables ---------- //
         std::unique_ptr<XMLNode> m_bordersNode;      /**< An XMLNode object with the borders item */
         std::vector<XLBorder> m_borders;
+        std::shared_ptr<XLStyleHashIndex> m_hashIndex {std::make_shared<XLStyleHashIndex>()};    /**< content hash index used by findOrCreate */
     };
 
 
@@ -1462,6 +1670,7 @@ namespace OpenXLSX
     class OPENXLSX_EXPORT XLAlignment
     {
         // friend class TBD: XLCellFormat or XLCellFormats;    // for access to m_alignmentNode in TBD
+        friend class XLCellFormat;    // for access to m_owner in XLCellFormat::alignment
     public:    // ---------- Public Member Functions ---------- //
         /**
          * @brief
@@ -1592,6 +1801,7 @@ namespace OpenXLSX
 
     private:                                         // ---------- Private Member Variables ---------- //
         std::unique_ptr<XMLNode> m_alignmentNode;    /**< An XMLNode object with the alignment item */
+        XLStyleEntryOwner m_owner {};                /**< the caches of the collection holding this entry, see XLStyleEntryOwner */
     };
 
 
@@ -1788,6 +1998,7 @@ namespace OpenXLSX
     private:                                         // ---------- Private Member Variables ---------- //
         std::unique_ptr<XMLNode> m_cellFormatNode;   /**< An XMLNode object with the cell format (xf) item */
         bool m_permitXfId{false};
+        XLStyleEntryOwner m_owner {};                /**< the caches of the collection holding this entry, see XLStyleEntryOwner */
         inline static const std::vector< std::string_view > m_nodeOrder = { "alignment", "protection" };
     };
 
@@ -1797,6 +2008,7 @@ namespace OpenXLSX
      */
     class OPENXLSX_EXPORT XLCellFormats
     {
+        friend class XLStyles;    // for access to m_cellFormats and m_tableStale in XLStyles::cellFormatTable
     public:    // ---------- Public Member Functions ---------- //
         /**
          * @brief
@@ -1870,10 +2082,30 @@ namespace OpenXLSX
          */
         XLStyleIndex create(XLCellFormat copyFrom = XLCellFormat{}, std::string styleEntriesPrefix = XLDefaultStyleEntriesPrefix);
 
+        /**
+         * @brief Find an existing XLCellFormat with XML content identical to copyFrom, or append a new one based on copyFrom
+         * @param copyFrom The XLCellFormat to look up, and to use as template if no identical cell format exists
+         * @param styleEntriesPrefix Prefix a newly created cell format XMLNode with this pugi::node_pcdata text
+         * @returns The index of the existing or newly created cell format as used by operator[]
+         */
+        XLStyleIndex findOrCreate(XLCellFormat copyFrom, std::string styleEntriesPrefix = XLDefaultStyleEntriesPrefix);
+
+        /**
+         * @brief Append a new XLCellFormat based on copyFrom, apply modify to it, and discard it again if an identical cell format already exists
+         * @param copyFrom Can provide an XLCellFormat to use as template for the new style
+         * @param modify A function that will be invoked with the new XLCellFormat before looking for an identical entry
+         * @param styleEntriesPrefix Prefix the newly created cell format XMLNode with this pugi::node_pcdata text
+         * @returns The index of the existing or newly created cell format as used by operator[]
+         */
+        XLStyleIndex findOrCreate(XLCellFormat copyFrom, std::function<void(XLCellFormat&)> const& modify,
+        /**/                      std::string styleEntriesPrefix = XLDefaultStyleEntriesPrefix);
+
     private:                                         // ---------- Private Member Variables ---------- //
         std::unique_ptr<XMLNode> m_cellFormatsNode;  /**< An XMLNode object with the cell formats item */
         std::vector<XLCellFormat> m_cellFormats;
         bool m_permitXfId{false};
+        std::shared_ptr<XLStyleHashIndex> m_hashIndex {std::make_shared<XLStyleHashIndex>()};    /**< content hash index used by findOrCreate */
+        std::shared_ptr<XLStyleTouchList> m_tableStale {std::make_shared<XLStyleTouchList>()};    /**< entries to be re-decoded by XLStyles::cellFormatTable */
     };
 
 
@@ -2368,8 +2600,69 @@ namespace OpenXLSX
          */
         XLDiffCellFormats& diffCellFormats() const;
 
+        /**
+         * @brief Get a decoded struct-of-arrays copy of the cell formats, for fast lookups in loops over many cells
+         * @return the decoded cell format table, brought up to date with entries created or modified in cellFormats() since the last call
+         * @note The XML remains the authoritative copy: the table is never written back. It is built at construction and subsequently
+         *       only entries that were appended, or modified through any XLCellFormat handle (including handles kept from before the
+         *       last call), are re-decoded.
+         *       A reference to the table remains valid, but its content is only updated by calling this function again.
+         */
+        XLCellFormatTable const& cellFormatTable() const;
+
+        /**
+         * @brief Get a decoded copy of the custom number formats with a lookup by numFmtId
+         * @return the decoded number format table, brought up to date like cellFormatTable
+         */
+        XLNumberFormatTable const& numberFormatTable() const;
+
+        /**
+         * @brief Get the number format classification of a cell format
+         * @param cellFormatIndex an index into cellFormats()
+         * @return the classification of the number format used by the cell format, XLNumberFormatType::General for an invalid index
+         * @note The classification of all cell formats is precomputed and only recomputed when entries were created or modified
+         *       in numberFormats() or cellFormats() - the lookup is O(1) otherwise
+         */
+        XLNumberFormatType cellFormatType(XLStyleIndex cellFormatIndex) const;
+
+        /**
+         * @brief Get the number format classification of all cell formats
+         * @return an array with one element per cell format index, brought up to date like cellFormatType
+         */
+        std::vector<XLNumberFormatType> const& cellFormatTypes() const;
+
+        /**
+         * @brief Get the estimated memory held by the style objects, outside of the xl/styles.xml DOM
+         * @return the bytes held by the entry objects of all collections, the findOrCreate hash indices and the decoded tables
+         */
+        size_t memoryUsage() const;
+
+        /**
+         * @brief Drop all style entries that are not in use and renumber the remaining entries and all references within xl/styles.xml
+         * @param cellFormatsInUse flags the <cellXfs> entries that are referenced from outside xl/styles.xml - index 0 is always kept
+         * @param diffCellFormatsInUse flags the <dxfs> entries that are referenced from outside xl/styles.xml
+         * @return the renumbering that must be applied to all cell format and differential format references outside of xl/styles.xml
+         * @note Fonts, fills, borders and custom number formats are kept if referenced from a remaining cell format or from any cell style format.
+         *       All <cellStyleXfs> entries are kept. Previously obtained style entry objects become invalid, the collections are reloaded in place.
+         * @note Use XLDocument::compactStyles to collect the references from all worksheets and renumber them
+         */
+        XLStyleCompactionMap compact(std::vector<bool> cellFormatsInUse, std::vector<bool> diffCellFormatsInUse);
+
         // ---------- Protected Member Functions ---------- //
     private:
+        /**
+         * @brief Bring m_cellFormatTable up to date with the XML
+         * @return true if any table entry was (re-)decoded or dropped
+         */
+        bool syncCellFormatTable() const;
+
+        /**
+         * @brief Bring m_numberFormatTable up to date with the XML
+         * @return true if any table entry was (re-)decoded or dropped
+         */
+        bool syncNumberFormatTable() const;
+
+        // ---------- Private Member Variables ---------- //
         bool                                m_suppressWarnings; // if true, will suppress output of warnings where supported
         std::unique_ptr<XLNumberFormats>    m_numberFormats;    // handle to the underlying number formats
         std::unique_ptr<XLFonts>            m_fonts;            // handle to the underlying fonts
@@ -2379,6 +2672,9 @@ namespace OpenXLSX
         std::unique_ptr<XLCellFormats>      m_cellFormats;      // handle to the underlying cell formats descriptions
         std::unique_ptr<XLCellStyles>       m_cellStyles;       // handle to the underlying cell styles
         std::unique_ptr<XLDiffCellFormats>  m_diffCellFormats;  // handle to the underlying differential cell formats
+        mutable XLCellFormatTable           m_cellFormatTable;  // decoded copy of the cell formats
+        mutable XLNumberFormatTable         m_numberFormatTable;// decoded copy of the number formats
+        mutable std::vector<XLNumberFormatType> m_cellFormatTypes; // number format classification for each cell format
     };
 }    // namespace OpenXLSX
 
@@ -0,0 +1,134 @@
+/*
+
+   ____                               ____      ___ ____       ____  ____      ___
+  6MMMMb                              `MM(      )M' `MM'      6MMMMb\`MM(      )M'
+ 8P    Y8                              `MM.     d'   MM      6M'    ` `MM.     d'
+6M      Mb __ ____     ____  ___  __    `MM.   d'    MM      MM        `MM.   d'
+MM      MM `M6MMMMb   6MMMMb `MM 6MMb    `MM. d'     MM      YM.        `MM. d'
+MM      MM  MM'  `Mb 6M'  `Mb MMM9 `Mb    `MMd       MM       YMMMMb     `MMd
+MM      MM  MM    MM MM    MM MM'   MM     dMM.      MM           `Mb     dMM.
+MM      MM  MM    MM MMMMMMMM MM    MM    d'`MM.     MM            MM    d'`MM.
+YM      M9  MM    MM MM       MM    MM   d'  `MM.    MM            MM   d'  `MM.
+ 8b    d8   MM.  ,M9 YM    d9 MM    MM  d'    `MM.   MM    / L    ,M9  d'    `MM.
+  YMMMM9    MMYMMM9   YMMMM9 _MM_  _MM_M(_    _)MM_ _MMMMMMM MYMMMM9 _M(_    _)MM_
+            MM
+            MM
+           _MM_
+
+  Copyright (c) 2018, Kenneth Troldal Balslev
+
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+  - Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+  - Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+  - Neither the name of the author nor the
+    names of any contributors may be used to endorse or promote products
+    derived from this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+  DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+  DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+  ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ */
+
+#ifndef OPENXLSX_XLTEMPLATE_HPP
+#define OPENXLSX_XLTEMPLATE_HPP
+
+#ifdef _MSC_VER    // conditionally enable MSVC specific pragmas to avoid other compilers warning about unknown pragmas
+#   pragma warning(push)
+#   pragma warning(disable : 4251)
+#   pragma warning(disable : 4275)
+#endif // _MSC_VER
+
+// ===== External Includes ===== //
+#include <cstddef>
+#include <memory>
+#include <string>
+
+// ===== OpenXLSX Includes ===== //
+#include "OpenXLSX-Exports.hpp"
+
+namespace OpenXLSX
+{
+    struct XLTemplatePackage;    // see utilities/XLTemplatePackage.hpp
+
+    /**
+     * @brief An .xlsx package that is opened once, and from which any number of documents can be forked, see XLDocument::open(const XLTemplate&)
+     * @details The constructor reads the whole file into memory, indexes the zip directory and parses the parts every open
+     *  document needs: [Content_Types].xml, the relationships, the workbook, the shared strings, the styles and the document
+     *  properties. A fork starts out with copies of these parsed parts and with the template's string cache, so that none
+     *  of them is inflated or parsed again. All other parts (worksheets, comments, tables, ...) stay compressed in the template
+     *  until a fork accesses them, and parts a fork never accesses are copied into its saved file with their compressed bytes.
+     *
+     *  An XLTemplate is immutable once constructed. Copies are cheap and share the same package, which is released with
+     *  the last copy (or the last document forked from it). Any number of documents can be forked from one template
+     *  concurrently, on different threads.
+     */
+    class OPENXLSX_EXPORT XLTemplate
+    {
+        friend class XLDocument;
+
+    public:
+        /**
+         * @brief Construct an empty template, that can not be forked
+         */
+        XLTemplate() = default;
+
+        /**
+         * @brief Open the .xlsx file with the given path as a template
+         * @param fileName The path of the .xlsx file. The file is read completely, and is not accessed again afterwards.
+         * @throw XLInputError if the file can not be read, or the document structure is invalid
+         */
+        explicit XLTemplate(const std::string& fileName);
+
+        XLTemplate(const XLTemplate& other)            = default;
+        XLTemplate(XLTemplate&& other) noexcept        = default;
+        XLTemplate& operator=(const XLTemplate& other) = default;
+        XLTemplate& operator=(XLTemplate&& other)      = default;
+        ~XLTemplate()                                  = default;
+
+        /**
+         * @brief Test whether the template holds a package
+         * @return false for a default constructed (or moved-from) template
+         */
+        bool valid() const { return m_package != nullptr; }
+
+        /**
+         * @brief operator bool, same as valid()
+         */
+        explicit operator bool() const { return valid(); }
+
+        /**
+         * @brief Get the path of the file the template was opened from
+         * @return an empty string for an invalid template
+         */
+        std::string name() const;
+
+        /**
+         * @brief Get the size of the compressed package that is held in memory
+         * @return the size of the file the template was opened from, 0 for an invalid template
+         */
+        size_t packageSize() const;
+
+    private:
+        std::shared_ptr<const XLTemplatePackage> m_package {};    /**< Shared by the copies of this template and by its forks */
+    };
+}    // namespace OpenXLSX
+
+#ifdef _MSC_VER    // conditionally enable MSVC specific pragmas to avoid other compilers warning about unknown pragmas
+#   pragma warning(pop)
+#endif // _MSC_VER
+
+#endif    // OPENXLSX_XLTEMPLATE_HPP
@@ -0,0 +1,152 @@
+/*
+
+   ____                               ____      ___ ____       ____  ____      ___
+  6MMMMb                              `MM(      )M' `MM'      6MMMMb\`MM(      )M'
+ 8P    Y8                              `MM.     d'   MM      6M'    ` `MM.     d'
+6M      Mb __ ____     ____  ___  __    `MM.   d'    MM      MM        `MM.   d'
+MM      MM `M6MMMMb   6MMMMb `MM 6MMb    `MM. d'     MM      YM.        `MM. d'
+MM      MM  MM'  `Mb 6M'  `Mb MMM9 `Mb    `MMd       MM       YMMMMb     `MMd
+MM      MM  MM    MM MM    MM MM'   MM     dMM.      MM           `Mb     dMM.
+MM      MM  MM    MM MMMMMMMM MM    MM    d'`MM.     MM            MM    d'`MM.
+YM      M9  MM    MM MM       MM    MM   d'  `MM.    MM            MM   d'  `MM.
+ 8b    d8   MM.  ,M9 YM    d9 MM    MM  d'    `MM.   MM    / L    ,M9  d'    `MM.
+  YMMMM9    MMYMMM9   YMMMM9 _MM_  _MM_M(_    _)MM_ _MMMMMMM MYMMMM9 _M(_    _)MM_
+            MM
+            MM
+           _MM_
+
+  Copyright (c) 2018, Kenneth Troldal Balslev
+
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+  - Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+  - Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+  - Neither the name of the author nor the
+    names of any contributors may be used to endorse or promote products
+    derived from this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+  DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+  DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+  ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ */
+
+#ifndef OPENXLSX_XLXMLARENA_HPP
+#define OPENXLSX_XLXMLARENA_HPP
+
+#ifdef _MSC_VER    // conditionally enable MSVC specific pragmas to avoid other compilers warning about unknown pragmas
+#   pragma warning(push)
+#   pragma warning(disable : 4251)
+#   pragma warning(disable : 4275)
+#endif // _MSC_VER
+
+// ===== External Includes ===== //
+#include <cstddef>
+#include <map>
+#include <mutex>
+
+// ===== OpenXLSX Includes ===== //
+#include "OpenXLSX-Exports.hpp"
+
+namespace OpenXLSX
+{
+    /**
+     * @brief A pool of pugixml memory pages, owned by an XLDocument and reused across close() / open() cycles
+     * @details pugixml only supports process-wide allocation functions. OpenXLSX installs its own during static initialization,
+     *  chained to the functions that were installed before. Every block carries a small header naming the arena it came from:
+     *  while an XLXmlArena::Scope is active on a thread, pugixml allocations on that thread are served from (and later returned
+     *  to) the scope's arena, all other allocations are passed through. XLDocument opens a scope while it parses an XML part.
+     *  Requests are rounded up to size classes (at most 1/8 larger), and released blocks are kept by the arena and handed out
+     *  again for requests of the same class, so that a process opening many workbooks reuses the same pages instead of
+     *  fragmenting the heap.
+     * @note Programs that install their own pugixml allocation functions must do so before any document is created (as
+     *  required by pugixml) - arenas are then bypassed, unless the new functions chain to the previous ones.
+     * @note The arena must outlive all XML documents parsed with it.
+     */
+    class OPENXLSX_EXPORT XLXmlArena
+    {
+    public:
+        /**
+         * @brief Serve the pugixml allocations of the current thread from an arena for the lifetime of the scope
+         */
+        class OPENXLSX_EXPORT Scope
+        {
+        public:
+            /**
+             * @brief Activate arena for the current thread
+             * @param arena the arena to use, nullptr to pass allocations through
+             */
+            explicit Scope(XLXmlArena* arena);
+            Scope(const Scope& other) = delete;
+            Scope& operator=(const Scope& other) = delete;
+
+            /**
+             * @brief Restore the arena that was active before
+             */
+            ~Scope();
+
+        private:
+            XLXmlArena* m_previous; /**< The arena that was active when the scope was opened */
+        };
+
+        /**
+         * @brief Constructor
+         */
+        XLXmlArena() = default;
+
+        XLXmlArena(const XLXmlArena& other) = delete;
+        XLXmlArena& operator=(const XLXmlArena& other) = delete;
+
+        /**
+         * @brief Destructor, frees the retained blocks
+         */
+        ~XLXmlArena();
+
+        /**
+         * @brief Allocate a block, reusing a retained one of the same size class if possible
+         * @param size the requested size
+         * @return a pointer to the usable memory (after the block header), nullptr if the allocation failed
+         */
+        void* allocate(size_t size);
+
+        /**
+         * @brief Take back a block for reuse
+         * @param block the block start (the block header) of memory obtained from allocate
+         */
+        void release(void* block);
+
+        /**
+         * @brief Free all retained blocks
+         */
+        void trim();
+
+        /**
+         * @brief Get the size of the blocks that are retained for reuse
+         * @return the number of bytes held by the arena that are not in use
+         */
+        size_t retainedSize() const;
+
+    private:
+        mutable std::mutex             m_mutex {};      /**< Serializes parts that are parsed concurrently */
+        std::multimap<size_t, void*>   m_free {};       /**< Released blocks by capacity */
+        size_t                         m_retained {0};  /**< The sum of the capacities in m_free */
+    };
+}    // namespace OpenXLSX
+
+#ifdef _MSC_VER    // conditionally enable MSVC specific pragmas to avoid other compilers warning about unknown pragmas
+#   pragma warning(pop)
+#endif // _MSC_VER
+
+#endif    // OPENXLSX_XLXMLARENA_HPP
@@ -53,7 +53,10 @@ YM      M9  MM    MM MM       MM    MM   d'  `MM.    MM            MM   d'  `MM.
 #endif // _MSC_VER
 
 // ===== External Includes ===== //
+#include <atomic>
+#include <cstdint>
 #include <memory>
+#include <mutex>
 #include <string>
 
 // ===== OpenXLSX Includes ===== //
@@ -94,6 +97,8 @@ namespace OpenXLSX
         bool        m_standalone;
     };
 
+    struct XLSharedFormulaCache;    // defined in XLFormula.cpp
+
     /**
      * @brief The XLXmlData class encapsulates the properties and behaviour of the .xml files in an .xlsx file zip
      * package. Objects of the XLXmlData type are intended to be stored centrally in an XLDocument object, from where
@@ -102,6 +107,9 @@ namespace OpenXLSX
      */
     class OPENXLSX_EXPORT XLXmlData final
     {
+        friend class XLDocument;
+        friend class XLFormulaProxy;    // for access to m_formulaCache
+
     public:
         // ===== PUBLIC MEMBER FUNCTIONS ===== //
 
@@ -226,6 +234,48 @@ namespace OpenXLSX
          */
         const XMLDocument* getXmlDocument() const;
 
+        /**
+         * @brief Test whether the XML document has been parsed from the archive (or set with setRawData)
+         * @return false if the XML data was never accessed, so that the archive entry is still up to date
+         */
+        bool isLoaded() const
+        {
+            return m_loadState && m_loadState->parsed.load(std::memory_order_acquire) && not m_xmlDoc->document_element().empty();
+        }
+
+        /**
+         * @brief Test whether the XML document was evicted from memory with changes that are not in the archive
+         * @return true if the document is held as compressed XML text, to be re-parsed on the next getXmlDocument()
+         * @note see XLDocument::setMemoryBudget
+         */
+        bool isSpilled() const { return not m_spill.empty(); }
+
+        /**
+         * @brief Estimate the memory held by this object
+         * @return for a parsed document: the size of the parse buffer and of the DOM nodes and attributes;
+         *         for a spilled document: the size of the compressed XML text; otherwise 0
+         * @note This walks the whole DOM - it is meant for diagnostics, not for use in a loop
+         */
+        size_t residentSize() const;
+
+        /**
+         * @brief Get a token that keeps the XML document from being evicted while any copy of it exists
+         * @return a shared token - XLXmlFile holds one for its lifetime, so that no document referred to by a live
+         *         XLWorksheet (or other XLXmlFile object) is unloaded
+         * @note Internal operations that keep DOM handles across the loading of other parts use XLDocument::BudgetHold instead
+         */
+        std::shared_ptr<const void> pin() const
+        {
+            std::lock_guard<std::mutex> lock(m_loadState->mutex);    // a pin taken concurrently with unload() is seen by it
+            return m_pin;
+        }
+
+        /**
+         * @brief Test whether an XLXmlFile object (or another holder of pin()) refers to this document
+         * @return true if the document must not be evicted
+         */
+        bool isPinned() const { return m_pin.use_count() > 1; }
+
         /**
          * @brief Test whether there is an XML file linked to this object
          * @return true if there is no underlying XML file, otherwise false
@@ -233,6 +283,42 @@ namespace OpenXLSX
         bool empty() const;
 
     private:
+        /**
+         * @brief The synchronization of the lazy parse
+         */
+        struct LoadState
+        {
+            std::mutex            mutex {};         /**< Serializes load() and unload() */
+            std::atomic<bool>     parsed {false};   /**< Set (release) once m_xmlDoc holds the parsed document */
+            std::atomic<uint64_t> lastUse {0};      /**< Access counter value of the last getXmlDocument() */
+        };
+
+        // ===== PRIVATE MEMBER FUNCTIONS ===== //
+
+        /**
+         * @brief Parse the XML document from its spill, or from the archive, and apply the parent's memory budget
+         * @note Concurrent callers are serialized: the document is parsed once, and all callers return after it is complete
+         */
+        void load() const;
+
+        /**
+         * @brief Record an access for the least-recently-used eviction, if the parent has a memory budget
+         */
+        void touch() const;
+
+        /**
+         * @brief Release the parsed XML document
+         * @param spill if true, the document is first serialized and compressed, so that changes are retained
+         */
+        void unload(bool spill);
+
+        /**
+         * @brief Replace the XML document with a copy of the parsed document of source
+         * @param source a loaded XLXmlData object of another XLDocument, which is only read
+         * @note used to fork a document from an XLTemplate, see XLDocument::open(const XLTemplate&)
+         */
+        void copyXmlDocument(const XLXmlData& source);
+
         // ===== PRIVATE MEMBER VARIABLES ===== //
 
         XLDocument*                          m_parentDoc {}; /**< A pointer to the parent XLDocument object. >*/
@@ -240,6 +326,14 @@ namespace OpenXLSX
         std::string                          m_xmlID {};     /**< The relationship ID of the XML data. >*/
         XLContentType                        m_xmlType {};   /**< The type represented by the XML data. >*/
         mutable std::unique_ptr<XMLDocument> m_xmlDoc;       /**< The underlying XMLDocument object. >*/
+
+        std::shared_ptr<const void> m_pin {};                /**< Copies are held by XLXmlFile objects, see pin() >*/
+        mutable std::string         m_spill {};              /**< The compressed XML text of an evicted, modified document >*/
+        mutable size_t              m_spillSize {0};         /**< The uncompressed size of m_spill >*/
+        mutable size_t              m_textSize {0};          /**< The size of the XML text the document was parsed from >*/
+        mutable size_t              m_residentSize {0};      /**< The estimated memory held by the parsed document >*/
+        mutable std::shared_ptr<XLSharedFormulaCache> m_formulaCache {}; /**< The shared formula masters of a worksheet, dropped with the DOM >*/
+        std::unique_ptr<LoadState>  m_loadState {std::make_unique<LoadState>()}; /**< Held by pointer so that XLXmlData remains movable >*/
     };
 }    // namespace OpenXLSX
 
@@ -52,6 +52,9 @@ YM      M9  MM    MM MM       MM    MM   d'  `MM.    MM            MM   d'  `MM.
 #   pragma warning(disable : 4275)
 #endif // _MSC_VER
 
+// ===== External Includes ===== //
+#include <memory>
+
 // ===== OpenXLSX Includes ===== //
 #include "OpenXLSX-Exports.hpp"
 #include "XLXmlParser.hpp"
@@ -118,6 +121,12 @@ namespace OpenXLSX
          */
         bool valid() const { return m_xmlData != nullptr; }
 
+        /**
+         * @brief check whether the parent document was opened with XLOpenMode::ReadOnly
+         * @return true if the parent document is read-only - read accessors then never create missing XML nodes
+         */
+        bool isReadOnly() const;
+
         /**
          * @brief The copy assignment operator. The default implementation has been used.
          * @param other The object to copy.
@@ -184,6 +193,9 @@ namespace OpenXLSX
 
     protected:                            // ===== PROTECTED MEMBER VARIABLES
         XLXmlData* m_xmlData { nullptr }; /**< The underlying XML data object. */
+
+    private:
+        std::shared_ptr<const void> m_pin {}; /**< Keeps m_xmlData from being evicted under a memory budget, see XLXmlData::pin */
     };
 }    // namespace OpenXLSX
 
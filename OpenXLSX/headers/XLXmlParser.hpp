@@ -46,6 +46,7 @@ YM      M9  MM    MM MM       MM    MM   d'  `MM.    MM            MM   d'  `MM.
 #ifndef OPENXLSX_XLXMLPARSER_HPP
 #define OPENXLSX_XLXMLPARSER_HPP
 
+#include <atomic>
 #include <memory> // shared_ptr
 
 // ===== pugixml.hpp needed for pugi::impl::xml_memory_page_type_mask, pugi::xml_node_type, pugi::char_t, pugi::node_element, pugi::xml_node, pugi::xml_attribute, pugi::xml_document
@@ -60,7 +61,7 @@ namespace OpenXLSX
 {
 #   define ENABLE_XML_NAMESPACES 1    // disable this line to control behavior via compiler flag
 #   define NO_MULTITHREADING_SAFETY 1 // if this is defined, the function namespaced_name_char will be used for XML namespace support,
-//                                    //  using a static character array for improved performance when multithreading conflicts are not a risk
+//                                    //  using a thread_local character array for improved performance over namespaced_name_shared_ptr
 
 #   ifdef ENABLE_XML_NAMESPACES
         // ===== Macro for NAMESPACED_NAME when node names might need to be prefixed with the current node's namespace
@@ -82,7 +83,7 @@ namespace OpenXLSX
      * Affected XMLNode methods: ::set_name, ::append_child, ::prepend_child, ::insert_child_after, ::insert_child_before
      */
 
-    extern bool NO_XML_NS; // defined in XLXmlParser.cpp - default: no XML namespaces
+    extern std::atomic<bool> NO_XML_NS; // defined in XLXmlParser.cpp - default: no XML namespaces - atomic, as it is read by concurrent readers
     /**
      * @brief Set NO_XML_NS to false
      * @return true if PUGI_AUGMENTED is defined (success), false if PUGI_AUGMENTED is not in use (function would be pointless)
@@ -129,7 +130,7 @@ namespace OpenXLSX
         // explicit OpenXLSX_xml_node(base b) : pugi::xml_node(b), name_begin(0) // TBD on explicit keyword
         OpenXLSX_xml_node(base b) : pugi::xml_node(b), name_begin(0)
         {
-            if (NO_XML_NS) return;
+            if (NO_XML_NS.load(std::memory_order_relaxed)) return;
                 const char *name = xml_node::name();
             int pos = 0;
             while (name[pos] && name[pos] != ':') ++pos; // find name delimiter
@@ -149,9 +149,11 @@ namespace OpenXLSX
         void deleteEntry(const std::string& entryName);
 
         /**
-         * @brief
+         * @brief Extract the data of an entry
          * @param name
          * @return
+         * @note The archive does not keep the extracted data of unmodified entries, these are copied without
+         *       decompression on save
          */
         std::string getEntry(const std::string& name) const;
 
@@ -162,6 +164,29 @@ namespace OpenXLSX
          */
         bool hasEntry(const std::string& entryName) const;
 
+        /**
+         * @brief Get the memory held by the entry data cached in the archive
+         * @return the bytes held for entries added (or replaced) since the archive was opened, which are kept until it is saved
+         */
+        size_t cachedDataSize() const;
+
+        /**
+         * @brief Compress a block of data in memory (zlib format, fastest compression level)
+         * @param data the data to compress
+         * @return the compressed data
+         * @throw XLInternalError if compression fails
+         */
+        static std::string compressData(const std::string& data);
+
+        /**
+         * @brief Decompress a block of data produced by compressData
+         * @param data the compressed data
+         * @param size the size of the uncompressed data
+         * @return the uncompressed data
+         * @throw XLInternalError if the data can not be decompressed to the given size
+         */
+        static std::string decompressData(const std::string& data, size_t size);
+
     private:
         std::shared_ptr<Zippy::ZipArchive> m_archive; /**< */
     };
@@ -225,6 +225,36 @@ XLCellValue XLCell::calculatedValue() const
 */
 size_t XLCell::cellFormat() const { return m_cellNode->attribute("s").as_uint(0); }
 
+/**
+ * @details a numeric cell has no t attribute, or t="n", and a <v> child
+ */
+bool XLCell::isDateTime(XLStyles const& styles) const
+{
+    XMLAttribute typeAttr = m_cellNode->attribute("t");
+    if ((not typeAttr.empty() && strcmp(typeAttr.value(), "n") != 0) || m_cellNode->child("v").empty()) return false;
+    switch (styles.cellFormatType(cellFormat())) {
+        case XLNumberFormatType::Date:     [[fallthrough]];
+        case XLNumberFormatType::Time:     [[fallthrough]];
+        case XLNumberFormatType::DateTime: return true;
+        default:                           return false;
+    }
+}
+
+/**
+ * @details convert the serial number stored in <v> without going through XLCellValue. A time of day (serial in [0, 1) with a time
+ *          only format) is placed on day 1, as XLDateTime does not permit serials below 1.0
+ */
+XLDateTime XLCell::dateTimeValue(XLStyles const& styles) const
+{
+    if (not isDateTime(styles)) {
+        using namespace std::literals::string_literals;
+        throw XLValueTypeError("XLCell::"s + __func__ + ": cell "s + cellReference().address() + " does not hold a date / time"s);
+    }
+    const double serial = m_cellNode->child("v").text().as_double();
+    if (serial >= 0.0 && serial < 1.0 && styles.cellFormatType(cellFormat()) == XLNumberFormatType::Time) return XLDateTime(serial + 1.0);
+    return XLDateTime(serial);
+}
+
 /**
 * @details set the s attribute of the cell node, pointing to an xl/styles.xml cellXfs index
 *          the attribute will be created if not existant, function will fail if attribute creation fails
@@ -148,7 +148,8 @@ XLCellIterator::XLCellIterator(const XLCellRange& cellRange, XLIteratorLocation
       m_currentCellStatus(XLNotLoaded),
       m_currentRow(0),
       m_currentColumn(0),
-      m_colStyles(colStyles)
+      m_colStyles(colStyles),
+      m_readOnly(m_sharedStrings.get().isReadOnly())
 {
     if (loc == XLIteratorLocation::End)
         m_endReached = true;
@@ -182,7 +183,8 @@ XLCellIterator::XLCellIterator(const XLCellIterator& other)
       m_currentCellStatus(other.m_currentCellStatus),
       m_currentRow   (other.m_currentRow),
       m_currentColumn(other.m_currentColumn),
-      m_colStyles    (other.m_colStyles)
+      m_colStyles    (other.m_colStyles),
+      m_readOnly     (other.m_readOnly)
 {}
 
 /**
@@ -208,6 +210,7 @@ XLCellIterator& XLCellIterator::operator=(const XLCellIterator& other)
         m_currentRow    =  other.m_currentRow;
         m_currentColumn =  other.m_currentColumn;
         m_colStyles     =  other.m_colStyles;
+        m_readOnly      =  other.m_readOnly;
     }
 
     return *this;
@@ -238,9 +241,12 @@ XLCellIterator& XLCellIterator::operator=(XLCellIterator&& other) noexcept = def
 
 /**
  * @brief update m_currentCell by fetching (or inserting) a cell at m_currentRow, m_currentColumn
+ * @note in a read-only document, a missing cell is not inserted: the iterator then points to an empty XLCell, whose value is empty
  */
 void XLCellIterator::updateCurrentCell(bool createIfMissing)
 {
+    createIfMissing = createIfMissing && not m_readOnly;    // reading a read-only document must not modify it
+
     // ===== Quick exit checks - can't be true when m_endReached
     if (m_currentCellStatus == XLLoaded) return;                         // nothing to do, cell is already loaded
     if (!createIfMissing && m_currentCellStatus == XLNoSuchCell) return; // nothing to do, cell has already been determined as missing
@@ -292,9 +298,10 @@ void XLCellIterator::updateCurrentCell(bool createIfMissing)
             if (createIfMissing && rowNode.empty()) {
                 rowNode = m_dataNode->insert_child_after("row", m_hintNode.parent());
                 rowNode.append_attribute("r").set_value(m_currentRow);
+                OPENXLSX_STATS_COUNT(rowNodesCreated);
             }
             if (rowNode.empty())    // if row could not be found / created
-                m_currentCell = XLCell{}; // make sure m_currentCell is set to an empty cell
+                m_currentCell = XLCell(XMLNode{}, m_sharedStrings.get()); // make sure m_currentCell is set to an empty cell
             else {                  // else: row found
                 if (createIfMissing) {
                     // ===== Pass the already known m_currentRow to getCellNode so that it does not have to be fetched again
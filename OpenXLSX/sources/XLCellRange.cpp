@@ -44,13 +44,185 @@ YM      M9  MM    MM MM       MM    MM   d'  `MM.    MM            MM   d'  `MM.
  */
 
 // ===== External Includes ===== //
+#include <algorithm>    // std::min
 #include <pugixml.hpp>
+#include <string>       // std::to_string
+#include <vector>       // std::vector
 
 // ===== OpenXLSX Includes ===== //
 #include "XLCellRange.hpp"
+#include "XLRow.hpp"
+#include "utilities/XLUtilities.hpp"    // OpenXLSX::parseNumber, OpenXLSX::cellNodeColumn
 
 using namespace OpenXLSX;
 
+namespace    // anonymous namespace for module local functions
+{
+    /**
+     * @brief Set the s attribute of the cells firstCol..lastCol of a row, in a single pass over the row
+     * @param rowNode the <row> node
+     * @param rowName the row number as a string, used for the r attribute of created cells
+     * @param columnNames the column letters for firstCol..lastCol, used for the r attribute of created cells
+     * @param createMissing if true, cells that do not exist are created, otherwise only existing cells are formatted
+     */
+    void formatRowCells(XMLNode rowNode, std::string const& rowName, uint16_t firstCol, uint16_t lastCol, XLStyleIndex cellFormatIndex,
+                        std::vector<std::string> const& columnNames, bool createMissing)
+    {
+        // ===== Past the last cell, the column is MAX_COLS + 1, so that the remaining columns are all missing
+        auto nodeColumn = [](XMLNode const& node) -> uint32_t { return node.empty() ? MAX_COLS + 1 : cellNodeColumn(node); };
+
+        XMLNode  cellNode   = rowNode.first_child_of_type(pugi::node_element);
+        uint32_t cellColumn = nodeColumn(cellNode);
+        while (cellColumn < firstCol) {
+            cellNode   = cellNode.next_sibling_of_type(pugi::node_element);
+            cellColumn = nodeColumn(cellNode);
+        }
+
+        auto setStyle = [cellFormatIndex](XMLNode node) {
+            XMLAttribute attr = node.attribute("s");
+            if (attr.empty()) attr = node.append_attribute("s");
+            attr.set_value(cellFormatIndex);
+        };
+
+        for (uint32_t column = firstCol; column <= lastCol; ++column) {
+            if (cellColumn == column) {    // existing cell
+                setStyle(cellNode);
+                cellNode   = cellNode.next_sibling_of_type(pugi::node_element);
+                cellColumn = nodeColumn(cellNode);
+            }
+            else if (createMissing) {      // cellColumn > column: create the missing cell before cellNode
+                XMLNode newNode = cellNode.empty() ? rowNode.append_child("c") : rowNode.insert_child_before("c", cellNode);
+                newNode.append_attribute("r").set_value((columnNames[column - firstCol] + rowName).c_str());
+                newNode.append_attribute("s").set_value(cellFormatIndex);
+                OPENXLSX_STATS_COUNT(cellNodesCreated);
+            }
+            else if (cellColumn <= lastCol)
+                column = cellColumn - 1;   // skip ahead to the next existing cell
+            else
+                break;
+        }
+    }
+
+    /**
+     * @brief Set the style attribute of the <col> entries for firstCol..lastCol, splitting entries that extend beyond
+     *        the range and inserting entries for columns that have none
+     * @param colsNode the <cols> node
+     */
+    void formatColumns(XMLNode colsNode, uint16_t firstCol, uint16_t lastCol, XLStyleIndex cellFormatIndex)
+    {
+        auto insertColumns = [&](XMLNode before, uint32_t minCol, uint32_t maxCol) {
+            XMLNode node = before.empty() ? colsNode.append_child("col") : colsNode.insert_child_before("col", before);
+            node.append_attribute("min")         = minCol;
+            node.append_attribute("max")         = maxCol;
+            node.append_attribute("width")       = 9.8;    // NOLINT - same default as XLWorksheet::column
+            node.append_attribute("customWidth") = 0;
+            node.append_attribute("style")       = cellFormatIndex;
+        };
+
+        uint32_t nextCol = firstCol;    // first column of the range that is not yet formatted
+        XMLNode  col     = colsNode.first_child_of_type(pugi::node_element);
+        while (nextCol <= lastCol) {
+            if (col.empty()) {    // no more <col> entries: insert one for the remainder of the range
+                insertColumns(col, nextCol, lastCol);
+                break;
+            }
+            uint32_t minCol = col.attribute("min").as_uint();
+            uint32_t maxCol = col.attribute("max").as_uint();
+            if (maxCol < nextCol) {    // entry is left of the remaining range
+                col = col.next_sibling_of_type(pugi::node_element);
+                continue;
+            }
+            if (minCol > nextCol) {    // gap before this entry
+                uint32_t gapEnd = std::min<uint32_t>(lastCol, minCol - 1);
+                insertColumns(col, nextCol, gapEnd);
+                nextCol = gapEnd + 1;
+                continue;
+            }
+            if (minCol < nextCol) {    // split off the part left of the range
+                colsNode.insert_copy_before(col, col).attribute("max").set_value(nextCol - 1);
+                col.attribute("min").set_value(nextCol);
+            }
+            if (maxCol > lastCol) {    // split off the part right of the range
+                colsNode.insert_copy_after(col, col).attribute("min").set_value(lastCol + 1);
+                col.attribute("max").set_value(lastCol);
+                maxCol = lastCol;
+            }
+            XMLAttribute styleAtt = col.attribute("style");
+            if (styleAtt.empty()) styleAtt = col.append_attribute("style");
+            styleAtt.set_value(cellFormatIndex);
+            nextCol = maxCol + 1;
+            col     = col.next_sibling_of_type(pugi::node_element);
+        }
+    }
+
+    /**
+     * @brief Accumulates sum, min and max over a stream of values in fixed size blocks
+     * @details Each block is reduced in kLanes independent lanes, which the compiler keeps in SIMD registers. The summation
+     *          order within a lane is fixed, so the vectorization does not depend on -ffast-math; the result may however
+     *          differ in the last bits from a strictly sequential sum.
+     */
+    class XLNumberAccumulator
+    {
+    public:
+        void add(double value)
+        {
+            m_block[m_size++] = value;
+            if (m_size == kBlockSize) flush();
+        }
+
+        void finish(XLRangeAggregate& result)
+        {
+            flush();
+            if (not m_seeded) return;
+            result.sum = m_sum[0];
+            result.min = m_min[0];
+            result.max = m_max[0];
+            for (int lane = 1; lane < kLanes; ++lane) {
+                result.sum += m_sum[lane];
+                result.min = m_min[lane] < result.min ? m_min[lane] : result.min;
+                result.max = m_max[lane] > result.max ? m_max[lane] : result.max;
+            }
+        }
+
+    private:
+        void flush()
+        {
+            if (m_size == 0) return;
+            if (not m_seeded) {    // seed min/max with a real value, so that idle lanes do not distort the result
+                for (int lane = 0; lane < kLanes; ++lane) m_min[lane] = m_max[lane] = m_block[0];
+                m_seeded = true;
+            }
+
+            const size_t full = m_size - m_size % kLanes;
+            for (size_t i = 0; i < full; i += kLanes) {
+                for (int lane = 0; lane < kLanes; ++lane) {
+                    const double value = m_block[i + lane];
+                    m_sum[lane] += value;
+                    m_min[lane] = value < m_min[lane] ? value : m_min[lane];
+                    m_max[lane] = value > m_max[lane] ? value : m_max[lane];
+                }
+            }
+            for (size_t i = full; i < m_size; ++i) {
+                const double value = m_block[i];
+                m_sum[0] += value;
+                m_min[0] = value < m_min[0] ? value : m_min[0];
+                m_max[0] = value > m_max[0] ? value : m_max[0];
+            }
+            m_size = 0;
+        }
+
+        static constexpr int    kLanes     = 4;
+        static constexpr size_t kBlockSize = 256;
+
+        double m_block[kBlockSize];
+        size_t m_size {0};
+        double m_sum[kLanes] {};
+        double m_min[kLanes] {};
+        double m_max[kLanes] {};
+        bool   m_seeded {false};
+    };
+}    // anonymous namespace
+
 /**
  * @details
  */
@@ -230,13 +402,142 @@ void XLCellRange::clear()
 }
 
 /**
- * @details Iterate over the full range and set format for each existing cell
+ * @details The result is equivalent to setting the format of each cell in the range, but avoids creating cells where possible:
+ *          - if the range covers whole columns, the <col> style is set, and only existing cells (and the cells of rows with a
+ *            custom row format, which takes precedence over the column style) are formatted individually
+ *          - if the range covers whole rows, the row format is set, and only existing cells are formatted individually
+ *          - otherwise, all cells are formatted (and created as needed) in a single pass over each row
  */
-bool XLCellRange::setFormat(size_t cellFormatIndex)
+bool XLCellRange::setFormat(XLStyleIndex cellFormatIndex)
 {
-    // ===== Iterate over all cells in the range
-    for (auto it = begin(); it != end(); ++it)
-        if (!it->setCellFormat(cellFormatIndex))    // attempt to set cell format
-            return false;                               // fail if any setCellFormat failed
-    return true; // success if loop finished nominally
+    if (m_dataNode->empty()) return false;
+
+    uint32_t firstRow   = m_topLeft.row();
+    uint32_t lastRow    = m_bottomRight.row();
+    uint16_t firstCol   = m_topLeft.column();
+    uint16_t lastCol    = m_bottomRight.column();
+    bool     allRows    = (firstRow == 1 && lastRow == MAX_ROWS);
+    bool     allColumns = (firstCol == 1 && lastCol == MAX_COLS);
+
+    std::vector<std::string> columnNames;
+    if (not allColumns) {
+        columnNames.reserve(lastCol - firstCol + 1);
+        for (uint32_t column = firstCol; column <= lastCol; ++column) columnNames.push_back(XLCellReference::columnAsString(column));
+    }
+
+    // ===== Skip the rows above the range
+    XMLNode rowNode = m_dataNode->first_child_of_type(pugi::node_element);
+    while (not rowNode.empty() && rowNode.attribute("r").as_ullong() < firstRow) rowNode = rowNode.next_sibling_of_type(pugi::node_element);
+
+    if (allRows) {
+        // ===== Whole columns: set the column style, then format the existing rows
+        XMLNode colsNode = m_dataNode->parent().child("cols");
+        if (colsNode.empty()) colsNode = m_dataNode->parent().insert_child_before("cols", *m_dataNode);
+        formatColumns(colsNode, firstCol, lastCol, cellFormatIndex);
+        fetchColumnStyles();
+
+        for (; not rowNode.empty(); rowNode = rowNode.next_sibling_of_type(pugi::node_element)) {
+            bool customRowFormat = rowNode.attribute("customFormat").as_bool();
+            if (allColumns && customRowFormat && not XLRow(rowNode, m_sharedStrings.get()).setFormat(cellFormatIndex)) return false;
+            formatRowCells(rowNode, rowNode.attribute("r").value(), firstCol, lastCol, cellFormatIndex, columnNames, customRowFormat && not allColumns);
+        }
+        return true;
+    }
+
+    for (uint32_t rowNumber = firstRow; rowNumber <= lastRow; ++rowNumber) {
+        // ===== Locate or create the row node - rows are visited in ascending order, so this is a single pass over sheetData
+        while (not rowNode.empty() && rowNode.attribute("r").as_ullong() < rowNumber) rowNode = rowNode.next_sibling_of_type(pugi::node_element);
+        if (rowNode.empty() || rowNode.attribute("r").as_ullong() > rowNumber) {
+            rowNode = rowNode.empty() ? m_dataNode->append_child("row") : m_dataNode->insert_child_before("row", rowNode);
+            rowNode.append_attribute("r") = rowNumber;
+            OPENXLSX_STATS_COUNT(rowNodesCreated);
+        }
+
+        // ===== Whole rows: set the row format and format only the existing cells
+        if (allColumns && not XLRow(rowNode, m_sharedStrings.get()).setFormat(cellFormatIndex)) return false;
+        formatRowCells(rowNode, std::to_string(rowNumber), firstCol, lastCol, cellFormatIndex, columnNames, not allColumns);
+        rowNode = rowNode.next_sibling_of_type(pugi::node_element);
+    }
+    return true;
 }
+
+/**
+ * @details A single pass over the rows of the range, reading the <v> text of each cell in place. Cells without a type
+ *          attribute (or with t="n") are numeric; shared strings, inline strings, formula strings, booleans, errors and ISO
+ *          dates count as non-numeric, as do numeric cells whose text cannot be decoded. Cells without a value are skipped.
+ */
+XLRangeAggregate XLCellRange::aggregate() const
+{
+    XLRangeAggregate result;
+    if (m_dataNode->empty()) return result;
+
+    const uint32_t firstRow = m_topLeft.row();
+    const uint32_t lastRow  = m_bottomRight.row();
+    const uint32_t firstCol = m_topLeft.column();
+    const uint32_t lastCol  = m_bottomRight.column();
+
+    XLNumberAccumulator accumulator;
+    uint64_t            rowNumber = 0;
+    for (XMLNode rowNode = m_dataNode->first_child_of_type(pugi::node_element); not rowNode.empty();
+         rowNode         = rowNode.next_sibling_of_type(pugi::node_element))
+    {
+        const XMLAttribute rowRef = rowNode.attribute("r");
+        rowNumber                 = rowRef.empty() ? rowNumber + 1 : rowRef.as_ullong();
+        if (rowNumber < firstRow) continue;
+        if (rowNumber > lastRow) break;
+
+        uint32_t column = 0;
+        for (XMLNode cellNode = rowNode.first_child_of_type(pugi::node_element); not cellNode.empty();
+             cellNode         = cellNode.next_sibling_of_type(pugi::node_element))
+        {
+            const XMLAttribute cellRef = cellNode.attribute("r");
+            column                     = cellRef.empty() ? column + 1 : cellNodeColumn(cellNode);
+            if (column < firstCol) continue;
+            if (column > lastCol) break;
+
+            const char* type = cellNode.attribute("t").value();
+            if (type[0] == 'i') {    // inlineStr holds its text in <is>, not <v>
+                ++result.nonNumericCount;
+                continue;
+            }
+            const XMLNode valueNode = cellNode.child("v");
+            if (valueNode.empty()) continue;
+            const char* text = valueNode.child_value();
+            if (type[0] != '\0' && not(type[0] == 'n' && type[1] == '\0')) {
+                ++result.nonNumericCount;
+                continue;
+            }
+            if (text[0] == '\0') continue;
+
+            double value;
+            if (parseNumber(text, value)) {
+                accumulator.add(value);
+                ++result.count;
+            }
+            else
+                ++result.nonNumericCount;
+        }
+    }
+    accumulator.finish(result);
+    return result;
+}
+
+/**
+ * @details
+ */
+double XLCellRange::sum() const { return aggregate().sum; }
+
+/**
+ * @details
+ */
+uint64_t XLCellRange::count() const { return aggregate().count; }
+
+/**
+ * @details
+ */
+double XLCellRange::mean() const { return aggregate().mean(); }
+
+/**
+ * @details
+ */
+uint64_t XLCellRange::countNonNumeric() const { return aggregate().nonNumericCount; }
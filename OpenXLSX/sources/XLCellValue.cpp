@@ -244,9 +244,8 @@ XLCellValueProxy& XLCellValueProxy::setError(const std::string &error)
  */
 XLValueType XLCellValueProxy::type() const
 {
-    // ===== Check that the m_cellNode is valid.
+    // ===== Check that the m_cellNode is valid. An empty node (a missing cell in a read-only document) reads as an empty value.
     assert(m_cellNode != nullptr);      // NOLINT
-    assert(not m_cellNode->empty());    // NOLINT
 
     // ===== If neither a Type attribute or a getValue node is present, the cell is empty.
     if (!m_cellNode->attribute("t") && !m_cellNode->child("v")) return XLValueType::Empty;
@@ -451,9 +450,8 @@ void XLCellValueProxy::setString(const char* stringValue) // NOLINT
  */
 XLCellValue XLCellValueProxy::getValue() const
 {
-    // ===== Check that the m_cellNode is valid.
+    // ===== Check that the m_cellNode is valid. An empty node (a missing cell in a read-only document) reads as an empty value.
     assert(m_cellNode != nullptr);      // NOLINT
-    assert(not m_cellNode->empty());    // NOLINT
 
     switch (type()) {
         case XLValueType::Empty:
@@ -44,7 +44,7 @@ YM      M9  MM    MM MM       MM    MM   d'  `MM.    MM            MM   d'  `MM.
  */
 
 // ===== External Includes ===== //
-// #include <algorithm>
+#include <algorithm>    // std::stable_sort
 #include <pugixml.hpp>
 
 // ===== OpenXLSX Includes ===== //
@@ -85,6 +85,11 @@ namespace {
         }
         return result;
     }
+
+    /**
+     * @details the key of a cell in the comment and shape indexes: sorts by row, then column - the sequence of the comment list
+     */
+    uint64_t commentKey(uint32_t row, uint16_t column) { return (static_cast<uint64_t>(row) << 16) | column; }
 }    // namespace
 
 
@@ -179,7 +184,11 @@ XLComments::XLComments(const XLComments& other)
       m_vmlDrawing(std::make_unique<XLVmlDrawing>(*other.m_vmlDrawing)),
       // m_vmlDrawing(std::make_unique<XLVmlDrawing>(other.m_vmlDrawing ? *other.m_vmlDrawing : XLVmlDrawing())) // this can be used if other.m_vmlDrawing can be uninitialized
       m_hintNode(other.m_hintNode),
-      m_hintIndex(other.m_hintIndex)
+      m_hintIndex(other.m_hintIndex),
+      m_commentIndex(other.m_commentIndex),
+      m_shapeIndex(other.m_shapeIndex),
+      m_commentIndexValid(other.m_commentIndexValid),
+      m_shapeIndexValid(other.m_shapeIndexValid)
 {}
 
 /**
@@ -191,7 +200,11 @@ XLComments::XLComments(XLComments&& other) noexcept
       m_commentList(std::move(other.m_commentList)),
       m_vmlDrawing(std::move(other.m_vmlDrawing)),
       m_hintNode(other.m_hintNode),
-      m_hintIndex(other.m_hintIndex)
+      m_hintIndex(other.m_hintIndex),
+      m_commentIndex(std::move(other.m_commentIndex)),
+      m_shapeIndex(std::move(other.m_shapeIndex)),
+      m_commentIndexValid(other.m_commentIndexValid),
+      m_shapeIndexValid(other.m_shapeIndexValid)
 {}
 
 /**
@@ -206,6 +219,10 @@ XLComments& XLComments::operator=(XLComments&& other) noexcept
         m_vmlDrawing       = std::move(other.m_vmlDrawing);
         m_hintNode         = std::move(other.m_hintNode);
         m_hintIndex        = other.m_hintIndex;
+        m_commentIndex     = std::move(other.m_commentIndex);
+        m_shapeIndex       = std::move(other.m_shapeIndex);
+        m_commentIndexValid = other.m_commentIndexValid;
+        m_shapeIndexValid  = other.m_shapeIndexValid;
     }
     return *this;
 }
@@ -226,6 +243,7 @@ XLComments& XLComments::operator=(const XLComments& other)
 bool XLComments::setVmlDrawing(XLVmlDrawing &vmlDrawing)
 {
     m_vmlDrawing = std::make_unique<XLVmlDrawing>(vmlDrawing);
+    m_shapeIndexValid = false; // shapes of the new drawing are indexed on first use
     return true;
 }
 
@@ -267,11 +285,55 @@ XMLNode XLComments::commentNode(size_t index) const
 }
 
 /**
- * @details TODO: write doxygen headers for functions in this module
+ * @details look up a comment XML node by its cell reference in m_commentIndex
+ * @return the comment node, or an empty node if the cell has no comment
  */
 XMLNode XLComments::commentNode(const std::string& cellRef) const
 {
-    return m_commentList.find_child_by_attribute("comment", "ref", cellRef.c_str());
+    if (!m_commentIndexValid) buildCommentIndex();
+    XLCellReference ref(cellRef);
+    const auto entry = m_commentIndex.find(commentKey(ref.row(), ref.column()));
+    return entry == m_commentIndex.end() ? XMLNode{} : entry->second;
+}
+
+/**
+ * @details index all comment nodes by cell, in a single pass over the comment list
+ */
+void XLComments::buildCommentIndex() const
+{
+    using namespace std::literals::string_literals;
+
+    m_commentIndex.clear();
+    XMLNode comment = m_commentList.first_child_of_type(pugi::node_element);
+    while (not comment.empty()) {
+        if (comment.name() == "comment"s) { // safeguard against rogue nodes
+            XLCellReference ref(comment.attribute("ref").value());
+            m_commentIndex.emplace(commentKey(ref.row(), ref.column()), comment); // should a cell have two comments: the first one wins
+        }
+        comment = comment.next_sibling_of_type(pugi::node_element);
+    }
+    m_commentIndexValid = true;
+}
+
+/**
+ * @details index all shape nodes of the VML drawing by the cell in their client data, in a single pass over the drawing
+ */
+void XLComments::buildShapeIndex() const
+{
+    m_shapeIndex.clear();
+    if (m_vmlDrawing->valid()) {
+        XMLNode node = m_vmlDrawing->firstShapeNode();
+        while (not node.empty()) {
+            if (node.name() == ShapeNodeName) {
+                XMLNode clientData = node.child("x:ClientData");
+                uint32_t row = clientData.child("x:Row").text().as_uint() + 1;                             // x:Row and x:Column are zero-indexed
+                uint16_t col = static_cast<uint16_t>(clientData.child("x:Column").text().as_uint() + 1);   // ..
+                m_shapeIndex.emplace(commentKey(row, col), node); // should a cell have two shapes: the first one wins
+            }
+            node = node.next_sibling_of_type(pugi::node_element);
+        }
+    }
+    m_shapeIndexValid = true;
 }
 
 /**
@@ -372,15 +434,24 @@ uint16_t XLComments::authorId(const std::string& cellRef) const
  */
 bool XLComments::deleteComment(const std::string& cellRef)
 {
-    XMLNode comment = commentNode(cellRef);
-    if (comment.empty()) return false;
+    if (!m_commentIndexValid) buildCommentIndex();
+    XLCellReference ref(cellRef);
+    const uint64_t key = commentKey(ref.row(), ref.column());
+    const auto comment = m_commentIndex.find(key);
+    if (comment == m_commentIndex.end()) return false;
     else {
-        m_commentList.remove_child(comment);
+        m_commentList.remove_child(comment->second);
+        m_commentIndex.erase(comment);
         m_hintNode = XMLNode{}; // reset hint after modification of comment list
         m_hintIndex = 0;
     }
     // ===== Delete the shape associated with the comment.
-    OpenXLSX::ignore(m_vmlDrawing->deleteShape(cellRef)); // disregard if deleteShape fails
+    if (!m_shapeIndexValid) buildShapeIndex();
+    const auto shape = m_shapeIndex.find(key);
+    if (shape != m_shapeIndex.end()) {
+        OpenXLSX::ignore(m_vmlDrawing->deleteShapeNode(shape->second)); // disregard if deleteShapeNode fails
+        m_shapeIndex.erase(shape);
+    }
     return true;
 }
 
@@ -410,21 +481,54 @@ std::string XLComments::get(const std::string& cellRef) const { return getCommen
 bool XLComments::set(std::string const& cellRef, std::string const& commentText, uint16_t authorId_)
 {
     XLCellReference destRef(cellRef);
+    if (!m_commentIndexValid) buildCommentIndex();
+    auto next = m_commentIndex.lower_bound(commentKey(destRef.row(), destRef.column()));
+    setComment(destRef, commentText, authorId_, next);
+    return true;
+}
+
+/**
+ * @details Sort the comments once, then walk the comment index forward only: each comment is inserted before the first existing comment
+ *          that sorts behind it, so that the whole batch costs one pass over the comment list instead of one search per comment
+ */
+bool XLComments::setMany(std::vector<XLCommentData> const& comments)
+{
+    std::vector<std::pair<XLCellReference, size_t>> sorted;
+    sorted.reserve(comments.size());
+    for (size_t i = 0; i < comments.size(); ++i) sorted.emplace_back(XLCellReference(comments[i].cellRef), i);
+    std::stable_sort(sorted.begin(), sorted.end(), [](auto const& a, auto const& b) {    // stable: the last entry for a cell is set last
+        return commentKey(a.first.row(), a.first.column()) < commentKey(b.first.row(), b.first.column());
+    });
+
+    if (!m_commentIndexValid) buildCommentIndex();
+    auto next = m_commentIndex.begin();
+    for (auto const& [destRef, i] : sorted) {
+        const uint64_t destKey = commentKey(destRef.row(), destRef.column());
+        while (next != m_commentIndex.end() && next->first < destKey) ++next;
+        setComment(destRef, comments[i].text, comments[i].authorId, next);
+    }
+    return true;
+}
+
+/**
+ * @details Set a comment and format its shape
+ * @param next the first entry of m_commentIndex at or behind destRef - updated to point to the entry for destRef
+ */
+void XLComments::setComment(XLCellReference const& destRef, std::string const& commentText, uint16_t authorId_,
+                            std::map<uint64_t, XMLNode>::iterator& next)
+{
     uint32_t destRow = destRef.row();
     uint16_t destCol = destRef.column();
-    bool newCommentCreated = false; // if false, try to find an existing shape before creating one
+    const uint64_t destKey = commentKey(destRow, destCol);
+    bool newCommentCreated = false;
 
     using namespace std::literals::string_literals;
-    XMLNode comment = m_commentList.first_child_of_type(pugi::node_element);
-    while (not comment.empty()) {
-        if (comment.name() == "comment"s) { // safeguard against rogue nodes
-            XLCellReference ref(comment.attribute("ref").value());
-            if (ref.row() > destRow ||(ref.row() == destRow && ref.column() >= destCol)) // abort when node or a node behind it is found
-    break;
-        }
-        comment = comment.next_sibling_of_type(pugi::node_element);
+    XMLNode comment{};
+    if (next != m_commentIndex.end() && next->first == destKey) {             // node exists / was found
+        comment = next->second;
+        comment.remove_children();    // clear node content
     }
-    if(comment.empty()) {                                                     // no comments yet or this will be the last comment
+    else if (next == m_commentIndex.end()) {                                  // no comments yet or this will be the last comment
         comment = m_commentList.last_child_of_type(pugi::node_element);
         if (comment.empty()) {                                                   // if this is the only comment so far
             comment = m_commentList.prepend_child("comment");                                   // prepend new comment
@@ -436,19 +540,15 @@ bool XLComments::set(std::string const& cellRef, std::string const& commentText,
         }
         newCommentCreated = true;
     }
-    else {
-        XLCellReference ref(comment.attribute("ref").value());
-        if(ref.row() != destRow || ref.column() != destCol) {                 // if node has to be inserted *before* this one
-            comment = m_commentList.insert_child_before("comment", comment);        // insert new comment
-            copyLeadingWhitespaces(m_commentList, comment, comment.next_sibling()); // and copy whitespaces prefix from next node
-            newCommentCreated = true;
-        }
-        else // node exists / was found
-            comment.remove_children();    // clear node content
+    else {                                                                    // node has to be inserted *before* the next one
+        comment = m_commentList.insert_child_before("comment", next->second);      // insert new comment
+        copyLeadingWhitespaces(m_commentList, comment, comment.next_sibling());    // and copy whitespaces prefix from next node
+        newCommentCreated = true;
     }
 
-    // ===== If the list of nodes was modified, re-set m_hintNode that is used to access nodes by index
+    // ===== If the list of nodes was modified, index the new node and re-set m_hintNode that is used to access nodes by index
     if (newCommentCreated) {
+        next = m_commentIndex.emplace_hint(next, destKey, comment);
         m_hintNode = XMLNode{}; // reset hint after modification of comment list
         m_hintIndex = 0;
     }
@@ -462,18 +562,15 @@ bool XLComments::set(std::string const& cellRef, std::string const& commentText,
     tNode.prepend_child(pugi::node_pcdata).set_value(commentText.c_str()); // finally, insert <t> node_pcdata value
 
     if (m_vmlDrawing->valid()) {
+        if (!m_shapeIndexValid) buildShapeIndex();
         XLShape cShape{};
-        bool newShapeNeeded = newCommentCreated; // on new comments: create new shape
-        if (!newCommentCreated) {
-           try {
-               cShape = shape(cellRef); // for existing comments, try to access existing shape
-           }
-           catch (XLException const& e) {
-               newShapeNeeded = true; // not found: create fresh
-           }
-        }
-        if (newShapeNeeded)
+        const auto existingShape = m_shapeIndex.find(destKey);
+        if (existingShape != m_shapeIndex.end())
+            cShape = XLShape(existingShape->second); // for existing comments, use the existing shape
+        else {                                       // not found: create fresh
             cShape = m_vmlDrawing->createShape();
+            m_shapeIndex.emplace(destKey, *cShape.m_shapeNode);
+        }
 
         cShape.setFillColor("#ffffc0");
         cShape.setStroked(true);
@@ -561,8 +658,6 @@ bool XLComments::set(std::string const& cellRef, std::string const& commentText,
     }
     else
         throw XLException("XLComments::set: can not set (format) any comments when VML Drawing object is invalid");
-
-    return true;
 }
 
 /**
@@ -573,12 +668,14 @@ XLShape XLComments::shape(std::string const& cellRef)
     if (!m_vmlDrawing->valid())
         throw XLException("XLComments::shape: can not access any shapes when VML Drawing object is invalid");
 
-    XMLNode shape = m_vmlDrawing->shapeNode(cellRef);
-    if (shape.empty()) {
+    if (!m_shapeIndexValid) buildShapeIndex();
+    XLCellReference ref(cellRef);
+    const auto shape = m_shapeIndex.find(commentKey(ref.row(), ref.column()));
+    if (shape == m_shapeIndex.end()) {
         using namespace std::literals::string_literals;
         throw XLException("XLComments::shape: not found for cell "s + cellRef + " - was XLComment::set invoked first?"s);
     }
-    return XLShape(shape);
+    return XLShape(shape->second);
 }
 
 /**
@@ -45,6 +45,9 @@ YM      M9  MM    MM MM       MM    MM   d'  `MM.    MM            MM   d'  `MM.
 
 // ===== External Includes ===== //
 #include <algorithm>
+#include <chrono>         // std::chrono::seconds
+#include <exception>      // std::exception_ptr
+#include <map>
 #ifdef ENABLE_NOWIDE
 #    include <nowide/fstream.hpp>
 #endif
@@ -52,7 +55,9 @@ YM      M9  MM    MM MM       MM    MM   d'  `MM.    MM            MM   d'  `MM.
 #    include <random>
 #endif
 #include <pugixml.hpp>
+#include <string_view>
 #include <sys/stat.h>     // for stat, to test if a file exists and if a file is a directory
+#include <thread>         // std::thread
 #include <vector>         // std::vector
 
 // ===== OpenXLSX Includes ===== //
@@ -60,6 +65,9 @@ YM      M9  MM    MM MM       MM    MM   d'  `MM.    MM            MM   d'  `MM.
 #include "XLDocument.hpp"
 #include "XLSheet.hpp"
 #include "XLStyles.hpp"
+#include "utilities/XLParallel.hpp"
+#include "utilities/XLStatsRecorder.hpp"
+#include "utilities/XLTemplatePackage.hpp"
 #include "utilities/XLUtilities.hpp"
 
 // don't use "stat" directly because windows has compatibility-breaking defines
@@ -430,6 +438,34 @@ namespace
         0x0a, 0x00, 0x0a, 0x00, 0x80, 0x02, 0x00, 0x00, 0x8c, 0x1b, 0x00, 0x00, 0x00, 0x00
     };
 
+
+    /**
+     * @brief collect the formula cells of a worksheet in one sweep over sheetData
+     * @param sheetXml the worksheet XML document
+     * @return the cell keys (row << 16 | column) of all cells with a formula, in ascending order
+     */
+    std::vector<uint64_t> collectFormulaCells(const XMLDocument& sheetXml)
+    {
+        std::vector<uint64_t> cells;
+        const XMLNode sheetData = sheetXml.document_element().child("sheetData");
+        for (XMLNode row = sheetData.first_child_of_type(pugi::node_element); not row.empty(); row = row.next_sibling_of_type(pugi::node_element)) {
+            uint32_t rowNumber = row.attribute("r").as_uint();
+            uint16_t column    = 0;
+            for (XMLNode cell = row.first_child_of_type(pugi::node_element); not cell.empty(); cell = cell.next_sibling_of_type(pugi::node_element)) {
+                if (const XMLAttribute ref = cell.attribute("r"); not ref.empty()) {
+                    const XLCellReference cellRef(ref.value());
+                    rowNumber = cellRef.row();
+                    column    = cellRef.column();
+                }
+                else
+                    ++column;
+                if (not cell.child("f").empty()) cells.push_back((static_cast<uint64_t>(rowNumber) << 16) | column);
+            }
+        }
+        std::sort(cells.begin(), cells.end());    // a no-op for well-formed sheetData
+        cells.erase(std::unique(cells.begin(), cells.end()), cells.end());
+        return cells;
+    }
 }    // namespace
 
 XLDocument::XLDocument(const IZipArchive& zipArchive) : m_xmlSavingDeclaration{}, m_archive(zipArchive) {}
@@ -444,13 +480,57 @@ XLDocument::XLDocument(const std::string& docPath, const IZipArchive& zipArchive
 }
 
 /**
- * @details The destructor calls the closeDocument method before the object is destroyed.
+ * @details The destructor waits for a pending asynchronous operation, and calls the closeDocument method before the object
+ * is destroyed.
  */
 XLDocument::~XLDocument()
 {
+    if (m_pendingAsync.valid()) m_pendingAsync.wait();
     if (isOpen()) close();// 2024-05-31 prevent double-close if document has been manually closed before
 }
 
+/**
+ * @details The members are assigned in declaration order, which would replace (and free) m_xmlArena while the old m_data still holds
+ * pages of it. Hence m_data is emptied first, and the remaining members are then moved one by one.
+ */
+XLDocument& XLDocument::operator=(XLDocument&& other) noexcept
+{
+    if (this == &other) return *this;
+    if (m_pendingAsync.valid()) m_pendingAsync.wait();
+    if (isOpen()) close();
+    m_xmlDataIndex.clear();
+    m_xmlDataByRoot.clear();
+    m_data.clear();    // returns the XML pages of a document that was closed without clearing (e.g. a failed open) to m_xmlArena
+
+    m_suppressWarnings     = other.m_suppressWarnings;
+    m_leanXmlParsing       = other.m_leanXmlParsing;
+    m_openMode             = other.m_openMode;
+    m_xmlParseOptions      = other.m_xmlParseOptions;
+    m_memoryBudget         = other.m_memoryBudget;
+    m_filePath             = std::move(other.m_filePath);
+    m_xmlArenaEnabled      = other.m_xmlArenaEnabled;
+    m_xmlArena             = std::move(other.m_xmlArena);
+    m_sync                 = std::move(other.m_sync);
+    m_pendingAsync         = std::move(other.m_pendingAsync);
+    m_stats                = std::move(other.m_stats);
+    m_xmlSavingDeclaration = std::move(other.m_xmlSavingDeclaration);
+    m_data                 = std::move(other.m_data);
+    m_xmlDataIndex         = std::move(other.m_xmlDataIndex);
+    m_xmlDataByRoot        = std::move(other.m_xmlDataByRoot);
+    m_sharedStringCache    = std::move(other.m_sharedStringCache);
+    m_sharedStrings        = std::move(other.m_sharedStrings);
+    m_docRelationships     = std::move(other.m_docRelationships);
+    m_wbkRelationships     = std::move(other.m_wbkRelationships);
+    m_contentTypes         = std::move(other.m_contentTypes);
+    m_appProperties        = std::move(other.m_appProperties);
+    m_coreProperties       = std::move(other.m_coreProperties);
+    m_styles               = std::move(other.m_styles);
+    m_workbook             = std::move(other.m_workbook);
+    m_archive              = std::move(other.m_archive);
+    m_fileArchive          = std::move(other.m_fileArchive);
+    return *this;
+}
+
 /**
 * @details disable m_suppressWarnings
 */
@@ -461,6 +541,89 @@ void XLDocument::showWarnings() { m_suppressWarnings = false; }
 */
 void XLDocument::suppressWarnings() { m_suppressWarnings = true; }
 
+/**
+ * @details A read-only document keeps its lean parse options regardless of the setting
+ */
+void XLDocument::setLeanXmlParsing(bool lean)
+{
+    m_leanXmlParsing = lean;
+    if (m_openMode != XLOpenMode::ReadOnly) m_xmlParseOptions = (lean ? pugi_lean_parse_settings : pugi_parse_settings);
+}
+
+/**
+ * @details Pages of parts that are still parsed are returned to the arena on close(), and freed there
+ */
+void XLDocument::setXmlArena(bool enable)
+{
+    m_xmlArenaEnabled = enable;
+    if (not enable && m_xmlArena) m_xmlArena->trim();
+}
+
+/**
+ * @details
+ */
+size_t XLDocument::xmlArenaRetainedSize() const { return m_xmlArena ? m_xmlArena->retainedSize() : 0; }
+
+/**
+ * @details
+ */
+XLMemoryUsage XLDocument::memoryUsage() const
+{
+    XLMemoryUsage result;
+    for (const auto& item : m_data) {
+        if (not item.isLoaded() && not item.isSpilled()) continue;
+        const size_t size = item.residentSize();
+        result.parts.push_back(item.isLoaded() ? XLPartMemoryUsage { item.getXmlPath(), size, 0 }
+                                               : XLPartMemoryUsage { item.getXmlPath(), 0, size });
+        result.xmlParts += size;
+    }
+    if (m_archive.isValid()) result.zipEntries = m_archive.cachedDataSize();
+    for (const auto& str : m_sharedStringCache) result.sharedStrings += sizeof(std::string) + heapSize(str);
+    result.styles           = m_styles.memoryUsage();
+    result.xmlArenaRetained = xmlArenaRetainedSize();
+    return result;
+}
+
+/**
+ * @details
+ */
+XLStats XLDocument::stats() const { return m_stats->snapshot(); }
+
+/**
+ * @details
+ */
+void XLDocument::resetStats() { m_stats->reset(); }
+
+/**
+ * @details
+ */
+XLXmlArena* XLDocument::xmlArena() const { return m_xmlArenaEnabled ? m_xmlArena.get() : nullptr; }
+
+/**
+ * @details The parsed parts are measured once here - afterwards, each part is measured when it is parsed
+ */
+void XLDocument::setMemoryBudget(size_t bytes)
+{
+    m_memoryBudget = bytes;
+    if (m_memoryBudget == 0) return;
+    for (auto& item : m_data) {
+        if (not item.isLoaded()) continue;
+        item.residentSize();
+        item.touch();
+    }
+    enforceMemoryBudget(nullptr);
+}
+
+/**
+ * @details
+ */
+size_t XLDocument::memoryBudget() const { return m_memoryBudget; }
+
+/**
+ * @details
+ */
+size_t XLDocument::residentSize(const std::string& path) const { return getXmlData(path)->residentSize(); }
+
 /**
  * @details The openDocument method opens the .xlsx package in the following manner:
  * - Check if a document is already open. If yes, close it.
@@ -468,17 +631,21 @@ void XLDocument::suppressWarnings() { m_suppressWarnings = true; }
  * - Unzip the contents of the package to the temporary folder.
  * - load the contents into the data structure for manipulation.
  */
-void XLDocument::open(const std::string& fileName)
+void XLDocument::open(const std::string& fileName, XLOpenMode mode)
 {
     // Check if a document is already open. If yes, close it.
     if (m_archive.isOpen()) close(); // TBD: consider throwing if a file is already open.
-    m_filePath = fileName;
+    m_filePath        = fileName;
+    m_openMode        = mode;
+    m_xmlParseOptions = (mode == XLOpenMode::ReadOnly || m_leanXmlParsing ? pugi_lean_parse_settings : pugi_parse_settings);
+    m_stats->reset();
     m_archive.open(m_filePath);
+    const bool readOnly = (mode == XLOpenMode::ReadOnly);
 
     // ===== Add and open the Relationships and [Content_Types] files for the document level.
     std::string relsFilename = "_rels/.rels";
-    m_data.emplace_back(this, "[Content_Types].xml");
-    m_data.emplace_back(this, relsFilename);
+    addXmlData(this, "[Content_Types].xml");
+    addXmlData(this, relsFilename);
 
     m_contentTypes     = XLContentTypes(getXmlData("[Content_Types].xml"));
     m_docRelationships = XLRelationships(getXmlData(relsFilename), relsFilename);
@@ -488,7 +655,7 @@ void XLDocument::open(const std::string& fileName)
         if (item.type() == XLRelationshipType::Workbook) {
             workbookPath = item.target();
             if( workbookPath[ 0 ] == '/' ) workbookPath = workbookPath.substr(1); // NON STANDARD FORMATS: strip leading '/'
-            m_data.emplace_back(this, workbookPath, item.id(), XLContentType::Workbook);
+            addXmlData(this, workbookPath, item.id(), XLContentType::Workbook);
             workbookAdded = true;
     break;
         }
@@ -501,14 +668,12 @@ void XLDocument::open(const std::string& fileName)
         throw XLInputError(std::string("workbook path from "s + relsFilename + " has no folder name: "s) + workbookPath);
     }
     std::string workbookRelsFilename = std::string("xl/_rels/") + workbookPath.substr(pos + 1) + std::string(".rels");
-    m_data.emplace_back(this, workbookRelsFilename); // m_data.emplace_back(this, "xl/_rels/workbook.xml.rels");
+    addXmlData(this, workbookRelsFilename); // addXmlData(this, "xl/_rels/workbook.xml.rels");
     m_wbkRelationships = XLRelationships(getXmlData(workbookRelsFilename), workbookRelsFilename);
 
-    // ===== Create xl/styles.xml if missing
-    if (!m_archive.hasEntry("xl/styles.xml")) execCommand(XLCommand(XLCommandType::AddStyles));
-
-    // ===== Create xl/sharedStrings.xml from scratch if missing
-    if (!m_archive.hasEntry("xl/sharedStrings.xml")) execCommand(XLCommand(XLCommandType::AddSharedStrings));
+    // ===== Create xl/styles.xml and xl/sharedStrings.xml if missing - a read-only document gets in-memory defaults below instead
+    if (!readOnly && !m_archive.hasEntry("xl/styles.xml")) execCommand(XLCommand(XLCommandType::AddStyles));
+    if (!readOnly && !m_archive.hasEntry("xl/sharedStrings.xml")) execCommand(XLCommand(XLCommandType::AddSharedStrings));
 
     // ===== Add remaining spreadsheet elements to the vector of XLXmlData objects.
     for (auto& item : m_contentTypes.getContentItems()) {
@@ -525,6 +690,7 @@ void XLDocument::open(const std::string& fileName)
         bool isWorkbookPath = (item.path().substr(1) == workbookPath);      // determine once, use thrice
         if (!isWorkbookPath && item.path().substr(0, 4) == "/xl/") {
             if ((item.path().substr(4, 7) == "comment")
+                   ||(item.path().substr(4)     == "calcChain.xml")          // loaded on save, see updateCalcChain
                    ||(item.path().substr(4, 12) == "tables/table")
                    ||(item.path().substr(4, 19) == "drawings/vmlDrawing")
                    ||(item.path().substr(4, 22) == "worksheets/_rels/sheet")
@@ -536,7 +702,7 @@ void XLDocument::open(const std::string& fileName)
                    ||(item.path().substr(4)     == "styles.xml")
                    ||(item.path().substr(4, 11) == "theme/theme"))
             {
-                m_data.emplace_back(/* parentDoc */ this,
+                addXmlData(/* parentDoc */ this,
                                     /* xmlPath   */ item.path().substr(1),
                                     /* xmlID     */ m_wbkRelationships.relationshipByTarget(item.path().substr(4)).id(),
                                     /* xmlType   */ item.type());
@@ -549,24 +715,33 @@ void XLDocument::open(const std::string& fileName)
         else if (!isWorkbookPath || !workbookAdded) { // do not re-add workbook if it was previously added via m_docRelationships
             if (isWorkbookPath) {    // if workbook is found but workbook relationship did not exist in m_docRelationships
                 workbookAdded = true; // 2024-09-30 bugfix: was set to true after checking item.path() == workbookPath, not item.path().substr(1) as above
-                std::cerr << "adding missing workbook relationship to _rels/.rels" << std::endl;
-                m_docRelationships.addRelationship(XLRelationshipType::Workbook, workbookPath);    // Pull request #185: Fix missing workbook relationship
+                if (!readOnly) {
+                    std::cerr << "adding missing workbook relationship to _rels/.rels" << std::endl;
+                    m_docRelationships.addRelationship(XLRelationshipType::Workbook, workbookPath);    // Pull request #185: Fix missing workbook relationship
+                }
             }
-            m_data.emplace_back(/* parentDoc */ this,
+            addXmlData(/* parentDoc */ this,
                                 /* xmlPath   */ item.path().substr(1),
                                 /* xmlID     */ m_docRelationships.relationshipByTarget(item.path().substr(1)).id(),
                                 /* xmlType   */ item.type());
         }
     }
 
+    // ===== A read-only document without styles or shared strings gets empty parts that only exist in memory: XLStyles and
+    //        XLSharedStrings create their default content when no document element is found
+    if (readOnly && !hasXmlData("xl/styles.xml")) addXmlData(this, "xl/styles.xml", "", XLContentType::Styles);
+    if (readOnly && !hasXmlData("xl/sharedStrings.xml")) addXmlData(this, "xl/sharedStrings.xml", "", XLContentType::SharedStrings);
+
     // ===== Read shared strings table.
     XMLDocument* sharedStrings = getXmlData("xl/sharedStrings.xml")->getXmlDocument();
-    if (not sharedStrings->document_element().attribute("uniqueCount").empty())
-        sharedStrings->document_element().remove_attribute(
-            "uniqueCount");    // pull request #192 -> remove count & uniqueCount as they are optional
-    if (not sharedStrings->document_element().attribute("count").empty())
-        sharedStrings->document_element().remove_attribute(
-            "count");          // pull request #192 -> remove count & uniqueCount as they are optional
+    if (!readOnly) {
+        if (not sharedStrings->document_element().attribute("uniqueCount").empty())
+            sharedStrings->document_element().remove_attribute(
+                "uniqueCount");    // pull request #192 -> remove count & uniqueCount as they are optional
+        if (not sharedStrings->document_element().attribute("count").empty())
+            sharedStrings->document_element().remove_attribute(
+                "count");          // pull request #192 -> remove count & uniqueCount as they are optional
+    }
 
     XMLNode node =
         sharedStrings->document_element().first_child_of_type(pugi::node_element);    // pull request #186: Skip non-element nodes in sst.
@@ -607,22 +782,71 @@ void XLDocument::open(const std::string& fileName)
     m_workbook       = XLWorkbook(getXmlData(workbookPath));
     // 2024-05-31: moved XLWorkbook object creation up in code worksheets info can be used for XLAppProperties generation from scratch
 
-    // ===== 2024-06-03: creating core and extended properties if they do not exist
-    execCommand(XLCommand(XLCommandType::CheckAndFixCoreProperties));      // checks & fixes consistency of docProps/core.xml related data
-    execCommand(XLCommand(XLCommandType::CheckAndFixExtendedProperties));  // checks & fixes consistency of docProps/app.xml related data
+    if (readOnly) {
+        // ===== Missing document properties are represented by empty in-memory parts, see styles & shared strings above
+        if (!hasXmlData("docProps/core.xml")) addXmlData(this, "docProps/core.xml", "", XLContentType::CoreProperties);
+        if (!hasXmlData("docProps/app.xml")) addXmlData(this, "docProps/app.xml", "", XLContentType::ExtendedProperties);
+    }
+    else {
+        // ===== 2024-06-03: creating core and extended properties if they do not exist
+        execCommand(XLCommand(XLCommandType::CheckAndFixCoreProperties));      // checks & fixes consistency of docProps/core.xml related data
+        execCommand(XLCommand(XLCommandType::CheckAndFixExtendedProperties));  // checks & fixes consistency of docProps/app.xml related data
 
-    if (!hasXmlData("docProps/core.xml") || !hasXmlData("docProps/app.xml"))
-        throw XLInternalError("Failed to repair docProps (core.xml and/or app.xml)");
+        if (!hasXmlData("docProps/core.xml") || !hasXmlData("docProps/app.xml"))
+            throw XLInternalError("Failed to repair docProps (core.xml and/or app.xml)");
+    }
 
     m_coreProperties = XLProperties(getXmlData("docProps/core.xml"));
     m_appProperties  = XLAppProperties(getXmlData("docProps/app.xml"), m_workbook.xmlDocument());
     // ===== 2024-09-02: ensure that all worksheets are contained in app.xml <TitlesOfParts> and reflected in <HeadingPairs> value for Worksheets
-    m_appProperties.alignWorksheets(m_workbook.sheetNames());
+    if (!readOnly) m_appProperties.alignWorksheets(m_workbook.sheetNames());
 
     m_sharedStrings  = XLSharedStrings(getXmlData("xl/sharedStrings.xml"), &m_sharedStringCache);
     m_styles         = XLStyles(getXmlData("xl/styles.xml"), m_suppressWarnings); // 2024-10-14: forward supress warnings setting to XLStyles
 }
 
+/**
+ * @details The fork is set up in the following manner:
+ * - Close a document that is already open, and set aside the archive the document was constructed with.
+ * - Fork the template's archive: the fork reads unchanged entries from the template's package, and records its own changes.
+ * - Register the same parts as the template's document, and copy the DOMs of the parts the template has parsed.
+ * - Bind the document level objects to the copied parts.
+ * The template has already applied the repairs of open(), so none of them is repeated here.
+ */
+void XLDocument::open(const XLTemplate& source)
+{
+    if (not source.valid()) throw XLInputError("XLDocument::open: the template is not valid");
+    const XLTemplatePackage& package  = *source.m_package;
+    const XLDocument&        original = package.document;
+
+    if (m_archive.isOpen()) close();
+    m_fileArchive     = std::make_unique<IZipArchive>(std::move(m_archive));
+    m_archive         = IZipArchive(package.archive.fork());
+    m_filePath.clear();
+    m_openMode        = XLOpenMode::ReadWrite;
+    m_xmlParseOptions = (m_leanXmlParsing ? pugi_lean_parse_settings : pugi_parse_settings);
+    m_stats->reset();
+
+    for (const auto& item : original.m_data) {
+        XLXmlData& xmlData = addXmlData(this, item.getXmlPath(), item.getXmlID(), item.getXmlType());
+        if (item.isLoaded()) xmlData.copyXmlDocument(item);
+    }
+    m_sharedStringCache = original.m_sharedStringCache;
+
+    // ===== The paths as determined by open(const std::string&)
+    const std::string relsFilename         = "_rels/.rels";
+    const std::string workbookPath         = original.m_workbook.getXmlPath();
+    const std::string workbookRelsFilename = "xl/_rels/" + workbookPath.substr(workbookPath.find_last_of('/') + 1) + ".rels";
+    m_contentTypes     = XLContentTypes(getXmlData("[Content_Types].xml"));
+    m_docRelationships = XLRelationships(getXmlData(relsFilename), relsFilename);
+    m_wbkRelationships = XLRelationships(getXmlData(workbookRelsFilename), workbookRelsFilename);
+    m_workbook         = XLWorkbook(getXmlData(workbookPath));
+    m_coreProperties   = XLProperties(getXmlData("docProps/core.xml"));
+    m_appProperties    = XLAppProperties(getXmlData("docProps/app.xml"), m_workbook.xmlDocument());
+    m_sharedStrings    = XLSharedStrings(getXmlData("xl/sharedStrings.xml"), &m_sharedStringCache);
+    m_styles           = XLStyles(getXmlData("xl/styles.xml"), m_suppressWarnings);
+}
+
 namespace {
     /**
      * @brief Test if path exists as either a file or a directory
@@ -664,6 +888,46 @@ namespace {
 #ifdef __GNUC__    // conditionally enable GCC specific pragmas to suppress unused function warning
 #   pragma GCC diagnostic pop
 #endif // __GNUC__
+
+    /**
+     * @brief Get the size of a file
+     * @return the size in bytes, 0 if the file does not exist
+     */
+    uint64_t fileSize(const std::string& fileName)
+    {
+        STATSTRUCT info;
+        if (STAT(fileName.c_str(), &info) == 0) return static_cast<uint64_t>(info.st_size);
+        return 0;
+    }
+
+    /**
+     * @brief Forwards the parts of one stage to an XLProgressCallback, one call at a time
+     */
+    class ProgressReporter
+    {
+    public:
+        ProgressReporter(const XLProgressCallback& callback, XLProgressStage stage, size_t partCount)
+            : m_callback(callback), m_stage(stage), m_partCount(partCount) {}
+
+        void report(const std::string& part, uint64_t bytes)
+        {
+            if (not m_callback) return;
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_callback(XLProgress { m_stage, part, bytes, ++m_partIndex, m_partCount });
+        }
+
+    private:
+        const XLProgressCallback& m_callback;
+        XLProgressStage           m_stage;
+        size_t                    m_partCount;
+        size_t                    m_partIndex {0};
+        std::mutex                m_mutex {};
+    };
+
+    /**
+     * @brief The number of background workers of the asynchronous operations
+     */
+    unsigned asyncThreads() { return std::max(1u, std::thread::hardware_concurrency()); }
 } // anonymous namespace
 
 /**
@@ -705,13 +969,22 @@ void XLDocument::create(const std::string& fileName) { create( fileName, XLForce
 void XLDocument::close()
 {
     if (m_archive.isValid()) m_archive.close();
+    if (m_fileArchive) {    // a template fork: restore the archive the document was constructed with
+        m_archive = std::move(*m_fileArchive);
+        m_fileArchive.reset();
+    }
     // m_suppressWarnings shall remain in the configured setting
 
     m_filePath.clear();
+    m_openMode        = XLOpenMode::ReadWrite;
+    m_xmlParseOptions = (m_leanXmlParsing ? pugi_lean_parse_settings : pugi_parse_settings);
 
     m_xmlSavingDeclaration = XLXmlSavingDeclaration();
 
-    m_data.clear();
+    m_xmlDataIndex.clear();
+    m_xmlDataByRoot.clear();
+    m_data.clear();                          // returns the XML pages to m_xmlArena for the next open()
+    if (not m_xmlArenaEnabled && m_xmlArena) m_xmlArena->trim();
     m_sharedStringCache.clear();             // 2024-12-18 BUGFIX: clear shared strings cache - addresses issue #283
     m_sharedStrings    = XLSharedStrings();  //
 
@@ -728,37 +1001,84 @@ void XLDocument::close()
 /**
  * @details Save the document with the same name. The existing file will be overwritten.
  */
-void XLDocument::save() { saveAs(m_filePath, XLForceOverwrite); }
+void XLDocument::save()
+{
+    if (m_filePath.empty()) throw XLException("XLDocument::save: the document has no file name yet, use saveAs");
+    saveAs(m_filePath, XLForceOverwrite);
+}
 
 /**
- * @details Save the document with a new name. If present, the 'calcChain.xml file will be ignored. The reason for this
- * is that changes to the document may invalidate the calcChain.xml file. Deleting will force Excel to re-create the
- * file. This will happen automatically, without the user noticing.
+ * @details Save the document with a new name. Changes to the document may invalidate the calcChain.xml file, which Excel
+ * reports as a corrupted document. Rather than deleting the calculation chain (forcing every consumer into a full
+ * dependency rebuild), it is updated to the current formula cells before saving, see updateCalcChain.
  */
 void XLDocument::saveAs(const std::string& fileName, bool forceOverwrite)
 {
+    const std::atomic<bool> notCancelled {false};
+    saveParts(fileName, forceOverwrite, XLProgressCallback(), notCancelled, 1);
+}
+
+/**
+ * @details The parts are serialized first (in parallel if threads > 1), and only added to the archive once all of them are
+ *  done, so that a cancelled save does not leave a partially updated archive behind.
+ */
+XLAsyncStatus XLDocument::saveParts(const std::string&        fileName,
+                                    bool                      forceOverwrite,
+                                    const XLProgressCallback& progress,
+                                    const std::atomic<bool>&  cancel,
+                                    unsigned                  threads)
+{
+    if (m_openMode == XLOpenMode::ReadOnly) throw XLException("XLDocument::saveAs: document " + m_filePath + " was opened read-only");
+
     // 2024-07-26: prevent silent overwriting of existing files
     if (!forceOverwrite && pathExists(fileName)) {
         using namespace std::literals::string_literals;
         throw XLException("XLDocument::saveAs: refusing to overwrite existing file "s + fileName);
     }
+    if (cancel) return XLAsyncStatus::Cancelled;
 
-    m_filePath = fileName;
+    // ===== Keep the calcChain.xml file in line with the formula cells
+    execCommand(XLCommand(XLCommandType::UpdateCalcChain));
 
-    // ===== Delete the calcChain.xml file in order to force re-calculation of the sheet
-    // TODO: Is this the best way to do it? Maybe there is a flag that can be set, that forces re-calculalion.
-    execCommand(XLCommand(XLCommandType::ResetCalcChain));
+    // ===== Serialize all xml items. Items that were never parsed are unchanged: the archive copies their compressed data as-is
+    std::vector<XLXmlData*> parts;
+    for (auto& item : m_data)
+        if (item.isLoaded() || item.isSpilled()) parts.push_back(&item);
 
-    // ===== Add all xml items to archive and save the archive.
-    for (auto& item : m_data) {
+    std::vector<std::string> rawData(parts.size());
+    ProgressReporter         reporter(progress, XLProgressStage::Serialize, parts.size());
+    runParallel(parts.size(), m_memoryBudget > 0 ? 1 : threads, [&](size_t i) {    // re-loading a spilled part may evict others
         bool xmlIsStandalone = m_xmlSavingDeclaration.standalone_as_bool();
-        if ((item.getXmlPath() == "docProps/core.xml")
-          ||(item.getXmlPath() == "docProps/app.xml"))
+        if ((parts[i]->getXmlPath() == "docProps/core.xml")
+          ||(parts[i]->getXmlPath() == "docProps/app.xml"))
             xmlIsStandalone = XLXmlStandalone;
-        m_archive.addEntry(item.getXmlPath(),
-            item.getRawData(XLXmlSavingDeclaration(m_xmlSavingDeclaration.version(), m_xmlSavingDeclaration.encoding(),xmlIsStandalone)));
+        OPENXLSX_STATS_TIMER(timer, m_stats.get(), XLStatsPhase::Serialize, parts[i]->getXmlPath());
+        rawData[i] = parts[i]->getRawData(XLXmlSavingDeclaration(m_xmlSavingDeclaration.version(), m_xmlSavingDeclaration.encoding(),xmlIsStandalone));
+        OPENXLSX_STATS_BYTES(timer, rawData[i].size());
+        reporter.report(parts[i]->getXmlPath(), rawData[i].size());
+    }, &cancel);
+    if (cancel) return XLAsyncStatus::Cancelled;
+
+    // ===== Add the items to the archive and save the archive
+    for (size_t i = 0; i < parts.size(); ++i) {
+        m_archive.addEntry(parts[i]->getXmlPath(), rawData[i]);
+        std::string().swap(rawData[i]);
     }
+    m_filePath = fileName;
+#ifdef OPENXLSX_ENABLE_STATS
+    archiveSaveDurations() = XLArchiveSaveDurations();
+    const uint64_t saveStart = XLStatsCollector::now();
+    m_archive.save(m_filePath);
+    const uint64_t               saveTime  = XLStatsCollector::now() - saveStart;
+    const XLArchiveSaveDurations durations = archiveSaveDurations();
+    const uint64_t               deflate   = durations.reported ? durations.deflate : saveTime;
+    m_stats->record(XLStatsPhase::Deflate, m_filePath, saveStart, deflate, fileSize(m_filePath));
+    if (durations.reported) m_stats->record(XLStatsPhase::Validate, m_filePath, saveStart + deflate, durations.validate, 0);
+#else
     m_archive.save(m_filePath);
+#endif
+    ProgressReporter(progress, XLProgressStage::Compress, 1).report(m_filePath, fileSize(m_filePath));
+    return XLAsyncStatus::Completed;
 }
 
 /**
@@ -768,6 +1088,110 @@ void XLDocument::saveAs(const std::string& fileName, bool forceOverwrite)
  */
 void XLDocument::saveAs(const std::string& fileName) { saveAs( fileName, XLForceOverwrite ); }
 
+/**
+ * @details
+ */
+XLAsyncResult::XLAsyncResult(std::shared_future<XLAsyncStatus> future, std::shared_ptr<std::atomic<bool>> cancelFlag)
+    : m_future(std::move(future)),
+      m_cancel(std::move(cancelFlag))
+{}
+
+/**
+ * @details
+ */
+bool XLAsyncResult::valid() const { return m_future.valid(); }
+
+/**
+ * @details
+ */
+bool XLAsyncResult::ready() const { return m_future.valid() && m_future.wait_for(std::chrono::seconds(0)) == std::future_status::ready; }
+
+/**
+ * @details
+ */
+void XLAsyncResult::wait() const { m_future.wait(); }
+
+/**
+ * @details
+ */
+XLAsyncStatus XLAsyncResult::get() const { return m_future.get(); }
+
+/**
+ * @details
+ */
+void XLAsyncResult::cancel()
+{
+    if (m_cancel) *m_cancel = true;
+}
+
+/**
+ * @details The document keeps a copy of the future: the last copy of a std::async future blocks until the thread finished,
+ *  so dropping the returned handle does not block the caller, and the destructor of the document waits for the operation.
+ */
+XLAsyncResult XLDocument::startAsync(std::function<XLAsyncStatus(const std::atomic<bool>&)> operation)
+{
+    if (m_pendingAsync.valid() && m_pendingAsync.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+        throw XLException("XLDocument: another asynchronous operation is still running on document " + m_filePath);
+
+    auto cancel    = std::make_shared<std::atomic<bool>>(false);
+    m_pendingAsync = std::async(std::launch::async, [operation = std::move(operation), cancel]() { return operation(*cancel); }).share();
+    return XLAsyncResult(m_pendingAsync, cancel);
+}
+
+/**
+ * @details The parts that open() parsed are reported first, then the sheets are parsed by several workers. Parsing different
+ *  parts concurrently is safe, see the concurrent read contract of open().
+ */
+XLAsyncResult XLDocument::openAsync(const std::string& fileName, XLOpenMode mode, XLProgressCallback progress)
+{
+    return startAsync([this, fileName, mode, progress = std::move(progress)](const std::atomic<bool>& cancel) {
+        if (cancel) return XLAsyncStatus::Cancelled;
+        try {
+            open(fileName, mode);
+
+            std::vector<XLXmlData*> parsed;
+            std::vector<XLXmlData*> pending;
+            for (auto& item : m_data) {
+                if (item.isLoaded())
+                    parsed.push_back(&item);
+                else if (m_memoryBudget == 0 && (item.getXmlType() == XLContentType::Worksheet || item.getXmlType() == XLContentType::Chartsheet))
+                    pending.push_back(&item);
+            }
+
+            ProgressReporter reporter(progress, XLProgressStage::Parse, parsed.size() + pending.size());
+            for (const auto* item : parsed) reporter.report(item->getXmlPath(), item->m_textSize);
+            runParallel(pending.size(), asyncThreads(), [&](size_t i) {
+                pending[i]->getXmlDocument();
+                reporter.report(pending[i]->getXmlPath(), pending[i]->m_textSize);
+            }, &cancel);
+        }
+        catch (...) {
+            close();
+            throw;
+        }
+        if (cancel) {
+            close();
+            return XLAsyncStatus::Cancelled;
+        }
+        return XLAsyncStatus::Completed;
+    });
+}
+
+/**
+ * @details
+ */
+XLAsyncResult XLDocument::saveAsync(XLProgressCallback progress) { return saveAsAsync(m_filePath, XLForceOverwrite, std::move(progress)); }
+
+/**
+ * @details
+ */
+XLAsyncResult XLDocument::saveAsAsync(const std::string& fileName, bool forceOverwrite, XLProgressCallback progress)
+{
+    return startAsync([this, fileName, forceOverwrite, progress = std::move(progress)](const std::atomic<bool>& cancel) {
+        return saveParts(fileName, forceOverwrite, progress, cancel, asyncThreads());
+    });
+}
+
 /**
  * @details
  */
@@ -1021,6 +1445,16 @@ XLDocument::operator bool() const
  */
 bool XLDocument::isOpen() const { return this->operator bool(); }
 
+/**
+ * @details
+ */
+bool XLDocument::isReadOnly() const { return m_openMode == XLOpenMode::ReadOnly; }
+
+/**
+ * @details
+ */
+unsigned int XLDocument::xmlParseOptions() const { return m_xmlParseOptions; }
+
 /**
 * @details fetch a reference to m_styles
 */
@@ -1079,7 +1513,7 @@ XLRelationships XLDocument::sheetRelationships(uint16_t sheetXmlNo)
     constexpr const bool DO_NOT_THROW = true;
     XLXmlData *xmlData = getXmlData(relsFilename, DO_NOT_THROW);
     if (xmlData == nullptr) // if not yet managed: add the sheet relationships file to the managed files
-        xmlData = &m_data.emplace_back(this, relsFilename, "", XLContentType::Relationships);
+        xmlData = &addXmlData(this, relsFilename, "", XLContentType::Relationships);
 
     return XLRelationships(xmlData, relsFilename);
 }
@@ -1100,7 +1534,7 @@ XLVmlDrawing XLDocument::sheetVmlDrawing(uint16_t sheetXmlNo)
     constexpr const bool DO_NOT_THROW = true;
     XLXmlData *xmlData = getXmlData(vmlDrawingFilename, DO_NOT_THROW);
     if (xmlData == nullptr) // if not yet managed: add the sheet drawing file to the managed files
-        xmlData = &m_data.emplace_back(this, vmlDrawingFilename, "", XLContentType::VMLDrawing);
+        xmlData = &addXmlData(this, vmlDrawingFilename, "", XLContentType::VMLDrawing);
 
     return XLVmlDrawing(xmlData);
 }
@@ -1121,7 +1555,7 @@ XLComments XLDocument::sheetComments(uint16_t sheetXmlNo)
     constexpr const bool DO_NOT_THROW = true;
     XLXmlData *xmlData = getXmlData(commentsFilename, DO_NOT_THROW);
     if (xmlData == nullptr) // if not yet managed: add the sheet comments file to the managed files
-        xmlData = &m_data.emplace_back(this, commentsFilename, "", XLContentType::Comments);
+        xmlData = &addXmlData(this, commentsFilename, "", XLContentType::Comments);
 
     return XLComments(xmlData);
 }
@@ -1142,7 +1576,7 @@ XLTables XLDocument::sheetTables(uint16_t sheetXmlNo)
     constexpr const bool DO_NOT_THROW = true;
     XLXmlData *xmlData = getXmlData(tablesFilename, DO_NOT_THROW);
     if (xmlData == nullptr) // if not yet managed: add the sheet tables file to the managed files
-        xmlData = &m_data.emplace_back(this, tablesFilename, "", XLContentType::Table);
+        xmlData = &addXmlData(this, tablesFilename, "", XLContentType::Table);
 
     return XLTables(xmlData);
 }
@@ -1233,11 +1667,16 @@ bool XLDocument::execCommand(const XLCommand& command)
 
         case XLCommandType::ResetCalcChain: {
             m_archive.deleteEntry("xl/calcChain.xml");
-            const auto item =
-                std::find_if(m_data.begin(), m_data.end(), [&](const XLXmlData& theItem) { return theItem.getXmlPath() == "xl/calcChain.xml"; });
-
-            if (item != m_data.end()) m_data.erase(item);
+            eraseXmlData("xl/calcChain.xml");
+            m_contentTypes.deleteOverride("/xl/calcChain.xml");
+            if (m_wbkRelationships.targetExists("calcChain.xml"))
+                m_wbkRelationships.deleteRelationship(m_wbkRelationships.relationshipByTarget("calcChain.xml"));
         } break;
+        case XLCommandType::UpdateCalcChain: {
+            OPENXLSX_STATS_TIMER(timer, m_stats.get(), XLStatsPhase::Cleanup, "xl/calcChain.xml");
+            updateCalcChain();
+            break;
+        }
         case XLCommandType::CheckAndFixCoreProperties: {    // does nothing if core properties are in good shape
             // ===== If _rels/.rels has no entry for docProps/core.xml
             if (!m_docRelationships.targetExists("docProps/core.xml"))
@@ -1251,7 +1690,7 @@ bool XLDocument::execCommand(const XLCommand& command)
             // ===== If [Content Types].xml has no relationship for docProps/core.xml
             if (!hasXmlData("docProps/core.xml")) {
                 m_contentTypes.addOverride("/docProps/core.xml", XLContentType::CoreProperties);    // add content types entry
-                m_data.emplace_back(                                                                // store new entry in m_data
+                addXmlData(                                                                // store new entry in m_data
                     /* parentDoc */ this,
                     /* xmlPath   */ "docProps/core.xml",
                     /* xmlID     */ m_docRelationships.relationshipByTarget("docProps/core.xml").id(),
@@ -1271,7 +1710,7 @@ bool XLDocument::execCommand(const XLCommand& command)
             // ===== If [Content Types].xml has no relationship for docProps/app.xml
             if (!hasXmlData("docProps/app.xml")) {
                 m_contentTypes.addOverride("/docProps/app.xml", XLContentType::ExtendedProperties);    // add content types entry
-                m_data.emplace_back(                                                                   // store new entry in m_data
+                addXmlData(                                                                   // store new entry in m_data
                     /* parentDoc */ this,
                     /* xmlPath   */ "docProps/app.xml",
                     /* xmlID     */ m_docRelationships.relationshipByTarget("docProps/app.xml").id(),
@@ -1305,7 +1744,7 @@ bool XLDocument::execCommand(const XLCommand& command)
             m_wbkRelationships.addRelationship(XLRelationshipType::Worksheet, command.getParam<std::string>("sheetPath").substr(4));
             m_appProperties.appendSheetName(command.getParam<std::string>("sheetName"));
             m_archive.addEntry(command.getParam<std::string>("sheetPath").substr(1), emptyWorksheet);
-            m_data.emplace_back(
+            addXmlData(
                 /* parentDoc */ this,
                 /* xmlPath   */ command.getParam<std::string>("sheetPath").substr(1),
                 /* xmlID     */ m_wbkRelationships.relationshipByTarget(command.getParam<std::string>("sheetPath").substr(4)).id(),
@@ -1321,9 +1760,7 @@ bool XLDocument::execCommand(const XLCommand& command)
             m_archive.deleteEntry(sheetPath.substr(1));
             m_contentTypes.deleteOverride(sheetPath);
             m_wbkRelationships.deleteRelationship(command.getParam<std::string>("sheetID"));
-            m_data.erase(std::find_if(m_data.begin(), m_data.end(), [&](const XLXmlData& item) {
-                return item.getXmlPath() == sheetPath.substr(1);
-            }));
+            eraseXmlData(sheetPath.substr(1));
         } break;
         case XLCommandType::CloneSheet: {
             validateSheetName(command.getParam<std::string>("cloneName"), THROW_ON_INVALID);
@@ -1341,10 +1778,8 @@ bool XLDocument::execCommand(const XLCommand& command)
                 m_wbkRelationships.addRelationship(XLRelationshipType::Worksheet, sheetPath.substr(4));
                 m_appProperties.appendSheetName(command.getParam<std::string>("cloneName"));
                 m_archive.addEntry(sheetPath.substr(1),
-                                   std::find_if(m_data.begin(), m_data.end(), [&](const XLXmlData& data) {
-                                       return data.getXmlPath().substr(3) == sheetToClonePath; // 2024-12-15: ensure relative sheet path
-                                   })->getRawData());
-                m_data.emplace_back(
+                                   getXmlData("xl/" + sheetToClonePath)->getRawData()); // 2024-12-15: ensure relative sheet path
+                addXmlData(
                     /* parentDoc */ this,
                     /* xmlPath   */ sheetPath.substr(1),
                     /* xmlID     */ m_wbkRelationships.relationshipByTarget(sheetPath.substr(4)).id(),
@@ -1355,10 +1790,8 @@ bool XLDocument::execCommand(const XLCommand& command)
                 m_wbkRelationships.addRelationship(XLRelationshipType::Chartsheet, sheetPath.substr(4));
                 m_appProperties.appendSheetName(command.getParam<std::string>("cloneName"));
                 m_archive.addEntry(sheetPath.substr(1),
-                                   std::find_if(m_data.begin(), m_data.end(), [&](const XLXmlData& data) {
-                                       return data.getXmlPath().substr(3) == sheetToClonePath; // 2024-12-15: ensure relative sheet path
-                                   })->getRawData());
-                m_data.emplace_back(
+                                   getXmlData("xl/" + sheetToClonePath)->getRawData()); // 2024-12-15: ensure relative sheet path
+                addXmlData(
                     /* parentDoc */ this,
                     /* xmlPath   */ sheetPath.substr(1),
                     /* xmlID     */ m_wbkRelationships.relationshipByTarget(sheetPath.substr(4)).id(),
@@ -1430,12 +1863,16 @@ XLQuery XLDocument::execQuery(const XLQuery& query) const
             return XLQuery(query).setResult(m_sharedStrings);
 
         case XLQueryType::QueryXmlData: {
-            const auto result = std::find_if(m_data.begin(), m_data.end(), [&](const XLXmlData& item) {
-                return item.getXmlPath() == query.getParam<std::string>("xmlPath");
-            });
-            if (result == m_data.end())
+            const auto result = m_xmlDataIndex.find(query.getParam<std::string>("xmlPath"));
+            if (result == m_xmlDataIndex.end())
                 throw XLInternalError("Path does not exist in zip archive (" + query.getParam<std::string>("xmlPath") + ")");
-            return XLQuery(query).setResult(&*result);
+            return XLQuery(query).setResult(result->second);
+        }
+
+        case XLQueryType::QueryXmlDataOfNode: {    // the part whose XML document holds the node, e.g. the worksheet of a cell
+            const auto result = m_xmlDataByRoot.find(query.getParam<XMLNode>("xmlNode").root().internal_object());
+            if (result == m_xmlDataByRoot.end()) throw XLInternalError("XML node does not belong to a part of the document");
+            return XLQuery(query).setResult(result->second);
         }
         default:
             throw XLInternalError("XLDocument::execQuery: unknown query type " + std::to_string(static_cast<uint8_t>(query.type())));
@@ -1459,6 +1896,7 @@ void XLDocument::setSavingDeclaration(XLXmlSavingDeclaration const& savingDeclar
  */
 void XLDocument::cleanupSharedStrings()
 {
+    OPENXLSX_STATS_TIMER(timer, m_stats.get(), XLStatsPhase::Cleanup, "xl/sharedStrings.xml");
     int32_t oldStringCount = m_sharedStringCache.size();
     std::vector< int32_t > indexMap(oldStringCount, -1);      // indexMap[ oldIndex ] :== newIndex, -1 = not yet assigned
     int32_t newStringCount = 1; // reserve index 0 for empty string, count here +1 for each unique shared string index that is in use in the worksheet
@@ -1510,6 +1948,73 @@ void XLDocument::cleanupSharedStrings()
         throw XLInternalError("XLDocument::cleanupSharedStrings: failed to rewrite shared string table - document would be corrupted");
 }
 
+/**
+ * @details a single sweep over all worksheet XML collects the style references (cell & row s attributes, column style attributes,
+ *          conditional formatting dxfId attributes), XLStyles::compact drops the unreferenced entries, then the collected attributes are renumbered.
+ *          A BudgetHold keeps the swept worksheets parsed until then, so that the collected attributes remain valid under a memory budget.
+ */
+void XLDocument::compactStyles()
+{
+    if (m_openMode == XLOpenMode::ReadOnly) throw XLException("XLDocument::compactStyles: document " + m_filePath + " was opened read-only");
+
+    BudgetHold hold(*this);
+    std::vector<bool> cellFormatsInUse(m_styles.cellFormats().count(), false);
+    std::vector<bool> diffCellFormatsInUse(m_styles.diffCellFormats().count(), false);
+    std::vector<XMLAttribute> cellFormatReferences;
+    std::vector<XMLNode>      diffCellFormatRules;
+
+    auto addReference = [](XMLAttribute attr, std::vector<XMLAttribute>& references, std::vector<bool>& inUse) {
+        if (attr.empty()) return;
+        XLStyleIndex index = attr.as_uint(XLInvalidUInt32);
+        if (index < inUse.size()) inUse[index] = true;
+        references.push_back(attr);
+    };
+
+    for (XLXmlData& item : m_data) {
+        if (item.getXmlType() != XLContentType::Worksheet) continue;
+        XMLNode worksheet = item.getXmlDocument()->document_element();
+
+        for (XMLNode col = worksheet.child("cols").first_child_of_type(pugi::node_element); not col.empty(); col = col.next_sibling_of_type(pugi::node_element))
+            addReference(col.attribute("style"), cellFormatReferences, cellFormatsInUse);
+
+        for (XMLNode row = worksheet.child("sheetData").first_child_of_type(pugi::node_element); not row.empty(); row = row.next_sibling_of_type(pugi::node_element)) {
+            addReference(row.attribute("s"), cellFormatReferences, cellFormatsInUse);
+            for (XMLNode cell = row.first_child_of_type(pugi::node_element); not cell.empty(); cell = cell.next_sibling_of_type(pugi::node_element))
+                addReference(cell.attribute("s"), cellFormatReferences, cellFormatsInUse);
+        }
+
+        for (XMLNode cf = worksheet.child("conditionalFormatting"); not cf.empty(); cf = cf.next_sibling("conditionalFormatting"))
+            for (XMLNode rule = cf.child("cfRule"); not rule.empty(); rule = rule.next_sibling("cfRule"))
+                if (XMLAttribute dxfId = rule.attribute("dxfId"); not dxfId.empty()) {
+                    if (dxfId.as_uint(XLInvalidUInt32) < diffCellFormatsInUse.size()) diffCellFormatsInUse[dxfId.as_uint()] = true;
+                    diffCellFormatRules.push_back(rule);
+                }
+    }
+
+    // ===== Tables and pivot tables are not loaded, but may reference differential formats: keep all of them in that case
+    for (XLContentItem const& contentItem : m_contentTypes.getContentItems()) {
+        if (contentItem.type() == XLContentType::Table || contentItem.path().find("/pivotTables/") != std::string::npos) {
+            diffCellFormatsInUse.assign(diffCellFormatsInUse.size(), true);
+            break;
+        }
+    }
+
+    XLStyleCompactionMap indexMap = m_styles.compact(std::move(cellFormatsInUse), std::move(diffCellFormatsInUse));
+
+    // ===== Renumber the collected references. References to non-existing entries are reset to the default format
+    for (XMLAttribute& attr : cellFormatReferences) {
+        XLStyleIndex index = attr.as_uint(XLInvalidUInt32);
+        attr.set_value(index < indexMap.cellFormats.size() ? indexMap.cellFormats[index] : XLDefaultCellFormat);
+    }
+    for (XMLNode& rule : diffCellFormatRules) {
+        XLStyleIndex index = rule.attribute("dxfId").as_uint(XLInvalidUInt32);
+        if (index < indexMap.diffCellFormats.size())
+            rule.attribute("dxfId").set_value(indexMap.diffCellFormats[index]);
+        else
+            rule.remove_attribute("dxfId");    // a dxfId is optional: drop a reference to a non-existing entry
+    }
+}
+
 //----------------------------------------------------------------------------------------------------------------------
 //           Protected Member Functions
 //----------------------------------------------------------------------------------------------------------------------
@@ -1519,7 +2024,11 @@ void XLDocument::cleanupSharedStrings()
  */
 std::string XLDocument::extractXmlFromArchive(const std::string& path)
 {
-    return (m_archive.hasEntry(path) ? m_archive.getEntry(path) : "");
+    std::lock_guard<std::mutex> lock(m_sync->archive);    // parts may be parsed by concurrent readers
+    OPENXLSX_STATS_TIMER(timer, m_stats.get(), XLStatsPhase::Inflate, path);
+    std::string xml = (m_archive.hasEntry(path) ? m_archive.getEntry(path) : "");
+    OPENXLSX_STATS_BYTES(timer, xml.size());
+    return xml;
 }
 
 /**
@@ -1536,12 +2045,12 @@ XLXmlData* XLDocument::getXmlData(const std::string& path, bool doNotThrow)
  */
 const XLXmlData* XLDocument::getXmlData(const std::string& path, bool doNotThrow) const
 {
-    std::list<XLXmlData>::iterator result = std::find_if(m_data.begin(), m_data.end(), [&](const XLXmlData& item) { return item.getXmlPath() == path; });
-    if (result == m_data.end()) {
+    const auto result = m_xmlDataIndex.find(path);
+    if (result == m_xmlDataIndex.end()) {
         if (doNotThrow) return nullptr; // use with caution
         else throw XLInternalError("Path " + path + " does not exist in zip archive.");
     }
-    return &*result;
+    return result->second;
 }
 
 /**
@@ -1549,7 +2058,210 @@ const XLXmlData* XLDocument::getXmlData(const std::string& path, bool doNotThrow
  */
 bool XLDocument::hasXmlData(const std::string& path) const
 {
-    return std::find_if(m_data.begin(), m_data.end(), [&](const XLXmlData& item) { return item.getXmlPath() == path; }) != m_data.end();
+    return m_xmlDataIndex.find(path) != m_xmlDataIndex.end();
+}
+
+/**
+ * @details Sizes are the estimates taken when each part was parsed - growth through later edits is not tracked. Only worksheet and
+ *          chartsheet parts are evicted: all other parts are either small or referred to by the document-level objects. Without
+ *          dirty tracking, every worksheet of a read-write document is spilled, so that no edit is lost. Parts that are pinned, or
+ *          that were used while a BudgetHold exists, are skipped.
+ */
+void XLDocument::enforceMemoryBudget(const XLXmlData* keep)
+{
+    std::lock_guard<std::mutex> lock(m_sync->budget);
+    size_t                      total = 0;
+    for (const auto& item : m_data)
+        if (item.isLoaded()) total += item.m_residentSize;
+
+    const bool spill = (m_openMode != XLOpenMode::ReadOnly);
+    while (total > m_memoryBudget) {
+        XLXmlData* victim = nullptr;
+        for (auto& item : m_data) {
+            if (&item == keep || not item.isLoaded() || item.isPinned()) continue;
+            if (m_sync->holdDepth > 0 && item.m_loadState->lastUse.load(std::memory_order_relaxed) >= m_sync->holdStart) continue;
+            if (item.getXmlType() != XLContentType::Worksheet && item.getXmlType() != XLContentType::Chartsheet) continue;
+            if (victim == nullptr || item.m_loadState->lastUse.load(std::memory_order_relaxed) <
+                                         victim->m_loadState->lastUse.load(std::memory_order_relaxed))
+                victim = &item;
+        }
+        if (victim == nullptr) break;    // everything left is in use
+        victim->unload(spill);
+        if (not victim->isLoaded()) total -= victim->m_residentSize;
+    }
+}
+
+/**
+ * @details The accesses counted from now on are protected by the hold
+ */
+XLDocument::BudgetHold::BudgetHold(XLDocument& document) : m_document(document)
+{
+    std::lock_guard<std::mutex> lock(m_document.m_sync->budget);
+    if (m_document.m_sync->holdDepth++ == 0) m_document.m_sync->holdStart = m_document.m_sync->useCount + 1;
+}
+
+/**
+ * @details The budget is enforced on a best effort basis: should spilling a part fail, the part stays loaded until the next
+ *          part is parsed
+ */
+XLDocument::BudgetHold::~BudgetHold()
+{
+    bool outermost = false;
+    {
+        std::lock_guard<std::mutex> lock(m_document.m_sync->budget);
+        outermost = (--m_document.m_sync->holdDepth == 0);
+    }
+    if (not outermost || m_document.m_memoryBudget == 0) return;
+    try {
+        m_document.enforceMemoryBudget(nullptr);
+    }
+    catch (...) {
+        // a destructor must not throw
+    }
+}
+
+/**
+ * @details Removes the first stored object for path (the one the index refers to). Should a duplicate for the same path exist
+ *          further down m_data, it takes over the index slot, preserving the former linear search semantics.
+ */
+bool XLDocument::eraseXmlData(const std::string& path)
+{
+    const auto indexed = m_xmlDataIndex.find(path);
+    if (indexed == m_xmlDataIndex.end()) return false;
+
+    const XLXmlData* target = indexed->second;
+    m_xmlDataIndex.erase(indexed);
+    if (target->valid()) m_xmlDataByRoot.erase(target->m_xmlDoc->internal_object());
+    m_data.remove_if([&](const XLXmlData& item) { return &item == target; });
+
+    const auto duplicate = std::find_if(m_data.begin(), m_data.end(), [&](const XLXmlData& item) { return item.getXmlPath() == path; });
+    if (duplicate != m_data.end()) m_xmlDataIndex.emplace(path, &*duplicate);
+    return true;
+}
+
+/**
+ * @details The chain is reconciled in place, so that the calculation order Excel stored is preserved for all cells that still
+ *          hold a formula. Chain entries may omit the sheet id (i) if it equals the one of the previous entry - where an entry
+ *          is dropped, the id is written explicitly on the following entry.
+ */
+void XLDocument::updateCalcChain()
+{
+    constexpr const bool DO_NOT_THROW  = true;
+    const std::string    calcChainPath = "xl/calcChain.xml";
+
+    struct SheetFormulas
+    {
+        XLXmlData*            xmlData;
+        std::vector<uint64_t> cells {};        // formula cell keys, ascending
+        std::vector<bool>     inChain {};      // per cells entry: already listed in the chain
+        bool                  swept {false};   // cells is valid
+    };
+    std::map<uint32_t, SheetFormulas> sheets;    // by sheetId
+
+    auto sweep = [](SheetFormulas& sheet) {
+        sheet.cells   = collectFormulaCells(*sheet.xmlData->getXmlDocument());
+        sheet.inChain = std::vector<bool>(sheet.cells.size(), false);
+        sheet.swept   = true;
+    };
+
+    // ===== Sweep all worksheets that have been parsed - the ones that were not can not have changed
+    bool hasFormulas = false;
+    for (XMLNode sheet = m_workbook.xmlDocument().document_element().child("sheets").first_child_of_type(pugi::node_element);
+         not sheet.empty();
+         sheet = sheet.next_sibling_of_type(pugi::node_element))
+    {
+        std::string target = m_wbkRelationships.relationshipById(sheet.attribute("r:id").value()).target();
+        if (target.substr(0, 4) == "/xl/") target = target.substr(4);
+        XLXmlData* xmlData = getXmlData("xl/" + target, DO_NOT_THROW);
+        if (xmlData == nullptr) continue;
+        SheetFormulas& formulas = sheets.emplace(sheet.attribute("sheetId").as_uint(), SheetFormulas { xmlData }).first->second;
+        if (xmlData->isLoaded() || xmlData->isSpilled()) {
+            sweep(formulas);
+            hasFormulas |= not formulas.cells.empty();
+        }
+    }
+
+    // ===== Create the chain if formulas exist, but no chain
+    const bool hasChain = m_archive.hasEntry(calcChainPath);
+    if (not hasChain && not hasFormulas) return;
+    if (not hasChain) {
+        m_archive.addEntry(calcChainPath, "");    // the chain is built below
+        m_contentTypes.addOverride("/" + calcChainPath, XLContentType::CalculationChain);
+    }
+    if (not m_wbkRelationships.targetExists("calcChain.xml"))
+        m_wbkRelationships.addRelationship(XLRelationshipType::CalculationChain, "calcChain.xml");
+    XLXmlData* chainData = getXmlData(calcChainPath, DO_NOT_THROW);
+    if (chainData == nullptr)
+        chainData = &addXmlData(this, calcChainPath, m_wbkRelationships.relationshipByTarget("calcChain.xml").id(), XLContentType::CalculationChain);
+
+    // ===== Fallback: a new or unreadable chain is rebuilt from all worksheets
+    XMLDocument& chainXml = *chainData->getXmlDocument();
+    XMLNode      chain    = chainXml.document_element();
+    if (chain.empty() || std::string_view(chain.name()) != "calcChain") {
+        chainXml.reset();
+        chain = chainXml.append_child("calcChain");
+        chain.append_attribute("xmlns").set_value("http://schemas.openxmlformats.org/spreadsheetml/2006/main");
+        for (auto& [sheetId, formulas] : sheets)
+            if (not formulas.swept) sweep(formulas);
+    }
+
+    // ===== Drop the entries of deleted worksheets and of parsed worksheet cells that no longer hold a formula
+    uint32_t entrySheet   = 0;       // the sheet id of the current entry
+    uint32_t writtenSheet = 0;       // the sheet id in effect after the last kept entry
+    bool     firstEntry   = true;
+    XMLNode  entry        = chain.first_child_of_type(pugi::node_element);
+    while (not entry.empty()) {
+        const XMLNode      nextEntry = entry.next_sibling_of_type(pugi::node_element);
+        const XMLAttribute sheetId   = entry.attribute("i");
+        if (not sheetId.empty()) entrySheet = sheetId.as_uint();
+
+        bool       keep  = false;
+        const auto sheet = sheets.find(entrySheet);
+        if (sheet != sheets.end()) {
+            SheetFormulas& formulas = sheet->second;
+            if (not formulas.swept)
+                keep = true;
+            else {
+                try {
+                    const XLCellReference cellRef(entry.attribute("r").value());
+                    const uint64_t        key   = (static_cast<uint64_t>(cellRef.row()) << 16) | cellRef.column();
+                    const auto            found = std::lower_bound(formulas.cells.begin(), formulas.cells.end(), key);
+                    if (found != formulas.cells.end() && *found == key) {
+                        const size_t index = static_cast<size_t>(found - formulas.cells.begin());
+                        keep                   = not formulas.inChain[index];    // drop duplicate entries
+                        formulas.inChain[index] = true;
+                    }
+                }
+                catch (const XLException&) { /* invalid cell reference: drop the entry */ }
+            }
+        }
+
+        if (not keep)
+            chain.remove_child(entry);
+        else {
+            if (sheetId.empty() && (firstEntry || entrySheet != writtenSheet)) entry.append_attribute("i").set_value(entrySheet);
+            writtenSheet = entrySheet;
+            firstEntry   = false;
+        }
+        entry = nextEntry;
+    }
+
+    // ===== Append the formula cells that are not in the chain yet
+    for (auto& [sheetId, formulas] : sheets) {
+        for (size_t index = 0; index < formulas.cells.size(); ++index) {
+            if (formulas.inChain[index]) continue;
+            const uint64_t key      = formulas.cells[index];
+            XMLNode        newEntry = chain.append_child("c");
+            newEntry.append_attribute("r").set_value(
+                XLCellReference(static_cast<uint32_t>(key >> 16), static_cast<uint16_t>(key & 0xFFFF)).address().c_str());
+            if (firstEntry || sheetId != writtenSheet) newEntry.append_attribute("i").set_value(sheetId);
+            writtenSheet = sheetId;
+            firstEntry   = false;
+        }
+    }
+
+    // ===== A chain without entries is not valid: remove it
+    if (chain.first_child_of_type(pugi::node_element).empty()) execCommand(XLCommand(XLCommandType::ResetCalcChain));
 }
 
 
@@ -618,13 +618,17 @@ bool XLVmlDrawing::deleteShape(uint32_t index)
 /**
  * @details TODO: write doxygen headers for functions in this module
  */
-bool XLVmlDrawing::deleteShape(std::string const& cellRef)
+bool XLVmlDrawing::deleteShape(std::string const& cellRef) { return deleteShapeNode(shapeNode(cellRef)); }
+
+/**
+ * @details remove a shape node that was previously located, e.g. by an index kept in XLComments
+ */
+bool XLVmlDrawing::deleteShapeNode(XMLNode node)
 {
     XMLNode rootNode = xmlDocument().document_element();
-    XMLNode node = shapeNode(cellRef);
     if (node.empty()) return false;    // nothing found to delete
 
-    --m_shapeCount;                    // if shapeNode(cellRef) returned a non-empty node: decrement shape count
+    --m_shapeCount;                    // if node is not empty: decrement shape count
     while (node.previous_sibling().type() == pugi::node_pcdata) // remove leading whitespaces
         rootNode.remove_child(node.previous_sibling());
     rootNode.remove_child(node);                                // then remove shape node itself
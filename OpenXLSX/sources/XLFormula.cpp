@@ -4,9 +4,12 @@
 
 // ===== External Includes ===== //
 #include <cassert>
-#include <regex>
+#include <algorithm>
+#include <cstring>
 #include <cctype>
+#include <mutex>
 #include <string>
+#include <unordered_map>
 #include <vector>
 #include <pugixml.hpp>
 
@@ -15,6 +18,10 @@
 #include "XLException.hpp"
 #include "XLCellReference.hpp"
 #include "XLCell.hpp"
+#include "XLCommandQuery.hpp"
+#include "XLConstants.hpp"
+#include "XLDocument.hpp"
+#include "XLXmlData.hpp"
 
 using namespace OpenXLSX;
 
@@ -139,136 +146,210 @@ XLFormulaProxy& XLFormulaProxy::clear()
 // -------------------- Helpers for Shared Formula expansion --------------------
 namespace {
 
-    // find quoted string ranges to avoid touching refs inside strings
-    std::vector<std::pair<size_t,size_t>> findQuotedRanges(const std::string& s)
+    /**
+     * @brief A piece of a tokenized shared master formula: either literal text, or a cell reference that is moved when the
+     *        formula is expanded for a dependent cell
+     */
+    struct XLSharedFormulaToken
     {
-        std::vector<std::pair<size_t,size_t>> ranges;
-        bool in = false;
-        size_t start = 0;
-        for (size_t i = 0; i < s.size(); ++i) {
-            if (s[i] == '"') {
-                if (!in) { in = true; start = i; }
-                else {
-                    // check escaped double quote
-                    if (i + 1 < s.size() && s[i+1] == '"') { ++i; continue; }
-                    ranges.emplace_back(start, i + 1);
-                    in = false;
-                }
-            }
-        }
-        return ranges;
-    }
-
-    bool inRanges(const std::vector<std::pair<size_t,size_t>>& ranges, size_t pos)
+        std::string text;              // literal text, or the sheet prefix of a reference (e.g. 'My Sheet'!)
+        bool        isRef {false};
+        bool        colAbs {false};
+        bool        rowAbs {false};
+        uint16_t    col {0};
+        uint32_t    row {0};
+    };
+
+    /**
+     * @brief A shared formula master cell, with its formula text parsed once into tokens
+     */
+    struct XLSharedFormulaMaster
     {
-        for (auto const& r : ranges) {
-            if (pos >= r.first && pos < r.second) return true;
-        }
-        return false;
-    }
-
-    // convert column letters to number (A=1)
-    uint16_t columnLettersToNumber(const std::string& col)
+        XMLNode                           cell;      // the master <c> node - cell nodes are only released together with the DOM
+        uint32_t                          row;
+        uint16_t                          col;
+        std::string                       text;      // master formula text, to validate the cached entry
+        std::string                       range;     // the ref attribute of the master
+        std::vector<XLSharedFormulaToken> tokens;
+    };
+
+    bool isNameChar(char c) { return std::isalnum(static_cast<unsigned char>(c)) || c == '_' || c == '.'; }
+
+    /**
+     * @brief try to parse a cell reference $?COL$?ROW starting at pos
+     * @return the position after the reference, or std::string::npos if there is no cell reference at pos
+     */
+    size_t parseCellRef(const std::string& s, size_t pos, XLSharedFormulaToken& token)
     {
-        uint32_t colNo = 0;
-        for (char c : col) {
-            if (c >= 'A' && c <= 'Z') colNo = colNo * 26 + (c - 'A' + 1);
-            else break;
-        }
-        return static_cast<uint16_t>(colNo);
+        size_t i = pos;
+        token.colAbs = (i < s.size() && s[i] == '$');
+        if (token.colAbs) ++i;
+        uint32_t col     = 0;
+        size_t   letters = 0;
+        while (i < s.size() && s[i] >= 'A' && s[i] <= 'Z' && letters < 4) { col = col * 26 + static_cast<uint32_t>(s[i] - 'A' + 1); ++i; ++letters; }
+        if (letters == 0 || letters > 3) return std::string::npos;
+        token.rowAbs = (i < s.size() && s[i] == '$');
+        if (token.rowAbs) ++i;
+        uint64_t row    = 0;
+        size_t   digits = 0;
+        while (i < s.size() && std::isdigit(static_cast<unsigned char>(s[i])) && digits < 8) { row = row * 10 + static_cast<uint64_t>(s[i] - '0'); ++i; ++digits; }
+        if (digits == 0 || digits > 7) return std::string::npos;
+        if (i < s.size() && (isNameChar(s[i]) || s[i] == '(')) return std::string::npos;    // part of a longer name, or a function like LOG10(
+        token.col   = static_cast<uint16_t>(col);
+        token.row   = static_cast<uint32_t>(row);
+        token.isRef = true;
+        return i;
     }
 
-    // convert number to column letters (1=A)
-    std::string numberToColumnLetters(uint16_t column)
+    /**
+     * @brief split a formula into literal text and cell references - string constants are never tokenized as references
+     */
+    std::vector<XLSharedFormulaToken> tokenizeSharedFormula(const std::string& s)
     {
-        // reuse XLCellReference to avoid re-implementing; strip row afterwards
-        OpenXLSX::XLCellReference tmp(1, column);
-        std::string addr = tmp.address(); // e.g. A1
-        // strip trailing digits
-        size_t i = addr.size();
-        while (i > 0 && std::isdigit(static_cast<unsigned char>(addr[i-1]))) --i;
-        return addr.substr(0, i);
+        std::vector<XLSharedFormulaToken> tokens;
+        std::string                       literal;
+        auto flushLiteral = [&]() {
+            if (literal.empty()) return;
+            tokens.push_back(XLSharedFormulaToken { std::move(literal) });
+            literal.clear();
+        };
+
+        size_t i = 0;
+        while (i < s.size()) {
+            const char c = s[i];
+            if (c == '"') {    // string constant, with "" as an escaped quote
+                size_t end = i + 1;
+                while (end < s.size() && !(s[end] == '"' && (end + 1 >= s.size() || s[end + 1] != '"'))) end += (s[end] == '"') ? 2 : 1;
+                end = std::min(end + 1, s.size());
+                literal.append(s, i, end - i);
+                i = end;
+                continue;
+            }
+
+            // ===== Find an optional sheet prefix: 'quoted name'! or name!
+            size_t refStart = i;
+            size_t end      = i;
+            if (c == '\'') {
+                end = i + 1;
+                while (end < s.size() && !(s[end] == '\'' && (end + 1 >= s.size() || s[end + 1] != '\''))) end += (s[end] == '\'') ? 2 : 1;
+                end = std::min(end + 1, s.size());
+                if (end < s.size() && s[end] == '!') refStart = ++end;
+            }
+            else if (isNameChar(c) || c == '$') {
+                if (i > 0 && (isNameChar(s[i - 1]) || s[i - 1] == '$')) { literal += c; ++i; continue; }    // inside a name
+                end = i;
+                while (end < s.size() && isNameChar(s[end])) ++end;
+                if (end < s.size() && s[end] == '!' && end > i) refStart = end + 1;
+            }
+            else {
+                literal += c;
+                ++i;
+                continue;
+            }
+
+            XLSharedFormulaToken token { s.substr(i, refStart - i) };
+            const size_t refEnd = parseCellRef(s, refStart, token);
+            if (refEnd != std::string::npos) {
+                flushLiteral();
+                tokens.push_back(std::move(token));
+                i = refEnd;
+            }
+            else {    // not a reference: copy the quoted name or the whole word
+                end = std::max(end, i + 1);
+                literal.append(s, i, end - i);
+                i = end;
+            }
+        }
+        flushLiteral();
+        return tokens;
     }
 
-    std::string expandSharedFormulaString(const std::string& masterFormula,
-                                          const OpenXLSX::XLCellReference& masterCell,
-                                          const OpenXLSX::XLCellReference& targetCell)
+    /**
+     * @brief build the formula of a dependent cell from the tokens of its master, moving the relative references
+     */
+    std::string expandSharedFormula(const XLSharedFormulaMaster& master, const OpenXLSX::XLCellReference& targetCell)
     {
-        if (masterFormula.empty()) return masterFormula;
-        int rowOffset = static_cast<int>(targetCell.row()) - static_cast<int>(masterCell.row());
-        int colOffset = static_cast<int>(targetCell.column()) - static_cast<int>(masterCell.column());
-
-        // pattern: optional sheet ('..' or bare)! then optional $ col letters, optional $ row digits
-        std::regex refRe(R"(((?:'[^']+'|[A-Za-z_][\w\.]*)!)?(\$?)([A-Z]{1,3})(\$?)([0-9]{1,7}))");
-        auto quoted = findQuotedRanges(masterFormula);
+        const int64_t rowOffset = static_cast<int64_t>(targetCell.row()) - master.row;
+        const int64_t colOffset = static_cast<int64_t>(targetCell.column()) - master.col;
 
         std::string result;
-        result.reserve(masterFormula.size());
-        std::sregex_iterator it(masterFormula.begin(), masterFormula.end(), refRe);
-        std::sregex_iterator end;
-        size_t last = 0;
-        for (; it != end; ++it) {
-            size_t pos = static_cast<size_t>((*it).position());
-            size_t len = static_cast<size_t>((*it).length());
-            // skip if inside quoted string
-            if (inRanges(quoted, pos)) continue;
-            // append text before match
-            if (pos > last) result.append(masterFormula, last, pos - last);
-
-            std::smatch m = *it;
-            std::string sheetPart = m[1].str();
-            bool colAbs = !m[2].str().empty();
-            std::string colLetters = m[3].str();
-            bool rowAbs = !m[4].str().empty();
-            uint32_t row = static_cast<uint32_t>(std::stoul(m[5].str()));
-
-            uint16_t col = columnLettersToNumber(colLetters);
-            uint16_t newCol = static_cast<uint16_t>(colAbs ? col : static_cast<int>(col) + colOffset);
-            uint32_t newRow = static_cast<uint32_t>(rowAbs ? row : static_cast<int>(row) + rowOffset);
-
-            if (newCol < 1) newCol = 1; // basic guard
-            if (newRow < 1) newRow = 1;
-
-            std::string newColLetters = numberToColumnLetters(newCol);
-            if (colAbs) newColLetters = "$" + newColLetters;
-            std::string newRowStr = std::to_string(newRow);
-            if (rowAbs) newRowStr = "$" + newRowStr;
-
-            result += sheetPart + newColLetters + newRowStr;
-            last = pos + len;
+        result.reserve(master.text.size() + 8);
+        for (const auto& token : master.tokens) {
+            result += token.text;
+            if (!token.isRef) continue;
+            const int64_t col = std::clamp<int64_t>(token.colAbs ? token.col : token.col + colOffset, 1, OpenXLSX::MAX_COLS);    // basic guard
+            const int64_t row = std::clamp<int64_t>(token.rowAbs ? token.row : token.row + rowOffset, 1, OpenXLSX::MAX_ROWS);
+            const std::string address = OpenXLSX::XLCellReference(1, static_cast<uint16_t>(col)).address();    // e.g. A1
+            if (token.colAbs) result += '$';
+            result.append(address, 0, address.size() - 1);    // strip the row number 1
+            if (token.rowAbs) result += '$';
+            result += std::to_string(row);
         }
-        // append remaining tail
-        if (last < masterFormula.size()) result.append(masterFormula, last, std::string::npos);
-        if (result.empty()) return masterFormula; // in case every match fell into quoted ranges
         return result;
     }
 
-    bool findMasterSharedFormulaForIndex(const pugi::xml_node& sheetData,
-                                         uint32_t si,
-                                         OpenXLSX::XLCellReference& masterOut,
-                                         std::string& masterFormulaOut,
-                                         std::string& rangeOut)
+    /**
+     * @brief test whether the master cell of a table entry still holds the master formula the entry was built from
+     */
+    bool isCurrentMaster(const XLSharedFormulaMaster& master, uint32_t si)
     {
+        const XMLNode f = master.cell.child("f");
+        return std::strcmp(f.attribute("t").value(), "shared") == 0 && f.attribute("si").as_uint() == si && master.text == f.text().get();
+    }
+
+    /**
+     * @brief register all shared formula masters of a worksheet, in one sweep over sheetData
+     */
+    void buildSharedFormulaTable(const XMLNode& sheetData, std::unordered_map<uint32_t, XLSharedFormulaMaster>& masters)
+    {
+        masters.clear();
         for (auto row = sheetData.child("row"); !row.empty(); row = row.next_sibling("row")) {
             for (auto c = row.child("c"); !c.empty(); c = c.next_sibling("c")) {
                 auto f = c.child("f");
-                if (f.empty()) continue;
-                auto tAttr = f.attribute("t");
-                if (tAttr.empty() || std::string(tAttr.value()) != "shared") continue;
-                auto siAttr = f.attribute("si");
-                if (siAttr.empty() || siAttr.as_uint() != si) continue;
-                auto text = std::string(f.text().get());
-                if (!text.empty()) {
-                    masterFormulaOut = text;
-                    rangeOut = f.attribute("ref").as_string("");
-                    masterOut = OpenXLSX::XLCellReference{ c.attribute("r").value() };
-                    return true;
-                }
+                if (f.empty() || f.text().get()[0] == 0 || std::strcmp(f.attribute("t").value(), "shared") != 0) continue;
+                const uint32_t si = f.attribute("si").as_uint();
+                if (masters.count(si) != 0) continue;    // the first master for an index wins
+                const OpenXLSX::XLCellReference ref(c.attribute("r").value());
+                masters.emplace(si, XLSharedFormulaMaster { c, ref.row(), ref.column(), f.text().get(), f.attribute("ref").as_string(""),
+                                                            tokenizeSharedFormula(f.text().get()) });
             }
         }
-        return false;
     }
-}
+}    // namespace
+
+namespace OpenXLSX
+{
+    /**
+     * @brief The shared formula masters of one worksheet, by shared index (si)
+     * @details The table is held by the XLXmlData of the worksheet, which drops it whenever the DOM is unloaded or replaced, so
+     *          the master nodes never outlive their document. An entry is used after checking its master node; if that no longer
+     *          holds the master formula, the table is rebuilt. After a sweep, an index without an entry has no master (orphaned
+     *          dependents), and is answered without sweeping again - until XLFormulaProxy::setSharedMaster clears the table.
+     */
+    struct XLSharedFormulaCache
+    {
+        std::mutex                                          mutex {};          // readers of the same worksheet share the table
+        std::unordered_map<uint32_t, XLSharedFormulaMaster> masters {};
+        bool                                                built {false};     // true if masters holds all masters of the sheet
+
+        /**
+         * @brief look up the master for shared index si of the worksheet with sheetData
+         * @return a pointer to the master, or nullptr if there is no master for si
+         * @note the caller must hold mutex while the result is in use
+         */
+        const XLSharedFormulaMaster* find(const XMLNode& sheetData, uint32_t si)
+        {
+            auto master = masters.find(si);
+            if (master != masters.end() && isCurrentMaster(master->second, si)) return &master->second;
+            if (master == masters.end() && built) return nullptr;    // no master at the last sweep, and none was written since
+
+            buildSharedFormulaTable(sheetData, masters);
+            built  = true;
+            master = masters.find(si);
+            return master == masters.end() ? nullptr : &master->second;
+        }
+    };
+}    // namespace OpenXLSX
 
 /**
  * @details Convenience function for setting the formula. This method is called from the templated
@@ -342,15 +423,15 @@ XLFormula XLFormulaProxy::getFormula() const
             return f;
         }
 
-        // Non-master: find master and expand
-        const auto sheetData = m_cellNode->parent().parent();
-        OpenXLSX::XLCellReference masterRef;
-        std::string masterText;
-        std::string range;
-        if (findMasterSharedFormulaForIndex(sheetData, f.sharedIndex(), masterRef, masterText, range)) {
-            auto expanded = expandSharedFormulaString(masterText, masterRef, m_cell->cellReference());
-            f = expanded.c_str();
-            if (!range.empty()) f.setSharedRange(range);
+        // Non-master: find master and expand its tokens
+        const auto            sheetData = m_cellNode->parent().parent();
+        const auto            cache     = sharedFormulaCache();
+        XLSharedFormulaCache  detached;    // a cell that is not part of a document has no table to keep
+        XLSharedFormulaCache& table     = cache ? *cache : detached;
+        std::lock_guard<std::mutex> lock(table.mutex);
+        if (const auto* master = table.find(sheetData, f.sharedIndex()); master != nullptr) {
+            f = expandSharedFormula(*master, m_cell->cellReference()).c_str();
+            if (!master->range.empty()) f.setSharedRange(master->range);
             return f;
         }
 
@@ -362,6 +443,24 @@ XLFormula XLFormulaProxy::getFormula() const
     return XLFormula(formulaNode.text().get());
 }
 
+/**
+ * @details The worksheet part is found through the document of the shared strings table. The table is created on first use, under
+ *          the lock with which the XLXmlData drops it together with the DOM.
+ */
+std::shared_ptr<XLSharedFormulaCache> XLFormulaProxy::sharedFormulaCache() const
+{
+    const XLSharedStrings& sharedStrings = m_cell->m_sharedStrings.get();
+    if (not sharedStrings.valid()) return nullptr;
+
+    XLQuery query(XLQueryType::QueryXmlDataOfNode);
+    query.setParam("xmlNode", *m_cellNode);
+    XLXmlData* xmlData = sharedStrings.parentDoc().execQuery(query).result<XLXmlData*>();
+
+    std::lock_guard<std::mutex> lock(xmlData->m_loadState->mutex);
+    if (not xmlData->m_formulaCache) xmlData->m_formulaCache = std::make_shared<XLSharedFormulaCache>();
+    return xmlData->m_formulaCache;
+}
+
 /**
  * @brief Get the raw formula without expanding shared references.
  *        If the cell is a shared formula non-master, only metadata is returned.
@@ -422,6 +521,13 @@ bool XLFormulaProxy::setSharedMaster(uint32_t sharedIndex,
     // Clean cell type and possible inlineStr
     m_cellNode->remove_attribute("t");
     m_cellNode->remove_child("is");
+
+    // The new master may be for an index that had none, or precede the master of its index
+    if (const auto cache = sharedFormulaCache()) {
+        std::lock_guard<std::mutex> lock(cache->mutex);
+        cache->masters.clear();
+        cache->built = false;
+    }
     return true;
 }
 
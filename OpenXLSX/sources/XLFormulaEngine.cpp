@@ -0,0 +1,1373 @@
+/*
+
+   ____                               ____      ___ ____       ____  ____      ___
+  6MMMMb                              `MM(      )M' `MM'      6MMMMb\`MM(      )M'
+ 8P    Y8                              `MM.     d'   MM      6M'    ` `MM.     d'
+6M      Mb __ ____     ____  ___  __    `MM.   d'    MM      MM        `MM.   d'
+MM      MM `M6MMMMb   6MMMMb `MM 6MMb    `MM. d'     MM      YM.        `MM. d'
+MM      MM  MM'  `Mb 6M'  `Mb MMM9 `Mb    `MMd       MM       YMMMMb     `MMd
+MM      MM  MM    MM MM    MM MM'   MM     dMM.      MM           `Mb     dMM.
+MM      MM  MM    MM MMMMMMMM MM    MM    d'`MM.     MM            MM    d'`MM.
+YM      M9  MM    MM MM       MM    MM   d'  `MM.    MM            MM   d'  `MM.
+ 8b    d8   MM.  ,M9 YM    d9 MM    MM  d'    `MM.   MM    / L    ,M9  d'    `MM.
+  YMMMM9    MMYMMM9   YMMMM9 _MM_  _MM_M(_    _)MM_ _MMMMMMM MYMMMM9 _M(_    _)MM_
+            MM
+            MM
+           _MM_
+
+  Copyright (c) 2018, Kenneth Troldal Balslev
+
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+  - Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+  - Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+  - Neither the name of the author nor the
+    names of any contributors may be used to endorse or promote products
+    derived from this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+  DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+  DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+  ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ */
+
+// ===== External Includes ===== //
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <map>
+#include <pugixml.hpp>
+#include <sstream>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// ===== OpenXLSX Includes ===== //
+#include "XLCell.hpp"
+#include "XLCellReference.hpp"
+#include "XLConstants.hpp"
+#include "XLDocument.hpp"
+#include "XLException.hpp"
+#include "XLFormulaEngine.hpp"
+#include "XLSheet.hpp"
+
+using namespace OpenXLSX;
+
+namespace {    // anonymous namespace: do not export any symbols from here
+    /**
+     * @brief the postfix program operations of a compiled formula
+     */
+    enum class XLOp : uint8_t {
+        Number, String, Boolean, Error, Ref, Range,
+        Add, Sub, Mul, Div, Pow, Concat, Neg, Percent,
+        Eq, Ne, Lt, Le, Gt, Ge,
+        Call
+    };
+
+    /**
+     * @brief the supported worksheet functions
+     */
+    enum class XLFunction : uint8_t { Sum, Average, Min, Max, Count, If, VLookup, Index, Match };
+
+    /**
+     * @brief one step of a compiled formula. References carry their absolute ($) flags, so that a shared formula compiled for its master
+     *  cell can be moved to a dependent cell by offsetting the relative coordinates
+     */
+    struct XLInstruction
+    {
+        XLOp        op;
+        XLFunction  function {XLFunction::Sum};
+        uint8_t     argCount {0};
+        bool        absRow1 {false};
+        bool        absCol1 {false};
+        bool        absRow2 {false};
+        bool        absCol2 {false};
+        uint32_t    sheet {0};
+        uint32_t    row1 {0};
+        uint32_t    row2 {0};
+        uint16_t    col1 {0};
+        uint16_t    col2 {0};
+        double      number {0.0};
+        std::string text {};    // string constant or error code
+    };
+
+    using XLProgram = std::vector<XLInstruction>;
+
+    /**
+     * @brief a value on the evaluation stack: a scalar, or a (not yet dereferenced) rectangular range
+     */
+    struct XLValue
+    {
+        enum class Kind : uint8_t { Empty, Number, Text, Boolean, Error, Range };
+        Kind        kind {Kind::Empty};
+        double      number {0.0};    // Number, Boolean (0 / 1)
+        std::string text {};         // Text, Error
+        uint32_t    sheet {0};       // Range
+        uint32_t    row1 {0};
+        uint32_t    row2 {0};
+        uint16_t    col1 {0};
+        uint16_t    col2 {0};
+
+        static XLValue numberValue(double value) { XLValue v; v.kind = Kind::Number; v.number = value; return v; }
+        static XLValue boolValue(bool value) { XLValue v; v.kind = Kind::Boolean; v.number = value ? 1.0 : 0.0; return v; }
+        static XLValue textValue(std::string value) { XLValue v; v.kind = Kind::Text; v.text = std::move(value); return v; }
+        static XLValue errorValue(std::string code) { XLValue v; v.kind = Kind::Error; v.text = std::move(code); return v; }
+        static XLValue rangeValue(uint32_t sheet, uint32_t row1, uint16_t col1, uint32_t row2, uint16_t col2)
+        {
+            XLValue v; v.kind = Kind::Range; v.sheet = sheet; v.row1 = row1; v.col1 = col1; v.row2 = row2; v.col2 = col2;
+            return v;
+        }
+        bool isError() const { return kind == Kind::Error; }
+    };
+
+    /**
+     * @brief the key of a cell within a worksheet - sorts by row, then column
+     */
+    uint64_t cellKey(uint32_t row, uint16_t column) { return (static_cast<uint64_t>(row) << 16) | column; }
+    uint32_t keyRow(uint64_t key) { return static_cast<uint32_t>(key >> 16); }
+    uint16_t keyColumn(uint64_t key) { return static_cast<uint16_t>(key & 0xFFFF); }
+
+    /**
+     * @brief the key of a cell within the workbook
+     */
+    uint64_t globalKey(uint32_t sheet, uint64_t key) { return (static_cast<uint64_t>(sheet) << 40) | key; }
+
+    std::string toUpper(std::string_view text)
+    {
+        std::string result(text);
+        std::transform(result.begin(), result.end(), result.begin(), [](unsigned char c) { return static_cast<char>(std::toupper(c)); });
+        return result;
+    }
+
+    /**
+     * @brief format a number the way a general number format shows it, for concatenation and text comparison
+     */
+    std::string numberToText(double number)
+    {
+        if (std::floor(number) == number && std::fabs(number) < 1e15) return std::to_string(static_cast<int64_t>(number));
+        std::ostringstream stream;
+        stream.precision(15);
+        stream << number;
+        return toUpper(stream.str());    // 1e+20 -> 1E+20
+    }
+
+    /**
+     * @brief convert a text to a number, if the complete text (except surrounding blanks) is numeric
+     */
+    bool textToNumber(const std::string& text, double& number)
+    {
+        const char* begin = text.c_str();
+        while (*begin == ' ') ++begin;
+        if (*begin == 0) return false;
+        char* end = nullptr;
+        number = std::strtod(begin, &end);
+        while (*end == ' ') ++end;
+        return *end == 0;
+    }
+
+    /**
+     * @brief The XLFormulaCompiler translates formula text into a postfix program with a recursive descent parser, following the
+     *  Excel operator precedence (lowest first): comparison, &, + -, * /, ^, %, unary -
+     * @throws XLFormulaError if the formula uses anything that is not supported
+     */
+    class XLFormulaCompiler
+    {
+    public:
+        using SheetLookup = std::function<int64_t(const std::string&)>;
+
+        XLFormulaCompiler(std::string_view text, uint32_t sheet, const SheetLookup& sheetLookup)
+            : m_text(text), m_sheet(sheet), m_sheetLookup(sheetLookup)
+        {}
+
+        XLProgram compile()
+        {
+            skipBlanks();
+            if (m_pos < m_text.size() && m_text[m_pos] == '=') ++m_pos;    // tolerate a leading '='
+            comparison();
+            skipBlanks();
+            if (m_pos != m_text.size()) fail("unexpected character");
+            return std::move(m_program);
+        }
+
+    private:
+        [[noreturn]] void fail(const char* reason) const
+        {
+            throw XLFormulaError("XLFormulaEngine: " + std::string(reason) + " in formula \"" + std::string(m_text) + "\"");
+        }
+
+        void skipBlanks()
+        {
+            while (m_pos < m_text.size() && (m_text[m_pos] == ' ' || m_text[m_pos] == '\n' || m_text[m_pos] == '\r')) ++m_pos;
+        }
+
+        bool accept(std::string_view token)
+        {
+            skipBlanks();
+            if (m_text.substr(m_pos, token.size()) != token) return false;
+            m_pos += token.size();
+            return true;
+        }
+
+        void emit(XLOp op)
+        {
+            XLInstruction instruction;
+            instruction.op = op;
+            m_program.push_back(std::move(instruction));
+        }
+
+        void comparison()
+        {
+            concatenation();
+            while (true) {
+                XLOp op;
+                if (accept("<>"))      op = XLOp::Ne;
+                else if (accept("<=")) op = XLOp::Le;
+                else if (accept(">=")) op = XLOp::Ge;
+                else if (accept("="))  op = XLOp::Eq;
+                else if (accept("<"))  op = XLOp::Lt;
+                else if (accept(">"))  op = XLOp::Gt;
+                else break;
+                concatenation();
+                emit(op);
+            }
+        }
+
+        void concatenation()
+        {
+            additive();
+            while (accept("&")) {
+                additive();
+                emit(XLOp::Concat);
+            }
+        }
+
+        void additive()
+        {
+            multiplicative();
+            while (true) {
+                if (accept("+"))      { multiplicative(); emit(XLOp::Add); }
+                else if (accept("-")) { multiplicative(); emit(XLOp::Sub); }
+                else break;
+            }
+        }
+
+        void multiplicative()
+        {
+            power();
+            while (true) {
+                if (accept("*"))      { power(); emit(XLOp::Mul); }
+                else if (accept("/")) { power(); emit(XLOp::Div); }
+                else break;
+            }
+        }
+
+        void power()
+        {
+            percent();
+            while (accept("^")) {
+                percent();
+                emit(XLOp::Pow);
+            }
+        }
+
+        void percent()
+        {
+            unary();
+            while (accept("%")) emit(XLOp::Percent);
+        }
+
+        void unary()
+        {
+            if (accept("-")) {
+                unary();
+                emit(XLOp::Neg);
+            }
+            else if (accept("+"))
+                unary();
+            else
+                primary();
+        }
+
+        void primary()
+        {
+            skipBlanks();
+            if (m_pos >= m_text.size()) fail("unexpected end");
+            const char c = m_text[m_pos];
+
+            if (c == '(') {
+                ++m_pos;
+                comparison();
+                if (!accept(")")) fail("missing )");
+            }
+            else if (std::isdigit(static_cast<unsigned char>(c)) || c == '.')
+                numberConstant();
+            else if (c == '"')
+                stringConstant();
+            else if (c == '#')
+                errorConstant();
+            else if (c == '\'') {    // quoted sheet name
+                std::string sheetName;
+                ++m_pos;
+                while (true) {
+                    if (m_pos >= m_text.size()) fail("unterminated sheet name");
+                    if (m_text[m_pos] == '\'') {
+                        if (m_pos + 1 < m_text.size() && m_text[m_pos + 1] == '\'') { sheetName += '\''; m_pos += 2; continue; }
+                        ++m_pos;
+                        break;
+                    }
+                    sheetName += m_text[m_pos++];
+                }
+                if (m_pos >= m_text.size() || m_text[m_pos] != '!') fail("missing ! after sheet name");
+                ++m_pos;
+                reference(sheetName);
+            }
+            else {
+                const size_t start = m_pos;
+                std::string_view word = readWord();
+                if (word.empty()) fail("unexpected character");
+                if (m_pos < m_text.size() && m_text[m_pos] == '(') {
+                    ++m_pos;
+                    functionCall(word);
+                }
+                else if (m_pos < m_text.size() && m_text[m_pos] == '!') {
+                    ++m_pos;
+                    reference(std::string(word));
+                }
+                else if (toUpper(word) == "TRUE" || toUpper(word) == "FALSE") {
+                    emit(XLOp::Boolean);
+                    m_program.back().number = (toUpper(word) == "TRUE") ? 1.0 : 0.0;
+                }
+                else {
+                    m_pos = start;
+                    reference(std::string());
+                }
+            }
+        }
+
+        std::string_view readWord()
+        {
+            const size_t start = m_pos;
+            while (m_pos < m_text.size()
+                   && (std::isalnum(static_cast<unsigned char>(m_text[m_pos])) || m_text[m_pos] == '_' || m_text[m_pos] == '.' || m_text[m_pos] == '$'))
+                ++m_pos;
+            return m_text.substr(start, m_pos - start);
+        }
+
+        void numberConstant()
+        {
+            const std::string rest(m_text.substr(m_pos));
+            char* end = nullptr;
+            const double value = std::strtod(rest.c_str(), &end);
+            if (end == rest.c_str()) fail("invalid number");
+            m_pos += static_cast<size_t>(end - rest.c_str());
+            emit(XLOp::Number);
+            m_program.back().number = value;
+        }
+
+        void stringConstant()
+        {
+            std::string value;
+            ++m_pos;
+            while (true) {
+                if (m_pos >= m_text.size()) fail("unterminated string");
+                if (m_text[m_pos] == '"') {
+                    if (m_pos + 1 < m_text.size() && m_text[m_pos + 1] == '"') { value += '"'; m_pos += 2; continue; }
+                    ++m_pos;
+                    break;
+                }
+                value += m_text[m_pos++];
+            }
+            emit(XLOp::String);
+            m_program.back().text = std::move(value);
+        }
+
+        void errorConstant()
+        {
+            for (const char* code : { "#NULL!", "#DIV/0!", "#VALUE!", "#REF!", "#NAME?", "#NUM!", "#N/A" }) {
+                if (m_text.substr(m_pos, std::strlen(code)) == code) {
+                    m_pos += std::strlen(code);
+                    emit(XLOp::Error);
+                    m_program.back().text = code;
+                    return;
+                }
+            }
+            fail("unknown error constant");
+        }
+
+        /**
+         * @brief parse one side of a reference: $?COL$?ROW, or $?COL alone (whole column, only within a range)
+         * @return false if text is not a cell or column reference
+         */
+        static bool parseCoordinate(std::string_view text, uint32_t& row, uint16_t& col, bool& absRow, bool& absCol, bool& hasRow)
+        {
+            size_t pos = 0;
+            absCol = (pos < text.size() && text[pos] == '$');
+            if (absCol) ++pos;
+            uint32_t column = 0;
+            size_t letters = 0;
+            while (pos < text.size() && std::isalpha(static_cast<unsigned char>(text[pos]))) {
+                column = column * 26 + static_cast<uint32_t>(std::toupper(static_cast<unsigned char>(text[pos])) - 'A' + 1);
+                ++pos;
+                ++letters;
+            }
+            if (letters == 0 || letters > 3 || column > MAX_COLS) return false;
+            col = static_cast<uint16_t>(column);
+
+            absRow = (pos < text.size() && text[pos] == '$');
+            if (absRow) ++pos;
+            hasRow = (pos < text.size());
+            if (!hasRow) return !absRow;    // whole column reference
+            uint64_t number = 0;
+            while (pos < text.size() && std::isdigit(static_cast<unsigned char>(text[pos]))) number = number * 10 + static_cast<uint64_t>(text[pos++] - '0');
+            if (pos != text.size() || number < 1 || number > MAX_ROWS) return false;
+            row = static_cast<uint32_t>(number);
+            return true;
+        }
+
+        void reference(const std::string& sheetName)
+        {
+            XLInstruction instruction;
+            instruction.op = XLOp::Ref;
+            instruction.sheet = m_sheet;
+            bool unknownSheet = false;
+            if (!sheetName.empty()) {
+                const int64_t sheet = m_sheetLookup(sheetName);
+                if (sheet < 0) unknownSheet = true;
+                else instruction.sheet = static_cast<uint32_t>(sheet);
+            }
+
+            bool hasRow1 = true;
+            if (!parseCoordinate(readWord(), instruction.row1, instruction.col1, instruction.absRow1, instruction.absCol1, hasRow1))
+                fail("unsupported name or reference");
+            instruction.row2 = instruction.row1;
+            instruction.col2 = instruction.col1;
+            instruction.absRow2 = instruction.absRow1;
+            instruction.absCol2 = instruction.absCol1;
+
+            if (m_pos < m_text.size() && m_text[m_pos] == ':') {
+                ++m_pos;
+                bool hasRow2 = true;
+                if (!parseCoordinate(readWord(), instruction.row2, instruction.col2, instruction.absRow2, instruction.absCol2, hasRow2)
+                    || hasRow1 != hasRow2)
+                    fail("unsupported range reference");
+                if (!hasRow1) {    // whole columns: A:C
+                    instruction.row1 = 1;
+                    instruction.row2 = MAX_ROWS;
+                    instruction.absRow1 = instruction.absRow2 = true;
+                }
+                if (instruction.row2 < instruction.row1) std::swap(instruction.row1, instruction.row2);
+                if (instruction.col2 < instruction.col1) std::swap(instruction.col1, instruction.col2);
+                instruction.op = XLOp::Range;
+            }
+            else if (!hasRow1)
+                fail("unsupported name");
+
+            if (unknownSheet) {
+                instruction = XLInstruction();
+                instruction.op = XLOp::Error;
+                instruction.text = "#REF!";
+            }
+            m_program.push_back(std::move(instruction));
+        }
+
+        void functionCall(std::string_view name)
+        {
+            std::string upper = toUpper(name);
+            if (upper.substr(0, 6) == "_XLFN.") upper = upper.substr(6);
+
+            struct Signature { const char* name; XLFunction function; uint8_t minArgs; uint8_t maxArgs; };
+            static const Signature signatures[] = {
+                { "SUM",     XLFunction::Sum,     1, 255 },
+                { "AVERAGE", XLFunction::Average, 1, 255 },
+                { "MIN",     XLFunction::Min,     1, 255 },
+                { "MAX",     XLFunction::Max,     1, 255 },
+                { "COUNT",   XLFunction::Count,   1, 255 },
+                { "IF",      XLFunction::If,      2, 3   },
+                { "VLOOKUP", XLFunction::VLookup, 3, 4   },
+                { "INDEX",   XLFunction::Index,   2, 3   },
+                { "MATCH",   XLFunction::Match,   2, 3   }
+            };
+            const auto signature = std::find_if(std::begin(signatures), std::end(signatures), [&](const Signature& s) { return upper == s.name; });
+            if (signature == std::end(signatures)) fail("unsupported function");
+
+            size_t argCount = 0;
+            if (!accept(")")) {
+                do {
+                    comparison();
+                    ++argCount;
+                } while (accept(","));
+                if (!accept(")")) fail("missing )");
+            }
+            if (argCount < signature->minArgs || argCount > signature->maxArgs) fail("wrong argument count");
+
+            emit(XLOp::Call);
+            m_program.back().function = signature->function;
+            m_program.back().argCount = static_cast<uint8_t>(argCount);
+        }
+
+        std::string_view   m_text;
+        size_t             m_pos {0};
+        uint32_t           m_sheet;
+        const SheetLookup& m_sheetLookup;
+        XLProgram          m_program {};
+    };
+
+    /**
+     * @brief move a program compiled for the cell at (fromRow, fromCol) to the cell at (toRow, toCol): relative references are offset
+     * @return false if a moved reference falls off the worksheet
+     */
+    bool offsetProgram(XLProgram& program, int64_t rowOffset, int64_t colOffset)
+    {
+        auto offset = [](auto& coordinate, bool absolute, int64_t delta, int64_t max) {
+            if (absolute) return true;
+            const int64_t moved = static_cast<int64_t>(coordinate) + delta;
+            if (moved < 1 || moved > max) return false;
+            coordinate = static_cast<std::remove_reference_t<decltype(coordinate)>>(moved);
+            return true;
+        };
+        for (auto& instruction : program) {
+            if (instruction.op != XLOp::Ref && instruction.op != XLOp::Range) continue;
+            if (!offset(instruction.row1, instruction.absRow1, rowOffset, MAX_ROWS) || !offset(instruction.row2, instruction.absRow2, rowOffset, MAX_ROWS)
+                || !offset(instruction.col1, instruction.absCol1, colOffset, MAX_COLS) || !offset(instruction.col2, instruction.absCol2, colOffset, MAX_COLS))
+                return false;
+        }
+        return true;
+    }
+}    // anonymous namespace
+
+/**
+ * @brief The engine state: worksheets, compiled formulas and the dependency graph
+ */
+class XLFormulaEngine::Impl
+{
+public:
+    struct Sheet
+    {
+        std::string                  name;
+        XLWorksheet                  worksheet;
+        std::map<uint64_t, XMLNode>  cells {};       /**< all cell nodes by cellKey */
+        std::map<uint64_t, uint32_t> formulas {};    /**< formula ids by cellKey */
+        std::vector<std::vector<uint32_t>> columnRanges {};    /**< per column: formulas with a range reference covering the column */
+        std::vector<uint32_t>        wideRanges {};  /**< formulas with a range reference covering more than WideRangeColumns columns */
+    };
+
+    struct Formula
+    {
+        uint32_t  sheet;
+        uint64_t  key;
+        XMLNode   cell;
+        XLProgram program;
+        bool      active {true};
+    };
+
+    struct SharedMaster
+    {
+        uint64_t  key;
+        XLProgram program;
+    };
+
+    static constexpr uint16_t WideRangeColumns = 64;
+
+    explicit Impl(XLDocument& document) : m_sharedStrings(&document.sharedStrings())
+    {
+        XLWorkbook workbook = document.workbook();
+        for (const auto& name : workbook.worksheetNames()) {
+            m_sheetByName.emplace(toUpper(name), static_cast<uint32_t>(m_sheets.size()));
+            m_sheets.push_back(Sheet { name, workbook.worksheet(name) });
+        }
+        for (uint32_t sheet = 0; sheet < m_sheets.size(); ++sheet) sweepSheet(sheet);
+    }
+
+    size_t formulaCount() const { return m_activeFormulas; }
+
+    /**
+     * @brief index all cells of a worksheet and compile its formulas, in one pass over sheetData
+     */
+    void sweepSheet(uint32_t sheet)
+    {
+        Sheet& s = m_sheets[sheet];
+        XMLNode sheetData = s.worksheet.xmlDocument().document_element().child("sheetData");
+        std::vector<std::pair<uint64_t, XMLNode>> pendingShared;    // dependents of shared formulas whose master was not seen yet
+        auto hint = s.cells.end();
+        for (XMLNode row = sheetData.first_child_of_type(pugi::node_element); not row.empty(); row = row.next_sibling_of_type(pugi::node_element)) {
+            uint16_t column = 0;
+            for (XMLNode cell = row.first_child_of_type(pugi::node_element); not cell.empty(); cell = cell.next_sibling_of_type(pugi::node_element)) {
+                XMLAttribute ref = cell.attribute("r");
+                uint32_t rowNumber = row.attribute("r").as_uint();
+                if (not ref.empty()) {
+                    XLCellReference cellRef(ref.value());
+                    rowNumber = cellRef.row();
+                    column = cellRef.column();
+                }
+                else ++column;
+                const uint64_t key = cellKey(rowNumber, column);
+                hint = s.cells.emplace_hint(hint, key, cell);
+
+                XMLNode formula = cell.child("f");
+                if (formula.empty()) continue;
+                if (std::strcmp(formula.attribute("t").value(), "shared") == 0 && formula.text().get()[0] == 0)
+                    pendingShared.emplace_back(key, cell);
+                else
+                    compileCell(sheet, key, cell);
+            }
+        }
+        for (auto& [key, cell] : pendingShared) compileCell(sheet, key, cell);
+    }
+
+    /**
+     * @brief compile the formula of a cell node and register it - formulas that can not be compiled are left untouched
+     */
+    void compileCell(uint32_t sheet, uint64_t key, XMLNode cell)
+    {
+        XMLNode formula = cell.child("f");
+        const char* type = formula.attribute("t").value();
+        XLProgram program;
+        try {
+            if (std::strcmp(type, "shared") == 0) {
+                const uint64_t sharedKey = (static_cast<uint64_t>(sheet) << 32) | formula.attribute("si").as_uint();
+                if (formula.text().get()[0] != 0) {    // master: compile and keep for the dependents
+                    program = compile(sheet, formula.text().get());
+                    m_sharedMasters[sharedKey] = SharedMaster { key, program };
+                }
+                else {
+                    const auto master = m_sharedMasters.find(sharedKey);
+                    if (master == m_sharedMasters.end()) return;
+                    program = master->second.program;
+                    if (!offsetProgram(program,
+                                       static_cast<int64_t>(keyRow(key)) - static_cast<int64_t>(keyRow(master->second.key)),
+                                       static_cast<int64_t>(keyColumn(key)) - static_cast<int64_t>(keyColumn(master->second.key))))
+                        return;
+                }
+            }
+            else if (type[0] == 0 || std::strcmp(type, "normal") == 0)
+                program = compile(sheet, formula.text().get());
+            else
+                return;    // array & data table formulas are not evaluated
+        }
+        catch (const XLFormulaError&) {
+            return;    // unsupported formula: keep the cached value
+        }
+        registerFormula(sheet, key, cell, std::move(program));
+    }
+
+    XLProgram compile(uint32_t sheet, const char* text) const
+    {
+        XLFormulaCompiler::SheetLookup lookup = [this](const std::string& name) -> int64_t {
+            const auto found = m_sheetByName.find(toUpper(name));
+            return found == m_sheetByName.end() ? -1 : static_cast<int64_t>(found->second);
+        };
+        return XLFormulaCompiler(text, sheet, lookup).compile();
+    }
+
+    uint32_t registerFormula(uint32_t sheet, uint64_t key, XMLNode cell, XLProgram program)
+    {
+        const uint32_t id = static_cast<uint32_t>(m_formulas.size());
+        m_formulas.push_back(Formula { sheet, key, cell, std::move(program) });
+        m_sheets[sheet].formulas[key] = id;
+        ++m_activeFormulas;
+
+        for (const auto& instruction : m_formulas[id].program) {
+            if (instruction.op == XLOp::Ref)
+                m_cellDependents[globalKey(instruction.sheet, cellKey(instruction.row1, instruction.col1))].push_back(id);
+            else if (instruction.op == XLOp::Range) {
+                Sheet& target = m_sheets[instruction.sheet];
+                if (instruction.col2 - instruction.col1 >= WideRangeColumns)
+                    target.wideRanges.push_back(id);
+                else {
+                    if (target.columnRanges.size() <= instruction.col2) target.columnRanges.resize(static_cast<size_t>(instruction.col2) + 1);
+                    for (size_t col = instruction.col1; col <= instruction.col2; ++col) target.columnRanges[col].push_back(id);
+                }
+            }
+        }
+        return id;
+    }
+
+    void unregisterFormula(uint32_t id)
+    {
+        Formula& formula = m_formulas[id];
+        if (!formula.active) return;
+        formula.active = false;
+        --m_activeFormulas;
+        m_sheets[formula.sheet].formulas.erase(formula.key);
+
+        auto eraseId = [id](std::vector<uint32_t>& ids) { ids.erase(std::remove(ids.begin(), ids.end(), id), ids.end()); };
+        for (const auto& instruction : formula.program) {
+            if (instruction.op == XLOp::Ref) {
+                const auto dependents = m_cellDependents.find(globalKey(instruction.sheet, cellKey(instruction.row1, instruction.col1)));
+                if (dependents != m_cellDependents.end()) eraseId(dependents->second);
+            }
+            else if (instruction.op == XLOp::Range) {
+                Sheet& target = m_sheets[instruction.sheet];
+                if (instruction.col2 - instruction.col1 >= WideRangeColumns)
+                    eraseId(target.wideRanges);
+                else
+                    for (size_t col = instruction.col1; col <= instruction.col2 && col < target.columnRanges.size(); ++col) eraseId(target.columnRanges[col]);
+            }
+        }
+        formula.program.clear();
+    }
+
+    uint32_t sheetIndex(const std::string& sheetName) const
+    {
+        const auto found = m_sheetByName.find(toUpper(sheetName));
+        if (found == m_sheetByName.end()) throw XLInputError("XLFormulaEngine: unknown worksheet \"" + sheetName + "\"");
+        return found->second;
+    }
+
+    /**
+     * @brief make sure the cell at cellRef exists and is indexed
+     */
+    std::pair<uint64_t, XMLNode> touchCell(uint32_t sheet, const std::string& cellRef)
+    {
+        Sheet& s = m_sheets[sheet];
+        XLCell cell = s.worksheet.cell(cellRef);
+        const uint64_t key = cellKey(cell.cellReference().row(), cell.cellReference().column());
+        XMLNode node = *cell.m_cellNode;
+        s.cells[key] = node;
+        return { key, node };
+    }
+
+    void dropFormula(uint32_t sheet, uint64_t key)
+    {
+        const auto formula = m_sheets[sheet].formulas.find(key);
+        if (formula != m_sheets[sheet].formulas.end()) unregisterFormula(formula->second);
+    }
+
+    void setValue(const std::string& sheetName, const std::string& cellRef, const XLCellValue& value)
+    {
+        const uint32_t sheet = sheetIndex(sheetName);
+        auto [key, node] = touchCell(sheet, cellRef);
+        dropFormula(sheet, key);
+        XLCell cell(node, *m_sharedStrings);
+        cell.formula().clear();
+        cell.value() = value;
+        m_dirtyCells.push_back(globalKey(sheet, key));
+    }
+
+    void setFormula(const std::string& sheetName, const std::string& cellRef, const std::string& formula)
+    {
+        const uint32_t sheet = sheetIndex(sheetName);
+        auto [key, node] = touchCell(sheet, cellRef);
+        dropFormula(sheet, key);
+        XLCell cell(node, *m_sharedStrings);
+        cell.formula() = formula;
+        compileCell(sheet, key, node);
+        const auto compiled = m_sheets[sheet].formulas.find(key);
+        if (compiled != m_sheets[sheet].formulas.end()) m_dirtyFormulas.push_back(compiled->second);
+        m_dirtyCells.push_back(globalKey(sheet, key));
+    }
+
+    void markDirty(const std::string& sheetName, const std::string& cellRef)
+    {
+        const uint32_t sheet = sheetIndex(sheetName);
+        Sheet& s = m_sheets[sheet];
+        XLCellReference ref(cellRef);
+        const uint64_t key = cellKey(ref.row(), ref.column());
+        dropFormula(sheet, key);
+
+        XLCellAssignable cell = s.worksheet.findCell(ref);
+        if (cell.empty())
+            s.cells.erase(key);
+        else {
+            XMLNode node = *cell.m_cellNode;
+            s.cells[key] = node;
+            if (not node.child("f").empty()) {
+                compileCell(sheet, key, node);
+                const auto compiled = s.formulas.find(key);
+                if (compiled != s.formulas.end()) m_dirtyFormulas.push_back(compiled->second);
+            }
+        }
+        m_dirtyCells.push_back(globalKey(sheet, key));
+    }
+
+    /**
+     * @brief mark the formulas reading any of the dirty cells, and then the formulas reading those, and so on
+     */
+    std::vector<uint32_t> collectDirty()
+    {
+        std::vector<uint8_t>  marked(m_formulas.size(), 0);
+        std::vector<uint32_t> result;
+        std::deque<uint64_t>  changedCells(m_dirtyCells.begin(), m_dirtyCells.end());
+
+        auto mark = [&](uint32_t id) {
+            if (marked[id] || !m_formulas[id].active) return;
+            marked[id] = 1;
+            result.push_back(id);
+            changedCells.push_back(globalKey(m_formulas[id].sheet, m_formulas[id].key));
+        };
+        for (uint32_t id : m_dirtyFormulas) mark(id);
+
+        while (!changedCells.empty()) {
+            const uint64_t changed = changedCells.front();
+            changedCells.pop_front();
+            const auto dependents = m_cellDependents.find(changed);
+            if (dependents != m_cellDependents.end())
+                for (uint32_t id : dependents->second) mark(id);
+
+            const uint32_t sheet = static_cast<uint32_t>(changed >> 40);
+            const uint64_t key = changed & ((uint64_t(1) << 40) - 1);
+            const uint32_t row = keyRow(key);
+            const uint16_t col = keyColumn(key);
+            const Sheet& s = m_sheets[sheet];
+            auto covers = [&](uint32_t id) {
+                for (const auto& instruction : m_formulas[id].program)
+                    if (instruction.op == XLOp::Range && instruction.sheet == sheet && row >= instruction.row1 && row <= instruction.row2
+                        && col >= instruction.col1 && col <= instruction.col2)
+                        return true;
+                return false;
+            };
+            if (col < s.columnRanges.size())
+                for (uint32_t id : s.columnRanges[col]) if (!marked[id] && covers(id)) mark(id);
+            for (uint32_t id : s.wideRanges) if (!marked[id] && covers(id)) mark(id);
+        }
+        m_dirtyCells.clear();
+        m_dirtyFormulas.clear();
+        return result;
+    }
+
+    /**
+     * @brief call visit(key, item) for all entries of a cellKey map within a rectangle, jumping over the columns outside of it
+     */
+    template<typename Map, typename Visitor>
+    static void forEachInRect(Map& map, uint32_t row1, uint16_t col1, uint32_t row2, uint16_t col2, Visitor visit)
+    {
+        auto it = map.lower_bound(cellKey(row1, col1));
+        const uint64_t last = cellKey(row2, col2);
+        while (it != map.end() && it->first <= last) {
+            const uint32_t row = keyRow(it->first);
+            const uint16_t col = keyColumn(it->first);
+            if (col < col1) { it = map.lower_bound(cellKey(row, col1)); continue; }
+            if (col > col2) {
+                if (row >= row2) break;
+                it = map.lower_bound(cellKey(row + 1, col1));
+                continue;
+            }
+            visit(it->first, it->second);
+            ++it;
+        }
+    }
+
+    /**
+     * @brief evaluate formulas in dependency order (Kahn's algorithm over the formulas in ids) and write the results
+     */
+    size_t evaluate(const std::vector<uint32_t>& ids)
+    {
+        std::unordered_map<uint32_t, uint32_t> local;    // formula id -> position in ids
+        local.reserve(ids.size());
+        for (uint32_t i = 0; i < ids.size(); ++i) local.emplace(ids[i], i);
+
+        std::vector<uint32_t>              pending(ids.size(), 0);    // count of not yet evaluated precedents
+        std::vector<std::vector<uint32_t>> successors(ids.size());
+        for (uint32_t i = 0; i < ids.size(); ++i) {
+            auto addEdge = [&](uint32_t precedent) {
+                const auto found = local.find(precedent);
+                if (found == local.end() || found->second == i) return;
+                successors[found->second].push_back(i);
+                ++pending[i];
+            };
+            for (const auto& instruction : m_formulas[ids[i]].program) {
+                Sheet& s = m_sheets[instruction.sheet];
+                if (instruction.op == XLOp::Ref) {
+                    const auto precedent = s.formulas.find(cellKey(instruction.row1, instruction.col1));
+                    if (precedent != s.formulas.end()) addEdge(precedent->second);
+                }
+                else if (instruction.op == XLOp::Range)
+                    forEachInRect(s.formulas, instruction.row1, instruction.col1, instruction.row2, instruction.col2,
+                                  [&](uint64_t, uint32_t precedent) { addEdge(precedent); });
+            }
+        }
+
+        std::vector<uint32_t> ready;
+        for (uint32_t i = 0; i < ids.size(); ++i) if (pending[i] == 0) ready.push_back(i);
+        std::vector<uint8_t> done(ids.size(), 0);
+        while (!ready.empty()) {
+            const uint32_t i = ready.back();
+            ready.pop_back();
+            done[i] = 1;
+            writeResult(m_formulas[ids[i]].cell, run(m_formulas[ids[i]]));
+            for (uint32_t successor : successors[i])
+                if (--pending[successor] == 0) ready.push_back(successor);
+        }
+        for (uint32_t i = 0; i < ids.size(); ++i)
+            if (!done[i]) writeResult(m_formulas[ids[i]].cell, XLValue::numberValue(0.0));    // circular reference
+        return ids.size();
+    }
+
+    size_t recalculate() { return evaluate(collectDirty()); }
+
+    size_t recalculateAll()
+    {
+        m_dirtyCells.clear();
+        m_dirtyFormulas.clear();
+        std::vector<uint32_t> ids;
+        for (uint32_t id = 0; id < m_formulas.size(); ++id) if (m_formulas[id].active) ids.push_back(id);
+        return evaluate(ids);
+    }
+
+    /**
+     * @brief read the (cached) value of a cell node
+     */
+    XLValue readCell(const XMLNode& cell) const
+    {
+        const char*   type  = cell.attribute("t").value();
+        const XMLNode value = cell.child("v");
+        if (std::strcmp(type, "s") == 0) return XLValue::textValue(m_sharedStrings->getString(value.text().as_int()));
+        if (std::strcmp(type, "str") == 0) return XLValue::textValue(value.text().get());
+        if (std::strcmp(type, "inlineStr") == 0) return XLValue::textValue(cell.child("is").child("t").text().get());
+        if (std::strcmp(type, "b") == 0) return XLValue::boolValue(value.text().as_bool());
+        if (std::strcmp(type, "e") == 0) return XLValue::errorValue(value.text().get());
+        if (value.empty()) return XLValue();
+        return XLValue::numberValue(value.text().as_double());
+    }
+
+    XLValue cellValue(uint32_t sheet, uint32_t row, uint16_t col) const
+    {
+        const auto& cells = m_sheets[sheet].cells;
+        const auto  found = cells.find(cellKey(row, col));
+        return found == cells.end() ? XLValue() : readCell(found->second);
+    }
+
+    /**
+     * @brief call visit(row, col, value) for all non-empty cells of a range value, in row-major order
+     */
+    template<typename Visitor>
+    void forEachCell(const XLValue& range, Visitor visit) const
+    {
+        forEachInRect(m_sheets[range.sheet].cells, range.row1, range.col1, range.row2, range.col2,
+                      [&](uint64_t key, const XMLNode& node) { visit(keyRow(key), keyColumn(key), readCell(node)); });
+    }
+
+    /**
+     * @brief reduce a value to a scalar: single cell ranges are dereferenced, larger ranges are a #VALUE! error
+     */
+    XLValue scalar(const XLValue& value) const
+    {
+        if (value.kind != XLValue::Kind::Range) return value;
+        if (value.row1 == value.row2 && value.col1 == value.col2) return cellValue(value.sheet, value.row1, value.col1);
+        return XLValue::errorValue("#VALUE!");
+    }
+
+    static XLValue toNumber(const XLValue& value)
+    {
+        switch (value.kind) {
+            case XLValue::Kind::Empty:   return XLValue::numberValue(0.0);
+            case XLValue::Kind::Number:  return value;
+            case XLValue::Kind::Boolean: return XLValue::numberValue(value.number);
+            case XLValue::Kind::Text: {
+                double number = 0.0;
+                return textToNumber(value.text, number) ? XLValue::numberValue(number) : XLValue::errorValue("#VALUE!");
+            }
+            default: return value.kind == XLValue::Kind::Error ? value : XLValue::errorValue("#VALUE!");
+        }
+    }
+
+    static XLValue toText(const XLValue& value)
+    {
+        switch (value.kind) {
+            case XLValue::Kind::Empty:   return XLValue::textValue("");
+            case XLValue::Kind::Number:  return XLValue::textValue(numberToText(value.number));
+            case XLValue::Kind::Boolean: return XLValue::textValue(value.number != 0.0 ? "TRUE" : "FALSE");
+            case XLValue::Kind::Text:    return value;
+            default: return value.kind == XLValue::Kind::Error ? value : XLValue::errorValue("#VALUE!");
+        }
+    }
+
+    static XLValue toBoolean(const XLValue& value)
+    {
+        switch (value.kind) {
+            case XLValue::Kind::Empty:   return XLValue::boolValue(false);
+            case XLValue::Kind::Number:  [[fallthrough]];
+            case XLValue::Kind::Boolean: return XLValue::boolValue(value.number != 0.0);
+            case XLValue::Kind::Text: {
+                const std::string upper = toUpper(value.text);
+                if (upper == "TRUE") return XLValue::boolValue(true);
+                if (upper == "FALSE") return XLValue::boolValue(false);
+                return XLValue::errorValue("#VALUE!");
+            }
+            default: return value.kind == XLValue::Kind::Error ? value : XLValue::errorValue("#VALUE!");
+        }
+    }
+
+    /**
+     * @brief compare two scalars the way Excel does: numbers < texts < booleans, texts case-insensitive, empty as the other side's zero
+     * @return <0, 0 or >0
+     */
+    static int compare(XLValue a, XLValue b)
+    {
+        auto rank = [](XLValue::Kind kind) { return kind == XLValue::Kind::Number ? 0 : kind == XLValue::Kind::Text ? 1 : 2; };
+        if (a.kind == XLValue::Kind::Empty && b.kind == XLValue::Kind::Empty) return 0;
+        if (a.kind == XLValue::Kind::Empty) a = (b.kind == XLValue::Kind::Text) ? XLValue::textValue("") : b.kind == XLValue::Kind::Boolean ? XLValue::boolValue(false) : XLValue::numberValue(0.0);
+        if (b.kind == XLValue::Kind::Empty) b = (a.kind == XLValue::Kind::Text) ? XLValue::textValue("") : a.kind == XLValue::Kind::Boolean ? XLValue::boolValue(false) : XLValue::numberValue(0.0);
+        if (rank(a.kind) != rank(b.kind)) return rank(a.kind) - rank(b.kind);
+        if (a.kind == XLValue::Kind::Text) {
+            const std::string upperA = toUpper(a.text);
+            const std::string upperB = toUpper(b.text);
+            return upperA < upperB ? -1 : (upperA > upperB ? 1 : 0);
+        }
+        return a.number < b.number ? -1 : (a.number > b.number ? 1 : 0);
+    }
+
+    XLValue arithmetic(XLOp op, const XLValue& lhs, const XLValue& rhs) const
+    {
+        const XLValue a = toNumber(scalar(lhs));
+        if (a.isError()) return a;
+        const XLValue b = toNumber(scalar(rhs));
+        if (b.isError()) return b;
+        double result = 0.0;
+        switch (op) {
+            case XLOp::Add: result = a.number + b.number; break;
+            case XLOp::Sub: result = a.number - b.number; break;
+            case XLOp::Mul: result = a.number * b.number; break;
+            case XLOp::Div:
+                if (b.number == 0.0) return XLValue::errorValue("#DIV/0!");
+                result = a.number / b.number;
+                break;
+            default:    // XLOp::Pow
+                result = std::pow(a.number, b.number);
+                break;
+        }
+        return std::isfinite(result) ? XLValue::numberValue(result) : XLValue::errorValue("#NUM!");
+    }
+
+    /**
+     * @brief SUM, AVERAGE, MIN, MAX and COUNT: ranges contribute their numbers, scalar arguments are converted to numbers
+     */
+    XLValue aggregate(XLFunction function, const std::vector<XLValue>& args) const
+    {
+        double  sum   = 0.0;
+        double  min   = 0.0;
+        double  max   = 0.0;
+        size_t  count = 0;
+        XLValue error {};
+        auto add = [&](double number) {
+            if (count == 0 || number < min) min = number;
+            if (count == 0 || number > max) max = number;
+            sum += number;
+            ++count;
+        };
+        for (const auto& arg : args) {
+            if (arg.kind == XLValue::Kind::Range) {
+                forEachCell(arg, [&](uint32_t, uint16_t, const XLValue& value) {
+                    if (value.kind == XLValue::Kind::Number) add(value.number);
+                    else if (value.isError() && !error.isError()) error = value;
+                });
+            }
+            else {
+                const XLValue number = toNumber(arg);
+                if (!number.isError()) add(number.number);
+                else if (!error.isError()) error = number;
+            }
+        }
+        if (function == XLFunction::Count) return XLValue::numberValue(static_cast<double>(count));
+        if (error.isError()) return error;
+        switch (function) {
+            case XLFunction::Sum:     return XLValue::numberValue(sum);
+            case XLFunction::Average: return count ? XLValue::numberValue(sum / static_cast<double>(count)) : XLValue::errorValue("#DIV/0!");
+            case XLFunction::Min:     return XLValue::numberValue(min);
+            default:                  return XLValue::numberValue(max);
+        }
+    }
+
+    /**
+     * @brief find value in the one-dimensional range lookup, returning the 1-based position or 0 if not found
+     * @param matchType 0: first equal value, 1: largest value <= value (ascending data), -1: smallest value >= value (descending data)
+     */
+    uint32_t lookupPosition(const XLValue& value, const XLValue& lookup, int matchType) const
+    {
+        const bool vertical = (lookup.col1 == lookup.col2);
+        uint32_t   found    = 0;
+        bool       stop     = false;
+        forEachCell(lookup, [&](uint32_t row, uint16_t col, const XLValue& candidate) {
+            if (stop || candidate.kind == XLValue::Kind::Empty) return;
+            const uint32_t position = vertical ? row - lookup.row1 + 1 : static_cast<uint32_t>(col - lookup.col1 + 1);
+            const bool sameKind = (candidate.kind == value.kind)
+                                  || (candidate.kind == XLValue::Kind::Boolean && value.kind == XLValue::Kind::Boolean);
+            if (!sameKind) return;
+            const int order = compare(candidate, value);
+            if (matchType == 0) {
+                if (order == 0) { found = position; stop = true; }
+            }
+            else if (matchType > 0) {
+                if (order <= 0) found = position;
+                else stop = true;
+            }
+            else {
+                if (order >= 0) found = position;
+                else stop = true;
+            }
+        });
+        return found;
+    }
+
+    XLValue call(XLFunction function, std::vector<XLValue>& args) const
+    {
+        switch (function) {
+            case XLFunction::Sum:     [[fallthrough]];
+            case XLFunction::Average: [[fallthrough]];
+            case XLFunction::Min:     [[fallthrough]];
+            case XLFunction::Max:     [[fallthrough]];
+            case XLFunction::Count:   return aggregate(function, args);
+
+            case XLFunction::If: {
+                const XLValue condition = toBoolean(scalar(args[0]));
+                if (condition.isError()) return condition;
+                if (condition.number != 0.0) return args[1];
+                return args.size() > 2 ? args[2] : XLValue::boolValue(false);
+            }
+
+            case XLFunction::VLookup: {
+                const XLValue value = scalar(args[0]);
+                if (value.isError()) return value;
+                if (args[1].kind != XLValue::Kind::Range) return XLValue::errorValue("#VALUE!");
+                const XLValue column = toNumber(scalar(args[2]));
+                if (column.isError()) return column;
+                const XLValue approximate = args.size() > 3 ? toBoolean(scalar(args[3])) : XLValue::boolValue(true);
+                if (approximate.isError()) return approximate;
+                const int64_t columnIndex = static_cast<int64_t>(column.number);
+                if (columnIndex < 1) return XLValue::errorValue("#VALUE!");
+                if (columnIndex > static_cast<int64_t>(args[1].col2 - args[1].col1) + 1) return XLValue::errorValue("#REF!");
+
+                XLValue firstColumn = args[1];
+                firstColumn.col2 = firstColumn.col1;
+                const uint32_t position = lookupPosition(value, firstColumn, approximate.number != 0.0 ? 1 : 0);
+                if (position == 0) return XLValue::errorValue("#N/A");
+                return cellValue(args[1].sheet, args[1].row1 + position - 1, static_cast<uint16_t>(args[1].col1 + columnIndex - 1));
+            }
+
+            case XLFunction::Index: {
+                if (args[0].kind != XLValue::Kind::Range) return args.size() == 2 ? scalar(args[0]) : XLValue::errorValue("#REF!");
+                const XLValue& range = args[0];
+                const XLValue  first = toNumber(scalar(args[1]));
+                if (first.isError()) return first;
+                int64_t row = static_cast<int64_t>(first.number);
+                int64_t col = 1;
+                if (args.size() > 2) {
+                    const XLValue second = toNumber(scalar(args[2]));
+                    if (second.isError()) return second;
+                    col = static_cast<int64_t>(second.number);
+                }
+                else if (range.row1 == range.row2) {    // a single row with a single index: the index is the column
+                    col = row;
+                    row = 1;
+                }
+                const int64_t rows = static_cast<int64_t>(range.row2 - range.row1) + 1;
+                const int64_t cols = static_cast<int64_t>(range.col2 - range.col1) + 1;
+                if (row < 0 || col < 0 || row > rows || col > cols) return XLValue::errorValue("#REF!");
+                XLValue result = range;    // row or column 0 selects the whole column or row
+                if (row > 0) result.row1 = result.row2 = range.row1 + static_cast<uint32_t>(row) - 1;
+                if (col > 0) result.col1 = result.col2 = static_cast<uint16_t>(range.col1 + col - 1);
+                return result;
+            }
+
+            default: {    // XLFunction::Match
+                const XLValue value = scalar(args[0]);
+                if (value.isError()) return value;
+                if (args[1].kind != XLValue::Kind::Range || (args[1].row1 != args[1].row2 && args[1].col1 != args[1].col2))
+                    return XLValue::errorValue("#N/A");
+                const XLValue type = args.size() > 2 ? toNumber(scalar(args[2])) : XLValue::numberValue(1.0);
+                if (type.isError()) return type;
+                const uint32_t position = lookupPosition(value, args[1], type.number > 0 ? 1 : (type.number < 0 ? -1 : 0));
+                return position == 0 ? XLValue::errorValue("#N/A") : XLValue::numberValue(position);
+            }
+        }
+    }
+
+    /**
+     * @brief execute the postfix program of a formula
+     */
+    XLValue run(const Formula& formula) const
+    {
+        std::vector<XLValue> stack;
+        stack.reserve(formula.program.size());
+        auto pop = [&]() { XLValue value = std::move(stack.back()); stack.pop_back(); return value; };
+
+        for (const auto& instruction : formula.program) {
+            switch (instruction.op) {
+                case XLOp::Number:  stack.push_back(XLValue::numberValue(instruction.number)); break;
+                case XLOp::String:  stack.push_back(XLValue::textValue(instruction.text)); break;
+                case XLOp::Boolean: stack.push_back(XLValue::boolValue(instruction.number != 0.0)); break;
+                case XLOp::Error:   stack.push_back(XLValue::errorValue(instruction.text)); break;
+                case XLOp::Ref:     stack.push_back(cellValue(instruction.sheet, instruction.row1, instruction.col1)); break;
+                case XLOp::Range:
+                    stack.push_back(XLValue::rangeValue(instruction.sheet, instruction.row1, instruction.col1, instruction.row2, instruction.col2));
+                    break;
+
+                case XLOp::Add: [[fallthrough]];
+                case XLOp::Sub: [[fallthrough]];
+                case XLOp::Mul: [[fallthrough]];
+                case XLOp::Div: [[fallthrough]];
+                case XLOp::Pow: {
+                    const XLValue rhs = pop();
+                    const XLValue lhs = pop();
+                    stack.push_back(arithmetic(instruction.op, lhs, rhs));
+                } break;
+
+                case XLOp::Neg: [[fallthrough]];
+                case XLOp::Percent: {
+                    const XLValue number = toNumber(scalar(pop()));
+                    if (number.isError()) stack.push_back(number);
+                    else stack.push_back(XLValue::numberValue(instruction.op == XLOp::Neg ? -number.number : number.number / 100.0));
+                } break;
+
+                case XLOp::Concat: {
+                    const XLValue rhs = toText(scalar(pop()));
+                    const XLValue lhs = toText(scalar(pop()));
+                    if (lhs.isError()) stack.push_back(lhs);
+                    else if (rhs.isError()) stack.push_back(rhs);
+                    else stack.push_back(XLValue::textValue(lhs.text + rhs.text));
+                } break;
+
+                case XLOp::Eq: [[fallthrough]];
+                case XLOp::Ne: [[fallthrough]];
+                case XLOp::Lt: [[fallthrough]];
+                case XLOp::Le: [[fallthrough]];
+                case XLOp::Gt: [[fallthrough]];
+                case XLOp::Ge: {
+                    const XLValue rhs = scalar(pop());
+                    const XLValue lhs = scalar(pop());
+                    if (lhs.isError()) { stack.push_back(lhs); break; }
+                    if (rhs.isError()) { stack.push_back(rhs); break; }
+                    const int order = compare(lhs, rhs);
+                    bool result = false;
+                    switch (instruction.op) {
+                        case XLOp::Eq: result = (order == 0); break;
+                        case XLOp::Ne: result = (order != 0); break;
+                        case XLOp::Lt: result = (order < 0);  break;
+                        case XLOp::Le: result = (order <= 0); break;
+                        case XLOp::Gt: result = (order > 0);  break;
+                        default:       result = (order >= 0); break;
+                    }
+                    stack.push_back(XLValue::boolValue(result));
+                } break;
+
+                case XLOp::Call: {
+                    std::vector<XLValue> args(instruction.argCount);
+                    for (size_t i = instruction.argCount; i > 0; --i) args[i - 1] = pop();
+                    stack.push_back(call(instruction.function, args));
+                } break;
+            }
+        }
+        return stack.empty() ? XLValue() : scalar(stack.back());
+    }
+
+    /**
+     * @brief write a formula result into the <v> node of the cell, with the matching t attribute
+     */
+    static void writeResult(XMLNode cell, const XLValue& result)
+    {
+        XMLNode value = cell.child("v");
+        if (value.empty()) value = cell.append_child("v");
+        XMLAttribute type = cell.attribute("t");
+        auto setType = [&](const char* newType) {
+            if (type.empty()) type = cell.append_attribute("t");
+            type.set_value(newType);
+        };
+        cell.remove_child("is");
+
+        switch (result.kind) {
+            case XLValue::Kind::Empty:    // a formula reading an empty cell results in 0
+                cell.remove_attribute("t");
+                value.text().set(0);
+                break;
+            case XLValue::Kind::Number:
+                cell.remove_attribute("t");
+                value.text().set(result.number);
+                break;
+            case XLValue::Kind::Boolean:
+                setType("b");
+                value.text().set(result.number != 0.0 ? 1 : 0);
+                break;
+            case XLValue::Kind::Text:
+                setType("str");
+                value.text().set(result.text.c_str());
+                break;
+            default:
+                setType("e");
+                value.text().set(result.kind == XLValue::Kind::Error ? result.text.c_str() : "#VALUE!");
+                break;
+        }
+    }
+
+private:
+    const XLSharedStrings*                           m_sharedStrings;
+    std::vector<Sheet>                               m_sheets {};
+    std::unordered_map<std::string, uint32_t>        m_sheetByName {};      /**< sheet index by upper case name */
+    std::vector<Formula>                             m_formulas {};         /**< by formula id - removed formulas stay as inactive slots */
+    size_t                                           m_activeFormulas {0};
+    std::unordered_map<uint64_t, SharedMaster>       m_sharedMasters {};    /**< compiled shared formula masters by sheet << 32 | si */
+    std::unordered_map<uint64_t, std::vector<uint32_t>> m_cellDependents {}; /**< formulas reading a single cell, by globalKey */
+    std::vector<uint64_t>                            m_dirtyCells {};       /**< globalKeys of cells changed since the last calculation */
+    std::vector<uint32_t>                            m_dirtyFormulas {};    /**< formulas changed since the last calculation */
+};
+
+/**
+ * @details
+ */
+XLFormulaEngine::XLFormulaEngine(XLDocument& document) : m_impl(std::make_unique<Impl>(document)) {}
+
+/**
+ * @details
+ */
+XLFormulaEngine::~XLFormulaEngine() = default;
+
+/**
+ * @details
+ */
+XLFormulaEngine::XLFormulaEngine(XLFormulaEngine&& other) noexcept = default;
+
+/**
+ * @details
+ */
+XLFormulaEngine& XLFormulaEngine::operator=(XLFormulaEngine&& other) noexcept = default;
+
+/**
+ * @details
+ */
+size_t XLFormulaEngine::formulaCount() const { return m_impl->formulaCount(); }
+
+/**
+ * @details
+ */
+void XLFormulaEngine::setValue(const std::string& sheetName, const std::string& cellRef, const XLCellValue& value)
+{
+    m_impl->setValue(sheetName, cellRef, value);
+}
+
+/**
+ * @details
+ */
+void XLFormulaEngine::setFormula(const std::string& sheetName, const std::string& cellRef, const std::string& formula)
+{
+    m_impl->setFormula(sheetName, cellRef, formula);
+}
+
+/**
+ * @details
+ */
+void XLFormulaEngine::markDirty(const std::string& sheetName, const std::string& cellRef) { m_impl->markDirty(sheetName, cellRef); }
+
+/**
+ * @details
+ */
+size_t XLFormulaEngine::recalculate() { return m_impl->recalculate(); }
+
+/**
+ * @details
+ */
+size_t XLFormulaEngine::recalculateAll() { return m_impl->recalculateAll(); }
@@ -51,11 +51,62 @@ YM      M9  MM    MM MM       MM    MM   d'  `MM.    MM            MM   d'  `MM.
 // ===== OpenXLSX Includes ===== //
 #include "XLMergeCells.hpp"
 #include "XLCellReference.hpp"
+#include "XLConstants.hpp"
 #include "XLException.hpp"
 #include "utilities/XLUtilities.hpp" // appendAndGetNode
 
 using namespace OpenXLSX;
 
+namespace { // anonymous namespace: do not export any symbols from here
+    /**
+     * @brief Parse a range reference into its top left and bottom right cell coordinates
+     * @param reference the range reference, e.g. A1:B5
+     * @param caller the function name to use in error messages
+     * @param topRow, firstCol, bottomRow, lastCol receive the range coordinates
+     * @throws XLInputError if reference is not a valid range reference of at least two cells
+     */
+    void parseMergeReference(const std::string& reference, const char* caller,
+                             uint32_t& topRow, uint16_t& firstCol, uint32_t& bottomRow, uint16_t& lastCol)
+    {
+        using namespace std::literals::string_literals;
+
+        size_t pos = reference.find_first_of(':'); // find split mark between top left and bottom right cell
+        if (pos < 2 || pos + 2 >= reference.length()) // range reference must have at least 2 characters before and after the colon
+            throw XLInputError("XLMergeCells::"s + caller + ": not a valid range reference: \""s + reference + "\""s);
+        XLCellReference refTL(reference.substr(0, pos));  // get top left cell reference
+        XLCellReference refBR(reference.substr(pos + 1)); // get bottom right cell reference
+
+        topRow    = refTL.row();
+        firstCol  = refTL.column();
+        bottomRow = refBR.row();
+        lastCol   = refBR.column();
+        if (bottomRow < topRow || lastCol < firstCol || (bottomRow == topRow && lastCol == firstCol))
+            throw XLInputError("XLMergeCells::"s + caller + ": not a valid range reference: \""s + reference + "\""s);
+    }
+
+    // ===== The segment trees have one leaf per row or column: node 1 is the root, the children of node n are 2n and 2n + 1
+    constexpr uint32_t RowTreeLeaves    = MAX_ROWS;
+    constexpr uint32_t ColumnTreeLeaves = MAX_COLS;
+    static_assert((RowTreeLeaves & (RowTreeLeaves - 1)) == 0 && (ColumnTreeLeaves & (ColumnTreeLeaves - 1)) == 0,
+                  "the merge segment trees require a power of two leaves");
+
+    /**
+     * @brief Call visit for each node of the smallest set of segment tree nodes that together cover the interval first..last
+     * @param leaves the leaf count of the tree
+     * @param first, last the 1-based interval to cover
+     * @param visit the callable to invoke with each node number
+     * @note an interval is covered by at most two nodes per tree level
+     */
+    template<typename Visit>
+    void forEachCoveringNode(uint32_t leaves, uint32_t first, uint32_t last, Visit visit)
+    {
+        for (uint32_t lo = leaves + first - 1, hi = leaves + last; lo < hi; lo >>= 1, hi >>= 1) {
+            if (lo & 1) visit(lo++);
+            if (hi & 1) visit(--hi);
+        }
+    }
+} // anonymous namespace
+
 /**
  * @details Constructs an uninitialized XLMergeCells object
  */
@@ -63,8 +114,8 @@ XLMergeCells::XLMergeCells() = default;
 
 /**
  * @details Constructs a new XLMergeCells object. Invoked by XLWorksheet::mergeCells / ::unmergeCells
- * @note Unfortunately, there is no easy way to persist the reference cache, this could be optimized - however, references access shouldn't
- *       be much of a performance issue
+ * @note Unfortunately, there is no easy way to persist the reference cache, this could be optimized - however, each reference is only
+ *       parsed once, into the segment trees
  */
 XLMergeCells::XLMergeCells(const XMLNode& rootNode, std::vector< std::string_view > const & nodeOrder)
  : m_rootNode(std::make_unique<XMLNode>(rootNode)),
@@ -82,10 +133,13 @@ XLMergeCells::XLMergeCells(const XMLNode& rootNode, std::vector< std::string_vie
         // ===== For valid mergeCell nodes, add the reference to the reference cache
         if (std::string(mergeNode.name()) == "mergeCell") {
             std::string ref = mergeNode.attribute("ref").value();
-            if (ref.length() > 0) {
-                m_referenceCache.emplace_back(ref);
-                invalidNode = false;
+            XLMergeRange range{};
+            try {
+                parseMergeReference(ref, __func__, range.topRow, range.firstCol, range.bottomRow, range.lastCol);
+                invalidNode = (findOverlap(range) != XLMergeNoId); // overlapping merges are as invalid as malformed references
             }
+            catch (XLInputError const&) {} // invalidNode remains true
+            if (not invalidNode) insertMerge(ref, range, mergeNode);
         }
 
         // ===== Determine next element mergeNode
@@ -93,7 +147,7 @@ XLMergeCells::XLMergeCells(const XMLNode& rootNode, std::vector< std::string_vie
 
         // ===== In case of an invalid XML element: print an error and remove it from the XML, including whitespaces to the next sibling
         if (invalidNode) { // if mergeNode is not named mergeCell or does not have a valid ref attribute: remove it from the XML
-            std::cerr << "XLMergeCells constructor: invalid child element, either name is not mergeCell or reference is invalid:" << std::endl;
+            std::cerr << "XLMergeCells constructor: invalid child element, either name is not mergeCell or reference is invalid or overlapping:" << std::endl;
             mergeNode.print(std::cerr);
             if (not nextNode.empty()) {
                 // delete whitespaces between mergeNode and nextNode
@@ -106,11 +160,11 @@ XLMergeCells::XLMergeCells(const XMLNode& rootNode, std::vector< std::string_vie
         mergeNode = nextNode;
     }
 
-    if (m_referenceCache.size() > 0) {
+    if (m_merges.size() > 0) {
         // ===== Ensure initial array count attribute / issue #351
         XMLAttribute attr = m_mergeCellsNode->attribute("count");
         if (attr.empty()) attr = m_mergeCellsNode->append_attribute("count");
-        attr.set_value(m_referenceCache.size());
+        attr.set_value(m_merges.size());
     }
     else // no merges left
         deleteAll(); // delete mergeCells element & re-initialize m_mergeCellsNode to a default-constructed XMLNode()
@@ -129,7 +183,12 @@ XLMergeCells::XLMergeCells(const XLMergeCells& other)
     m_rootNode = other.m_rootNode ? std::make_unique<XMLNode>( *other.m_rootNode ) : std::unique_ptr<XMLNode> {};
     m_nodeOrder = other.m_nodeOrder;
     m_mergeCellsNode = other.m_mergeCellsNode ? std::make_unique<XMLNode>( *other.m_mergeCellsNode ) : std::unique_ptr<XMLNode> {};
-    m_referenceCache = other.m_referenceCache;
+    m_merges = other.m_merges;
+    m_mergeRanks = other.m_mergeRanks;
+    m_nextMergeId = other.m_nextMergeId;
+    m_rowTree = other.m_rowTree;
+    m_columnTree = other.m_columnTree;
+    m_cornerTree = other.m_cornerTree;
 }
 
 /**
@@ -140,7 +199,12 @@ XLMergeCells::XLMergeCells(XLMergeCells&& other)
     m_rootNode = std::move( other.m_rootNode );
     m_nodeOrder = std::move( other.m_nodeOrder );
     m_mergeCellsNode = std::move( other.m_mergeCellsNode );
-    m_referenceCache = std::move( other.m_referenceCache );
+    m_merges = std::move( other.m_merges );
+    m_mergeRanks = std::move( other.m_mergeRanks );
+    m_nextMergeId = other.m_nextMergeId;
+    m_rowTree = std::move( other.m_rowTree );
+    m_columnTree = std::move( other.m_columnTree );
+    m_cornerTree = std::move( other.m_cornerTree );
 }
 
 /**
@@ -151,7 +215,12 @@ XLMergeCells& XLMergeCells::operator=(const XLMergeCells& other)
     m_rootNode = other.m_rootNode ? std::make_unique<XMLNode>( *other.m_rootNode ) : std::unique_ptr<XMLNode> {};
     m_nodeOrder = other.m_nodeOrder;
     m_mergeCellsNode = other.m_mergeCellsNode ? std::make_unique<XMLNode>( *other.m_mergeCellsNode ) : std::unique_ptr<XMLNode> {};
-    m_referenceCache = other.m_referenceCache;
+    m_merges = other.m_merges;
+    m_mergeRanks = other.m_mergeRanks;
+    m_nextMergeId = other.m_nextMergeId;
+    m_rowTree = other.m_rowTree;
+    m_columnTree = other.m_columnTree;
+    m_cornerTree = other.m_cornerTree;
     return *this;
 }
 
@@ -163,7 +232,12 @@ XLMergeCells& XLMergeCells::operator=(XLMergeCells&& other)
     m_rootNode = std::move( other.m_rootNode );
     m_nodeOrder = std::move( other.m_nodeOrder );
     m_mergeCellsNode = std::move( other.m_mergeCellsNode );
-    m_referenceCache = std::move( other.m_referenceCache );
+    m_merges = std::move( other.m_merges );
+    m_mergeRanks = std::move( other.m_mergeRanks );
+    m_nextMergeId = other.m_nextMergeId;
+    m_rowTree = std::move( other.m_rowTree );
+    m_columnTree = std::move( other.m_columnTree );
+    m_cornerTree = std::move( other.m_cornerTree );
     return *this;
 }
 
@@ -172,50 +246,149 @@ XLMergeCells& XLMergeCells::operator=(XLMergeCells&& other)
  */
 bool XLMergeCells::valid() const { return ( m_rootNode != nullptr && not m_rootNode->empty() ); }
 
+/**
+ * @details A merge overlaps with range if and only if one of the following holds:
+ *          - it contains the top row of range, and its columns overlap with those of range: the merges stored at the row tree nodes
+ *            on the path to the top row all contain that row, so that the merges stored at one such node have disjoint columns
+ *          - it contains the first column of range, and its rows overlap with those of range: likewise in the column tree
+ *          - its top left cell lies within range: the corner tree stores each merge at the nodes on the path to its first column,
+ *            ordered by top row, so that a range search in each node covering the columns of range finds it
+ */
+uint32_t XLMergeCells::findOverlap(const XLMergeRange& range) const
+{
+    // ===== The spans stored at one node are disjoint: the only candidate is the last span that starts at or before last
+    auto findSpan = [](const XLMergeSpans& spans, uint32_t first, uint32_t last) {
+        auto span = spans.upper_bound(last);
+        if (span == spans.begin()) return XLMergeNoId;
+        --span;
+        return span->second.last >= first ? span->second.mergeId : XLMergeNoId;
+    };
+
+    if (m_merges.empty()) return XLMergeNoId;
+
+    for (uint32_t node = RowTreeLeaves + range.topRow - 1; node > 0; node >>= 1) {
+        auto spans = m_rowTree.find(node);
+        if (spans == m_rowTree.end()) continue;
+        const uint32_t mergeId = findSpan(spans->second, range.firstCol, range.lastCol);
+        if (mergeId != XLMergeNoId) return mergeId;
+    }
 
-namespace { // anonymous namespace: do not export any symbols from here
-    /**
-     * @brief Test if (range) reference overlaps with the cell window defined by topRow, firstCol, bottomRow, lastCol
-     * @return true in case of overlap, false if no overlap
-     */
-    bool XLReferenceOverlaps(std::string reference, uint32_t topRow, uint16_t firstCol, uint32_t bottomRow, uint16_t lastCol)
-    {
-        using namespace std::literals::string_literals;
+    for (uint32_t node = ColumnTreeLeaves + range.firstCol - 1; node > 0; node >>= 1) {
+        auto spans = m_columnTree.find(node);
+        if (spans == m_columnTree.end()) continue;
+        const uint32_t mergeId = findSpan(spans->second, range.topRow, range.bottomRow);
+        if (mergeId != XLMergeNoId) return mergeId;
+    }
 
-        size_t pos = reference.find_first_of(':'); // find split mark between top left and bottom right cell
-        if (pos < 2 || pos + 2 >= reference.length()) // range reference must have at least 2 characters before and after the colon
-            throw XLInputError("XLMergeCells::"s + __func__ + ": not a valid range reference: \""s + reference + "\""s);
-        XLCellReference refTL(reference.substr(0, pos));  // get top left cell reference
-        XLCellReference refBR(reference.substr(pos + 1)); // get bottom right cell reference
+    uint32_t mergeId = XLMergeNoId;
+    forEachCoveringNode(ColumnTreeLeaves, range.firstCol, range.lastCol, [&](uint32_t node) {
+        if (mergeId != XLMergeNoId) return;
+        auto corners = m_cornerTree.find(node);
+        if (corners == m_cornerTree.end()) return;
+        auto corner = corners->second.lower_bound(std::make_pair(range.topRow, uint32_t{0}));
+        if (corner != corners->second.end() && corner->first <= range.bottomRow) mergeId = corner->second;
+    });
+    return mergeId;
+}
 
-        uint32_t refTopRow    = refTL.row();
-        uint16_t refFirstCol  = refTL.column();
-        uint32_t refBottomRow = refBR.row();
-        uint16_t refLastCol   = refBR.column();
-        if (refBottomRow < refTopRow || refLastCol < refFirstCol || (refBottomRow == refTopRow && refLastCol == refFirstCol))
-            throw XLInputError("XLMergeCells::"s + __func__ + ": not a valid range reference: \""s + reference + "\""s);
-
-// std::cout << __func__ << ":" << " reference is " << reference
-//    << " refTopRow is " << refTopRow << " refBottomRow is " << refBottomRow << " refFirstCol is " << refFirstCol << " refLastCol is " << refLastCol
-//    << " topRow is " << topRow << " bottomRow is " << bottomRow << " firstCol is " << firstCol << " lastCol is " << lastCol
-//    << std::endl;
-
-        // overlap
-        if (refTopRow <= bottomRow && refBottomRow >= topRow        // vertical overlap
-            && refFirstCol <= lastCol && refLastCol >= firstCol)    // horizontal overlap
-            return true;
-        return false; // otherwise: no overlap
+/**
+ * @details
+ */
+void XLMergeCells::indexMerge(const XLMergeRange& range, uint32_t mergeId)
+{
+    forEachCoveringNode(RowTreeLeaves, range.topRow, range.bottomRow, [&](uint32_t node) {
+        m_rowTree[node].emplace(range.firstCol, XLMergeSpan{ range.lastCol, mergeId });
+    });
+    forEachCoveringNode(ColumnTreeLeaves, range.firstCol, range.lastCol, [&](uint32_t node) {
+        m_columnTree[node].emplace(range.topRow, XLMergeSpan{ range.bottomRow, mergeId });
+    });
+    for (uint32_t node = ColumnTreeLeaves + range.firstCol - 1; node > 0; node >>= 1) m_cornerTree[node].emplace(range.topRow, mergeId);
+}
+
+/**
+ * @details Tree nodes that no longer store any merge are removed, so that the trees only ever hold the nodes in use
+ */
+void XLMergeCells::unindexMerge(const XLMergeRange& range, uint32_t mergeId)
+{
+    auto eraseSpan = [](std::unordered_map<uint32_t, XLMergeSpans>& tree, uint32_t node, uint32_t first) {
+        auto spans = tree.find(node);
+        if (spans == tree.end()) return;
+        spans->second.erase(first);
+        if (spans->second.empty()) tree.erase(spans);
+    };
+
+    forEachCoveringNode(RowTreeLeaves, range.topRow, range.bottomRow, [&](uint32_t node) { eraseSpan(m_rowTree, node, range.firstCol); });
+    forEachCoveringNode(ColumnTreeLeaves, range.firstCol, range.lastCol, [&](uint32_t node) { eraseSpan(m_columnTree, node, range.topRow); });
+    for (uint32_t node = ColumnTreeLeaves + range.firstCol - 1; node > 0; node >>= 1) {
+        auto corners = m_cornerTree.find(node);
+        if (corners == m_cornerTree.end()) continue;
+        corners->second.erase(std::make_pair(range.topRow, mergeId));
+        if (corners->second.empty()) m_cornerTree.erase(corners);
     }
-} // anonymous namespace
+}
+
+/**
+ * @details Stable ids are assigned in document order and never reused until deleteAll, so that the index of a merge is the count of
+ *          ids in use below its own. The new id is appended to the Fenwick tree m_mergeRanks with its count of 1 plus the counts of
+ *          the lower ids that its element aggregates.
+ */
+void XLMergeCells::insertMerge(const std::string& reference, const XLMergeRange& range, const XMLNode& node)
+{
+    const uint32_t mergeId = m_nextMergeId++;
+    m_merges.emplace_hint(m_merges.end(), mergeId, XLMergeEntry{ reference, range, node });
+
+    const uint32_t element = mergeId + 1; // 1-based Fenwick element of mergeId
+    m_mergeRanks.push_back(static_cast<uint32_t>(1 + mergePosition(element - 1) - mergePosition(element & (element - 1))));
+    indexMerge(range, mergeId);
+}
+
+/**
+ * @details m_mergeRanks[element - 1] holds the count of ids in use among the ids element - lowbit(element) .. element - 1, so that the
+ *          count of ids in use below mergeId - its merge index - is a sum of one element per set bit of mergeId
+ */
+XLMergeIndex XLMergeCells::mergePosition(uint32_t mergeId) const
+{
+    uint32_t position = 0;
+    for (uint32_t element = mergeId; element > 0; element &= element - 1) position += m_mergeRanks[element - 1];
+    return static_cast<XLMergeIndex>(position);
+}
+
+/**
+ * @details Descend the Fenwick tree from the largest power of two: the result is the largest id with at most index ids in use below
+ *          it, which is the id of the merge at index
+ * @note index must be a valid merge index
+ */
+uint32_t XLMergeCells::mergeIdAt(XLMergeIndex index) const
+{
+    const auto size = static_cast<uint32_t>(m_mergeRanks.size());
+    uint32_t step = 1;
+    while (step <= size / 2) step <<= 1;
+
+    uint32_t mergeId   = 0;
+    auto     remaining = static_cast<uint32_t>(index);
+    for (; step > 0; step >>= 1) {
+        if (mergeId + step <= size && m_mergeRanks[mergeId + step - 1] <= remaining) {
+            mergeId += step;
+            remaining -= m_mergeRanks[mergeId - 1];
+        }
+    }
+    return mergeId;
+}
 
 /**
  * @details Look up a merge index by the reference. If the reference does not exist, the returned index is XLMergeNotFound (-1).
  */
 XLMergeIndex XLMergeCells::findMerge(const std::string& reference) const
 {
-    const auto iter = std::find_if(m_referenceCache.begin(), m_referenceCache.end(), [&](const std::string& ref) { return reference == ref; });
+    XLMergeRange range{};
+    try {
+        parseMergeReference(reference, __func__, range.topRow, range.firstCol, range.bottomRow, range.lastCol);
+    }
+    catch (XLInputError const&) { return XLMergeNotFound; } // a malformed reference can not be a merge
 
-    return iter == m_referenceCache.end() ? XLMergeNotFound : static_cast<XLMergeIndex>(std::distance(m_referenceCache.begin(), iter));
+    // ===== The merge containing the top left cell is the only candidate: it must also match the reference string
+    const uint32_t mergeId = findOverlap(XLMergeRange{ range.topRow, range.firstCol, range.topRow, range.firstCol });
+    return (mergeId != XLMergeNoId && m_merges.at(mergeId).reference == reference) ? mergePosition(mergeId) : XLMergeNotFound;
 }
 
 /**
@@ -229,29 +402,26 @@ bool XLMergeCells::mergeExists(const std::string& reference) const { return find
 XLMergeIndex XLMergeCells::findMergeByCell(const std::string& cellRef) const { return findMergeByCell(XLCellReference(cellRef)); }
 XLMergeIndex XLMergeCells::findMergeByCell(XLCellReference cellRef) const
 {
-    const auto iter = std::find_if(m_referenceCache.begin(), m_referenceCache.end(),
-    /**/                           [&](const std::string& ref) { // use XLReferenceOverlaps with a "range" that only contains cellRef
-    /**/                               return XLReferenceOverlaps( ref, cellRef.row(), cellRef.column(), cellRef.row(), cellRef.column());
-    /**/                           });
-
-    return iter == m_referenceCache.end() ? XLMergeNotFound : static_cast<XLMergeIndex>(std::distance(m_referenceCache.begin(), iter));
+    // ===== Use findOverlap with a "range" that only contains cellRef
+    const uint32_t mergeId = findOverlap(XLMergeRange{ cellRef.row(), cellRef.column(), cellRef.row(), cellRef.column() });
+    return mergeId == XLMergeNoId ? XLMergeNotFound : mergePosition(mergeId);
 }
 
 /**
  * @details
  */
-size_t XLMergeCells::count() const { return m_referenceCache.size(); }
+size_t XLMergeCells::count() const { return m_merges.size(); }
 
 /**
  * @details
  */
 const char* XLMergeCells::merge(XLMergeIndex index) const
 {
-    if (index < 0 || static_cast<uint32_t>(index) >= m_referenceCache.size()) {
+    if (index < 0 || static_cast<uint32_t>(index) >= m_merges.size()) {
         using namespace std::literals::string_literals;
         throw XLInputError("XLMergeCells::"s + __func__ + ": index "s + std::to_string(index) + " is out of range"s);
     }
-    return m_referenceCache[index].c_str();
+    return m_merges.at(mergeIdAt(index)).reference.c_str();
 }
 
 /**
@@ -263,28 +433,17 @@ XLMergeIndex XLMergeCells::appendMerge(const std::string& reference)
 {
     using namespace std::literals::string_literals;
 
-    size_t referenceCacheSize = m_referenceCache.size();
-    if (referenceCacheSize >= XLMaxMergeCells)
+    const size_t mergeCount = m_merges.size();
+    if (mergeCount >= XLMaxMergeCells)
         throw XLInputError("XLMergeCells::"s + __func__ + ": exceeded max merge cells count "s + std::to_string(XLMaxMergeCells));
 
-    size_t pos = reference.find_first_of(':'); // find split mark between top left and bottom right cell
-    if (pos < 2 || pos + 2 >= reference.length()) // range reference must have at least 2 characters before and after the colon
-        throw XLInputError("XLMergeCells::"s + __func__ + ": not a valid range reference: \""s + reference + "\""s);
-    XLCellReference refTL(reference.substr(0, pos));  // get top left cell reference
-    XLCellReference refBR(reference.substr(pos + 1)); // get bottom right cell reference
-
-    uint32_t refTopRow    = refTL.row();
-    uint16_t refFirstCol  = refTL.column();
-    uint32_t refBottomRow = refBR.row();
-    uint16_t refLastCol   = refBR.column();
-    if (refBottomRow < refTopRow || refLastCol < refFirstCol || (refBottomRow == refTopRow && refLastCol == refFirstCol))
-        throw XLInputError("XLMergeCells::"s + __func__ + ": not a valid range reference: \""s + reference + "\""s);
-
-    for (std::string ref : m_referenceCache) {
-        if (XLReferenceOverlaps(ref, refTopRow, refFirstCol, refBottomRow, refLastCol))
-            throw XLInputError("XLMergeCells::"s + __func__ + ": reference \""s + reference
-            /**/                   + "\" overlaps with existing reference \""s + ref + "\""s);
-    }
+    XLMergeRange range{};
+    parseMergeReference(reference, __func__, range.topRow, range.firstCol, range.bottomRow, range.lastCol);
+
+    const uint32_t overlapId = findOverlap(range);
+    if (overlapId != XLMergeNoId)
+        throw XLInputError("XLMergeCells::"s + __func__ + ": reference \""s + reference
+        /**/                   + "\" overlaps with existing reference \""s + m_merges.at(overlapId).reference + "\""s);
     // if execution gets here: no overlaps
 
     if (m_mergeCellsNode->empty()) // create mergeCells element if needed
@@ -299,46 +458,46 @@ XLMergeIndex XLMergeCells::appendMerge(const std::string& reference)
         throw XLInternalError("XLMergeCells::"s + __func__ + ": failed to insert reference: \""s + reference + "\""s);
     newMerge.append_attribute("ref").set_value(reference.c_str());
 
-    m_referenceCache.emplace_back(newMerge.attribute("ref").value()); // index of this element = previous referenceCacheSize
+    insertMerge(newMerge.attribute("ref").value(), range, newMerge); // the new id is the highest: its index = previous mergeCount
 
     // ===== Update the array count attribute
     XMLAttribute attr = m_mergeCellsNode->attribute("count");
     if (attr.empty()) attr = m_mergeCellsNode->append_attribute("count");
-    attr.set_value(m_referenceCache.size());
+    attr.set_value(m_merges.size());
 
-    return static_cast<XLMergeIndex>(referenceCacheSize);
+    return static_cast<XLMergeIndex>(mergeCount);
 }
 
 /**
- * @details Delete the merge at the given index
+ * @details Delete the merge at the given index. The stable ids of the other merges remain valid, only the Fenwick tree counts of
+ *          the ids above the deleted one are updated
  */
 void XLMergeCells::deleteMerge(XLMergeIndex index)
 {
     using namespace std::literals::string_literals;
 
-    if (index < 0 || static_cast<uint32_t>(index) >= m_referenceCache.size())
+    if (index < 0 || static_cast<uint32_t>(index) >= m_merges.size())
         throw XLInputError("XLMergeCells::"s + __func__ + ": index "s + std::to_string(index) + " is out of range"s);
 
-    XLMergeIndex curIndex = 0;
-    XMLNode node = m_mergeCellsNode->first_child_of_type(pugi::node_element);
-    while(curIndex < index && not node.empty()) {
-        node = node.next_sibling_of_type(pugi::node_element);
-        ++curIndex;
-    }
-    if (node.empty())
-        throw XLInternalError("XLMergeCells::"s + __func__ + ": mismatch between size of mergeCells XML node and internal reference cache"s);
+    const uint32_t mergeId = mergeIdAt(index);
+    auto           entry   = m_merges.find(mergeId);
+    XMLNode        node    = entry->second.node;
+    if (node.empty() || node.parent() != *m_mergeCellsNode)
+        throw XLInternalError("XLMergeCells::"s + __func__ + ": mismatch between mergeCells XML node and internal reference cache"s);
 
     // ===== node was found: delete preceeding whitespace nodes and the node itself
     while (node.previous_sibling().type() == pugi::node_pcdata) m_mergeCellsNode->remove_child(node.previous_sibling());
     m_mergeCellsNode->remove_child(node);
 
-    m_referenceCache.erase(m_referenceCache.begin() + curIndex);
+    unindexMerge(entry->second.range, mergeId);
+    m_merges.erase(entry);
+    for (uint32_t element = mergeId + 1; element <= m_mergeRanks.size(); element += element & (~element + 1)) --m_mergeRanks[element - 1];
 
-    if (m_referenceCache.size() > 0) {
+    if (m_merges.size() > 0) {
         // ===== Update the array count attribute
         XMLAttribute attr = m_mergeCellsNode->attribute("count");
         if (attr.empty()) attr = m_mergeCellsNode->append_attribute("count");
-        attr.set_value(m_referenceCache.size()); // update the array count attribute
+        attr.set_value(m_merges.size()); // update the array count attribute
     }
     else // no merges left
         deleteAll(); // delete mergeCells element & re-initialize m_mergeCellsNode to a default-constructed XMLNode()
@@ -346,7 +505,12 @@ void XLMergeCells::deleteMerge(XLMergeIndex index)
 
 void XLMergeCells::deleteAll()
 {
-    m_referenceCache.clear();
+    m_merges.clear();
+    m_mergeRanks.clear();
+    m_nextMergeId = 0;
+    m_rowTree.clear();
+    m_columnTree.clear();
+    m_cornerTree.clear();
     m_rootNode->remove_child(*m_mergeCellsNode);
     m_mergeCellsNode = std::make_unique<XMLNode>(XMLNode());
 }
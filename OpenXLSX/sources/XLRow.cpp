@@ -394,7 +394,8 @@ namespace OpenXLSX
           m_hintRow(),
           m_hintRowNumber(0),
           m_currentRowStatus(XLNotLoaded),
-          m_currentRowNumber(0)
+          m_currentRowNumber(0),
+          m_readOnly(m_sharedStrings.get().isReadOnly())
     {
         if (loc == XLIteratorLocation::End)
             m_endReached = true;
@@ -425,7 +426,8 @@ namespace OpenXLSX
           m_hintRow(other.m_hintRow),
           m_hintRowNumber(other.m_hintRowNumber),
           m_currentRowStatus(other.m_currentRowStatus),
-          m_currentRowNumber(other.m_currentRowNumber)
+          m_currentRowNumber(other.m_currentRowNumber),
+          m_readOnly(other.m_readOnly)
     {}
 
     /**
@@ -459,9 +461,12 @@ namespace OpenXLSX
 
     /**
      * @brief update m_currentRow by fetching (or inserting) a row at m_currentRowNumber
+     * @note in a read-only document, a missing row is not inserted: the iterator then points to an empty XLRow without cells
      */
     void XLRowIterator::updateCurrentRow(bool createIfMissing)
     {
+        createIfMissing = createIfMissing && not m_readOnly;    // reading a read-only document must not modify it
+
         // ===== Quick exit checks - can't be true when m_endReached
         if (m_currentRowStatus == XLLoaded) return;                           // nothing to do, row is already loaded
         if (!createIfMissing && m_currentRowStatus == XLNoSuchRow) return;    // nothing to do, row has already been determined as missing
@@ -496,9 +501,10 @@ namespace OpenXLSX
                 if (createIfMissing && rowNode.empty()) {
                     rowNode = m_dataNode->insert_child_after("row", m_hintRow);
                     rowNode.append_attribute("r").set_value(m_currentRowNumber);
+                    OPENXLSX_STATS_COUNT(rowNodesCreated);
                 }
                 if (rowNode.empty())    // if row could not be found / created
-                    m_currentRow = XLRow{}; // make sure m_currentRow is set to an empty cell
+                    m_currentRow = XLRow(XMLNode{}, m_sharedStrings.get()); // make sure m_currentRow is set to an empty row
                 else
                     m_currentRow = XLRow(rowNode, m_sharedStrings.get());
             }
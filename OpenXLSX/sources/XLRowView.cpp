@@ -0,0 +1,204 @@
+/*
+
+   ____                               ____      ___ ____       ____  ____      ___
+  6MMMMb                              `MM(      )M' `MM'      6MMMMb\`MM(      )M'
+ 8P    Y8                              `MM.     d'   MM      6M'    ` `MM.     d'
+6M      Mb __ ____     ____  ___  __    `MM.   d'    MM      MM        `MM.   d'
+MM      MM `M6MMMMb   6MMMMb `MM 6MMb    `MM. d'     MM      YM.        `MM. d'
+MM      MM  MM'  `Mb 6M'  `Mb MMM9 `Mb    `MMd       MM       YMMMMb     `MMd
+MM      MM  MM    MM MM    MM MM'   MM     dMM.      MM           `Mb     dMM.
+MM      MM  MM    MM MMMMMMMM MM    MM    d'`MM.     MM            MM    d'`MM.
+YM      M9  MM    MM MM       MM    MM   d'  `MM.    MM            MM   d'  `MM.
+ 8b    d8   MM.  ,M9 YM    d9 MM    MM  d'    `MM.   MM    / L    ,M9  d'    `MM.
+  YMMMM9    MMYMMM9   YMMMM9 _MM_  _MM_M(_    _)MM_ _MMMMMMM MYMMMM9 _M(_    _)MM_
+            MM
+            MM
+           _MM_
+
+  Copyright (c) 2018, Kenneth Troldal Balslev
+
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+  - Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+  - Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+  - Neither the name of the author nor the
+    names of any contributors may be used to endorse or promote products
+    derived from this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+  DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+  DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+  ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ */
+
+// ===== External Includes ===== //
+#include <cmath>        // std::isfinite
+#include <cstring>      // std::strcmp
+#include <pugixml.hpp>
+
+// ===== OpenXLSX Includes ===== //
+#include "XLCell.hpp"
+#include "XLException.hpp"
+#include "XLRowView.hpp"
+#include "utilities/XLUtilities.hpp"    // OpenXLSX::parseNumber, OpenXLSX::cellNodeColumn
+
+using namespace OpenXLSX;
+
+/**
+ * @details
+ */
+uint32_t XLCellView::row() const { return m_row != nullptr ? m_row->rowNumber() : 0; }
+
+/**
+ * @details Mirrors XLCellValueProxy::type, without copying the value text.
+ */
+XLValueType XLCellView::type() const
+{
+    if (m_cellNode.empty()) return XLValueType::Empty;
+
+    const XMLAttribute typeAttr  = m_cellNode.attribute("t");
+    const XMLNode      valueNode = m_cellNode.child("v");
+    if (typeAttr.empty() && valueNode.empty()) return XLValueType::Empty;
+
+    const char* type = typeAttr.value();
+    if (typeAttr.empty() || (std::strcmp(type, "n") == 0 && not valueNode.empty())) {
+        const char* text = valueNode.child_value();
+        if (std::strchr(text, '.') != nullptr || std::strstr(text, "E-") != nullptr || std::strstr(text, "e-") != nullptr)
+            return XLValueType::Float;
+        return XLValueType::Integer;
+    }
+    if (std::strcmp(type, "s") == 0 || std::strcmp(type, "inlineStr") == 0 || std::strcmp(type, "str") == 0) return XLValueType::String;
+    if (std::strcmp(type, "b") == 0) return XLValueType::Boolean;
+    return XLValueType::Error;
+}
+
+/**
+ * @details
+ */
+double XLCellView::number() const
+{
+    const XLValueType valueType = type();
+    double            result    = 0.0;
+    if ((valueType != XLValueType::Integer && valueType != XLValueType::Float) || not parseNumber(m_cellNode.child("v").child_value(), result))
+        throw XLValueTypeError("XLCellView::number: cell is not numeric");
+    return result;
+}
+
+/**
+ * @details
+ */
+bool XLCellView::boolean() const
+{
+    if (type() != XLValueType::Boolean) throw XLValueTypeError("XLCellView::boolean: cell is not a boolean");
+    return m_cellNode.child("v").text().as_bool();
+}
+
+/**
+ * @details
+ */
+const char* XLCellView::text() const
+{
+    if (type() != XLValueType::String) throw XLValueTypeError("XLCellView::text: cell is not a string");
+
+    const char* type = m_cellNode.attribute("t").value();
+    if (type[0] == 's' && type[1] == '\0') return m_row->m_sharedStrings->getString(m_cellNode.child("v").text().as_int());
+    if (type[0] == 'i') return m_cellNode.child("is").child("t").child_value();
+    return m_cellNode.child("v").child_value();
+}
+
+/**
+ * @details
+ */
+XLCellValue XLCellView::value() const
+{
+    if (m_cellNode.empty()) return XLCellValue();
+    return XLCell(m_cellNode, *m_row->m_sharedStrings).value();
+}
+
+/**
+ * @details A number assigned to a number cell only replaces the text of the <v> node. Everything else is assigned through
+ *  XLCellValueProxy, so the resulting XML is the same as for XLCell::value().
+ */
+void XLCellView::setValue(const XLCellValue& value)
+{
+    if (m_row == nullptr || m_row->m_writeMutex == nullptr)
+        throw XLException("XLCellView::setValue: the rows were not requested with XLParallelMode::UpdateValues");
+    if (m_cellNode.empty()) throw XLException("XLCellView::setValue: cell does not exist (cells are not inserted by parallelForRows)");
+    if (value.type() == XLValueType::String) throw XLInputError("XLCellView::setValue: strings would modify the shared strings table");
+
+    std::lock_guard<std::mutex> lock(*m_row->m_writeMutex);
+    XMLNode    valueNode = m_cellNode.child("v");
+    const bool isNumber  = m_cellNode.attribute("t").empty() && not valueNode.empty();
+    if (isNumber && value.type() == XLValueType::Integer)
+        valueNode.text().set(value.get<int64_t>());
+    else if (isNumber && value.type() == XLValueType::Float && std::isfinite(value.get<double>()))
+        valueNode.text().set(value.get<double>());
+    else
+        XLCell(m_cellNode, *m_row->m_sharedStrings).value() = value;
+}
+
+/**
+ * @details
+ */
+XLRowView::Iterator& XLRowView::Iterator::operator++()
+{
+    m_cell = m_cell.m_row->makeCell(m_cell.m_cellNode.next_sibling_of_type(pugi::node_element), m_cell.m_column);
+    return *this;
+}
+
+/**
+ * @details Cells without an r attribute follow their predecessor.
+ */
+XLCellView XLRowView::makeCell(const XMLNode& cellNode, uint16_t previousColumn) const
+{
+    if (cellNode.empty()) return XLCellView();
+    const uint16_t column = cellNodeColumn(cellNode);
+    return XLCellView(cellNode, column != 0 ? column : previousColumn + 1, this);
+}
+
+/**
+ * @details
+ */
+XLRowView::Iterator XLRowView::begin() const { return Iterator(makeCell(m_rowNode.first_child_of_type(pugi::node_element), 0)); }
+
+/**
+ * @details
+ */
+uint16_t XLRowView::cellCount() const
+{
+    const XMLNode last = m_rowNode.last_child_of_type(pugi::node_element);
+    if (last.empty()) return 0;
+    const uint16_t column = cellNodeColumn(last);
+    if (column != 0) return column;
+
+    uint16_t count = 0;    // no r attribute: count the cells
+    for (auto cell = begin(); cell != end(); ++cell) count = cell->column();
+    return count;
+}
+
+/**
+ * @details The search starts at the cell found by the previous call if that is not beyond the requested column, so that
+ *  ascending lookups walk the row once.
+ */
+XLCellView XLRowView::cell(uint16_t column) const
+{
+    XLCellView current = (not m_hint.empty() && m_hint.m_column <= column) ? m_hint : makeCell(m_rowNode.first_child_of_type(pugi::node_element), 0);
+    while (not current.empty() && current.m_column < column)
+        current = makeCell(current.m_cellNode.next_sibling_of_type(pugi::node_element), current.m_column);
+
+    if (current.empty() || current.m_column != column) return XLCellView(XMLNode(), column, this);
+    m_hint = current;
+    return current;
+}
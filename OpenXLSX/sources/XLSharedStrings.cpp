@@ -52,6 +52,7 @@ YM      M9  MM    MM MM       MM    MM   d'  `MM.    MM            MM   d'  `MM.
 #include "XLSharedStrings.hpp"
 
 #include "XLException.hpp"
+#include "utilities/XLStatsRecorder.hpp"
 
 namespace OpenXLSX {
     const XLSharedStrings XLSharedStringsDefaulted{};
@@ -92,6 +93,7 @@ XLSharedStrings::~XLSharedStrings() = default;
  */
 int32_t XLSharedStrings::getStringIndex(const std::string& str) const
 {
+    OPENXLSX_STATS_COUNT(sharedStringLookups);
     const auto iter = std::find_if(m_stringCache->begin(), m_stringCache->end(), [&](const std::string& s) { return str == s; });
 
     return iter == m_stringCache->end() ? -1 : static_cast<int32_t>(std::distance(m_stringCache->begin(), iter));
@@ -107,6 +109,7 @@ bool XLSharedStrings::stringExists(const std::string& str) const { return getStr
  */
 const char* XLSharedStrings::getString(int32_t index) const
 {
+    OPENXLSX_STATS_COUNT(sharedStringLookups);
     if (index < 0 || static_cast<size_t>(index) >= m_stringCache->size()) { // 2024-04-30: added range check
         using namespace std::literals::string_literals;
         throw XLInternalError("XLSharedStrings::"s + __func__ + ": index "s + std::to_string(index) + " is out of range"s);
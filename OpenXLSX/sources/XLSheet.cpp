@@ -48,7 +48,9 @@ YM      M9  MM    MM MM       MM    MM   d'  `MM.    MM            MM   d'  `MM.
 #include <cctype>    // std::isdigit (issue #330)
 #include <limits>    // std::numeric_limits
 #include <map>       // std::multimap
+#include <mutex>     // std::mutex
 #include <pugixml.hpp>
+#include <thread>    // std::thread::hardware_concurrency
 
 // ===== OpenXLSX Includes ===== //
 #include "XLCellRange.hpp"
@@ -56,6 +58,7 @@ YM      M9  MM    MM MM       MM    MM   d'  `MM.    MM            MM   d'  `MM.
 #include "XLDocument.hpp"
 #include "XLMergeCells.hpp"
 #include "XLSheet.hpp"
+#include "utilities/XLParallel.hpp"
 #include "utilities/XLUtilities.hpp"
 
 using namespace OpenXLSX;
@@ -1029,6 +1032,9 @@ std::string XLConditionalFormats::summary() const
  */
 XLWorksheet::XLWorksheet(XLXmlData* xmlData) : XLSheetBase(xmlData)
 {
+    // ===== A read-only document is used as-is: column ranges are split on demand by XLWorksheet::column
+    if (parentDoc().isReadOnly()) return;
+
     // ===== Read the dimensions of the Sheet and set data members accordingly.
     if (const std::string dimensions = xmlDocument().document_element().child("dimension").attribute("ref").value();
         dimensions.find(':') == std::string::npos)
@@ -1175,6 +1181,8 @@ XLCellAssignable XLWorksheet::cell(const XLCellReference& ref) const { return ce
  */
 XLCellAssignable XLWorksheet::cell(uint32_t rowNumber, uint16_t columnNumber) const
 {
+    if (parentDoc().isReadOnly()) return findCell(rowNumber, columnNumber);    // reading a read-only document must not modify it
+
     const XMLNode rowNode  = getRowNode(xmlDocument().document_element().child("sheetData"), rowNumber);
     const XMLNode cellNode = getCellNode(rowNode, columnNumber, rowNumber);
     // ===== Move-construct XLCellAssignable from temporary XLCell
@@ -1274,6 +1282,54 @@ XLRowRange XLWorksheet::rows(uint32_t firstRow, uint32_t lastRow) const
                       parentDoc().sharedStrings());
 }
 
+/**
+ * @details The workers take blocks of the row index from a shared counter. The blocks are large enough to amortize the
+ *  counter, and small enough (about 8 per thread) to balance rows of different cost. The calling thread is one of the workers.
+ */
+void XLWorksheet::parallelForRows(uint32_t                               firstRow,
+                                  uint32_t                               lastRow,
+                                  const std::function<void(XLRowView&)>& fn,
+                                  unsigned                               threads,
+                                  XLParallelMode                         mode) const
+{
+    using namespace std::literals::string_literals;
+    if (firstRow < 1 || firstRow > lastRow || lastRow > MAX_ROWS)
+        throw XLInputError("XLWorksheet::parallelForRows: invalid row band "s + std::to_string(firstRow) + ":"s + std::to_string(lastRow));
+    if (mode == XLParallelMode::UpdateValues && parentDoc().isReadOnly())
+        throw XLException("XLWorksheet::parallelForRows: can not update values of a read-only document");
+
+    // ===== Parse the sheet (if needed) and index the row nodes of the band, before any worker starts
+    std::vector<std::pair<XMLNode, uint32_t>> rowIndex;
+    uint32_t                                  rowNumber = 0;
+    for (XMLNode rowNode = xmlDocument().document_element().child("sheetData").first_child_of_type(pugi::node_element); not rowNode.empty();
+         rowNode         = rowNode.next_sibling_of_type(pugi::node_element))
+    {
+        const XMLAttribute rowRef = rowNode.attribute("r");
+        rowNumber                 = rowRef.empty() ? rowNumber + 1 : rowRef.as_uint();
+        if (rowNumber < firstRow) continue;
+        if (rowNumber > lastRow) break;
+        rowIndex.emplace_back(rowNode, rowNumber);
+    }
+    if (rowIndex.empty()) return;
+
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+    const size_t blockSize  = std::max<size_t>(64, rowIndex.size() / (size_t { threads } * 8));
+    const size_t blockCount = (rowIndex.size() + blockSize - 1) / blockSize;
+    threads                 = static_cast<unsigned>(std::min<size_t>(threads, blockCount));
+
+    const XLSharedStrings* sharedStrings = &parentDoc().sharedStrings();
+    std::mutex             writeMutex;
+    std::mutex* const      writes = (mode == XLParallelMode::UpdateValues ? &writeMutex : nullptr);
+
+    runParallel(blockCount, threads, [&](size_t block) {
+        const size_t end = std::min(rowIndex.size(), (block + 1) * blockSize);
+        for (size_t i = block * blockSize; i < end; ++i) {
+            XLRowView row(rowIndex[i].first, rowIndex[i].second, sharedStrings, writes);
+            fn(row);
+        }
+    });
+}
+
 /**
  * @details Get the XLRow object corresponding to the given row number. In the XML file, all cell data are stored under
  * the corresponding row, and all rows have to be ordered in ascending order. If a row have no data, there may not be a
@@ -1281,6 +1337,8 @@ XLRowRange XLWorksheet::rows(uint32_t firstRow, uint32_t lastRow) const
  */
 XLRow XLWorksheet::row(uint32_t rowNumber) const
 {
+    if (parentDoc().isReadOnly()) return XLRow { findRowNode(xmlDocument().document_element().child("sheetData"), rowNumber), parentDoc().sharedStrings() };
+
     return XLRow { getRowNode(xmlDocument().document_element().child("sheetData"), rowNumber),
                    parentDoc().sharedStrings() };
 }
@@ -1297,6 +1355,13 @@ XLColumn XLWorksheet::column(uint16_t columnNumber) const
     if (columnNumber < 1 || columnNumber > OpenXLSX::MAX_COLS)    // 2024-08-05: added range check
         throw XLException("XLWorksheet::column: columnNumber "s + std::to_string(columnNumber) + " is outside allowed range [1;"s + std::to_string(MAX_COLS) + "]"s);
 
+    // ===== In a read-only document, return the node that covers the column, or an empty XLColumn (with default properties)
+    if (parentDoc().isReadOnly()) {
+        return XLColumn(xmlDocument().document_element().child("cols").find_child([&](const XMLNode node) {
+            return columnNumber >= node.attribute("min").as_int() && columnNumber <= node.attribute("max").as_int();
+        }));
+    }
+
     // If no columns exists, create the <cols> node in the XML document.
     if (xmlDocument().document_element().child("cols").empty())
         xmlDocument().document_element().insert_child_before("cols", xmlDocument().document_element().child("sheetData"));
@@ -0,0 +1,252 @@
+/*
+
+   ____                               ____      ___ ____       ____  ____      ___
+  6MMMMb                              `MM(      )M' `MM'      6MMMMb\`MM(      )M'
+ 8P    Y8                              `MM.     d'   MM      6M'    ` `MM.     d'
+6M      Mb __ ____     ____  ___  __    `MM.   d'    MM      MM        `MM.   d'
+MM      MM `M6MMMMb   6MMMMb `MM 6MMb    `MM. d'     MM      YM.        `MM. d'
+MM      MM  MM'  `Mb 6M'  `Mb MMM9 `Mb    `MMd       MM       YMMMMb     `MMd
+MM      MM  MM    MM MM    MM MM'   MM     dMM.      MM           `Mb     dMM.
+MM      MM  MM    MM MMMMMMMM MM    MM    d'`MM.     MM            MM    d'`MM.
+YM      M9  MM    MM MM       MM    MM   d'  `MM.    MM            MM   d'  `MM.
+ 8b    d8   MM.  ,M9 YM    d9 MM    MM  d'    `MM.   MM    / L    ,M9  d'    `MM.
+  YMMMM9    MMYMMM9   YMMMM9 _MM_  _MM_M(_    _)MM_ _MMMMMMM MYMMMM9 _M(_    _)MM_
+            MM
+            MM
+           _MM_
+
+  Copyright (c) 2018, Kenneth Troldal Balslev
+
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+  - Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+  - Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+  - Neither the name of the author nor the
+    names of any contributors may be used to endorse or promote products
+    derived from this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+  DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+  DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+  ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ */
+
+// ===== External Includes ===== //
+#include <algorithm>
+#include <chrono>
+#include <cstdio>       // std::snprintf
+#include <unordered_map>
+
+// ===== OpenXLSX Includes ===== //
+#include "XLStats.hpp"
+#include "utilities/XLStatsRecorder.hpp"
+
+using namespace OpenXLSX;
+
+namespace    // anonymous namespace for module local functions
+{
+    XLStatsCounterSet counterSet {};    // the process wide counters
+
+    /**
+     * @brief Append str to out as a JSON string literal
+     */
+    void appendJsonString(std::string& out, const std::string& str)
+    {
+        out += '"';
+        for (const char c : str) {
+            switch (c) {
+                case '"': out += "\\\""; break;
+                case '\\': out += "\\\\"; break;
+                case '\n': out += "\\n"; break;
+                case '\t': out += "\\t"; break;
+                default:
+                    if (static_cast<unsigned char>(c) < 0x20) {
+                        char buffer[8];
+                        std::snprintf(buffer, sizeof(buffer), "\\u%04x", static_cast<unsigned>(c));
+                        out += buffer;
+                    }
+                    else
+                        out += c;
+            }
+        }
+        out += '"';
+    }
+
+    /**
+     * @brief Format nanoseconds as the microseconds used by the Chrome trace event format
+     */
+    std::string microseconds(uint64_t nanoseconds)
+    {
+        char buffer[32];
+        std::snprintf(buffer, sizeof(buffer), "%llu.%03llu", static_cast<unsigned long long>(nanoseconds / 1000),
+                      static_cast<unsigned long long>(nanoseconds % 1000));
+        return buffer;
+    }
+}    // anonymous namespace
+
+/**
+ * @details
+ */
+XLStatsCounterSet& OpenXLSX::statsCounters() { return counterSet; }
+
+/**
+ * @details
+ */
+XLArchiveSaveDurations& OpenXLSX::archiveSaveDurations()
+{
+    thread_local XLArchiveSaveDurations durations {};
+    return durations;
+}
+
+/**
+ * @details
+ */
+const char* OpenXLSX::XLStatsPhaseName(XLStatsPhase phase)
+{
+    switch (phase) {
+        case XLStatsPhase::Cleanup: return "Cleanup";
+        case XLStatsPhase::Inflate: return "Inflate";
+        case XLStatsPhase::Parse: return "Parse";
+        case XLStatsPhase::Serialize: return "Serialize";
+        case XLStatsPhase::Deflate: return "Deflate";
+        case XLStatsPhase::Validate: return "Validate";
+    }
+    return "invalid";
+}
+
+/**
+ * @details
+ */
+bool XLStats::enabled()
+{
+#ifdef OPENXLSX_ENABLE_STATS
+    return true;
+#else
+    return false;
+#endif
+}
+
+/**
+ * @details
+ */
+const XLPartStats* XLStats::part(const std::string& path) const
+{
+    const auto result = std::find_if(m_parts.begin(), m_parts.end(), [&](const XLPartStats& p) { return p.part == path; });
+    return result == m_parts.end() ? nullptr : &*result;
+}
+
+/**
+ * @details Each phase run becomes a complete ("X") event named after its part, with the phase as category. The counters are
+ *  added as one counter ("C") event at the end of the last run.
+ */
+std::string XLStats::chromeTrace() const
+{
+    std::string result = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    uint64_t    end    = 0;
+    for (const auto& event : m_events) {
+        result += "\n{\"name\":";
+        appendJsonString(result, event.part);
+        result += ",\"cat\":\"";
+        result += XLStatsPhaseName(event.phase);
+        result += "\",\"ph\":\"X\",\"ts\":" + microseconds(event.start) + ",\"dur\":" + microseconds(event.duration);
+        result += ",\"pid\":1,\"tid\":" + std::to_string(event.thread);
+        result += ",\"args\":{\"bytes\":" + std::to_string(event.bytes) + "}},";
+        end = std::max(end, event.start + event.duration);
+    }
+    result += "\n{\"name\":\"counters\",\"ph\":\"C\",\"ts\":" + microseconds(end) + ",\"pid\":1,\"tid\":0,\"args\":{";
+    result += "\"sharedStringLookups\":" + std::to_string(m_counters.sharedStringLookups);
+    result += ",\"rowNodesCreated\":" + std::to_string(m_counters.rowNodesCreated);
+    result += ",\"cellNodesCreated\":" + std::to_string(m_counters.cellNodesCreated);
+    result += ",\"cacheHits\":" + std::to_string(m_counters.cacheHits);
+    result += "}}\n]}\n";
+    return result;
+}
+
+/**
+ * @details
+ */
+XLStatsCollector::XLStatsCollector() { reset(); }
+
+/**
+ * @details
+ */
+void XLStatsCollector::record(XLStatsPhase phase, const std::string& part, uint64_t start, uint64_t duration, uint64_t bytes)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    const auto thread = m_threads.emplace(std::this_thread::get_id(), static_cast<uint32_t>(m_threads.size())).first->second;
+    m_events.push_back(XLStatsEvent { phase, part, start > m_origin ? start - m_origin : 0, duration, bytes, thread });
+}
+
+/**
+ * @details
+ */
+void XLStatsCollector::reset()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_origin   = now();
+    m_baseline = counters();
+    m_events.clear();
+    m_threads.clear();
+}
+
+/**
+ * @details
+ */
+XLStats XLStatsCollector::snapshot() const
+{
+    XLStats result;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        result.m_events = m_events;
+        const XLStatsCounters current = counters();
+        result.m_counters.sharedStringLookups = current.sharedStringLookups - m_baseline.sharedStringLookups;
+        result.m_counters.rowNodesCreated     = current.rowNodesCreated - m_baseline.rowNodesCreated;
+        result.m_counters.cellNodesCreated    = current.cellNodesCreated - m_baseline.cellNodesCreated;
+        result.m_counters.cacheHits           = current.cacheHits - m_baseline.cacheHits;
+    }
+
+    std::unordered_map<std::string, size_t> partIndex;
+    for (const auto& event : result.m_events) {
+        const auto index = partIndex.emplace(event.part, result.m_parts.size());
+        if (index.second) result.m_parts.push_back(XLPartStats { event.part, {} });
+        for (XLPhaseStats* totals : { &result.m_phases[static_cast<size_t>(event.phase)],
+                                      &result.m_parts[index.first->second].phases[static_cast<size_t>(event.phase)] }) {
+            totals->nanoseconds += event.duration;
+            totals->bytes += event.bytes;
+            ++totals->count;
+        }
+    }
+    return result;
+}
+
+/**
+ * @details
+ */
+uint64_t XLStatsCollector::now()
+{
+    return static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+/**
+ * @details
+ */
+XLStatsCounters XLStatsCollector::counters()
+{
+    return XLStatsCounters { counterSet.sharedStringLookups.load(std::memory_order_relaxed),
+                             counterSet.rowNodesCreated.load(std::memory_order_relaxed),
+                             counterSet.cellNodesCreated.load(std::memory_order_relaxed),
+                             counterSet.cacheHits.load(std::memory_order_relaxed) };
+}
@@ -44,12 +44,17 @@ YM      M9  MM    MM MM       MM    MM   d'  `MM.    MM            MM   d'  `MM.
  */
 
 // ===== External Includes ===== //
+#include <algorithm>    // std::sort
+#include <cctype>       // std::tolower
 #include <cstdint>      // uint32_t
+#include <functional>   // std::hash
 #include <iostream>     // std::cout, std::cerr
 #include <memory>       // std::make_unique
 #include <pugixml.hpp>
 #include <stdexcept>    // std::invalid_argument
 #include <string>       // std::stoi, std::literals::string_literals
+#include <string_view>  // std::string_view
+#include <utility>      // std::pair
 #include <vector>       // std::vector
 
 // ===== OpenXLSX Includes ===== //
@@ -399,14 +404,314 @@ namespace     // anonymous namespace for module local functions
         }
     }
 
+    /**
+     * @brief Determine whether a new style entry shall be prefixed with whitespace
+     * @param styleEntriesPrefix the configured prefix
+     * @param lastEntry the current last entry of the style collection, if any
+     * @return true if a prefix is configured, unless the existing entries are not indented - e.g. because the part was
+     *         written without indentation or parsed without whitespace text nodes - so that new entries follow the layout
+     */
+    bool useEntryPrefix(std::string const & styleEntriesPrefix, XMLNode const & lastEntry)
+    {
+        if (styleEntriesPrefix.empty()) return false;
+        return lastEntry.empty() || lastEntry.previous_sibling().type() == pugi::node_pcdata;
+    }
+
+    /**
+     * @brief Surround a newly prepended node with whitespace prefix, unless the following element is not indented either
+     */
     void wrapNode(XMLNode parentNode, XMLNode & node, std::string const & prefix)
     {
-        if (not node.empty() && prefix.length() > 0) {
+        if (not node.empty() && prefix.length() > 0 && node.next_sibling().type() != pugi::node_element) {
             parentNode.insert_child_before(pugi::node_pcdata, node).set_value(prefix.c_str());    // insert prefix before node opening tag
             node.append_child(pugi::node_pcdata).set_value(prefix.c_str());                       // insert prefix before node closing tag (within node)
         }
     }
 
+    /**
+     * @brief Append a canonical representation of node's content to key: element name, attributes sorted by name,
+     *        element children in document order and any text that is not whitespace-only
+     * @note name / value delimiters are '\0' and '\1', which can not occur in XML 1.0 documents
+     */
+    void appendStyleContentKey(std::string & key, XMLNode const & node)
+    {
+        key += node.name();
+        key += '\1';
+        std::vector< std::pair< std::string_view, std::string_view > > attributes;
+        for (XMLAttribute attr = node.first_attribute(); not attr.empty(); attr = attr.next_attribute())
+            attributes.emplace_back(attr.name(), attr.value());
+        std::sort(attributes.begin(), attributes.end());
+        for (auto const & [name, value] : attributes) {
+            key += name;
+            key += '\0';
+            key += value;
+            key += '\0';
+        }
+        key += '\1';
+        for (XMLNode child = node.first_child(); not child.empty(); child = child.next_sibling()) {
+            if (child.type() == pugi::node_element)
+                appendStyleContentKey(key, child);
+            else if (child.type() == pugi::node_pcdata || child.type() == pugi::node_cdata) {
+                std::string_view text = child.value();
+                if (text.find_first_not_of(" \t\r\n") != std::string_view::npos) {
+                    key += text;
+                    key += '\0';
+                }
+            }
+        }
+        key += '\1';
+    }
+
+    std::string styleContentKey(XMLNode const & node)
+    {
+        std::string key;
+        appendStyleContentKey(key, node);
+        return key;
+    }
+
+    /**
+     * @brief Bring a content hash index up to date: re-hash all entries that were touched, and add all entries that were appended
+     * @param index the hash index of a style collection
+     * @param entryCount the current amount of entries in the style collection
+     * @param entryNode a function returning the XMLNode of the entry with the given index
+     */
+    template< typename NodeGetter >
+    void updateStyleHashIndex(XLStyleHashIndex & index, size_t entryCount, NodeGetter entryNode)
+    {
+        if (index.hashes.size() > entryCount) index.clear(); // entries were removed: rebuild the index
+
+        for (XLStyleIndex entry : index.stale) {
+            auto range = index.buckets.equal_range(index.hashes[ entry ]);
+            for (auto it = range.first; it != range.second; ++it) {
+                if (it->second == entry) { index.buckets.erase(it); break; }
+            }
+            index.hashes[ entry ] = std::hash< std::string >{}(styleContentKey(entryNode(entry)));
+            index.buckets.emplace(index.hashes[ entry ], entry);
+            index.touched[ entry ] = false;
+        }
+        index.stale.clear();
+
+        index.hashes.reserve(entryCount);
+        for (XLStyleIndex entry = index.hashes.size(); entry < entryCount; ++entry) {
+            index.hashes.push_back(std::hash< std::string >{}(styleContentKey(entryNode(entry))));
+            index.touched.push_back(false);
+            index.buckets.emplace(index.hashes.back(), entry);
+        }
+    }
+
+    /**
+     * @brief Look up an entry with content identical to node in an up-to-date content hash index
+     * @return the index of the matching entry, or XLInvalidStyleIndex if none was found
+     */
+    template< typename NodeGetter >
+    XLStyleIndex findInStyleHashIndex(XLStyleHashIndex const & index, XMLNode const & node, NodeGetter entryNode)
+    {
+        std::string key = styleContentKey(node);
+        auto range = index.buckets.equal_range(std::hash< std::string >{}(key));
+        XLStyleIndex result = XLInvalidStyleIndex;
+        for (auto it = range.first; it != range.second; ++it) {     // hash collisions are resolved by a full key comparison
+            if (it->second < result && styleContentKey(entryNode(it->second)) == key)
+                result = it->second;                                // prefer the lowest index among identical entries
+        }
+        return result;
+    }
+
+    /**
+     * @brief Remove the last entry node from a style collection node, including the prefix that create inserted before it
+     * @param parent the style collection node
+     * @param node the entry node to be removed
+     * @param styleEntriesPrefix the prefix that was passed to create
+     * @param newCount the entry count to store in the parent count attribute
+     */
+    void removeLastStyleEntry(XMLNode & parent, XMLNode const & node, std::string const & styleEntriesPrefix, size_t newCount)
+    {
+        XMLNode prefix = node.previous_sibling();
+        if (styleEntriesPrefix.length() > 0 && prefix.type() == pugi::node_pcdata && styleEntriesPrefix == prefix.value())
+            parent.remove_child(prefix);
+        parent.remove_child(node);
+        appendAndSetAttribute(parent, "count", std::to_string(newCount));
+    }
+
+    /**
+     * @brief Remove the entry nodes of a style collection node that are not flagged to be kept, including their whitespace prefix
+     * @param parent the style collection node
+     * @param keep flags the entries to be kept - entries beyond keep.size() are removed
+     * @return the renumbering of the entries: old index -> new index, or XLInvalidStyleIndex for removed entries
+     */
+    std::vector<XLStyleIndex> removeUnusedStyleEntries(XMLNode parent, std::vector<bool> const & keep)
+    {
+        std::vector<XLStyleIndex> indexMap;
+        XLStyleIndex newIndex = 0;
+        XMLNode node = parent.first_child_of_type(pugi::node_element);
+        while (not node.empty()) {
+            XMLNode next = node.next_sibling_of_type(pugi::node_element);
+            if (indexMap.size() < keep.size() && keep[indexMap.size()])
+                indexMap.push_back(newIndex++);
+            else {
+                indexMap.push_back(XLInvalidStyleIndex);
+                XMLNode prefix = node.previous_sibling();
+                if (prefix.type() == pugi::node_pcdata && std::string_view(prefix.value()).find_first_not_of(" \t\r\n") == std::string_view::npos)
+                    parent.remove_child(prefix);
+                parent.remove_child(node);
+            }
+            node = next;
+        }
+        if (newIndex < indexMap.size()) appendAndSetAttribute(parent, "count", std::to_string(newIndex));
+        return indexMap;
+    }
+
+    /**
+     * @brief Apply a renumbering to an index attribute, if present. References to indexes outside the map are reset to 0
+     */
+    void renumberStyleAttribute(XMLAttribute attr, std::vector<XLStyleIndex> const & indexMap)
+    {
+        if (attr.empty()) return;
+        XLStyleIndex oldIndex = attr.as_uint(XLInvalidUInt32);
+        attr.set_value(oldIndex < indexMap.size() && indexMap[oldIndex] != XLInvalidStyleIndex ? indexMap[oldIndex] : 0);
+    }
+
+    /**
+     * @brief Flag the index stored in an attribute, if present and within the range of flags
+     */
+    void flagStyleAttribute(XMLAttribute attr, std::vector<bool> & flags)
+    {
+        if (attr.empty()) return;
+        XLStyleIndex index = attr.as_uint(XLInvalidUInt32);
+        if (index < flags.size()) flags[index] = true;
+    }
+
+    /**
+     * @brief Collect all attributes named attributeName in the subtree below node
+     */
+    void collectAttributes(XMLNode const & node, char const * attributeName, std::vector<XMLAttribute> & result)
+    {
+        XMLNode child = node.first_child_of_type(pugi::node_element);
+        while (not child.empty()) {
+            XMLAttribute attr = child.attribute(attributeName);
+            if (not attr.empty()) result.push_back(attr);
+            collectAttributes(child, attributeName, result);
+            child = child.next_sibling_of_type(pugi::node_element);
+        }
+    }
+
+    /**
+     * @brief Classify a built-in number format by its id (ECMA-376 part 1, 18.8.30, plus the locale specific ids used by Excel)
+     * @param numFmtId the number format id
+     * @return the classification, XLNumberFormatType::General for ids that are not built-in
+     */
+    XLNumberFormatType builtinNumberFormatType(uint32_t numFmtId)
+    {
+        if (numFmtId ==  0)                   return XLNumberFormatType::General;
+        if (numFmtId ==  9 || numFmtId == 10) return XLNumberFormatType::Percent;
+        if (numFmtId >= 14 && numFmtId <= 17) return XLNumberFormatType::Date;
+        if (numFmtId >= 18 && numFmtId <= 21) return XLNumberFormatType::Time;
+        if (numFmtId == 22)                   return XLNumberFormatType::DateTime;
+        if (numFmtId >= 27 && numFmtId <= 36) return XLNumberFormatType::Date;        // East Asian date formats
+        if (numFmtId >= 45 && numFmtId <= 47) return XLNumberFormatType::Time;
+        if (numFmtId == 49)                   return XLNumberFormatType::Text;
+        if (numFmtId >= 50 && numFmtId <= 58) return XLNumberFormatType::Date;        // East Asian date formats
+        if (numFmtId == 67 || numFmtId == 68) return XLNumberFormatType::Percent;     // Thai formats
+        if (numFmtId >= 71 && numFmtId <= 74) return XLNumberFormatType::Date;
+        if (numFmtId == 75 || numFmtId == 76) return XLNumberFormatType::Time;
+        if (numFmtId == 77)                   return XLNumberFormatType::DateTime;
+        if (numFmtId >= 78 && numFmtId <= 80) return XLNumberFormatType::Time;
+        if (numFmtId == 81)                   return XLNumberFormatType::Date;
+        if (numFmtId <= 81)                   return XLNumberFormatType::Number;
+        return XLNumberFormatType::General;
+    }
+
+    /**
+     * @brief Classify a custom number format code, based on its first section (the one used for positive numbers)
+     * @param formatCode the format code
+     * @return the classification
+     * @note Quoted literals, escaped characters and [color] / [$-locale] / [condition] tags are ignored, elapsed time tags ([h], [mm], [ss])
+     *       count as time.
+     *       An 'm' is a minute if it follows an hour or precedes a second, otherwise it is a month.
+     */
+    XLNumberFormatType numberFormatTypeFromCode(std::string_view formatCode)
+    {
+        auto startsWith = [&](size_t pos, std::string_view word) {
+            if (formatCode.length() - pos < word.length()) return false;
+            for (size_t i = 0; i < word.length(); ++i)
+                if (std::tolower(static_cast<unsigned char>(formatCode[pos + i])) != word[i]) return false;
+            return true;
+        };
+        auto skipLiteral = [&](size_t pos) {    // return the position of the last character belonging to a literal starting at pos
+            switch (formatCode[pos]) {
+                case '"': { size_t end = formatCode.find('"', pos + 1); return end == std::string_view::npos ? formatCode.length() : end; }
+                case '[': { size_t end = formatCode.find(']', pos + 1); return end == std::string_view::npos ? formatCode.length() : end; }
+                case '\\': [[fallthrough]];
+                case '_':  [[fallthrough]];
+                case '*':  return pos + 1;
+                default:   return pos;
+            }
+        };
+        auto nextDateTimeLetter = [&](size_t pos) {    // the next date/time letter that is not an 'm', or 0
+            for (++pos; pos < formatCode.length() && formatCode[pos] != ';'; ++pos) {
+                if (size_t end = skipLiteral(pos); end != pos) { pos = end; continue; }
+                char c = static_cast<char>(std::tolower(static_cast<unsigned char>(formatCode[pos])));
+                if (c == 'h' || c == 's' || c == 'd' || c == 'y') return c;
+            }
+            return '\0';
+        };
+
+        bool hasDate = false, hasTime = false, hasPercent = false, hasText = false, hasDigit = false;
+        char lastLetter = '\0';
+        for (size_t pos = 0; pos < formatCode.length() && formatCode[pos] != ';'; ++pos) {
+            if (formatCode[pos] == '[') {
+                size_t end = skipLiteral(pos);
+                if (end > pos + 1 && end < formatCode.length()) {    // elapsed time: [h], [mm], [ss] - a tag of a single, repeated letter
+                    char c = static_cast<char>(std::tolower(static_cast<unsigned char>(formatCode[pos + 1])));
+                    bool elapsed = (c == 'h' || c == 'm' || c == 's');
+                    for (size_t i = pos + 2; elapsed && i < end; ++i)
+                        elapsed = std::tolower(static_cast<unsigned char>(formatCode[i])) == c;
+                    if (elapsed) { hasTime = true; lastLetter = c; }
+                }
+                pos = end;
+                continue;
+            }
+            if (size_t end = skipLiteral(pos); end != pos) { pos = end; continue; }
+
+            char c = static_cast<char>(std::tolower(static_cast<unsigned char>(formatCode[pos])));
+            switch (c) {
+                case '%': hasPercent = true; break;
+                case '@': hasText    = true; break;
+                case '0': [[fallthrough]];
+                case '#': [[fallthrough]];
+                case '?': hasDigit   = true; break;
+                case 'g':
+                    if (startsWith(pos, "general")) pos += 6;
+                    break;
+                case 'e':
+                    if (pos + 1 < formatCode.length() && (formatCode[pos + 1] == '+' || formatCode[pos + 1] == '-')) { ++pos; break; } // exponent
+                    [[fallthrough]];
+                case 'y': [[fallthrough]];
+                case 'd': hasDate = true; lastLetter = c; break;
+                case 'h': [[fallthrough]];
+                case 's': hasTime = true; lastLetter = c; break;
+                case 'a':
+                    if      (startsWith(pos, "am/pm")) { hasTime = true; pos += 4; }
+                    else if (startsWith(pos, "a/p"))   { hasTime = true; pos += 2; }
+                    break;
+                case 'm':
+                    if (lastLetter == 'h' || nextDateTimeLetter(pos) == 's') hasTime = true;
+                    else hasDate = true;
+                    while (pos + 1 < formatCode.length() && std::tolower(static_cast<unsigned char>(formatCode[pos + 1])) == 'm') ++pos;
+                    lastLetter = 'm';
+                    break;
+                default: break;
+            }
+        }
+
+        if (hasDate && hasTime) return XLNumberFormatType::DateTime;
+        if (hasDate)            return XLNumberFormatType::Date;
+        if (hasTime)            return XLNumberFormatType::Time;
+        if (hasText)            return XLNumberFormatType::Text;
+        if (hasPercent)         return XLNumberFormatType::Percent;
+        if (hasDigit)           return XLNumberFormatType::Number;
+        return XLNumberFormatType::General;
+    }
+
    /**
      * @brief Format val as a string with decimalPlaces
      * @param val The value to format
@@ -442,10 +747,114 @@ namespace     // anonymous namespace for module local functions
         if (val < min) val = min; else if (val > max) val = max;             // fix rounding errors within tolerance
         return formatDoubleAsString(val, decimalPlaces);
     }
+
+    /**
+     * @brief Estimate the memory held by a findOrCreate hash index
+     * @note each multimap element is counted as a node holding the value, a next pointer and the cached hash
+     */
+    size_t hashIndexSize(XLStyleHashIndex const& index)
+    {
+        return index.buckets.size() * (sizeof(std::pair<const size_t, XLStyleIndex>) + 2 * sizeof(void*))
+               + index.buckets.bucket_count() * sizeof(void*) + heapSize(index.hashes) + heapSize(index.touched) + heapSize(index.stale);
+    }
+
+    /**
+     * @brief Estimate the memory held by the entry objects of a collection: each entry holds its XML node by std::unique_ptr
+     */
+    template<typename Entry>
+    size_t entriesSize(size_t count) { return count * (sizeof(Entry) + sizeof(XMLNode)); }
 }    // anonymous namespace
 
 
 
+/**
+ * @details flag the entry in the caches of its collection, if any
+ */
+void XLStyleEntryOwner::touch() const
+{
+    if (hashIndex)  hashIndex->touch(index);
+    if (tableStale) tableStale->touch(index);
+}
+
+/**
+ * @details flag an indexed entry as potentially modified
+ */
+void XLStyleHashIndex::touch(XLStyleIndex index)
+{
+    if (index < hashes.size() && not touched[ index ]) {
+        touched[ index ] = true;
+        stale.push_back(index);
+    }
+}
+
+/**
+ * @details discard all index data
+ */
+void XLStyleHashIndex::clear()
+{
+    buckets.clear();
+    hashes.clear();
+    touched.clear();
+    stale.clear();
+}
+
+/**
+ * @details flag an entry as potentially modified
+ */
+void XLStyleTouchList::touch(XLStyleIndex index)
+{
+    if (index >= flagged.size()) flagged.resize(index + 1, false);
+    if (not flagged[ index ]) {
+        flagged[ index ] = true;
+        entries.push_back(index);
+    }
+}
+
+/**
+ * @details reset all flags
+ */
+void XLStyleTouchList::clear()
+{
+    for (XLStyleIndex index : entries) flagged[ index ] = false;
+    entries.clear();
+}
+
+/**
+ * @details resize all arrays
+ */
+void XLCellFormatTable::resize(size_t newSize)
+{
+    numberFormatId.resize(newSize, XLInvalidUInt32);
+    fontIndex     .resize(newSize, XLInvalidUInt32);
+    fillIndex     .resize(newSize, XLInvalidUInt32);
+    borderIndex   .resize(newSize, XLInvalidUInt32);
+    xfId          .resize(newSize, XLInvalidUInt32);
+}
+
+/**
+ * @details resize all arrays, dropping the id lookup entries of removed number formats
+ */
+void XLNumberFormatTable::resize(size_t newSize)
+{
+    for (XLStyleIndex index = newSize; index < numberFormatId.size(); ++index) {
+        auto it = indexById.find(numberFormatId[ index ]);
+        if (it != indexById.end() && it->second == index) indexById.erase(it);
+    }
+    numberFormatId  .resize(newSize, XLInvalidUInt32);
+    formatCode      .resize(newSize);
+    numberFormatType.resize(newSize, XLNumberFormatType::General);
+}
+
+/**
+ * @details look up a number format index by numFmtId
+ */
+XLStyleIndex XLNumberFormatTable::indexOf(uint32_t id) const
+{
+    auto it = indexById.find(id);
+    return it != indexById.end() ? it->second : XLInvalidStyleIndex;
+}
+
+
 /**
  * @details Constructor. Initializes an empty XLNumberFormat object
  */
@@ -459,12 +868,16 @@ XLNumberFormat::XLNumberFormat(const XMLNode& node) : m_numberFormatNode(std::ma
 XLNumberFormat::~XLNumberFormat() = default;
 
 XLNumberFormat::XLNumberFormat(const XLNumberFormat& other)
-    : m_numberFormatNode(std::make_unique<XMLNode>(*other.m_numberFormatNode))
+    : m_numberFormatNode(std::make_unique<XMLNode>(*other.m_numberFormatNode)),
+      m_owner(other.m_owner)
 {}
 
 XLNumberFormat& XLNumberFormat::operator=(const XLNumberFormat& other)
 {
-    if (&other != this) *m_numberFormatNode = *other.m_numberFormatNode;
+    if (&other != this) {
+        *m_numberFormatNode = *other.m_numberFormatNode;
+        m_owner = other.m_owner;
+    }
     return *this;
 }
 
@@ -482,9 +895,9 @@ std::string XLNumberFormat::formatCode() const { return m_numberFormatNode->attr
  * @details Setter functions
  */
 bool XLNumberFormat::setNumberFormatId(uint32_t newNumberFormatId)
-    { return appendAndSetAttribute(*m_numberFormatNode, "numFmtId",   std::to_string(newNumberFormatId)).empty() == false; }
+    { m_owner.touch(); return appendAndSetAttribute(*m_numberFormatNode, "numFmtId",   std::to_string(newNumberFormatId)).empty() == false; }
 bool XLNumberFormat::setFormatCode    (std::string newFormatCode)
-    { return appendAndSetAttribute(*m_numberFormatNode, "formatCode", newFormatCode.c_str()            ).empty() == false; }
+    { m_owner.touch(); return appendAndSetAttribute(*m_numberFormatNode, "formatCode", newFormatCode.c_str()            ).empty() == false; }
 
 
 /**
@@ -521,6 +934,7 @@ XLNumberFormats::XLNumberFormats(const XMLNode& numberFormats)
             std::cerr << "WARNING: XLNumberFormats constructor: unknown subnode " << nodeName << std::endl;
         node = node.next_sibling_of_type(pugi::node_element);
     }
+    for (XLStyleIndex index = 0; index < m_numberFormats.size(); ++index) m_numberFormats[ index ].m_owner = XLStyleEntryOwner{ {}, m_tableStale, index };
 }
 
 XLNumberFormats::~XLNumberFormats()
@@ -530,12 +944,16 @@ XLNumberFormats::~XLNumberFormats()
 
 XLNumberFormats::XLNumberFormats(const XLNumberFormats& other)
     : m_numberFormatsNode(std::make_unique<XMLNode>(*other.m_numberFormatsNode)),
-      m_numberFormats(other.m_numberFormats)
-{}
+      m_numberFormats(other.m_numberFormats),
+      m_tableStale(std::make_shared<XLStyleTouchList>(*other.m_tableStale))
+{
+    for (XLStyleIndex index = 0; index < m_numberFormats.size(); ++index) m_numberFormats[ index ].m_owner = XLStyleEntryOwner{ {}, m_tableStale, index };
+}
 
 XLNumberFormats::XLNumberFormats(XLNumberFormats&& other)
     : m_numberFormatsNode(std::move(other.m_numberFormatsNode)),
-      m_numberFormats(std::move(other.m_numberFormats))
+      m_numberFormats(std::move(other.m_numberFormats)),
+      m_tableStale(std::move(other.m_tableStale))
 {}
 
 
@@ -548,6 +966,8 @@ XLNumberFormats& XLNumberFormats::operator=(const XLNumberFormats& other)
         *m_numberFormatsNode = *other.m_numberFormatsNode;
         m_numberFormats.clear();
         m_numberFormats = other.m_numberFormats;
+        m_tableStale = std::make_shared<XLStyleTouchList>(*other.m_tableStale);
+        for (XLStyleIndex index = 0; index < m_numberFormats.size(); ++index) m_numberFormats[ index ].m_owner = XLStyleEntryOwner{ {}, m_tableStale, index };
     }
     return *this;
 }
@@ -574,9 +994,9 @@ XLNumberFormat XLNumberFormats::numberFormatByIndex(XLStyleIndex index) const
  */
 XLNumberFormat XLNumberFormats::numberFormatById(uint32_t numberFormatId) const
 {
-    for (XLNumberFormat fmt : m_numberFormats)
-        if (fmt.numberFormatId() == numberFormatId)
-            return fmt;
+    for (XLStyleIndex index = 0; index < m_numberFormats.size(); ++index) {
+        if (m_numberFormats[index].numberFormatId() == numberFormatId) return m_numberFormats[index];
+    }
     using namespace std::literals::string_literals;
     throw XLException("XLNumberFormats::"s + __func__ + ": numberFormatId "s + std::to_string(numberFormatId) + " not found"s);
 }
@@ -609,7 +1029,7 @@ XLStyleIndex XLNumberFormats::create(XLNumberFormat copyFrom, std::string styleE
         using namespace std::literals::string_literals;
         throw XLException("XLNumberFormats::"s + __func__ + ": failed to append a new numFmt node"s);
     }
-    if (styleEntriesPrefix.length() > 0)    // if a whitespace prefix is configured
+    if (useEntryPrefix(styleEntriesPrefix, lastStyle))    // if a whitespace prefix is configured and matches the layout
         m_numberFormatsNode->insert_child_before(pugi::node_pcdata, newNode).set_value(styleEntriesPrefix.c_str());    // prefix the new node with styleEntriesPrefix
 
     XLNumberFormat newNumberFormat(newNode);
@@ -622,6 +1042,7 @@ XLStyleIndex XLNumberFormats::create(XLNumberFormat copyFrom, std::string styleE
         copyXMLNode(newNode, *copyFrom.m_numberFormatNode); // will use copyFrom as template, does nothing if copyFrom is empty
 
     m_numberFormats.push_back(newNumberFormat);
+    m_numberFormats.back().m_owner = XLStyleEntryOwner{ {}, m_tableStale, index };
     appendAndSetAttribute(*m_numberFormatsNode, "count", std::to_string(m_numberFormats.size())); // update array count in XML
     return index;
 }
@@ -640,12 +1061,16 @@ XLFont::XLFont(const XMLNode& node) : m_fontNode(std::make_unique<XMLNode>(node)
 XLFont::~XLFont() = default;
 
 XLFont::XLFont(const XLFont& other)
-    : m_fontNode(std::make_unique<XMLNode>(*other.m_fontNode))
+    : m_fontNode(std::make_unique<XMLNode>(*other.m_fontNode)),
+      m_owner(other.m_owner)
 {}
 
 XLFont& XLFont::operator=(const XLFont& other)
 {
-    if (&other != this) *m_fontNode = *other.m_fontNode;
+    if (&other != this) {
+        *m_fontNode = *other.m_fontNode;
+        m_owner = other.m_owner;
+    }
     return *this;
 }
 
@@ -655,6 +1080,7 @@ XLFont& XLFont::operator=(const XLFont& other)
  */
 std::string XLFont::fontName() const
 {
+    m_owner.touch();
     XMLAttribute attr = appendAndGetNodeAttribute(*m_fontNode, "name", "val", OpenXLSX::XLDefaultFontName);
     return attr.value();
 }
@@ -664,6 +1090,7 @@ std::string XLFont::fontName() const
  */
 size_t XLFont::fontCharset() const
 {
+    m_owner.touch();
     XMLAttribute attr = appendAndGetNodeAttribute(*m_fontNode, "charset", "val", std::to_string(OpenXLSX::XLDefaultFontCharset));
     return attr.as_uint();
 }
@@ -673,6 +1100,7 @@ size_t XLFont::fontCharset() const
  */
 size_t XLFont::fontFamily() const
 {
+    m_owner.touch();
     XMLAttribute attr = appendAndGetNodeAttribute(*m_fontNode, "family", "val", std::to_string(OpenXLSX::XLDefaultFontFamily));
     return attr.as_uint();
 }
@@ -682,6 +1110,7 @@ size_t XLFont::fontFamily() const
  */
 size_t XLFont::fontSize() const
 {
+    m_owner.touch();
     XMLAttribute attr = appendAndGetNodeAttribute(*m_fontNode, "sz", "val", std::to_string(OpenXLSX::XLDefaultFontSize));
     return attr.as_uint();
 }
@@ -691,6 +1120,7 @@ size_t XLFont::fontSize() const
  */
 XLColor XLFont::fontColor() const
 {
+    m_owner.touch();
     using namespace std::literals::string_literals;
     // XMLAttribute attr = appendAndGetNodeAttribute(*m_fontNode, "color", "theme", OpenXLSX::XLDefaultFontColorTheme);
     // TBD what "theme" is and whether it should be supported at all
@@ -701,38 +1131,38 @@ XLColor XLFont::fontColor() const
 /**
  * @details getter functions: return the font's bold, italic, underline, strikethrough status
  */
-bool                    XLFont::bold()          const { return getBoolAttributeWhenOmittedMeansTrue(*m_fontNode, "b",        "val"); }
-bool                    XLFont::italic()        const { return getBoolAttributeWhenOmittedMeansTrue(*m_fontNode, "i",        "val"); }
-bool                    XLFont::strikethrough() const { return getBoolAttributeWhenOmittedMeansTrue(*m_fontNode, "strike",   "val"); }
-XLUnderlineStyle        XLFont::underline()     const { return XLUnderlineStyleFromString       (appendAndGetNodeAttribute(*m_fontNode, "u",         "val", "none"    ).value()  ); }
-XLFontSchemeStyle       XLFont::scheme()        const { return XLFontSchemeStyleFromString      (appendAndGetNodeAttribute(*m_fontNode, "scheme",    "val", "none"    ).value()  ); }
-XLVerticalAlignRunStyle XLFont::vertAlign()     const { return XLVerticalAlignRunStyleFromString(appendAndGetNodeAttribute(*m_fontNode, "vertAlign", "val", "baseline").value()  ); }
-bool                    XLFont::outline()       const { return getBoolAttributeWhenOmittedMeansTrue(*m_fontNode, "outline",  "val"); }
-bool                    XLFont::shadow()        const { return getBoolAttributeWhenOmittedMeansTrue(*m_fontNode, "shadow",   "val"); }
-bool                    XLFont::condense()      const { return getBoolAttributeWhenOmittedMeansTrue(*m_fontNode, "condense", "val"); }
-bool                    XLFont::extend()        const { return getBoolAttributeWhenOmittedMeansTrue(*m_fontNode, "extend",   "val"); }
+bool                    XLFont::bold()          const { m_owner.touch(); return getBoolAttributeWhenOmittedMeansTrue(*m_fontNode, "b",        "val"); }
+bool                    XLFont::italic()        const { m_owner.touch(); return getBoolAttributeWhenOmittedMeansTrue(*m_fontNode, "i",        "val"); }
+bool                    XLFont::strikethrough() const { m_owner.touch(); return getBoolAttributeWhenOmittedMeansTrue(*m_fontNode, "strike",   "val"); }
+XLUnderlineStyle        XLFont::underline()     const { m_owner.touch(); return XLUnderlineStyleFromString       (appendAndGetNodeAttribute(*m_fontNode, "u",         "val", "none"    ).value()  ); }
+XLFontSchemeStyle       XLFont::scheme()        const { m_owner.touch(); return XLFontSchemeStyleFromString      (appendAndGetNodeAttribute(*m_fontNode, "scheme",    "val", "none"    ).value()  ); }
+XLVerticalAlignRunStyle XLFont::vertAlign()     const { m_owner.touch(); return XLVerticalAlignRunStyleFromString(appendAndGetNodeAttribute(*m_fontNode, "vertAlign", "val", "baseline").value()  ); }
+bool                    XLFont::outline()       const { m_owner.touch(); return getBoolAttributeWhenOmittedMeansTrue(*m_fontNode, "outline",  "val"); }
+bool                    XLFont::shadow()        const { m_owner.touch(); return getBoolAttributeWhenOmittedMeansTrue(*m_fontNode, "shadow",   "val"); }
+bool                    XLFont::condense()      const { m_owner.touch(); return getBoolAttributeWhenOmittedMeansTrue(*m_fontNode, "condense", "val"); }
+bool                    XLFont::extend()        const { m_owner.touch(); return getBoolAttributeWhenOmittedMeansTrue(*m_fontNode, "extend",   "val"); }
 
 /**
  * @details Setter functions
  */
-bool XLFont::setFontName     (std::string newName)    { return appendAndSetNodeAttribute(*m_fontNode, "name",     "val", newName.c_str()                        ).empty() == false; }
-bool XLFont::setFontCharset  (size_t newCharset)      { return appendAndSetNodeAttribute(*m_fontNode, "charset",  "val", std::to_string(newCharset)             ).empty() == false; }
-bool XLFont::setFontFamily   (size_t newFamily)       { return appendAndSetNodeAttribute(*m_fontNode, "family",   "val", std::to_string(newFamily)              ).empty() == false; }
-bool XLFont::setFontSize     (size_t newSize)         { return appendAndSetNodeAttribute(*m_fontNode, "sz",       "val", std::to_string(newSize)                ).empty() == false; }
-bool XLFont::setFontColor    (XLColor newColor)       { return appendAndSetNodeAttribute(*m_fontNode, "color",    "rgb", newColor.hex(), XLRemoveAttributes     ).empty() == false; }
-bool XLFont::setBold         (bool set)               { return appendAndSetNodeAttribute(*m_fontNode, "b",        "val", (set ? "true" : "false")               ).empty() == false; }
-bool XLFont::setItalic       (bool set)               { return appendAndSetNodeAttribute(*m_fontNode, "i",        "val", (set ? "true" : "false")               ).empty() == false; }
-bool XLFont::setStrikethrough(bool set)               { return appendAndSetNodeAttribute(*m_fontNode, "strike",   "val", (set ? "true" : "false")               ).empty() == false; }
+bool XLFont::setFontName     (std::string newName)    { m_owner.touch(); return appendAndSetNodeAttribute(*m_fontNode, "name",     "val", newName.c_str()                        ).empty() == false; }
+bool XLFont::setFontCharset  (size_t newCharset)      { m_owner.touch(); return appendAndSetNodeAttribute(*m_fontNode, "charset",  "val", std::to_string(newCharset)             ).empty() == false; }
+bool XLFont::setFontFamily   (size_t newFamily)       { m_owner.touch(); return appendAndSetNodeAttribute(*m_fontNode, "family",   "val", std::to_string(newFamily)              ).empty() == false; }
+bool XLFont::setFontSize     (size_t newSize)         { m_owner.touch(); return appendAndSetNodeAttribute(*m_fontNode, "sz",       "val", std::to_string(newSize)                ).empty() == false; }
+bool XLFont::setFontColor    (XLColor newColor)       { m_owner.touch(); return appendAndSetNodeAttribute(*m_fontNode, "color",    "rgb", newColor.hex(), XLRemoveAttributes     ).empty() == false; }
+bool XLFont::setBold         (bool set)               { m_owner.touch(); return appendAndSetNodeAttribute(*m_fontNode, "b",        "val", (set ? "true" : "false")               ).empty() == false; }
+bool XLFont::setItalic       (bool set)               { m_owner.touch(); return appendAndSetNodeAttribute(*m_fontNode, "i",        "val", (set ? "true" : "false")               ).empty() == false; }
+bool XLFont::setStrikethrough(bool set)               { m_owner.touch(); return appendAndSetNodeAttribute(*m_fontNode, "strike",   "val", (set ? "true" : "false")               ).empty() == false; }
 bool XLFont::setUnderline    (XLUnderlineStyle style)
-    { return appendAndSetNodeAttribute(*m_fontNode, "u",         "val", XLUnderlineStyleToString       (style       ).c_str()).empty() == false; }
+    { m_owner.touch(); return appendAndSetNodeAttribute(*m_fontNode, "u",         "val", XLUnderlineStyleToString       (style       ).c_str()).empty() == false; }
 bool XLFont::setScheme       (XLFontSchemeStyle newScheme)
-    { return appendAndSetNodeAttribute(*m_fontNode, "scheme",    "val", XLFontSchemeStyleToString      (newScheme   ).c_str()).empty() == false; }
+    { m_owner.touch(); return appendAndSetNodeAttribute(*m_fontNode, "scheme",    "val", XLFontSchemeStyleToString      (newScheme   ).c_str()).empty() == false; }
 bool XLFont::setVertAlign    (XLVerticalAlignRunStyle newVertAlign)
-    { return appendAndSetNodeAttribute(*m_fontNode, "vertAlign", "val", XLVerticalAlignRunStyleToString(newVertAlign).c_str()).empty() == false; }
-bool XLFont::setOutline (bool set)                    { return appendAndSetNodeAttribute(*m_fontNode, "outline",  "val", (set ? "true" : "false")               ).empty() == false; }
-bool XLFont::setShadow  (bool set)                    { return appendAndSetNodeAttribute(*m_fontNode, "shadow",   "val", (set ? "true" : "false")               ).empty() == false; }
-bool XLFont::setCondense(bool set)                    { return appendAndSetNodeAttribute(*m_fontNode, "condense", "val", (set ? "true" : "false")               ).empty() == false; }
-bool XLFont::setExtend  (bool set)                    { return appendAndSetNodeAttribute(*m_fontNode, "extend",   "val", (set ? "true" : "false")               ).empty() == false; }
+    { m_owner.touch(); return appendAndSetNodeAttribute(*m_fontNode, "vertAlign", "val", XLVerticalAlignRunStyleToString(newVertAlign).c_str()).empty() == false; }
+bool XLFont::setOutline (bool set)                    { m_owner.touch(); return appendAndSetNodeAttribute(*m_fontNode, "outline",  "val", (set ? "true" : "false")               ).empty() == false; }
+bool XLFont::setShadow  (bool set)                    { m_owner.touch(); return appendAndSetNodeAttribute(*m_fontNode, "shadow",   "val", (set ? "true" : "false")               ).empty() == false; }
+bool XLFont::setCondense(bool set)                    { m_owner.touch(); return appendAndSetNodeAttribute(*m_fontNode, "condense", "val", (set ? "true" : "false")               ).empty() == false; }
+bool XLFont::setExtend  (bool set)                    { m_owner.touch(); return appendAndSetNodeAttribute(*m_fontNode, "extend",   "val", (set ? "true" : "false")               ).empty() == false; }
 
 
 /**
@@ -782,6 +1212,7 @@ XLFonts::XLFonts(const XMLNode& fonts)
             std::cerr << "WARNING: XLFonts constructor: unknown subnode " << nodeName << std::endl;
         node = node.next_sibling_of_type(pugi::node_element);
     }
+    for (XLStyleIndex index = 0; index < m_fonts.size(); ++index) m_fonts[ index ].m_owner = XLStyleEntryOwner{ m_hashIndex, {}, index };
 }
 
 XLFonts::~XLFonts()
@@ -791,12 +1222,16 @@ XLFonts::~XLFonts()
 
 XLFonts::XLFonts(const XLFonts& other)
     : m_fontsNode(std::make_unique<XMLNode>(*other.m_fontsNode)),
-      m_fonts(other.m_fonts)
-{}
+      m_fonts(other.m_fonts),
+      m_hashIndex(std::make_shared<XLStyleHashIndex>(*other.m_hashIndex))
+{
+    for (XLStyleIndex index = 0; index < m_fonts.size(); ++index) m_fonts[ index ].m_owner = XLStyleEntryOwner{ m_hashIndex, {}, index };
+}
 
 XLFonts::XLFonts(XLFonts&& other)
     : m_fontsNode(std::move(other.m_fontsNode)),
-      m_fonts(std::move(other.m_fonts))
+      m_fonts(std::move(other.m_fonts)),
+      m_hashIndex(std::move(other.m_hashIndex))
 {}
 
 
@@ -809,6 +1244,8 @@ XLFonts& XLFonts::operator=(const XLFonts& other)
         *m_fontsNode = *other.m_fontsNode;
         m_fonts.clear();
         m_fonts = other.m_fonts;
+        m_hashIndex = std::make_shared<XLStyleHashIndex>(*other.m_hashIndex);
+        for (XLStyleIndex index = 0; index < m_fonts.size(); ++index) m_fonts[ index ].m_owner = XLStyleEntryOwner{ m_hashIndex, {}, index };
     }
     return *this;
 }
@@ -846,7 +1283,7 @@ XLStyleIndex XLFonts::create(XLFont copyFrom, std::string styleEntriesPrefix)
         using namespace std::literals::string_literals;
         throw XLException("XLFonts::"s + __func__ + ": failed to append a new fonts node"s);
     }
-    if (styleEntriesPrefix.length() > 0)    // if a whitespace prefix is configured
+    if (useEntryPrefix(styleEntriesPrefix, lastStyle))    // if a whitespace prefix is configured and matches the layout
         m_fontsNode->insert_child_before(pugi::node_pcdata, newNode).set_value(styleEntriesPrefix.c_str());    // prefix the new node with styleEntriesPrefix
 
     XLFont newFont(newNode);
@@ -860,10 +1297,46 @@ XLStyleIndex XLFonts::create(XLFont copyFrom, std::string styleEntriesPrefix)
         copyXMLNode(newNode, *copyFrom.m_fontNode);    // will use copyFrom as template, does nothing if copyFrom is empty
 
     m_fonts.push_back(newFont);
+    m_fonts.back().m_owner = XLStyleEntryOwner{ m_hashIndex, {}, index };
     appendAndSetAttribute(*m_fontsNode, "count", std::to_string(m_fonts.size())); // update array count in XML
     return index;
 }
 
+/**
+ * @details look up an entry with content identical to copyFrom via the content hash index, and create one if none exists
+ */
+XLStyleIndex XLFonts::findOrCreate(XLFont copyFrom, std::string styleEntriesPrefix)
+{
+    if (copyFrom.m_fontNode->empty())    // the default font content only exists once created
+        return findOrCreate(copyFrom, [](XLFont &) {}, styleEntriesPrefix);
+
+    auto entryNode = [this](XLStyleIndex index) { return *m_fonts[ index ].m_fontNode; };
+    updateStyleHashIndex(*m_hashIndex, m_fonts.size(), entryNode);
+    XLStyleIndex index = findInStyleHashIndex(*m_hashIndex, *copyFrom.m_fontNode, entryNode);
+    if (index != XLInvalidStyleIndex) return index;
+    return create(copyFrom, styleEntriesPrefix);
+}
+
+/**
+ * @details create a new entry, apply modify, and drop the new entry again if the content hash index has an identical one
+ */
+XLStyleIndex XLFonts::findOrCreate(XLFont copyFrom, std::function<void(XLFont&)> const& modify, std::string styleEntriesPrefix)
+{
+    auto entryNode = [this](XLStyleIndex index) { return *m_fonts[ index ].m_fontNode; };
+    updateStyleHashIndex(*m_hashIndex, m_fonts.size(), entryNode); // index all existing entries before the new one is appended
+
+    XLStyleIndex index = create(copyFrom, styleEntriesPrefix);
+    XLFont newEntry = m_fonts[ index ];
+    if (modify) modify(newEntry);
+
+    XLStyleIndex existing = findInStyleHashIndex(*m_hashIndex, *newEntry.m_fontNode, entryNode);
+    if (existing == XLInvalidStyleIndex) return index;    // the new entry will be indexed on next use
+
+    m_fonts.pop_back();
+    removeLastStyleEntry(*m_fontsNode, *newEntry.m_fontNode, styleEntriesPrefix, m_fonts.size());
+    return existing;
+}
+
 
 // ===== XLDataBarColor, used by XLFills gradientFill and by XLLine (to be implemented)
 
@@ -881,7 +1354,8 @@ XLDataBarColor::XLDataBarColor(const XMLNode& node) : m_colorNode(std::make_uniq
  * @details Copy constructor - initializes the member variables from other
  */
 XLDataBarColor::XLDataBarColor(const XLDataBarColor& other)
-    : m_colorNode(std::make_unique<XMLNode>(*other.m_colorNode))
+    : m_colorNode(std::make_unique<XMLNode>(*other.m_colorNode)),
+      m_owner(other.m_owner)
 {}
 
 /**
@@ -889,7 +1363,10 @@ XLDataBarColor::XLDataBarColor(const XLDataBarColor& other)
  */
 XLDataBarColor& XLDataBarColor::operator=(const XLDataBarColor& other)
 {
-    if (&other != this) *m_colorNode = *other.m_colorNode;
+    if (&other != this) {
+        *m_colorNode = *other.m_colorNode;
+        m_owner = other.m_owner;
+    }
     return *this;
 }
 
@@ -904,9 +1381,10 @@ uint32_t XLDataBarColor::theme()     const { return         m_colorNode->attribu
 /**
  * @details Setter functions
  */
-bool XLDataBarColor::setRgb (XLColor newColor)     { return appendAndSetAttribute(*m_colorNode, "rgb",       newColor.hex()               ).empty() == false; }
+bool XLDataBarColor::setRgb (XLColor newColor)     { m_owner.touch(); return appendAndSetAttribute(*m_colorNode, "rgb",       newColor.hex()               ).empty() == false; }
 bool XLDataBarColor::setTint(double newTint)
 {
+    m_owner.touch();
     std::string tintString = "";
     if (newTint != 0.0) {
         tintString = checkAndFormatDoubleAsString(newTint, -1.0, +1.0, 0.01);
@@ -919,9 +1397,10 @@ bool XLDataBarColor::setTint(double newTint)
 
     return (appendAndSetAttribute(*m_colorNode, "tint", tintString).empty() == false);    // else: set tint attribute
 }
-bool XLDataBarColor::setAutomatic(bool set)        { return appendAndSetAttribute(*m_colorNode, "auto",      (set ? "true" : "false")     ).empty() == false; }
-bool XLDataBarColor::setIndexed(uint32_t newIndex) { return appendAndSetAttribute(*m_colorNode, "indexed",   std::to_string(newIndex)     ).empty() == false; }
+bool XLDataBarColor::setAutomatic(bool set)        { m_owner.touch(); return appendAndSetAttribute(*m_colorNode, "auto",      (set ? "true" : "false")     ).empty() == false; }
+bool XLDataBarColor::setIndexed(uint32_t newIndex) { m_owner.touch(); return appendAndSetAttribute(*m_colorNode, "indexed",   std::to_string(newIndex)     ).empty() == false; }
 bool XLDataBarColor::setTheme(uint32_t newTheme)   {
+    m_owner.touch();
     if( newTheme == XLDeleteProperty ) return m_colorNode->remove_attribute("theme");
     return appendAndSetAttribute(*m_colorNode, "theme",     std::to_string(newTheme)     ).empty() == false;
 }
@@ -955,7 +1434,8 @@ XLGradientStop::XLGradientStop(const XMLNode& node) : m_stopNode(std::make_uniqu
  * @details Copy constructor - initializes the member variables from other
  */
 XLGradientStop::XLGradientStop(const XLGradientStop& other)
-    : m_stopNode(std::make_unique<XMLNode>(*other.m_stopNode))
+    : m_stopNode(std::make_unique<XMLNode>(*other.m_stopNode)),
+      m_owner(other.m_owner)
 {}
 
 /**
@@ -963,7 +1443,10 @@ XLGradientStop::XLGradientStop(const XLGradientStop& other)
  */
 XLGradientStop& XLGradientStop::operator=(const XLGradientStop& other)
 {
-    if (&other != this) *m_stopNode = *other.m_stopNode;
+    if (&other != this) {
+        *m_stopNode = *other.m_stopNode;
+        m_owner = other.m_owner;
+    }
     return *this;
 }
 
@@ -972,9 +1455,12 @@ XLGradientStop& XLGradientStop::operator=(const XLGradientStop& other)
  */
 XLDataBarColor XLGradientStop::color() const
 {
+    m_owner.touch();
     XMLNode color = appendAndGetNode(*m_stopNode, "color");
     if (color.empty()) return XLDataBarColor{};
-    return XLDataBarColor(color);
+    XLDataBarColor result(color);
+    result.m_owner = m_owner;
+    return result;
 }
 double XLGradientStop::position() const
 {
@@ -985,7 +1471,7 @@ double XLGradientStop::position() const
 /**
  * @details Setter functions
  */
-bool XLGradientStop::setPosition(double newPosition) { return appendAndSetAttribute(*m_stopNode, "position", formatDoubleAsString(newPosition)).empty() == false; }
+bool XLGradientStop::setPosition(double newPosition) { m_owner.touch(); return appendAndSetAttribute(*m_stopNode, "position", formatDoubleAsString(newPosition)).empty() == false; }
 
 
 /**
@@ -1031,12 +1517,14 @@ XLGradientStops::~XLGradientStops()
 
 XLGradientStops::XLGradientStops(const XLGradientStops& other)
     : m_gradientNode(std::make_unique<XMLNode>(*other.m_gradientNode)),
-      m_gradientStops(other.m_gradientStops)
+      m_gradientStops(other.m_gradientStops),
+      m_owner(other.m_owner)
 {}
 
 XLGradientStops::XLGradientStops(XLGradientStops&& other)
     : m_gradientNode(std::move(other.m_gradientNode)),
-      m_gradientStops(std::move(other.m_gradientStops))
+      m_gradientStops(std::move(other.m_gradientStops)),
+      m_owner(std::move(other.m_owner))
 {}
 
 
@@ -1049,6 +1537,7 @@ XLGradientStops& XLGradientStops::operator=(const XLGradientStops& other)
         *m_gradientNode = *other.m_gradientNode;
         m_gradientStops.clear();
         m_gradientStops = other.m_gradientStops;
+        m_owner = other.m_owner;
     }
     return *this;
 }
@@ -1086,7 +1575,7 @@ XLStyleIndex XLGradientStops::create(XLGradientStop copyFrom, std::string styleE
         using namespace std::literals::string_literals;
         throw XLException("XLGradientStops::"s + __func__ + ": failed to append a new stop node"s);
     }
-    if (styleEntriesPrefix.length() > 0)    // if a whitespace prefix is configured
+    if (useEntryPrefix(styleEntriesPrefix, lastStyle))    // if a whitespace prefix is configured and matches the layout
         m_gradientNode->insert_child_before(pugi::node_pcdata, newNode).set_value(styleEntriesPrefix.c_str());    // prefix the new node with styleEntriesPrefix
 
     XLGradientStop newStop(newNode);
@@ -1100,10 +1589,21 @@ XLStyleIndex XLGradientStops::create(XLGradientStop copyFrom, std::string styleE
         copyXMLNode(newNode, *copyFrom.m_stopNode);    // will use copyFrom as template, does nothing if copyFrom is empty
 
     m_gradientStops.push_back(newStop);
+    m_gradientStops.back().m_owner = m_owner;
     appendAndSetAttribute(*m_gradientNode, "count", std::to_string(m_gradientStops.size())); // update array count in XML
+    m_owner.touch();
     return index;
 }
 
+/**
+ * @details set the owner of the gradient fill and of all its stops
+ */
+void XLGradientStops::setOwner(const XLStyleEntryOwner& owner)
+{
+    m_owner = owner;
+    for (XLGradientStop& stop : m_gradientStops) stop.m_owner = owner;
+}
+
 std::string XLGradientStops::summary() const
 {
     std::string result{};
@@ -1126,12 +1626,16 @@ XLFill::XLFill(const XMLNode& node) : m_fillNode(std::make_unique<XMLNode>(node)
 XLFill::~XLFill() = default;
 
 XLFill::XLFill(const XLFill& other)
-    : m_fillNode(std::make_unique<XMLNode>(*other.m_fillNode))
+    : m_fillNode(std::make_unique<XMLNode>(*other.m_fillNode)),
+      m_owner(other.m_owner)
 {}
 
 XLFill& XLFill::operator=(const XLFill& other)
 {
-    if (&other != this) *m_fillNode = *other.m_fillNode;
+    if (&other != this) {
+        *m_fillNode = *other.m_fillNode;
+        m_owner = other.m_owner;
+    }
     return *this;
 }
 
@@ -1146,6 +1650,7 @@ XLFillType XLFill::fillType() const { return XLFillTypeFromString(m_fillNode->fi
  */
 bool XLFill::setFillType(XLFillType newFillType, bool force)
 {
+    m_owner.touch();
     XLFillType ft = fillType(); // determine once, use twice
 
     // ===== If desired filltype is already set
@@ -1179,6 +1684,7 @@ void XLFill::throwOnFillType(XLFillType typeToThrowOn, const char *functionName)
  */
 XMLNode XLFill::getValidFillDescription(XLFillType fillTypeIfEmpty, const char *functionName)
 {
+    m_owner.touch();
     XLFillType throwOnThis = XLFillTypeInvalid;
     switch (fillTypeIfEmpty) {
         case XLGradientFill: throwOnThis = XLPatternFill; break;     // throw on non-matching fill type
@@ -1202,7 +1708,12 @@ double          XLFill::left()         { return                          getVali
 double          XLFill::right()        { return                          getValidFillDescription(XLGradientFill, __func__).attribute("right" ).as_double(0) ; }
 double          XLFill::top()          { return                          getValidFillDescription(XLGradientFill, __func__).attribute("top"   ).as_double(0) ; }
 double          XLFill::bottom()       { return                          getValidFillDescription(XLGradientFill, __func__).attribute("bottom").as_double(0) ; }
-XLGradientStops XLFill::stops()        { return XLGradientStops(         getValidFillDescription(XLGradientFill, __func__)                                 ); }
+XLGradientStops XLFill::stops()
+{
+    XLGradientStops result(getValidFillDescription(XLGradientFill, __func__));
+    result.setOwner(m_owner);
+    return result;
+}
 
 /**
  * @details Getter functions for patternFill
@@ -1235,11 +1746,13 @@ XLColor XLFill::backgroundColor()
  */
 bool XLFill::setGradientType(XLGradientType newType)
 {
+    m_owner.touch();
     XMLNode fillDescription = getValidFillDescription(XLGradientFill, __func__);
     return appendAndSetAttribute(fillDescription, "type", XLGradientTypeToString(newType)).empty() == false;
 }
 bool XLFill::setDegree(double newDegree)
 {
+    m_owner.touch();
     std::string degreeString = checkAndFormatDoubleAsString(newDegree, 0.0, 360.0, 0.01);
     if (degreeString.length() == 0) {
         using namespace std::literals::string_literals;
@@ -1250,21 +1763,25 @@ bool XLFill::setDegree(double newDegree)
 }
 bool XLFill::setLeft(double newLeft)
 {
+    m_owner.touch();
     XMLNode fillDescription = getValidFillDescription(XLGradientFill, __func__);
     return appendAndSetAttribute(fillDescription, "left",   formatDoubleAsString(newLeft  ).c_str()).empty() == false;
 }
 bool XLFill::setRight(double newRight)
 {
+    m_owner.touch();
     XMLNode fillDescription = getValidFillDescription(XLGradientFill, __func__);
     return appendAndSetAttribute(fillDescription, "right",  formatDoubleAsString(newRight ).c_str()).empty() == false;
 }
 bool XLFill::setTop(double newTop)
 {
+    m_owner.touch();
     XMLNode fillDescription = getValidFillDescription(XLGradientFill, __func__);
     return appendAndSetAttribute(fillDescription, "top",    formatDoubleAsString(newTop   ).c_str()).empty() == false;
 }
 bool XLFill::setBottom(double newBottom)
 {
+    m_owner.touch();
     XMLNode fillDescription = getValidFillDescription(XLGradientFill, __func__);
     return appendAndSetAttribute(fillDescription, "bottom", formatDoubleAsString(newBottom).c_str()).empty() == false;
 }
@@ -1274,18 +1791,21 @@ bool XLFill::setBottom(double newBottom)
  */
 bool XLFill::setPatternType(XLPatternType newFillPattern)
 {
+    m_owner.touch();
     XMLNode fillDescription = getValidFillDescription(XLPatternFill, __func__);
     if (fillDescription.empty()) return false; // if no description could be fetched: fail
     return appendAndSetAttribute(fillDescription, "patternType", XLPatternTypeToString(newFillPattern)).empty() == false;
 }
 bool XLFill::setColor(XLColor newColor)
 {
+    m_owner.touch();
     XMLNode fillDescription = getValidFillDescription(XLPatternFill, __func__);
     if (fillDescription.empty()) return false; // if no description could be fetched: fail
     return appendAndSetNodeAttribute(fillDescription, "fgColor", "rgb", newColor.hex(), XLRemoveAttributes).empty() == false;
 }
 bool XLFill::setBackgroundColor(XLColor newBgColor)
 {
+    m_owner.touch();
     XMLNode fillDescription = getValidFillDescription(XLPatternFill, __func__);
     if (fillDescription.empty()) return false; // if no description could be fetched: fail
     return appendAndSetNodeAttribute(fillDescription, "bgColor", "rgb", newBgColor.hex(), XLRemoveAttributes).empty() == false;
@@ -1341,6 +1861,7 @@ XLFills::XLFills(const XMLNode& fills)
             std::cerr << "WARNING: XLFills constructor: unknown subnode " << nodeName << std::endl;
         node = node.next_sibling_of_type(pugi::node_element);
     }
+    for (XLStyleIndex index = 0; index < m_fills.size(); ++index) m_fills[ index ].m_owner = XLStyleEntryOwner{ m_hashIndex, {}, index };
 }
 
 XLFills::~XLFills()
@@ -1350,12 +1871,16 @@ XLFills::~XLFills()
 
 XLFills::XLFills(const XLFills& other)
     : m_fillsNode(std::make_unique<XMLNode>(*other.m_fillsNode)),
-      m_fills(other.m_fills)
-{}
+      m_fills(other.m_fills),
+      m_hashIndex(std::make_shared<XLStyleHashIndex>(*other.m_hashIndex))
+{
+    for (XLStyleIndex index = 0; index < m_fills.size(); ++index) m_fills[ index ].m_owner = XLStyleEntryOwner{ m_hashIndex, {}, index };
+}
 
 XLFills::XLFills(XLFills&& other)
     : m_fillsNode(std::move(other.m_fillsNode)),
-      m_fills(std::move(other.m_fills))
+      m_fills(std::move(other.m_fills)),
+      m_hashIndex(std::move(other.m_hashIndex))
 {}
 
 
@@ -1368,6 +1893,8 @@ XLFills& XLFills::operator=(const XLFills& other)
         *m_fillsNode = *other.m_fillsNode;
         m_fills.clear();
         m_fills = other.m_fills;
+        m_hashIndex = std::make_shared<XLStyleHashIndex>(*other.m_hashIndex);
+        for (XLStyleIndex index = 0; index < m_fills.size(); ++index) m_fills[ index ].m_owner = XLStyleEntryOwner{ m_hashIndex, {}, index };
     }
     return *this;
 }
@@ -1405,7 +1932,7 @@ XLStyleIndex XLFills::create(XLFill copyFrom, std::string styleEntriesPrefix)
         using namespace std::literals::string_literals;
         throw XLException("XLFills::"s + __func__ + ": failed to append a new fill node"s);
     }
-    if (styleEntriesPrefix.length() > 0)    // if a whitespace prefix is configured
+    if (useEntryPrefix(styleEntriesPrefix, lastStyle))    // if a whitespace prefix is configured and matches the layout
         m_fillsNode->insert_child_before(pugi::node_pcdata, newNode).set_value(styleEntriesPrefix.c_str());    // prefix the new node with styleEntriesPrefix
 
     XLFill newFill(newNode);
@@ -1419,10 +1946,46 @@ XLStyleIndex XLFills::create(XLFill copyFrom, std::string styleEntriesPrefix)
         copyXMLNode(newNode, *copyFrom.m_fillNode);    // will use copyFrom as template, does nothing if copyFrom is empty
 
     m_fills.push_back(newFill);
+    m_fills.back().m_owner = XLStyleEntryOwner{ m_hashIndex, {}, index };
     appendAndSetAttribute(*m_fillsNode, "count", std::to_string(m_fills.size())); // update array count in XML
     return index;
 }
 
+/**
+ * @details look up an entry with content identical to copyFrom via the content hash index, and create one if none exists
+ */
+XLStyleIndex XLFills::findOrCreate(XLFill copyFrom, std::string styleEntriesPrefix)
+{
+    if (copyFrom.m_fillNode->empty())    // the default fill content only exists once created
+        return findOrCreate(copyFrom, [](XLFill &) {}, styleEntriesPrefix);
+
+    auto entryNode = [this](XLStyleIndex index) { return *m_fills[ index ].m_fillNode; };
+    updateStyleHashIndex(*m_hashIndex, m_fills.size(), entryNode);
+    XLStyleIndex index = findInStyleHashIndex(*m_hashIndex, *copyFrom.m_fillNode, entryNode);
+    if (index != XLInvalidStyleIndex) return index;
+    return create(copyFrom, styleEntriesPrefix);
+}
+
+/**
+ * @details create a new entry, apply modify, and drop the new entry again if the content hash index has an identical one
+ */
+XLStyleIndex XLFills::findOrCreate(XLFill copyFrom, std::function<void(XLFill&)> const& modify, std::string styleEntriesPrefix)
+{
+    auto entryNode = [this](XLStyleIndex index) { return *m_fills[ index ].m_fillNode; };
+    updateStyleHashIndex(*m_hashIndex, m_fills.size(), entryNode); // index all existing entries before the new one is appended
+
+    XLStyleIndex index = create(copyFrom, styleEntriesPrefix);
+    XLFill newEntry = m_fills[ index ];
+    if (modify) modify(newEntry);
+
+    XLStyleIndex existing = findInStyleHashIndex(*m_hashIndex, *newEntry.m_fillNode, entryNode);
+    if (existing == XLInvalidStyleIndex) return index;    // the new entry will be indexed on next use
+
+    m_fills.pop_back();
+    removeLastStyleEntry(*m_fillsNode, *newEntry.m_fillNode, styleEntriesPrefix, m_fills.size());
+    return existing;
+}
+
 
 /**
  * @details Constructor. Initializes an empty XLLine object
@@ -1437,12 +2000,16 @@ XLLine::XLLine(const XMLNode& node) : m_lineNode(std::make_unique<XMLNode>(node)
 XLLine::~XLLine() = default;
 
 XLLine::XLLine(const XLLine& other)
-    : m_lineNode(std::make_unique<XMLNode>(*other.m_lineNode))
+    : m_lineNode(std::make_unique<XMLNode>(*other.m_lineNode)),
+      m_owner(other.m_owner)
 {}
 
 XLLine& XLLine::operator=(const XLLine& other)
 {
-    if (&other != this) *m_lineNode = *other.m_lineNode;
+    if (&other != this) {
+        *m_lineNode = *other.m_lineNode;
+        m_owner = other.m_owner;
+    }
     return *this;
 }
 
@@ -1452,6 +2019,7 @@ XLLine& XLLine::operator=(const XLLine& other)
 XLLineStyle XLLine::style() const
 {
     if (m_lineNode->empty()) return XLLineStyleNone;
+    m_owner.touch();
     XMLAttribute attr = appendAndGetAttribute(*m_lineNode, "style", OpenXLSX::XLDefaultLineStyle);
     return XLLineStyleFromString(attr.value());
 }
@@ -1466,9 +2034,12 @@ XLLine::operator bool() const { return (style() != XLLineStyleNone); }
  */
 XLDataBarColor XLLine::color() const
 {
+    m_owner.touch();
     XMLNode color = appendAndGetNode(*m_lineNode, "color");
     if (color.empty()) return XLDataBarColor{};
-    return XLDataBarColor(color);
+    XLDataBarColor result(color);
+    result.m_owner = m_owner;
+    return result;
 }
 // XLColor XLLine::color() const
 // {
@@ -1521,12 +2092,16 @@ XLBorder::XLBorder(const XMLNode& node) : m_borderNode(std::make_unique<XMLNode>
 XLBorder::~XLBorder() = default;
 
 XLBorder::XLBorder(const XLBorder& other)
-    : m_borderNode(std::make_unique<XMLNode>(*other.m_borderNode))
+    : m_borderNode(std::make_unique<XMLNode>(*other.m_borderNode)),
+      m_owner(other.m_owner)
 {}
 
 XLBorder& XLBorder::operator=(const XLBorder& other)
 {
-    if (&other != this) *m_borderNode = *other.m_borderNode;
+    if (&other != this) {
+        *m_borderNode = *other.m_borderNode;
+        m_owner = other.m_owner;
+    }
     return *this;
 }
 
@@ -1548,22 +2123,23 @@ bool XLBorder::outline() const { return m_borderNode->attribute("outline").as_bo
 /**
  * @details fetch lines
  */
-XLLine XLBorder::left()       const { return XLLine(m_borderNode->child("left")      ); }
-XLLine XLBorder::right()      const { return XLLine(m_borderNode->child("right")     ); }
-XLLine XLBorder::top()        const { return XLLine(m_borderNode->child("top")       ); }
-XLLine XLBorder::bottom()     const { return XLLine(m_borderNode->child("bottom")    ); }
-XLLine XLBorder::diagonal()   const { return XLLine(m_borderNode->child("diagonal")  ); }
-XLLine XLBorder::vertical()   const { return XLLine(m_borderNode->child("vertical")  ); }
-XLLine XLBorder::horizontal() const { return XLLine(m_borderNode->child("horizontal")); }
+XLLine XLBorder::left()       const { XLLine line(m_borderNode->child("left")      ); line.m_owner = m_owner; return line; }
+XLLine XLBorder::right()      const { XLLine line(m_borderNode->child("right")     ); line.m_owner = m_owner; return line; }
+XLLine XLBorder::top()        const { XLLine line(m_borderNode->child("top")       ); line.m_owner = m_owner; return line; }
+XLLine XLBorder::bottom()     const { XLLine line(m_borderNode->child("bottom")    ); line.m_owner = m_owner; return line; }
+XLLine XLBorder::diagonal()   const { XLLine line(m_borderNode->child("diagonal")  ); line.m_owner = m_owner; return line; }
+XLLine XLBorder::vertical()   const { XLLine line(m_borderNode->child("vertical")  ); line.m_owner = m_owner; return line; }
+XLLine XLBorder::horizontal() const { XLLine line(m_borderNode->child("horizontal")); line.m_owner = m_owner; return line; }
 
 /**
  * @details Setter functions
  */
-bool XLBorder::setDiagonalUp  (bool set) { return appendAndSetAttribute(*m_borderNode, "diagonalUp",   (set ? "true" : "false")).empty() == false; }
-bool XLBorder::setDiagonalDown(bool set) { return appendAndSetAttribute(*m_borderNode, "diagonalDown", (set ? "true" : "false")).empty() == false; }
-bool XLBorder::setOutline     (bool set) { return appendAndSetAttribute(*m_borderNode, "outline",      (set ? "true" : "false")).empty() == false; }
+bool XLBorder::setDiagonalUp  (bool set) { m_owner.touch(); return appendAndSetAttribute(*m_borderNode, "diagonalUp",   (set ? "true" : "false")).empty() == false; }
+bool XLBorder::setDiagonalDown(bool set) { m_owner.touch(); return appendAndSetAttribute(*m_borderNode, "diagonalDown", (set ? "true" : "false")).empty() == false; }
+bool XLBorder::setOutline     (bool set) { m_owner.touch(); return appendAndSetAttribute(*m_borderNode, "outline",      (set ? "true" : "false")).empty() == false; }
 bool XLBorder::setLine(XLLineType lineType, XLLineStyle lineStyle, XLColor lineColor, double lineTint)
 {
+    m_owner.touch();
     XMLNode lineNode = appendAndGetNode(*m_borderNode, XLLineTypeToString(lineType), m_nodeOrder); // generate line node if not present
     // 2024-12-19: non-existing lines are added using an ordered insert to address issue #304
     bool success = (lineNode.empty() == false);
@@ -1576,13 +2152,13 @@ bool XLBorder::setLine(XLLineType lineType, XLLineStyle lineStyle, XLColor lineC
     if (success) success = colorObject.setTint(lineTint);
     return success;
 }
-bool XLBorder::setLeft      (XLLineStyle lineStyle, XLColor lineColor, double lineTint) { return setLine(XLLineLeft,       lineStyle, lineColor, lineTint); }
-bool XLBorder::setRight     (XLLineStyle lineStyle, XLColor lineColor, double lineTint) { return setLine(XLLineRight,      lineStyle, lineColor, lineTint); }
-bool XLBorder::setTop       (XLLineStyle lineStyle, XLColor lineColor, double lineTint) { return setLine(XLLineTop,        lineStyle, lineColor, lineTint); }
-bool XLBorder::setBottom    (XLLineStyle lineStyle, XLColor lineColor, double lineTint) { return setLine(XLLineBottom,     lineStyle, lineColor, lineTint); }
-bool XLBorder::setDiagonal  (XLLineStyle lineStyle, XLColor lineColor, double lineTint) { return setLine(XLLineDiagonal,   lineStyle, lineColor, lineTint); }
-bool XLBorder::setVertical  (XLLineStyle lineStyle, XLColor lineColor, double lineTint) { return setLine(XLLineVertical,   lineStyle, lineColor, lineTint); }
-bool XLBorder::setHorizontal(XLLineStyle lineStyle, XLColor lineColor, double lineTint) { return setLine(XLLineHorizontal, lineStyle, lineColor, lineTint); }
+bool XLBorder::setLeft      (XLLineStyle lineStyle, XLColor lineColor, double lineTint) { m_owner.touch(); return setLine(XLLineLeft,       lineStyle, lineColor, lineTint); }
+bool XLBorder::setRight     (XLLineStyle lineStyle, XLColor lineColor, double lineTint) { m_owner.touch(); return setLine(XLLineRight,      lineStyle, lineColor, lineTint); }
+bool XLBorder::setTop       (XLLineStyle lineStyle, XLColor lineColor, double lineTint) { m_owner.touch(); return setLine(XLLineTop,        lineStyle, lineColor, lineTint); }
+bool XLBorder::setBottom    (XLLineStyle lineStyle, XLColor lineColor, double lineTint) { m_owner.touch(); return setLine(XLLineBottom,     lineStyle, lineColor, lineTint); }
+bool XLBorder::setDiagonal  (XLLineStyle lineStyle, XLColor lineColor, double lineTint) { m_owner.touch(); return setLine(XLLineDiagonal,   lineStyle, lineColor, lineTint); }
+bool XLBorder::setVertical  (XLLineStyle lineStyle, XLColor lineColor, double lineTint) { m_owner.touch(); return setLine(XLLineVertical,   lineStyle, lineColor, lineTint); }
+bool XLBorder::setHorizontal(XLLineStyle lineStyle, XLColor lineColor, double lineTint) { m_owner.touch(); return setLine(XLLineHorizontal, lineStyle, lineColor, lineTint); }
 
 
 /**
@@ -1627,6 +2203,7 @@ XLBorders::XLBorders(const XMLNode& borders)
             std::cerr << "WARNING: XLBorders constructor: unknown subnode " << nodeName << std::endl;
         node = node.next_sibling_of_type(pugi::node_element);
     }
+    for (XLStyleIndex index = 0; index < m_borders.size(); ++index) m_borders[ index ].m_owner = XLStyleEntryOwner{ m_hashIndex, {}, index };
 }
 
 XLBorders::~XLBorders()
@@ -1636,12 +2213,16 @@ XLBorders::~XLBorders()
 
 XLBorders::XLBorders(const XLBorders& other)
     : m_bordersNode(std::make_unique<XMLNode>(*other.m_bordersNode)),
-      m_borders(other.m_borders)
-{}
+      m_borders(other.m_borders),
+      m_hashIndex(std::make_shared<XLStyleHashIndex>(*other.m_hashIndex))
+{
+    for (XLStyleIndex index = 0; index < m_borders.size(); ++index) m_borders[ index ].m_owner = XLStyleEntryOwner{ m_hashIndex, {}, index };
+}
 
 XLBorders::XLBorders(XLBorders&& other)
     : m_bordersNode(std::move(other.m_bordersNode)),
-      m_borders(std::move(other.m_borders))
+      m_borders(std::move(other.m_borders)),
+      m_hashIndex(std::move(other.m_hashIndex))
 {}
 
 
@@ -1654,6 +2235,8 @@ XLBorders& XLBorders::operator=(const XLBorders& other)
         *m_bordersNode = *other.m_bordersNode;
         m_borders.clear();
         m_borders = other.m_borders;
+        m_hashIndex = std::make_shared<XLStyleHashIndex>(*other.m_hashIndex);
+        for (XLStyleIndex index = 0; index < m_borders.size(); ++index) m_borders[ index ].m_owner = XLStyleEntryOwner{ m_hashIndex, {}, index };
     }
     return *this;
 }
@@ -1691,7 +2274,7 @@ XLStyleIndex XLBorders::create(XLBorder copyFrom, std::string styleEntriesPrefix
         using namespace std::literals::string_literals;
         throw XLException("XLBorders::"s + __func__ + ": failed to append a new border node"s);
     }
-    if (styleEntriesPrefix.length() > 0)    // if a whitespace prefix is configured
+    if (useEntryPrefix(styleEntriesPrefix, lastStyle))    // if a whitespace prefix is configured and matches the layout
         m_bordersNode->insert_child_before(pugi::node_pcdata, newNode).set_value(styleEntriesPrefix.c_str());    // prefix the new node with styleEntriesPrefix
 
     XLBorder newBorder(newNode);
@@ -1705,10 +2288,46 @@ XLStyleIndex XLBorders::create(XLBorder copyFrom, std::string styleEntriesPrefix
         copyXMLNode(newNode, *copyFrom.m_borderNode);    // will use copyFrom as template, does nothing if copyFrom is empty
 
     m_borders.push_back(newBorder);
+    m_borders.back().m_owner = XLStyleEntryOwner{ m_hashIndex, {}, index };
     appendAndSetAttribute(*m_bordersNode, "count", std::to_string(m_borders.size())); // update array count in XML
     return index;
 }
 
+/**
+ * @details look up an entry with content identical to copyFrom via the content hash index, and create one if none exists
+ */
+XLStyleIndex XLBorders::findOrCreate(XLBorder copyFrom, std::string styleEntriesPrefix)
+{
+    if (copyFrom.m_borderNode->empty())    // the default border content only exists once created
+        return findOrCreate(copyFrom, [](XLBorder &) {}, styleEntriesPrefix);
+
+    auto entryNode = [this](XLStyleIndex index) { return *m_borders[ index ].m_borderNode; };
+    updateStyleHashIndex(*m_hashIndex, m_borders.size(), entryNode);
+    XLStyleIndex index = findInStyleHashIndex(*m_hashIndex, *copyFrom.m_borderNode, entryNode);
+    if (index != XLInvalidStyleIndex) return index;
+    return create(copyFrom, styleEntriesPrefix);
+}
+
+/**
+ * @details create a new entry, apply modify, and drop the new entry again if the content hash index has an identical one
+ */
+XLStyleIndex XLBorders::findOrCreate(XLBorder copyFrom, std::function<void(XLBorder&)> const& modify, std::string styleEntriesPrefix)
+{
+    auto entryNode = [this](XLStyleIndex index) { return *m_borders[ index ].m_borderNode; };
+    updateStyleHashIndex(*m_hashIndex, m_borders.size(), entryNode); // index all existing entries before the new one is appended
+
+    XLStyleIndex index = create(copyFrom, styleEntriesPrefix);
+    XLBorder newEntry = m_borders[ index ];
+    if (modify) modify(newEntry);
+
+    XLStyleIndex existing = findInStyleHashIndex(*m_hashIndex, *newEntry.m_borderNode, entryNode);
+    if (existing == XLInvalidStyleIndex) return index;    // the new entry will be indexed on next use
+
+    m_borders.pop_back();
+    removeLastStyleEntry(*m_bordersNode, *newEntry.m_borderNode, styleEntriesPrefix, m_borders.size());
+    return existing;
+}
+
 
 /**
  * @details Constructor. Initializes an empty XLAlignment object
@@ -1723,12 +2342,16 @@ XLAlignment::XLAlignment(const XMLNode& node) : m_alignmentNode(std::make_unique
 XLAlignment::~XLAlignment() = default;
 
 XLAlignment::XLAlignment(const XLAlignment& other)
-    : m_alignmentNode(std::make_unique<XMLNode>(*other.m_alignmentNode))
+    : m_alignmentNode(std::make_unique<XMLNode>(*other.m_alignmentNode)),
+      m_owner(other.m_owner)
 {}
 
 XLAlignment& XLAlignment::operator=(const XLAlignment& other)
 {
-    if (&other != this) *m_alignmentNode = *other.m_alignmentNode;
+    if (&other != this) {
+        *m_alignmentNode = *other.m_alignmentNode;
+        m_owner = other.m_owner;
+    }
     return *this;
 }
 
@@ -1780,15 +2403,15 @@ uint32_t XLAlignment::readingOrder() const { return m_alignmentNode->attribute("
 /**
  * @details Setter functions
  */
-bool XLAlignment::setHorizontal     (XLAlignmentStyle newStyle) { return appendAndSetAttribute(*m_alignmentNode, "horizontal",      XLAlignmentStyleToString(newStyle).c_str()).empty() == false; }
-bool XLAlignment::setVertical       (XLAlignmentStyle newStyle) { return appendAndSetAttribute(*m_alignmentNode, "vertical",        XLAlignmentStyleToString(newStyle).c_str()).empty() == false; }
-bool XLAlignment::setTextRotation   (uint16_t newRotation)      { return appendAndSetAttribute(*m_alignmentNode, "textRotation",    std::to_string(newRotation)               ).empty() == false; }
-bool XLAlignment::setWrapText       (bool set)                  { return appendAndSetAttribute(*m_alignmentNode, "wrapText",        (set ? "true" : "false")                  ).empty() == false; }
-bool XLAlignment::setIndent         (uint32_t newIndent)        { return appendAndSetAttribute(*m_alignmentNode, "indent",          std::to_string(newIndent)                 ).empty() == false; }
-bool XLAlignment::setRelativeIndent (int32_t newRelativeIndent) { return appendAndSetAttribute(*m_alignmentNode, "relativeIndent",  std::to_string(newRelativeIndent)         ).empty() == false; }
-bool XLAlignment::setJustifyLastLine(bool set)                  { return appendAndSetAttribute(*m_alignmentNode, "justifyLastLine", (set ? "true" : "false")                  ).empty() == false; }
-bool XLAlignment::setShrinkToFit    (bool set)                  { return appendAndSetAttribute(*m_alignmentNode, "shrinkToFit",     (set ? "true" : "false")                  ).empty() == false; }
-bool XLAlignment::setReadingOrder   (uint32_t newReadingOrder)  { return appendAndSetAttribute(*m_alignmentNode, "readingOrder",    std::to_string(newReadingOrder)           ).empty() == false; }
+bool XLAlignment::setHorizontal     (XLAlignmentStyle newStyle) { m_owner.touch(); return appendAndSetAttribute(*m_alignmentNode, "horizontal",      XLAlignmentStyleToString(newStyle).c_str()).empty() == false; }
+bool XLAlignment::setVertical       (XLAlignmentStyle newStyle) { m_owner.touch(); return appendAndSetAttribute(*m_alignmentNode, "vertical",        XLAlignmentStyleToString(newStyle).c_str()).empty() == false; }
+bool XLAlignment::setTextRotation   (uint16_t newRotation)      { m_owner.touch(); return appendAndSetAttribute(*m_alignmentNode, "textRotation",    std::to_string(newRotation)               ).empty() == false; }
+bool XLAlignment::setWrapText       (bool set)                  { m_owner.touch(); return appendAndSetAttribute(*m_alignmentNode, "wrapText",        (set ? "true" : "false")                  ).empty() == false; }
+bool XLAlignment::setIndent         (uint32_t newIndent)        { m_owner.touch(); return appendAndSetAttribute(*m_alignmentNode, "indent",          std::to_string(newIndent)                 ).empty() == false; }
+bool XLAlignment::setRelativeIndent (int32_t newRelativeIndent) { m_owner.touch(); return appendAndSetAttribute(*m_alignmentNode, "relativeIndent",  std::to_string(newRelativeIndent)         ).empty() == false; }
+bool XLAlignment::setJustifyLastLine(bool set)                  { m_owner.touch(); return appendAndSetAttribute(*m_alignmentNode, "justifyLastLine", (set ? "true" : "false")                  ).empty() == false; }
+bool XLAlignment::setShrinkToFit    (bool set)                  { m_owner.touch(); return appendAndSetAttribute(*m_alignmentNode, "shrinkToFit",     (set ? "true" : "false")                  ).empty() == false; }
+bool XLAlignment::setReadingOrder   (uint32_t newReadingOrder)  { m_owner.touch(); return appendAndSetAttribute(*m_alignmentNode, "readingOrder",    std::to_string(newReadingOrder)           ).empty() == false; }
 
 /**
  * @details assemble a string summary about the fill
@@ -1824,7 +2447,8 @@ XLCellFormat::~XLCellFormat() = default;
 
 XLCellFormat::XLCellFormat(const XLCellFormat& other)
     : m_cellFormatNode(std::make_unique<XMLNode>(*other.m_cellFormatNode)),
-      m_permitXfId(other.m_permitXfId)
+      m_permitXfId(other.m_permitXfId),
+      m_owner(other.m_owner)
 {}
 
 XLCellFormat& XLCellFormat::operator=(const XLCellFormat& other)
@@ -1832,6 +2456,7 @@ XLCellFormat& XLCellFormat::operator=(const XLCellFormat& other)
     if (&other != this) {
         *m_cellFormatNode = *other.m_cellFormatNode;
         m_permitXfId = other.m_permitXfId;
+        m_owner = other.m_owner;
     }
     return *this;
 }
@@ -1897,38 +2522,45 @@ bool XLCellFormat::hidden() const { return m_cellFormatNode->child("protection")
 XLAlignment XLCellFormat::alignment(bool createIfMissing) const
 {
     XMLNode nodeAlignment = m_cellFormatNode->child("alignment");
-    if (nodeAlignment.empty() && createIfMissing)
+    if (nodeAlignment.empty() && createIfMissing) {
+        m_owner.touch();
         nodeAlignment = appendAndGetNode(*m_cellFormatNode, "alignment", m_nodeOrder); // 2024-12-19: ordered insert to address issue #305
-    return XLAlignment(nodeAlignment);
+    }
+    XLAlignment result(nodeAlignment);
+    result.m_owner = m_owner;
+    return result;
 }
 
 /**
  * @details Setter functions
  */
-bool XLCellFormat::setNumberFormatId   (uint32_t newNumFmtId)        { return appendAndSetAttribute(*m_cellFormatNode, "numFmtId", std::to_string(newNumFmtId   )).empty() == false; }
-bool XLCellFormat::setFontIndex        (XLStyleIndex newXfIndex)     { return appendAndSetAttribute(*m_cellFormatNode, "fontId",   std::to_string(newXfIndex    )).empty() == false; }
-bool XLCellFormat::setFillIndex        (XLStyleIndex newFillIndex)   { return appendAndSetAttribute(*m_cellFormatNode, "fillId",   std::to_string(newFillIndex  )).empty() == false; }
-bool XLCellFormat::setBorderIndex      (XLStyleIndex newBorderIndex) { return appendAndSetAttribute(*m_cellFormatNode, "borderId", std::to_string(newBorderIndex)).empty() == false; }
+bool XLCellFormat::setNumberFormatId   (uint32_t newNumFmtId)        { m_owner.touch(); return appendAndSetAttribute(*m_cellFormatNode, "numFmtId", std::to_string(newNumFmtId   )).empty() == false; }
+bool XLCellFormat::setFontIndex        (XLStyleIndex newXfIndex)     { m_owner.touch(); return appendAndSetAttribute(*m_cellFormatNode, "fontId",   std::to_string(newXfIndex    )).empty() == false; }
+bool XLCellFormat::setFillIndex        (XLStyleIndex newFillIndex)   { m_owner.touch(); return appendAndSetAttribute(*m_cellFormatNode, "fillId",   std::to_string(newFillIndex  )).empty() == false; }
+bool XLCellFormat::setBorderIndex      (XLStyleIndex newBorderIndex) { m_owner.touch(); return appendAndSetAttribute(*m_cellFormatNode, "borderId", std::to_string(newBorderIndex)).empty() == false; }
 bool XLCellFormat::setXfId             (XLStyleIndex newXfId)
 {
+    m_owner.touch();
     if (m_permitXfId)                                                  return appendAndSetAttribute(*m_cellFormatNode, "xfId",     std::to_string(newXfId       )).empty() == false;
     throw XLException("XLCellFormat::setXfId not permitted when m_permitXfId is false");
 }
-bool XLCellFormat::setApplyNumberFormat(bool set)            { return appendAndSetAttribute    (*m_cellFormatNode, "applyNumberFormat",           (set ? "true" : "false")).empty() == false; }
-bool XLCellFormat::setApplyFont        (bool set)            { return appendAndSetAttribute    (*m_cellFormatNode, "applyFont",                   (set ? "true" : "false")).empty() == false; }
-bool XLCellFormat::setApplyFill        (bool set)            { return appendAndSetAttribute    (*m_cellFormatNode, "applyFill",                   (set ? "true" : "false")).empty() == false; }
-bool XLCellFormat::setApplyBorder      (bool set)            { return appendAndSetAttribute    (*m_cellFormatNode, "applyBorder",                 (set ? "true" : "false")).empty() == false; }
-bool XLCellFormat::setApplyAlignment   (bool set)            { return appendAndSetAttribute    (*m_cellFormatNode, "applyAlignment",              (set ? "true" : "false")).empty() == false; }
-bool XLCellFormat::setApplyProtection  (bool set)            { return appendAndSetAttribute    (*m_cellFormatNode, "applyProtection",             (set ? "true" : "false")).empty() == false; }
-bool XLCellFormat::setQuotePrefix      (bool set)            { return appendAndSetAttribute    (*m_cellFormatNode, "quotePrefix",                 (set ? "true" : "false")).empty() == false; }
-bool XLCellFormat::setPivotButton      (bool set)            { return appendAndSetAttribute    (*m_cellFormatNode, "pivotButton",                 (set ? "true" : "false")).empty() == false; }
+bool XLCellFormat::setApplyNumberFormat(bool set)            { m_owner.touch(); return appendAndSetAttribute    (*m_cellFormatNode, "applyNumberFormat",           (set ? "true" : "false")).empty() == false; }
+bool XLCellFormat::setApplyFont        (bool set)            { m_owner.touch(); return appendAndSetAttribute    (*m_cellFormatNode, "applyFont",                   (set ? "true" : "false")).empty() == false; }
+bool XLCellFormat::setApplyFill        (bool set)            { m_owner.touch(); return appendAndSetAttribute    (*m_cellFormatNode, "applyFill",                   (set ? "true" : "false")).empty() == false; }
+bool XLCellFormat::setApplyBorder      (bool set)            { m_owner.touch(); return appendAndSetAttribute    (*m_cellFormatNode, "applyBorder",                 (set ? "true" : "false")).empty() == false; }
+bool XLCellFormat::setApplyAlignment   (bool set)            { m_owner.touch(); return appendAndSetAttribute    (*m_cellFormatNode, "applyAlignment",              (set ? "true" : "false")).empty() == false; }
+bool XLCellFormat::setApplyProtection  (bool set)            { m_owner.touch(); return appendAndSetAttribute    (*m_cellFormatNode, "applyProtection",             (set ? "true" : "false")).empty() == false; }
+bool XLCellFormat::setQuotePrefix      (bool set)            { m_owner.touch(); return appendAndSetAttribute    (*m_cellFormatNode, "quotePrefix",                 (set ? "true" : "false")).empty() == false; }
+bool XLCellFormat::setPivotButton      (bool set)            { m_owner.touch(); return appendAndSetAttribute    (*m_cellFormatNode, "pivotButton",                 (set ? "true" : "false")).empty() == false; }
 bool XLCellFormat::setLocked(bool set)
 {
+    m_owner.touch();
     return appendAndSetNodeAttribute(*m_cellFormatNode, "protection", "locked", (set ? "true" : "false"),
     /**/                             XLKeepAttributes, m_nodeOrder).empty() == false;  // 2024-12-19: ordered insert to address issue #305
 }
 bool XLCellFormat::setHidden(bool set)
 {
+    m_owner.touch();
     return appendAndSetNodeAttribute(*m_cellFormatNode, "protection", "hidden", (set ? "true" : "false"),
     /**/                             XLKeepAttributes, m_nodeOrder).empty() == false;  // 2024-12-19: ordered insert to address issue #305
 }
@@ -1936,7 +2568,7 @@ bool XLCellFormat::setHidden(bool set)
 /**
  * @brief Unsupported setter function
  */
-bool XLCellFormat::setExtLst(XLUnsupportedElement const& newExtLst) { OpenXLSX::ignore(newExtLst); return false; }
+bool XLCellFormat::setExtLst(XLUnsupportedElement const& newExtLst) { m_owner.touch(); OpenXLSX::ignore(newExtLst); return false; }
 
 
 /**
@@ -1988,6 +2620,7 @@ XLCellFormats::XLCellFormats(const XMLNode& cellStyleFormats, bool permitXfId)
             std::cerr << "WARNING: XLCellFormats constructor: unknown subnode " << nodeName << std::endl;
         node = node.next_sibling_of_type(pugi::node_element);
     }
+    for (XLStyleIndex index = 0; index < m_cellFormats.size(); ++index) m_cellFormats[ index ].m_owner = XLStyleEntryOwner{ m_hashIndex, m_tableStale, index };
 }
 
 XLCellFormats::~XLCellFormats()
@@ -1998,13 +2631,19 @@ XLCellFormats::~XLCellFormats()
 XLCellFormats::XLCellFormats(const XLCellFormats& other)
     : m_cellFormatsNode(std::make_unique<XMLNode>(*other.m_cellFormatsNode)),
       m_cellFormats(other.m_cellFormats),
-      m_permitXfId(other.m_permitXfId)
-{}
+      m_permitXfId(other.m_permitXfId),
+      m_hashIndex(std::make_shared<XLStyleHashIndex>(*other.m_hashIndex)),
+      m_tableStale(std::make_shared<XLStyleTouchList>(*other.m_tableStale))
+{
+    for (XLStyleIndex index = 0; index < m_cellFormats.size(); ++index) m_cellFormats[ index ].m_owner = XLStyleEntryOwner{ m_hashIndex, m_tableStale, index };
+}
 
 XLCellFormats::XLCellFormats(XLCellFormats&& other)
     : m_cellFormatsNode(std::move(other.m_cellFormatsNode)),
       m_cellFormats(std::move(other.m_cellFormats)),
-      m_permitXfId(other.m_permitXfId)
+      m_permitXfId(other.m_permitXfId),
+      m_hashIndex(std::move(other.m_hashIndex)),
+      m_tableStale(std::move(other.m_tableStale))
 {}
 
 
@@ -2017,7 +2656,10 @@ XLCellFormats& XLCellFormats::operator=(const XLCellFormats& other)
         *m_cellFormatsNode = *other.m_cellFormatsNode;
         m_cellFormats.clear();
         m_cellFormats = other.m_cellFormats;
+        m_hashIndex = std::make_shared<XLStyleHashIndex>(*other.m_hashIndex);
+        m_tableStale = std::make_shared<XLStyleTouchList>(*other.m_tableStale);
         m_permitXfId = other.m_permitXfId;
+        for (XLStyleIndex index = 0; index < m_cellFormats.size(); ++index) m_cellFormats[ index ].m_owner = XLStyleEntryOwner{ m_hashIndex, m_tableStale, index };
     }
     return *this;
 }
@@ -2056,7 +2698,7 @@ XLStyleIndex XLCellFormats::create(XLCellFormat copyFrom, std::string styleEntri
         using namespace std::literals::string_literals;
         throw XLException("XLCellFormats::"s + __func__ + ": failed to append a new xf node"s);
     }
-    if (styleEntriesPrefix.length() > 0)    // if a whitespace prefix is configured
+    if (useEntryPrefix(styleEntriesPrefix, lastStyle))    // if a whitespace prefix is configured and matches the layout
         m_cellFormatsNode->insert_child_before(pugi::node_pcdata, newNode).set_value(styleEntriesPrefix.c_str());    // prefix the new node with styleEntriesPrefix
 
     XLCellFormat newCellFormat(newNode, m_permitXfId);
@@ -2085,10 +2727,46 @@ XLStyleIndex XLCellFormats::create(XLCellFormat copyFrom, std::string styleEntri
         copyXMLNode(newNode, *copyFrom.m_cellFormatNode); // will use copyFrom as template, does nothing if copyFrom is empty
 
     m_cellFormats.push_back(newCellFormat);
+    m_cellFormats.back().m_owner = XLStyleEntryOwner{ m_hashIndex, m_tableStale, index };
     appendAndSetAttribute(*m_cellFormatsNode, "count", std::to_string(m_cellFormats.size())); // update array count in XML
     return index;
 }
 
+/**
+ * @details look up an entry with content identical to copyFrom via the content hash index, and create one if none exists
+ */
+XLStyleIndex XLCellFormats::findOrCreate(XLCellFormat copyFrom, std::string styleEntriesPrefix)
+{
+    if (copyFrom.m_cellFormatNode->empty())    // the default cell format content only exists once created
+        return findOrCreate(copyFrom, [](XLCellFormat &) {}, styleEntriesPrefix);
+
+    auto entryNode = [this](XLStyleIndex index) { return *m_cellFormats[ index ].m_cellFormatNode; };
+    updateStyleHashIndex(*m_hashIndex, m_cellFormats.size(), entryNode);
+    XLStyleIndex index = findInStyleHashIndex(*m_hashIndex, *copyFrom.m_cellFormatNode, entryNode);
+    if (index != XLInvalidStyleIndex) return index;
+    return create(copyFrom, styleEntriesPrefix);
+}
+
+/**
+ * @details create a new entry, apply modify, and drop the new entry again if the content hash index has an identical one
+ */
+XLStyleIndex XLCellFormats::findOrCreate(XLCellFormat copyFrom, std::function<void(XLCellFormat&)> const& modify, std::string styleEntriesPrefix)
+{
+    auto entryNode = [this](XLStyleIndex index) { return *m_cellFormats[ index ].m_cellFormatNode; };
+    updateStyleHashIndex(*m_hashIndex, m_cellFormats.size(), entryNode); // index all existing entries before the new one is appended
+
+    XLStyleIndex index = create(copyFrom, styleEntriesPrefix);
+    XLCellFormat newEntry = m_cellFormats[ index ];
+    if (modify) modify(newEntry);
+
+    XLStyleIndex existing = findInStyleHashIndex(*m_hashIndex, *newEntry.m_cellFormatNode, entryNode);
+    if (existing == XLInvalidStyleIndex) return index;    // the new entry will be indexed on next use
+
+    m_cellFormats.pop_back();
+    removeLastStyleEntry(*m_cellFormatsNode, *newEntry.m_cellFormatNode, styleEntriesPrefix, m_cellFormats.size());
+    return existing;
+}
+
 
 /**
  * @details Constructor. Initializes an empty XLCellStyle object
@@ -2245,7 +2923,7 @@ XLStyleIndex XLCellStyles::create(XLCellStyle copyFrom, std::string styleEntries
         using namespace std::literals::string_literals;
         throw XLException("XLCellStyles::"s + __func__ + ": failed to append a new cellStyle node"s);
     }
-    if (styleEntriesPrefix.length() > 0)    // if a whitespace prefix is configured
+    if (useEntryPrefix(styleEntriesPrefix, lastStyle))    // if a whitespace prefix is configured and matches the layout
         m_cellStylesNode->insert_child_before(pugi::node_pcdata, newNode).set_value(styleEntriesPrefix.c_str());    // prefix the new node with styleEntriesPrefix
 
     XLCellStyle newCellStyle(newNode);
@@ -2432,7 +3110,7 @@ XLStyleIndex XLDiffCellFormats::create(XLDiffCellFormat copyFrom, std::string st
         using namespace std::literals::string_literals;
         throw XLException("XLDiffCellFormats::"s + __func__ + ": failed to append a new dxf node"s);
     }
-    if (styleEntriesPrefix.length() > 0)    // if a whitespace prefix is configured
+    if (useEntryPrefix(styleEntriesPrefix, lastDiffCellFormat))    // if a whitespace prefix is configured and matches the layout
         m_diffCellFormatsNode->insert_child_before(pugi::node_pcdata, newNode).set_value(styleEntriesPrefix.c_str());    // prefix the new node with styleEntriesPrefix
 
     XLDiffCellFormat newDiffCellFormat(newNode);
@@ -2574,6 +3252,9 @@ XLStyles::XLStyles(XLXmlData* xmlData, bool suppressWarnings, std::string styles
         wrapNode (doc.document_element(), node, stylesPrefix);
         m_numberFormats = std::make_unique<XLNumberFormats>(node);
     }
+
+    // ===== Decode the style tables once, subsequent calls only decode entries created or modified in the meantime
+    cellFormatTypes();
 }
 
 XLStyles::~XLStyles()
@@ -2593,7 +3274,10 @@ XLStyles::XLStyles(XLStyles&& other) noexcept
       m_cellStyleFormats(std::move(other.m_cellStyleFormats)),
       m_cellFormats     (std::move(other.m_cellFormats)     ),
       m_cellStyles      (std::move(other.m_cellStyles)      ),
-      m_diffCellFormats (std::move(other.m_diffCellFormats) )
+      m_diffCellFormats (std::move(other.m_diffCellFormats) ),
+      m_cellFormatTable  (std::move(other.m_cellFormatTable)  ),
+      m_numberFormatTable(std::move(other.m_numberFormatTable)),
+      m_cellFormatTypes  (std::move(other.m_cellFormatTypes)  )
 {}
 
 /**
@@ -2609,7 +3293,10 @@ XLStyles::XLStyles(const XLStyles& other)
       m_cellStyleFormats(std::make_unique<XLCellFormats    >(*other.m_cellStyleFormats)),
       m_cellFormats     (std::make_unique<XLCellFormats    >(*other.m_cellFormats)     ),
       m_cellStyles      (std::make_unique<XLCellStyles     >(*other.m_cellStyles)      ),
-      m_diffCellFormats (std::make_unique<XLDiffCellFormats>(*other.m_diffCellFormats) )
+      m_diffCellFormats (std::make_unique<XLDiffCellFormats>(*other.m_diffCellFormats) ),
+      m_cellFormatTable  (other.m_cellFormatTable  ),
+      m_numberFormatTable(other.m_numberFormatTable),
+      m_cellFormatTypes  (other.m_cellFormatTypes  )
 {}
 
 /**
@@ -2628,6 +3315,9 @@ XLStyles& XLStyles::operator=(XLStyles&& other) noexcept
         m_cellFormats      = std::move(other.m_cellFormats     );
         m_cellStyles       = std::move(other.m_cellStyles      );
         m_diffCellFormats  = std::move(other.m_diffCellFormats );
+        m_cellFormatTable   = std::move(other.m_cellFormatTable  );
+        m_numberFormatTable = std::move(other.m_numberFormatTable);
+        m_cellFormatTypes   = std::move(other.m_cellFormatTypes  );
     }
     return *this;
 }
@@ -2683,3 +3373,243 @@ XLCellStyles& XLStyles::cellStyles() const { return *m_cellStyles; }
  * @details return a handle to the underlying differential cell formats
  */
 XLDiffCellFormats& XLStyles::diffCellFormats() const { return *m_diffCellFormats; }
+
+/**
+ * @details Re-decode the entries that were modified since the last call, and append the entries created since then.
+ *          An entry count below the table size (findOrCreate dropping a temporary entry) truncates the table.
+ */
+bool XLStyles::syncCellFormatTable() const
+{
+    XLCellFormats const& formats = *m_cellFormats;
+    XLCellFormatTable & table = m_cellFormatTable;
+    size_t previousSize = table.size();
+    size_t decoded = std::min(previousSize, formats.count());
+    table.resize(formats.count());
+    auto decode = [&](XLStyleIndex index) {
+        XLCellFormat const& fmt = formats.m_cellFormats[index];
+        table.numberFormatId[index] = fmt.numberFormatId();
+        table.fontIndex     [index] = static_cast<uint32_t>(fmt.fontIndex());
+        table.fillIndex     [index] = static_cast<uint32_t>(fmt.fillIndex());
+        table.borderIndex   [index] = static_cast<uint32_t>(fmt.borderIndex());
+        table.xfId          [index] = static_cast<uint32_t>(fmt.xfId());
+    };
+    bool changed = (decoded < table.size() || decoded < previousSize || not formats.m_tableStale->entries.empty());
+    for (XLStyleIndex index : formats.m_tableStale->entries)
+        if (index < decoded) decode(index);
+    formats.m_tableStale->clear();
+    for (XLStyleIndex index = decoded; index < table.size(); ++index) decode(index);
+    return changed;
+}
+
+/**
+ * @details bring the table up to date and return it
+ */
+XLCellFormatTable const& XLStyles::cellFormatTable() const
+{
+    syncCellFormatTable();
+    return m_cellFormatTable;
+}
+
+/**
+ * @details Same update logic as cellFormatTable. The id lookup keeps the first number format for duplicate ids.
+ */
+bool XLStyles::syncNumberFormatTable() const
+{
+    XLNumberFormats const& formats = *m_numberFormats;
+    XLNumberFormatTable & table = m_numberFormatTable;
+    size_t previousSize = table.size();
+    size_t decoded = std::min(previousSize, formats.count());
+    table.resize(formats.count());
+    auto decode = [&](XLStyleIndex index) {
+        XLNumberFormat const& fmt = formats.m_numberFormats[index];
+        auto it = table.indexById.find(table.numberFormatId[index]);
+        if (it != table.indexById.end() && it->second == index) table.indexById.erase(it);
+        table.numberFormatId[index] = fmt.numberFormatId();
+        table.formatCode    [index] = fmt.formatCode();
+        table.numberFormatType[index] = numberFormatTypeFromCode(table.formatCode[index]);
+        table.indexById.emplace(table.numberFormatId[index], index);
+    };
+    bool changed = (decoded < table.size() || decoded < previousSize || not formats.m_tableStale->entries.empty());
+    for (XLStyleIndex index : formats.m_tableStale->entries)
+        if (index < decoded) decode(index);
+    formats.m_tableStale->clear();
+    for (XLStyleIndex index = decoded; index < table.size(); ++index) decode(index);
+    return changed;
+}
+
+/**
+ * @details bring the table up to date and return it
+ */
+XLNumberFormatTable const& XLStyles::numberFormatTable() const
+{
+    syncNumberFormatTable();
+    return m_numberFormatTable;
+}
+
+/**
+ * @details Re-classify all cell formats if any cell format or number format may have changed: a changed number format can
+ *          affect any number of cell formats, and re-classification is a cheap pass over the decoded arrays
+ */
+std::vector<XLNumberFormatType> const& XLStyles::cellFormatTypes() const
+{
+    bool numberFormatsChanged = syncNumberFormatTable();
+    bool cellFormatsChanged   = syncCellFormatTable();
+    if (numberFormatsChanged || cellFormatsChanged || m_cellFormatTypes.size() != m_cellFormatTable.size()) {
+        m_cellFormatTypes.resize(m_cellFormatTable.size());
+        for (XLStyleIndex index = 0; index < m_cellFormatTable.size(); ++index) {
+            uint32_t     numFmtId    = m_cellFormatTable.numberFormatId[index];
+            XLStyleIndex numFmtIndex = m_numberFormatTable.indexOf(numFmtId);
+            m_cellFormatTypes[index] = (numFmtIndex != XLInvalidStyleIndex ? m_numberFormatTable.numberFormatType[numFmtIndex]
+                                                                           : builtinNumberFormatType(numFmtId));
+        }
+    }
+    return m_cellFormatTypes;
+}
+
+/**
+ * @details The entry objects and the hash indices are estimated from their element counts, the tables from their capacities.
+ */
+size_t XLStyles::memoryUsage() const
+{
+    if (not m_cellFormats) return 0;    // default constructed / moved from
+
+    size_t result = entriesSize<XLNumberFormat>(m_numberFormats->count()) + entriesSize<XLFont>(m_fonts->count())
+                    + entriesSize<XLFill>(m_fills->count()) + entriesSize<XLBorder>(m_borders->count())
+                    + entriesSize<XLCellFormat>(m_cellStyleFormats->count() + m_cellFormats->count())
+                    + entriesSize<XLCellStyle>(m_cellStyles->count()) + entriesSize<XLDiffCellFormat>(m_diffCellFormats->count());
+
+    result += hashIndexSize(*m_fonts->m_hashIndex) + hashIndexSize(*m_fills->m_hashIndex) + hashIndexSize(*m_borders->m_hashIndex)
+              + hashIndexSize(*m_cellStyleFormats->m_hashIndex) + hashIndexSize(*m_cellFormats->m_hashIndex);
+    for (const XLStyleTouchList* list : { m_numberFormats->m_tableStale.get(), m_cellStyleFormats->m_tableStale.get(), m_cellFormats->m_tableStale.get() })
+        result += heapSize(list->flagged) + heapSize(list->entries);
+
+    result += heapSize(m_cellFormatTable.numberFormatId) + heapSize(m_cellFormatTable.fontIndex) + heapSize(m_cellFormatTable.fillIndex)
+              + heapSize(m_cellFormatTable.borderIndex) + heapSize(m_cellFormatTable.xfId);
+    result += heapSize(m_numberFormatTable.numberFormatId) + heapSize(m_numberFormatTable.formatCode)
+              + heapSize(m_numberFormatTable.numberFormatType) + heapSize(m_cellFormatTypes);
+    for (const std::string& code : m_numberFormatTable.formatCode) result += heapSize(code);
+    result += m_numberFormatTable.indexById.size() * (sizeof(std::pair<const uint32_t, XLStyleIndex>) + 2 * sizeof(void*))
+              + m_numberFormatTable.indexById.bucket_count() * sizeof(void*);
+    return result;
+}
+
+/**
+ * @details look up the classification of a single cell format
+ */
+XLNumberFormatType XLStyles::cellFormatType(XLStyleIndex cellFormatIndex) const
+{
+    std::vector<XLNumberFormatType> const& types = cellFormatTypes();
+    return cellFormatIndex < types.size() ? types[cellFormatIndex] : XLNumberFormatType::General;
+}
+
+/**
+ * @details Flags everything that remains referenced, removes all other entries from the XML and renumbers the references
+ *          within xl/styles.xml. The entry collections are then re-read from the XML, keeping their addresses unchanged.
+ */
+XLStyleCompactionMap XLStyles::compact(std::vector<bool> cellFormatsInUse, std::vector<bool> diffCellFormatsInUse)
+{
+    XMLNode styleSheet = xmlDocument().document_element();
+    XMLNode numFmtsNode, fontsNode, fillsNode, bordersNode, cellStyleXfsNode, cellXfsNode, dxfsNode, tableStylesNode, extLstNode;
+    XMLNode node = styleSheet.first_child_of_type(pugi::node_element);
+    while (not node.empty()) {
+        switch (XLStylesEntryTypeFromString(node.name())) {
+            case XLStylesNumberFormats:    numFmtsNode      = node; break;
+            case XLStylesFonts:            fontsNode        = node; break;
+            case XLStylesFills:            fillsNode        = node; break;
+            case XLStylesBorders:          bordersNode      = node; break;
+            case XLStylesCellStyleFormats: cellStyleXfsNode = node; break;
+            case XLStylesCellFormats:      cellXfsNode      = node; break;
+            case XLStylesDiffCellFormats:  dxfsNode         = node; break;
+            case XLStylesTableStyles:      tableStylesNode  = node; break;
+            case XLStylesExtLst:           extLstNode       = node; break;
+            default: break;
+        }
+        node = node.next_sibling_of_type(pugi::node_element);
+    }
+
+    // ===== The default cell format is always kept, as are the default font, border and the two fills required by Excel
+    cellFormatsInUse.resize(m_cellFormats->count(), false);
+    if (not cellFormatsInUse.empty()) cellFormatsInUse[XLDefaultCellFormat] = true;
+    diffCellFormatsInUse.resize(m_diffCellFormats->count(), false);
+    std::vector<bool> fontsInUse  (m_fonts->count(),   false);
+    std::vector<bool> fillsInUse  (m_fills->count(),   false);
+    std::vector<bool> bordersInUse(m_borders->count(), false);
+    for (size_t i = 0; i < fontsInUse.size()   && i < 1; ++i) fontsInUse[i]   = true;
+    for (size_t i = 0; i < fillsInUse.size()   && i < 2; ++i) fillsInUse[i]   = true;
+    for (size_t i = 0; i < bordersInUse.size() && i < 1; ++i) bordersInUse[i] = true;
+    std::vector<bool> numFmtIdsInUse;
+
+    // ===== Flag the fonts, fills, borders and number formats referenced by all cell style formats and the remaining cell formats
+    auto flagFormatReferences = [&](XMLNode xf) {
+        flagStyleAttribute(xf.attribute("fontId"),   fontsInUse);
+        flagStyleAttribute(xf.attribute("fillId"),   fillsInUse);
+        flagStyleAttribute(xf.attribute("borderId"), bordersInUse);
+        XLStyleIndex numFmtId = xf.attribute("numFmtId").as_uint(0);
+        if (numFmtId >= numFmtIdsInUse.size()) numFmtIdsInUse.resize(numFmtId + 1, false);
+        numFmtIdsInUse[numFmtId] = true;
+    };
+    for (XMLNode xf = cellStyleXfsNode.first_child_of_type(pugi::node_element); not xf.empty(); xf = xf.next_sibling_of_type(pugi::node_element))
+        flagFormatReferences(xf);
+    XLStyleIndex xfIndex = 0;
+    for (XMLNode xf = cellXfsNode.first_child_of_type(pugi::node_element); not xf.empty(); xf = xf.next_sibling_of_type(pugi::node_element), ++xfIndex)
+        if (xfIndex < cellFormatsInUse.size() && cellFormatsInUse[xfIndex]) flagFormatReferences(xf);
+
+    // ===== Differential formats referenced by table styles are kept. References from an <extLst> can not be resolved
+    //        reliably (they may address the <x14:dxfs> of the extension), so in that case all differential formats are kept
+    std::vector<XMLAttribute> dxfReferences;
+    std::vector<XMLAttribute> extLstDxfReferences;
+    collectAttributes(tableStylesNode, "dxfId", dxfReferences);
+    collectAttributes(extLstNode,      "dxfId", extLstDxfReferences);
+    if (not extLstDxfReferences.empty()) diffCellFormatsInUse.assign(diffCellFormatsInUse.size(), true);
+    for (XMLAttribute const & attr : dxfReferences) flagStyleAttribute(attr, diffCellFormatsInUse);
+
+    // ===== Custom number formats (their ids are not renumbered) are dropped if no longer referenced - also keep those
+    //        whose id is used by an inline number format of a differential format, to avoid id conflicts
+    XLStyleIndex dxfIndex = 0;
+    for (XMLNode dxf = dxfsNode.first_child_of_type(pugi::node_element); not dxf.empty(); dxf = dxf.next_sibling_of_type(pugi::node_element), ++dxfIndex) {
+        if (dxfIndex >= diffCellFormatsInUse.size() || not diffCellFormatsInUse[dxfIndex]) continue;
+        XMLAttribute numFmtId = dxf.child("numFmt").attribute("numFmtId");
+        if (numFmtId.empty()) continue;
+        if (numFmtId.as_uint() >= numFmtIdsInUse.size()) numFmtIdsInUse.resize(numFmtId.as_uint() + 1, false);
+        numFmtIdsInUse[numFmtId.as_uint()] = true;
+    }
+    std::vector<bool> numFmtsInUse;
+    for (XMLNode numFmt = numFmtsNode.first_child_of_type(pugi::node_element); not numFmt.empty(); numFmt = numFmt.next_sibling_of_type(pugi::node_element)) {
+        XLStyleIndex numFmtId = numFmt.attribute("numFmtId").as_uint(XLInvalidUInt32);
+        numFmtsInUse.push_back(numFmtId < numFmtIdsInUse.size() && numFmtIdsInUse[numFmtId]);
+    }
+
+    // ===== Drop all unreferenced entries
+    XLStyleCompactionMap result;
+    result.cellFormats     = removeUnusedStyleEntries(cellXfsNode, cellFormatsInUse);
+    result.diffCellFormats = removeUnusedStyleEntries(dxfsNode,    diffCellFormatsInUse);
+    std::vector<XLStyleIndex> fontsMap   = removeUnusedStyleEntries(fontsNode,   fontsInUse);
+    std::vector<XLStyleIndex> fillsMap   = removeUnusedStyleEntries(fillsNode,   fillsInUse);
+    std::vector<XLStyleIndex> bordersMap = removeUnusedStyleEntries(bordersNode, bordersInUse);
+    removeUnusedStyleEntries(numFmtsNode, numFmtsInUse);
+
+    // ===== Renumber the references within xl/styles.xml
+    for (XMLNode xfs : { cellStyleXfsNode, cellXfsNode }) {
+        for (XMLNode xf = xfs.first_child_of_type(pugi::node_element); not xf.empty(); xf = xf.next_sibling_of_type(pugi::node_element)) {
+            renumberStyleAttribute(xf.attribute("fontId"),   fontsMap);
+            renumberStyleAttribute(xf.attribute("fillId"),   fillsMap);
+            renumberStyleAttribute(xf.attribute("borderId"), bordersMap);
+        }
+    }
+    for (XMLAttribute const & attr : dxfReferences) renumberStyleAttribute(attr, result.diffCellFormats);
+
+    // ===== Re-read the collections from the modified XML
+    *m_numberFormats    = XLNumberFormats  (numFmtsNode);
+    *m_fonts            = XLFonts          (fontsNode);
+    *m_fills            = XLFills          (fillsNode);
+    *m_borders          = XLBorders        (bordersNode);
+    *m_cellStyleFormats = XLCellFormats    (cellStyleXfsNode);
+    *m_cellFormats      = XLCellFormats    (cellXfsNode, XLPermitXfID);
+    *m_diffCellFormats  = XLDiffCellFormats(dxfsNode);
+    m_cellFormatTable   = XLCellFormatTable();
+    m_numberFormatTable = XLNumberFormatTable();
+    m_cellFormatTypes.clear();
+    cellFormatTypes();
+
+    return result;
+}
@@ -0,0 +1,178 @@
+/*
+
+   ____                               ____      ___ ____       ____  ____      ___
+  6MMMMb                              `MM(      )M' `MM'      6MMMMb\`MM(      )M'
+ 8P    Y8                              `MM.     d'   MM      6M'    ` `MM.     d'
+6M      Mb __ ____     ____  ___  __    `MM.   d'    MM      MM        `MM.   d'
+MM      MM `M6MMMMb   6MMMMb `MM 6MMb    `MM. d'     MM      YM.        `MM. d'
+MM      MM  MM'  `Mb 6M'  `Mb MMM9 `Mb    `MMd       MM       YMMMMb     `MMd
+MM      MM  MM    MM MM    MM MM'   MM     dMM.      MM           `Mb     dMM.
+MM      MM  MM    MM MMMMMMMM MM    MM    d'`MM.     MM            MM    d'`MM.
+YM      M9  MM    MM MM       MM    MM   d'  `MM.    MM            MM   d'  `MM.
+ 8b    d8   MM.  ,M9 YM    d9 MM    MM  d'    `MM.   MM    / L    ,M9  d'    `MM.
+  YMMMM9    MMYMMM9   YMMMM9 _MM_  _MM_M(_    _)MM_ _MMMMMMM MYMMMM9 _M(_    _)MM_
+            MM
+            MM
+           _MM_
+
+  Copyright (c) 2018, Kenneth Troldal Balslev
+
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+  - Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+  - Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+  - Neither the name of the author nor the
+    names of any contributors may be used to endorse or promote products
+    derived from this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+  DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+  DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+  ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ */
+
+// ===== External Includes ===== //
+#include <cstdlib>
+#include <new>
+#include <pugixml.hpp>
+
+// ===== OpenXLSX Includes ===== //
+#include "XLXmlArena.hpp"
+
+using namespace OpenXLSX;
+
+namespace    // anonymous namespace for module local functions
+{
+    struct BlockHeader
+    {
+        XLXmlArena* arena;       // nullptr for blocks that were passed through
+        size_t      capacity;    // the usable size of the block
+    };
+
+    // ===== The header keeps the maximum fundamental alignment, which pugixml expects of its allocations
+    constexpr size_t headerSize = (sizeof(BlockHeader) + alignof(std::max_align_t) - 1) / alignof(std::max_align_t) * alignof(std::max_align_t);
+
+    thread_local XLXmlArena* currentArena = nullptr;
+
+    /**
+     * @brief Round a request up to its size class: multiples of 64 bytes up to 512 bytes, above that 8 classes per power of two
+     * @param size the requested size
+     * @return the capacity of a block serving the request - blocks of one class are interchangeable, and at most 1/8 is unused
+     */
+    size_t sizeClass(size_t size)
+    {
+        if (size <= 512) return (size + 63) & ~size_t(63);
+        size_t step = 64;
+        while ((step << 4) <= size) step <<= 1;    // step = 2^(floor(log2(size)) - 3)
+        return (size + step - 1) & ~(step - 1);
+    }
+
+    pugi::allocation_function   upstreamAllocate   = nullptr;
+    pugi::deallocation_function upstreamDeallocate = nullptr;
+
+    void* arenaAllocate(size_t size)
+    {
+        if (currentArena != nullptr) return currentArena->allocate(size);
+
+        void* block = upstreamAllocate(size + headerSize);
+        if (block == nullptr) return nullptr;
+        new (block) BlockHeader {nullptr, size};
+        return static_cast<char*>(block) + headerSize;
+    }
+
+    void arenaDeallocate(void* ptr)
+    {
+        void*        block  = static_cast<char*>(ptr) - headerSize;
+        XLXmlArena*  arena  = static_cast<BlockHeader*>(block)->arena;
+        if (arena != nullptr) arena->release(block);
+        else upstreamDeallocate(block);
+    }
+
+    // ===== Installed before main, i.e. before any XML document can exist
+    const bool arenaInstalled = (upstreamAllocate   = pugi::get_memory_allocation_function(),
+                                 upstreamDeallocate = pugi::get_memory_deallocation_function(),
+                                 pugi::set_memory_management_functions(arenaAllocate, arenaDeallocate),
+                                 true);
+}    // anonymous namespace
+
+/**
+ * @details
+ */
+XLXmlArena::Scope::Scope(XLXmlArena* arena) : m_previous(currentArena) { currentArena = arena; }
+
+/**
+ * @details
+ */
+XLXmlArena::Scope::~Scope() { currentArena = m_previous; }
+
+/**
+ * @details
+ */
+XLXmlArena::~XLXmlArena() { trim(); }
+
+/**
+ * @details pugixml requests pages of a fixed size and parse buffers of the size of the XML text, which differ between parts: these
+ *          are rounded up to a size class, so that they can be reused for parts of a similar size.
+ */
+void* XLXmlArena::allocate(size_t size)
+{
+    size = sizeClass(size);
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        const auto                  found = m_free.find(size);
+        if (found != m_free.end()) {
+            void* block = found->second;
+            m_retained -= found->first;
+            m_free.erase(found);
+            return static_cast<char*>(block) + headerSize;
+        }
+    }
+
+    void* block = upstreamAllocate(size + headerSize);
+    if (block == nullptr) return nullptr;
+    new (block) BlockHeader {this, size};
+    return static_cast<char*>(block) + headerSize;
+}
+
+/**
+ * @details
+ */
+void XLXmlArena::release(void* block)
+{
+    const size_t                capacity = static_cast<BlockHeader*>(block)->capacity;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_free.emplace(capacity, block);
+    m_retained += capacity;
+}
+
+/**
+ * @details
+ */
+void XLXmlArena::trim()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (const auto& [capacity, block] : m_free) upstreamDeallocate(block);
+    m_free.clear();
+    m_retained = 0;
+}
+
+/**
+ * @details
+ */
+size_t XLXmlArena::retainedSize() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_retained;
+}
@@ -50,9 +50,40 @@ YM      M9  MM    MM MM       MM    MM   d'  `MM.    MM            MM   d'  `MM.
 // ===== OpenXLSX Includes ===== //
 #include "XLDocument.hpp"
 #include "XLXmlData.hpp"
+#include "XLZipArchive.hpp"
+#include "utilities/XLStatsRecorder.hpp"
 
 using namespace OpenXLSX;
 
+namespace    // anonymous namespace for module local functions
+{
+    /**
+     * @brief Estimate the memory held by a parsed XML document
+     * @param doc the document
+     * @param textSize the size of the XML text it was parsed from - pugixml keeps the text as the buffer that names and values point into
+     * @return textSize plus the size of the node and attribute structures (each node holds 8 and each attribute 5 pointer sized fields)
+     */
+    size_t estimateDocumentSize(const XMLDocument& doc, size_t textSize)
+    {
+        size_t  nodes      = 0;
+        size_t  attributes = 0;
+        XMLNode node       = doc.first_child();
+        while (not node.empty()) {
+            ++nodes;
+            for (XMLAttribute attr = node.first_attribute(); not attr.empty(); attr = attr.next_attribute()) ++attributes;
+
+            // ===== Depth-first: descend, else advance to the next sibling of the node or of its closest ancestor
+            if (not node.first_child().empty()) {
+                node = node.first_child();
+                continue;
+            }
+            while (not node.empty() && node.next_sibling().empty()) node = node.parent();
+            if (not node.empty()) node = node.next_sibling();
+        }
+        return textSize + nodes * 8 * sizeof(void*) + attributes * 5 * sizeof(void*);
+    }
+}    // anonymous namespace
+
 /**
  * @details
  */
@@ -61,7 +92,8 @@ XLXmlData::XLXmlData(XLDocument* parentDoc, const std::string& xmlPath, const st
       m_xmlPath(xmlPath),
       m_xmlID(xmlId),
       m_xmlType(xmlType),
-      m_xmlDoc(std::make_unique<XMLDocument>())
+      m_xmlDoc(std::make_unique<XMLDocument>()),
+      m_pin(std::make_shared<int>(0))
 {
     m_xmlDoc->reset();
 }
@@ -72,11 +104,28 @@ XLXmlData::XLXmlData(XLDocument* parentDoc, const std::string& xmlPath, const st
 XLXmlData::~XLXmlData() = default;
 
 /**
- * @details
+ * @details Like load, the new document replaces any spilled text, and is measured and counted against the memory budget of the
+ *          parent document, if it has one
  */
 void XLXmlData::setRawData(const std::string& data) // NOLINT
 {
-    m_xmlDoc->load_string(data.c_str(), pugi_parse_settings);
+    const bool budget = (m_parentDoc != nullptr && m_parentDoc->m_memoryBudget > 0);
+    {
+        std::lock_guard<std::mutex> lock(m_loadState->mutex);
+        {
+            XLXmlArena::Scope arena(m_parentDoc ? m_parentDoc->xmlArena() : nullptr);
+            m_xmlDoc->load_string(data.c_str(), m_parentDoc ? m_parentDoc->xmlParseOptions() : pugi_parse_settings);
+        }
+        std::string().swap(m_spill);
+        m_spillSize = 0;
+        m_textSize  = data.size();
+        m_formulaCache.reset();
+        if (budget) m_residentSize = estimateDocumentSize(*m_xmlDoc, m_textSize);
+        m_loadState->parsed.store(true, std::memory_order_release);
+    }
+
+    touch();
+    if (budget) m_parentDoc->enforceMemoryBudget(this);
 }
 
 /**
@@ -165,19 +214,123 @@ XLContentType XLXmlData::getXmlType() const
  */
 XMLDocument* XLXmlData::getXmlDocument()
 {
-    if (!m_xmlDoc->document_element())
-        m_xmlDoc->load_string(m_parentDoc->extractXmlFromArchive(m_xmlPath).c_str(), pugi_parse_settings);
+    if (isLoaded()) {
+        OPENXLSX_STATS_COUNT(cacheHits);
+        touch();
+    }
+    else load();
 
     return m_xmlDoc.get();
 }
 
 /**
- * @details
+ * @details The parsed flag is tested first, so that a thread never inspects a document that another thread is still parsing.
  */
 const XMLDocument* XLXmlData::getXmlDocument() const
 {
-    if (!m_xmlDoc->document_element())
-        m_xmlDoc->load_string(m_parentDoc->extractXmlFromArchive(m_xmlPath).c_str(), pugi_parse_settings);
+    if (isLoaded()) {
+        OPENXLSX_STATS_COUNT(cacheHits);
+        touch();
+    }
+    else load();
 
     return m_xmlDoc.get();
 }
+
+/**
+ * @details
+ */
+size_t XLXmlData::residentSize() const
+{
+    if (isLoaded()) return m_residentSize = estimateDocumentSize(*m_xmlDoc, m_textSize);
+    return m_spill.size();
+}
+
+/**
+ * @details A spilled document is restored from its compressed text, everything else is (re-)read from the archive. If the parent
+ *          document has a memory budget, the new document is measured and other documents are evicted as needed - after the
+ *          lock is released, as eviction locks the evicted documents.
+ */
+void XLXmlData::load() const
+{
+    bool parsed = false;
+    {
+        std::lock_guard<std::mutex> lock(m_loadState->mutex);
+        if (m_xmlDoc->document_element().empty()) {    // else: parsed by another thread while this one was waiting
+            std::string xml;
+            if (m_spill.empty())
+                xml = m_parentDoc->extractXmlFromArchive(m_xmlPath);
+            else {
+                OPENXLSX_STATS_TIMER(timer, m_parentDoc->m_stats.get(), XLStatsPhase::Inflate, m_xmlPath);
+                xml = XLZipArchive::decompressData(m_spill, m_spillSize);
+                OPENXLSX_STATS_BYTES(timer, xml.size());
+            }
+            {
+                OPENXLSX_STATS_TIMER(timer, m_parentDoc->m_stats.get(), XLStatsPhase::Parse, m_xmlPath);
+                OPENXLSX_STATS_BYTES(timer, xml.size());
+                XLXmlArena::Scope arena(m_parentDoc->xmlArena());
+                m_xmlDoc->load_string(xml.c_str(), m_parentDoc->xmlParseOptions());
+            }
+            m_textSize = xml.size();
+            std::string().swap(m_spill);
+            m_spillSize = 0;
+            if (m_parentDoc->m_memoryBudget > 0) m_residentSize = estimateDocumentSize(*m_xmlDoc, m_textSize);
+            parsed = true;
+        }
+        m_loadState->parsed.store(true, std::memory_order_release);
+    }
+
+    touch();
+    if (parsed && m_parentDoc->m_memoryBudget > 0) m_parentDoc->enforceMemoryBudget(this);
+}
+
+/**
+ * @details
+ */
+void XLXmlData::touch() const
+{
+    if (m_parentDoc != nullptr && m_parentDoc->m_memoryBudget > 0)
+        m_loadState->lastUse.store(++m_parentDoc->m_sync->useCount, std::memory_order_relaxed);
+}
+
+/**
+ * @details The document is serialized without formatting, so that re-parsing it yields the same DOM.
+ */
+void XLXmlData::unload(bool spill)
+{
+    std::lock_guard<std::mutex> lock(m_loadState->mutex);
+    if (not isLoaded() || isPinned()) return;    // pinned by another thread since the caller checked
+    m_loadState->parsed.store(false, std::memory_order_relaxed);
+    if (spill) {
+        std::ostringstream ostr;
+        m_xmlDoc->save(ostr, "", pugi::format_raw | pugi::format_no_declaration);
+        const std::string xml = ostr.str();
+        OPENXLSX_STATS_TIMER(timer, m_parentDoc->m_stats.get(), XLStatsPhase::Deflate, m_xmlPath);
+        OPENXLSX_STATS_BYTES(timer, xml.size());
+        m_spill               = XLZipArchive::compressData(xml);
+        m_spillSize           = xml.size();
+    }
+    m_xmlDoc->reset();
+    m_formulaCache.reset();
+    m_residentSize = 0;
+    m_textSize     = 0;
+}
+
+/**
+ * @details The copy is allocated from this document's arena. pugixml copies all names and values, so the copy does not refer
+ *          to the parse buffer of source.
+ */
+void XLXmlData::copyXmlDocument(const XLXmlData& source)
+{
+    std::lock_guard<std::mutex> lock(m_loadState->mutex);
+    {
+        XLXmlArena::Scope arena(m_parentDoc ? m_parentDoc->xmlArena() : nullptr);
+        m_xmlDoc->reset(*source.m_xmlDoc);
+    }
+    std::string().swap(m_spill);
+    m_spillSize    = 0;
+    m_textSize     = source.m_textSize;
+    m_formulaCache.reset();
+    if (m_parentDoc != nullptr && m_parentDoc->m_memoryBudget > 0) m_residentSize = estimateDocumentSize(*m_xmlDoc, m_textSize);
+    m_loadState->parsed.store(true, std::memory_order_release);
+}
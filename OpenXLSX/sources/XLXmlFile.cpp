@@ -58,16 +58,23 @@ using namespace OpenXLSX;
  * the same path in the .zip file will be overwritten upon saving of the document. If no xmlData is provided,
  * the data will be read from the .zip file, using the given path.
  */
-XLXmlFile::XLXmlFile(XLXmlData* xmlData) : m_xmlData(xmlData) {}
+XLXmlFile::XLXmlFile(XLXmlData* xmlData) : m_xmlData(xmlData), m_pin(xmlData != nullptr ? xmlData->pin() : nullptr) {}
 
 XLXmlFile::~XLXmlFile() = default;
 
+/**
+ * @details
+ */
+bool XLXmlFile::isReadOnly() const { return m_xmlData != nullptr && m_xmlData->getParentDoc()->isReadOnly(); }
+
 /**
  * @details This method sets the XML data with a std::string as input. The underlying XMLDocument reads the data.
  * When envoking the load_string method in PugiXML, the flag 'parse_ws_pcdata' is passed along with the default flags.
  * This will enable parsing of whitespace characters. If not set, Excel cells with only spaces will be returned as
  * empty strings, which is not what we want. The downside is that whitespace characters such as \\n and \\t in the
  * input xml file may mess up the parsing.
+ * With XLDocument::setLeanXmlParsing, 'parse_ws_pcdata_single' is passed instead: cells with only spaces are retained,
+ * while the whitespace between elements is dropped.
  */
 void XLXmlFile::setXmlData(const std::string& xmlData) // NOLINT
 {
@@ -55,7 +55,7 @@ namespace OpenXLSX
     // ===== Copy definition of PUGI_IMPL_NODETYPE, which is defined in pugixml.cpp, within namespace pugi::impl(?), and somehow doesn't work here
 #   define PUGI_IMPL_NODETYPE(n) static_cast<pugi::xml_node_type>((n)->header & pugi::impl::xml_memory_page_type_mask)
 
-    bool NO_XML_NS = true; // default: no XML namespaces
+    std::atomic<bool> NO_XML_NS {true}; // default: no XML namespaces
     /**
      * @details this function is meaningless when PUGI_AUGMENTED is not defined / used
      */
@@ -87,7 +87,7 @@ namespace OpenXLSX
      */
     const pugi::char_t* XMLNode::name_without_namespace(const pugi::char_t* name_) const
     {
-        if (NO_XML_NS) return name_;    // if node namespaces are not stripped: return immediately
+        if (NO_XML_NS.load(std::memory_order_relaxed)) return name_;    // if node namespaces are not stripped: return immediately
         int pos = 0;
         while (name_[pos] && name_[pos] != ':') ++pos;    // find namespace delimiter
         if (!name_[pos]) return name_;                    // if no delimiter found: return unmodified name
@@ -95,8 +95,8 @@ namespace OpenXLSX
     }
 
     /**
-     * @details for creation of node children: copy this node's namespace without thread safety, using
-     *  a static character array to avoid smart pointer performance impact
+     * @details for creation of node children: copy this node's namespace, using a thread_local character array to avoid
+     *  smart pointer performance impact - the result is valid until the next call on the same thread
      */
     const pugi::char_t* XMLNode::namespaced_name_char(const pugi::char_t* name_, bool force_ns) const
     {
@@ -107,7 +107,7 @@ namespace OpenXLSX
         throw XLException("OpenXLSX_xml_node::"s + __func__ + ": strlen of "s + name_ + " exceeds XLMaxNamespacedNameLen "s + std::to_string(XLMaxNamespacedNameLen));
         }
 
-        static pugi::char_t namespaced_name_[ XLMaxNamespacedNameLen + 1 ]; // static memory allocation for concatenating node namespace and name_
+        thread_local pugi::char_t namespaced_name_[ XLMaxNamespacedNameLen + 1 ]; // per-thread memory for concatenating node namespace and name_
 
         // ===== If node has a namespace: create a namespaced version of name_
         memcpy(namespaced_name_, xml_node::name(), name_begin);    // copy the node namespace
@@ -44,10 +44,21 @@ YM      M9  MM    MM MM       MM    MM   d'  `MM.    MM            MM   d'  `MM.
  */
 
 // ===== External Includes ===== //
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <mutex>
 #include <zippy.hpp>
+#ifdef ENABLE_NOWIDE
+#    include <nowide/fstream.hpp>
+#endif
 
 // ===== OpenXLSX Includes ===== //
+#include "XLException.hpp"
 #include "XLZipArchive.hpp"
+#include "utilities/XLStatsRecorder.hpp"
+#include "utilities/XLTemplateArchive.hpp"
 
 using namespace OpenXLSX;
 
@@ -109,6 +120,10 @@ void XLZipArchive::close()
 void XLZipArchive::save(const std::string& path) // NOLINT
 {
     m_archive->Save(path);
+#ifdef OPENXLSX_ENABLE_STATS
+    const auto durations  = m_archive->LastSaveDurations();
+    archiveSaveDurations() = XLArchiveSaveDurations { true, static_cast<uint64_t>(durations.first), static_cast<uint64_t>(durations.second) };
+#endif
 }
 
 /**
@@ -127,11 +142,19 @@ void XLZipArchive::deleteEntry(const std::string& entryName) // NOLINT
     m_archive->DeleteEntry(entryName);
 }
 
+/**
+ * @details
+ */
+size_t XLZipArchive::cachedDataSize() const { return isOpen() ? m_archive->CachedDataSize() : 0; }
+
 /**
  * @details
  */
 std::string XLZipArchive::getEntry(const std::string& name) const {
-    return m_archive->GetEntry(name).GetDataAsString();
+    Zippy::ZipEntry entry = m_archive->GetEntry(name);
+    std::string data = entry.GetDataAsString();
+    entry.ReleaseData();    // the caller keeps (or parses) the returned copy - don't keep a second, inflated copy in the archive
+    return data;
 }
 
 /**
@@ -140,3 +163,293 @@ std::string XLZipArchive::getEntry(const std::string& name) const {
 bool XLZipArchive::hasEntry(const std::string& entryName) const {
     return m_archive->HasEntry(entryName);
 }
+
+/**
+ * @details
+ */
+std::string XLZipArchive::compressData(const std::string& data) {
+    using namespace ns_miniz;
+    mz_ulong    size = mz_compressBound(static_cast<mz_ulong>(data.size()));
+    std::string result(size, '\0');
+    if (mz_compress2(reinterpret_cast<unsigned char*>(&result[0]), &size, reinterpret_cast<const unsigned char*>(data.data()),
+                     static_cast<mz_ulong>(data.size()), MZ_BEST_SPEED) != MZ_OK)
+        throw XLInternalError("XLZipArchive::compressData: compression failed");
+    result.resize(size);
+    return result;
+}
+
+/**
+ * @details
+ */
+std::string XLZipArchive::decompressData(const std::string& data, size_t size) {
+    using namespace ns_miniz;
+    std::string result(size, '\0');
+    mz_ulong    length = static_cast<mz_ulong>(size);
+    if (mz_uncompress(reinterpret_cast<unsigned char*>(&result[0]), &length, reinterpret_cast<const unsigned char*>(data.data()),
+                      static_cast<mz_ulong>(data.size())) != MZ_OK || length != size)
+        throw XLInternalError("XLZipArchive::decompressData: data is corrupt");
+    return result;
+}
+
+// ========== XLTemplateArchive - implemented here, as zippy.hpp (and the miniz implementation it contains) can only be
+//             included by one translation unit
+
+/**
+ * @brief The package read by XLTemplateArchive::open, shared by all forks
+ */
+struct XLTemplateArchive::Source
+{
+    struct Entry
+    {
+        ns_miniz::mz_uint index;    /**< The file index in the package */
+        size_t            size;     /**< The uncompressed size */
+    };
+
+    std::string                            bytes {};      /**< The package, as read from disk */
+    ns_miniz::mz_zip_archive               reader {};     /**< A miniz reader on bytes */
+    std::unordered_map<std::string, Entry> index {};      /**< The file entries, by name; the last of duplicate names wins */
+    std::vector<std::string>               order {};      /**< The names of the file entries, in package order */
+    mutable std::mutex                     mutex {};      /**< Serializes the use of reader */
+
+    Source()                         = default;
+    Source(const Source&)            = delete;
+    Source& operator=(const Source&) = delete;
+    ~Source() { ns_miniz::mz_zip_reader_end(&reader); }
+
+    const Entry* find(const std::string& name) const
+    {
+        const auto result = index.find(name);
+        return result == index.end() ? nullptr : &result->second;
+    }
+};
+
+namespace    // anonymous namespace for module local functions
+{
+    /**
+     * @brief Read a file into a string
+     * @throws XLInputError if the file can not be read
+     */
+    std::string readFile(const std::string& fileName)
+    {
+#ifdef ENABLE_NOWIDE
+        nowide::ifstream infile(fileName, std::ios::binary);
+#else
+        std::ifstream infile(fileName, std::ios::binary);
+#endif
+        if (not infile) throw XLInputError("XLTemplateArchive: unable to read " + fileName);
+        return std::string(std::istreambuf_iterator<char>(infile), std::istreambuf_iterator<char>());
+    }
+
+    /**
+     * @brief Get a temporary file name in the directory of path, like Zippy::ZipArchive::Save
+     */
+    std::string temporaryPath(const std::string& path)
+    {
+        const size_t separator = path.find_last_of("/\\");
+        return (separator == std::string::npos ? std::string("./") : path.substr(0, separator + 1)) + Zippy::Impl::GenerateRandomName(20);
+    }
+
+    /**
+     * @brief Deflate data and add it to writer as the entry name
+     * @details miniz stamps each new entry using localtime(), which is not reentrant. Forks of one template are typically saved
+     *  on several threads at once, so the data is deflated first, and only the (cheap) adding of the deflated data is serialized.
+     */
+    bool addDeflatedEntry(ns_miniz::mz_zip_archive& writer, const std::string& name, const std::string& data)
+    {
+        using namespace ns_miniz;
+        static std::mutex timeMutex;
+
+        const int flags    = static_cast<int>(tdefl_create_comp_flags_from_zip_params(MZ_DEFAULT_LEVEL, -MZ_DEFAULT_WINDOW_BITS, MZ_DEFAULT_STRATEGY));
+        size_t    size     = 0;
+        void*     deflated = data.empty() ? nullptr : tdefl_compress_mem_to_heap(data.data(), data.size(), &size, flags);
+        if (deflated == nullptr) {
+            std::lock_guard<std::mutex> lock(timeMutex);
+            return mz_zip_writer_add_mem(&writer, name.c_str(), data.data(), data.size(), MZ_NO_COMPRESSION);
+        }
+
+        const auto crc = static_cast<mz_uint32>(mz_crc32(MZ_CRC32_INIT, reinterpret_cast<const mz_uint8*>(data.data()), data.size()));
+        mz_bool    result;
+        {
+            std::lock_guard<std::mutex> lock(timeMutex);
+            result = mz_zip_writer_add_mem_ex(&writer, name.c_str(), deflated, size, nullptr, 0, MZ_DEFAULT_LEVEL | MZ_ZIP_FLAG_COMPRESSED_DATA, data.size(), crc);
+        }
+        mz_free(deflated);
+        return result != MZ_FALSE;
+    }
+}    // anonymous namespace
+
+/**
+ * @details
+ */
+XLTemplateArchive::XLTemplateArchive() : m_state(std::make_shared<State>()) {}
+
+/**
+ * @details
+ */
+XLTemplateArchive::~XLTemplateArchive() = default;
+
+/**
+ * @details The changes recorded so far are copied, so that the fork sees the same entries as this archive.
+ */
+XLTemplateArchive XLTemplateArchive::fork() const
+{
+    if (not isOpen()) throw XLInternalError("XLTemplateArchive::fork: archive is not open");
+    XLTemplateArchive result;
+    *result.m_state = *m_state;
+    return result;
+}
+
+/**
+ * @details
+ */
+size_t XLTemplateArchive::sourceSize() const { return isOpen() ? m_state->source->bytes.size() : 0; }
+
+/**
+ * @details
+ */
+bool XLTemplateArchive::isValid() const { return m_state->source != nullptr; }
+
+/**
+ * @details
+ */
+bool XLTemplateArchive::isOpen() const { return isValid(); }
+
+/**
+ * @details The state is modified in place, so that copies of this archive (e.g. the one held by XLTemplatePackage::document)
+ *  keep sharing it.
+ */
+void XLTemplateArchive::open(const std::string& fileName)
+{
+    using namespace ns_miniz;
+    auto source   = std::make_shared<Source>();
+    source->bytes = readFile(fileName);
+    if (not mz_zip_reader_init_mem(&source->reader, source->bytes.data(), source->bytes.size(), 0))
+        throw XLInputError("XLTemplateArchive: " + fileName + " is not a valid zip archive: " +
+                           mz_zip_get_error_string(mz_zip_get_last_error(&source->reader)));
+
+    for (mz_uint i = 0; i < mz_zip_reader_get_num_files(&source->reader); ++i) {
+        mz_zip_archive_file_stat info;
+        if (not mz_zip_reader_file_stat(&source->reader, i, &info))
+            throw XLInputError("XLTemplateArchive: unable to read the directory of " + fileName);
+        if (info.m_is_directory) continue;
+        const auto [entry, inserted] = source->index.insert_or_assign(info.m_filename, Source::Entry { i, static_cast<size_t>(info.m_uncomp_size) });
+        if (inserted) source->order.emplace_back(entry->first);
+    }
+
+    *m_state        = State();
+    m_state->source = std::move(source);
+}
+
+/**
+ * @details
+ */
+void XLTemplateArchive::close() { *m_state = State(); }
+
+/**
+ * @details The package is written to a temporary file next to path, which then replaces path. Unchanged entries are copied
+ *  with their compressed data, in package order, followed by the entries added since.
+ */
+void XLTemplateArchive::save(const std::string& path)
+{
+    using namespace ns_miniz;
+    if (not isOpen()) throw XLInternalError("XLTemplateArchive::save: archive is not open");
+    const Source&     source   = *m_state->source;
+    const std::string tempPath = temporaryPath(path);
+
+    mz_zip_archive writer {};
+    if (not mz_zip_writer_init_file(&writer, tempPath.c_str(), 0))
+        throw XLException("XLTemplateArchive::save: unable to create " + tempPath + ": " + mz_zip_get_error_string(writer.m_last_error));
+
+    auto writeEntry = [&](const std::string& name) {
+        if (const auto changed = m_state->entries.find(name); changed != m_state->entries.end())
+            return addDeflatedEntry(writer, name, changed->second);
+        std::lock_guard<std::mutex> lock(source.mutex);
+        return mz_zip_writer_add_from_zip_reader(&writer, const_cast<mz_zip_archive*>(&source.reader), source.find(name)->index) != MZ_FALSE;
+    };
+
+    bool written = true;
+    for (const auto& name : source.order)
+        if (m_state->deleted.count(name) == 0 && not(written = writeEntry(name))) break;
+    for (size_t i = 0; written && i < m_state->added.size(); ++i) written = writeEntry(m_state->added[i]);
+    written = written && mz_zip_writer_finalize_archive(&writer);
+    const std::string error = mz_zip_get_error_string(writer.m_last_error);
+    mz_zip_writer_end(&writer);
+
+    mz_zip_error validation = MZ_ZIP_NO_ERROR;
+    if (written && not mz_zip_validate_file_archive(tempPath.c_str(), MZ_ZIP_FLAG_VALIDATE_HEADERS_ONLY, &validation)) written = false;
+    if (not written) {
+        std::remove(tempPath.c_str());
+        throw XLException("XLTemplateArchive::save: unable to write " + path + ": " +
+                          (validation != MZ_ZIP_NO_ERROR ? mz_zip_get_error_string(validation) : error));
+    }
+
+    std::remove(path.c_str());
+    if (std::rename(tempPath.c_str(), path.c_str()) != 0) {
+        std::remove(tempPath.c_str());
+        throw XLException("XLTemplateArchive::save: unable to replace " + path);
+    }
+}
+
+/**
+ * @details
+ */
+void XLTemplateArchive::addEntry(const std::string& name, const std::string& data)
+{
+    if (not isOpen()) throw XLInternalError("XLTemplateArchive::addEntry: archive is not open");
+    const bool existing = m_state->entries.count(name) > 0;
+    m_state->entries[name] = data;
+    m_state->deleted.erase(name);
+    if (not existing && m_state->source->find(name) == nullptr) m_state->added.push_back(name);
+}
+
+/**
+ * @details
+ */
+void XLTemplateArchive::deleteEntry(const std::string& entryName)
+{
+    if (not isOpen()) throw XLInternalError("XLTemplateArchive::deleteEntry: archive is not open");
+    if (m_state->entries.erase(entryName) > 0) {
+        auto& added = m_state->added;
+        added.erase(std::remove(added.begin(), added.end(), entryName), added.end());
+    }
+    if (m_state->source->find(entryName) != nullptr) m_state->deleted.insert(entryName);
+}
+
+/**
+ * @details
+ */
+std::string XLTemplateArchive::getEntry(const std::string& name) const
+{
+    using namespace ns_miniz;
+    if (not hasEntry(name)) throw XLInternalError("XLTemplateArchive::getEntry: entry " + name + " does not exist");
+    if (const auto changed = m_state->entries.find(name); changed != m_state->entries.end()) return changed->second;
+
+    const Source&       source = *m_state->source;
+    const Source::Entry entry  = *source.find(name);
+    std::string         data(entry.size, '\0');
+    std::lock_guard<std::mutex> lock(source.mutex);
+    if (entry.size > 0 &&
+        not mz_zip_reader_extract_to_mem(const_cast<mz_zip_archive*>(&source.reader), entry.index, data.data(), data.size(), 0))
+        throw XLInternalError("XLTemplateArchive::getEntry: unable to extract " + name);
+    return data;
+}
+
+/**
+ * @details
+ */
+bool XLTemplateArchive::hasEntry(const std::string& entryName) const
+{
+    if (not isOpen()) return false;
+    if (m_state->entries.count(entryName) > 0) return true;
+    return m_state->source->find(entryName) != nullptr && m_state->deleted.count(entryName) == 0;
+}
+
+/**
+ * @details The package itself is shared, and is reported by XLTemplate::packageSize.
+ */
+size_t XLTemplateArchive::cachedDataSize() const
+{
+    size_t result = 0;
+    for (const auto& [name, data] : m_state->entries) result += data.capacity();
+    return result;
+}
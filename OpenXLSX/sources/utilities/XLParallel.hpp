@@ -0,0 +1,64 @@
+//
+// The thread pool shared by XLWorksheet::parallelForRows and the parallel loading and saving of XLDocument
+//
+
+#ifndef OPENXLSX_XLPARALLEL_HPP
+#define OPENXLSX_XLPARALLEL_HPP
+
+#include <algorithm>     // std::min, std::max
+#include <atomic>        // std::atomic
+#include <exception>     // std::exception_ptr, std::current_exception, std::rethrow_exception
+#include <functional>    // std::function
+#include <mutex>         // std::mutex, std::lock_guard
+#include <thread>        // std::thread
+#include <vector>        // std::vector
+
+namespace OpenXLSX
+{
+    /**
+     * @brief Call task(0) .. task(count - 1) on up to threads threads, the calling thread being one of them
+     * @param count the number of tasks
+     * @param threads the maximum number of threads, at least one is used
+     * @param task the function to call with each task index - the tasks are taken in ascending order from a shared counter
+     * @param cancel if not nullptr, no further task is started once *cancel is set
+     * @details No further task is started once a task has thrown. The first exception is rethrown after all threads finished.
+     *  Should starting a thread fail, the threads already started are stopped after their current task and joined, before the
+     *  exception is rethrown - a std::thread must never be destroyed while it is joinable.
+     */
+    inline void runParallel(size_t count, unsigned threads, const std::function<void(size_t)>& task, const std::atomic<bool>* cancel = nullptr)
+    {
+        std::atomic<size_t> next {0};
+        std::atomic<bool>   failed {false};
+        std::exception_ptr  error;
+        std::mutex          errorMutex;
+
+        auto worker = [&]() {
+            try {
+                for (size_t i = next++; i < count && not failed && not(cancel != nullptr && *cancel); i = next++) task(i);
+            }
+            catch (...) {
+                std::lock_guard<std::mutex> lock(errorMutex);
+                if (not error) error = std::current_exception();
+                failed = true;
+            }
+        };
+
+        threads = static_cast<unsigned>(std::min<size_t>(std::max(threads, 1u), std::max<size_t>(count, 1)));
+        std::vector<std::thread> pool;
+        try {
+            pool.reserve(threads - 1);
+            for (unsigned t = 1; t < threads; ++t) pool.emplace_back(worker);
+        }
+        catch (...) {
+            failed = true;
+            for (auto& thread : pool) thread.join();
+            throw;
+        }
+
+        worker();
+        for (auto& thread : pool) thread.join();
+        if (error) std::rethrow_exception(error);
+    }
+}    // namespace OpenXLSX
+
+#endif    // OPENXLSX_XLPARALLEL_HPP
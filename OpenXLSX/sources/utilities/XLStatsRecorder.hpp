@@ -0,0 +1,94 @@
+//
+// The recording side of the instrumentation behind XLDocument::stats()
+//
+
+#ifndef OPENXLSX_XLSTATSRECORDER_HPP
+#define OPENXLSX_XLSTATSRECORDER_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <utility>
+
+#include "XLStats.hpp"
+
+namespace OpenXLSX
+{
+    /**
+     * @brief The process wide counters, see XLStatsCounters
+     */
+    struct XLStatsCounterSet
+    {
+        std::atomic<uint64_t> sharedStringLookups {0};
+        std::atomic<uint64_t> rowNodesCreated {0};
+        std::atomic<uint64_t> cellNodesCreated {0};
+        std::atomic<uint64_t> cacheHits {0};
+    };
+
+    /**
+     * @brief Get the process wide counters
+     */
+    XLStatsCounterSet& statsCounters();
+
+    /**
+     * @brief The durations of the steps of the last archive save on this thread, reported by XLZipArchive::save
+     * @details The archive is type-erased behind IZipArchive, so the split of its save into XLStatsPhase::Deflate and
+     *  XLStatsPhase::Validate is handed to the document through this thread local slot. An archive that does not report leaves
+     *  reported == false, and the whole save counts as XLStatsPhase::Deflate.
+     */
+    struct XLArchiveSaveDurations
+    {
+        bool     reported {false};
+        uint64_t deflate {0};
+        uint64_t validate {0};
+    };
+
+    /**
+     * @brief Get the archive save durations slot of the calling thread
+     */
+    XLArchiveSaveDurations& archiveSaveDurations();
+
+    /**
+     * @brief Records the time from its construction to its destruction as a run of a phase
+     */
+    class XLStatsTimer
+    {
+    public:
+        XLStatsTimer(XLStatsCollector* collector, XLStatsPhase phase, std::string part)
+            : m_collector(collector), m_phase(phase), m_part(std::move(part)), m_start(XLStatsCollector::now()) {}
+
+        XLStatsTimer(const XLStatsTimer&)            = delete;
+        XLStatsTimer& operator=(const XLStatsTimer&) = delete;
+
+        ~XLStatsTimer()
+        {
+            if (m_collector == nullptr) return;
+            try {
+                m_collector->record(m_phase, m_part, m_start, XLStatsCollector::now() - m_start, m_bytes);
+            }
+            catch (...) {}    // the instrumentation must never throw from a destructor
+        }
+
+        void setBytes(uint64_t bytes) { m_bytes = bytes; }
+
+    private:
+        XLStatsCollector* m_collector;
+        XLStatsPhase      m_phase;
+        std::string       m_part;
+        uint64_t          m_start;
+        uint64_t          m_bytes {0};
+    };
+}    // namespace OpenXLSX
+
+// ===== The instrumentation points. Without OPENXLSX_ENABLE_STATS they expand to nothing, and their arguments are not evaluated
+#ifdef OPENXLSX_ENABLE_STATS
+#   define OPENXLSX_STATS_COUNT(counter) (OpenXLSX::statsCounters().counter.fetch_add(1, std::memory_order_relaxed))
+#   define OPENXLSX_STATS_TIMER(name, collector, phase, part) OpenXLSX::XLStatsTimer name((collector), (phase), (part))
+#   define OPENXLSX_STATS_BYTES(name, bytes) name.setBytes(bytes)
+#else
+#   define OPENXLSX_STATS_COUNT(counter) ((void)0)
+#   define OPENXLSX_STATS_TIMER(name, collector, phase, part) ((void)0)
+#   define OPENXLSX_STATS_BYTES(name, bytes) ((void)0)
+#endif
+
+#endif    // OPENXLSX_XLSTATSRECORDER_HPP
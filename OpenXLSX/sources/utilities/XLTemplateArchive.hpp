@@ -0,0 +1,75 @@
+//
+// The archive behind XLTemplate and the documents forked from it
+//
+
+#ifndef OPENXLSX_XLTEMPLATEARCHIVE_HPP
+#define OPENXLSX_XLTEMPLATEARCHIVE_HPP
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace OpenXLSX
+{
+    /**
+     * @brief A zip archive held in memory, whose entries can be shared by any number of copy-on-write forks
+     * @details open() reads the whole package into an immutable source. Entries that are added, replaced or deleted are recorded
+     *  by the archive instance only, on top of the source. save() copies the compressed data of all unchanged entries from the
+     *  source, so that they are neither inflated nor deflated again, and compresses the changed entries.
+     *  The source may be read by forks on different threads; reads are serialized internally. A single archive instance (and
+     *  its copies, which share its changes like copies of XLZipArchive do) is not thread safe.
+     */
+    class XLTemplateArchive
+    {
+    public:
+        XLTemplateArchive();
+        XLTemplateArchive(const XLTemplateArchive& other)            = default;
+        XLTemplateArchive(XLTemplateArchive&& other)                 = default;
+        XLTemplateArchive& operator=(const XLTemplateArchive& other) = default;
+        XLTemplateArchive& operator=(XLTemplateArchive&& other)      = default;
+        ~XLTemplateArchive();
+
+        /**
+         * @brief Create a new archive on the same source, starting out with the changes recorded by this archive
+         * @throws XLInternalError if the archive is not open
+         */
+        XLTemplateArchive fork() const;
+
+        /**
+         * @brief Get the size of the package held in memory
+         */
+        size_t sourceSize() const;
+
+        // ===== The IZipArchive interface
+        bool        isValid() const;
+        bool        isOpen() const;
+        void        open(const std::string& fileName);
+        void        close();
+        void        save(const std::string& path);
+        void        addEntry(const std::string& name, const std::string& data);
+        void        deleteEntry(const std::string& entryName);
+        std::string getEntry(const std::string& name) const;
+        bool        hasEntry(const std::string& entryName) const;
+        size_t      cachedDataSize() const;
+
+    private:
+        struct Source;
+
+        /**
+         * @brief The changes of an archive relative to its source
+         */
+        struct State
+        {
+            std::shared_ptr<Source>                      source {};
+            std::unordered_map<std::string, std::string> entries {};    /**< Entries added or replaced, by name */
+            std::vector<std::string>                     added {};      /**< The names of entries not in the source, in order */
+            std::unordered_set<std::string>              deleted {};    /**< Source entries that were deleted */
+        };
+
+        std::shared_ptr<State> m_state {};
+    };
+}    // namespace OpenXLSX
+
+#endif    // OPENXLSX_XLTEMPLATEARCHIVE_HPP
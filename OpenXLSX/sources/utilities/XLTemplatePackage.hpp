@@ -0,0 +1,26 @@
+//
+// The content of an XLTemplate, shared by XLTemplate and XLDocument::open(const XLTemplate&)
+//
+
+#ifndef OPENXLSX_XLTEMPLATEPACKAGE_HPP
+#define OPENXLSX_XLTEMPLATEPACKAGE_HPP
+
+#include <string>
+
+#include "XLDocument.hpp"
+#include "XLTemplateArchive.hpp"
+
+namespace OpenXLSX
+{
+    /**
+     * @brief The content of an XLTemplate: a document opened on an XLTemplateArchive, which is never modified after opening
+     */
+    struct XLTemplatePackage
+    {
+        std::string       fileName {};
+        XLTemplateArchive archive {};
+        XLDocument        document {IZipArchive(archive)};    /**< Shares the state of archive */
+    };
+}    // namespace OpenXLSX
+
+#endif    // OPENXLSX_XLTEMPLATEPACKAGE_HPP
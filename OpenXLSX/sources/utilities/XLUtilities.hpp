@@ -5,6 +5,9 @@
 #ifndef OPENXLSX_XLUTILITIES_HPP
 #define OPENXLSX_XLUTILITIES_HPP
 
+#include <charconv>     // std::from_chars
+#include <cstdlib>      // std::strtod
+#include <cstring>      // std::memcpy, std::strlen
 #include <fstream>
 #include <pugixml.hpp>
 #include <string>       // 2024-04-25 needed for xml_node_type_string
@@ -16,6 +19,7 @@
 #include "XLCellValue.hpp"        // OpenXLSX::XLValueType
 #include "XLContentTypes.hpp"     // OpenXLSX::XLContentType
 #include "XLRelationships.hpp"    // OpenXLSX::XLRelationshipType
+#include "XLStatsRecorder.hpp"    // OPENXLSX_STATS_COUNT
 #include "XLStyles.hpp"           // OpenXLSX::XLStyleIndex
 #include "XLXmlParser.hpp"
 
@@ -163,6 +167,7 @@ namespace OpenXLSX
         if (result.empty() || (rowNumber > result.attribute("r").as_ullong())) {
             result = sheetDataNode.append_child("row");
             result.append_attribute("r") = rowNumber;
+            OPENXLSX_STATS_COUNT(rowNodesCreated);
             //            result.append_attribute("x14ac:dyDescent") = "0.2";
             //            result.append_attribute("spans")           = "1:1";
         }
@@ -177,6 +182,7 @@ namespace OpenXLSX
                 else
                     result = sheetDataNode.insert_child_after("row", result);
                 result.append_attribute("r") = rowNumber;
+                OPENXLSX_STATS_COUNT(rowNodesCreated);
                 //                result.append_attribute("x14ac:dyDescent") = "0.2";
                 //                result.append_attribute("spans")           = "1:1";
             }
@@ -194,6 +200,7 @@ namespace OpenXLSX
                 result = sheetDataNode.insert_child_before("row", result);
 
                 result.append_attribute("r") = rowNumber;
+                OPENXLSX_STATS_COUNT(rowNodesCreated);
                 //                result.append_attribute("x14ac:dyDescent") = "0.2";
                 //                result.append_attribute("spans")           = "1:1";
             }
@@ -231,10 +238,12 @@ namespace OpenXLSX
      * @param colNo the column number for this cell (to try and fetch a column style)
      * @param colStyles an optional std::vector<XLStyleIndex> that contains all pre-evaluated column styles,
      *         and can be used to avoid performance impact from lookup
+     * @note called for each newly created cell node, which is counted as XLStatsCounters::cellNodesCreated
      */
     inline void setDefaultCellAttributes(XMLNode cellNode, const std::string & cellRef, XMLNode rowNode, uint16_t colNo,
     /**/                                 std::vector<XLStyleIndex> const & colStyles = {})
     {
+        OPENXLSX_STATS_COUNT(cellNodesCreated);
         cellNode.append_attribute("r").set_value(cellRef.c_str());
         XMLAttribute rowStyle = rowNode.attribute("s");
         XLStyleIndex cellStyle;    // scope declaration
@@ -474,6 +483,158 @@ namespace OpenXLSX
         return valAttr.as_bool(); // return attribute value
     }
 
+    /**
+     * @brief Parse 8 ASCII digits at once (SWAR)
+     * @param chars pointer to at least 8 readable characters
+     * @param value receives the value of the 8 digits
+     * @return true if all 8 characters are digits, false otherwise
+     * @note On big endian targets, this falls back to a scalar loop
+     */
+    inline bool parseEightDigits(const char* chars, uint64_t& value)
+    {
+#if (defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__) || defined(_WIN32)
+        uint64_t word;
+        std::memcpy(&word, chars, sizeof(word));
+        // ===== All bytes must be in '0'..'9': the high nibble is 3, and adding 6 does not carry into it
+        if ((word & 0xF0F0F0F0F0F0F0F0ULL) != 0x3030303030303030ULL) return false;
+        if (((word + 0x0606060606060606ULL) & 0xF0F0F0F0F0F0F0F0ULL) != 0x3030303030303030ULL) return false;
+        word -= 0x3030303030303030ULL;
+        word  = (word * 10 + (word >> 8)) & 0x00FF00FF00FF00FFULL;
+        word  = (word * 100 + (word >> 16)) & 0x0000FFFF0000FFFFULL;
+        value = (word * 10000 + (word >> 32)) & 0xFFFFFFFFULL;
+        return true;
+#else
+        value = 0;
+        for (int i = 0; i < 8; ++i) {
+            if (chars[i] < '0' || chars[i] > '9') return false;
+            value = value * 10 + static_cast<uint64_t>(chars[i] - '0');
+        }
+        return true;
+#endif
+    }
+
+    /**
+     * @brief Decode the text of a numeric <v> node
+     * @param text the node text
+     * @param value receives the decoded value
+     * @return false if text is not a number
+     * @note Numbers with up to 19 significant digits and a decimal exponent within +/-22 are decoded without strtod: the
+     *        mantissa (if <= 2^53) and the power of ten are both exact doubles, so a single multiplication or division is
+     *        correctly rounded. Everything else (e.g. the 17 digit round-trip output of most writers) is handed to
+     *        std::from_chars, or to strtod if the standard library lacks floating point from_chars.
+     */
+    inline bool parseNumber(const char* text, double& value)
+    {
+        static constexpr double powersOfTen[] = { 1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+                                                  1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+
+        const char* const end      = text + std::strlen(text);
+        const char*       pos      = text;
+        const bool        negative = (pos != end && *pos == '-');
+        if (negative || (pos != end && *pos == '+')) ++pos;
+
+        uint64_t mantissa  = 0;
+        int      digits    = 0;    // significant digits accumulated in mantissa
+        int      exponent  = 0;
+        bool     anyDigits = false;
+        bool     exact     = true;
+
+        const auto appendDigits = [&](bool fraction) {
+            for (; pos != end && *pos == '0' && digits == 0; ++pos) {    // leading zeros are not significant
+                anyDigits = true;
+                if (fraction) --exponent;
+            }
+            uint64_t eight = 0;
+            while (end - pos >= 8 && digits <= 11 && parseEightDigits(pos, eight)) {
+                mantissa = mantissa * 100'000'000 + eight;
+                digits += 8;
+                pos += 8;
+                anyDigits = true;
+                if (fraction) exponent -= 8;
+            }
+            for (; pos != end && *pos >= '0' && *pos <= '9'; ++pos) {
+                anyDigits = true;
+                if (digits < 19) {
+                    mantissa = mantissa * 10 + static_cast<uint64_t>(*pos - '0');
+                    ++digits;
+                    if (fraction) --exponent;
+                }
+                else {
+                    exact = false;
+                    if (not fraction) ++exponent;
+                }
+            }
+        };
+
+        appendDigits(false);
+        if (pos != end && *pos == '.') {
+            ++pos;
+            appendDigits(true);
+        }
+        if (not anyDigits) return false;
+
+        if (pos != end && (*pos == 'e' || *pos == 'E')) {
+            ++pos;
+            const bool negativeExponent = (pos != end && *pos == '-');
+            if (negativeExponent || (pos != end && *pos == '+')) ++pos;
+            if (pos == end || *pos < '0' || *pos > '9') return false;
+            int explicitExponent = 0;
+            for (; pos != end && *pos >= '0' && *pos <= '9'; ++pos)
+                if (explicitExponent < 100'000) explicitExponent = explicitExponent * 10 + (*pos - '0');
+            exponent += negativeExponent ? -explicitExponent : explicitExponent;
+        }
+        if (pos != end) return false;    // trailing characters
+
+        if (exact && mantissa <= (1ULL << 53) && exponent >= -22 && exponent <= 22) {
+            value = static_cast<double>(mantissa);
+            value = exponent < 0 ? value / powersOfTen[-exponent] : value * powersOfTen[exponent];
+            if (negative) value = -value;
+            return true;
+        }
+
+#if defined(__cpp_lib_to_chars)    // floating point from_chars is locale independent and much faster than strtod
+        const auto [parsedEnd, error] = std::from_chars(text[0] == '+' ? text + 1 : text, end, value);
+        return error == std::errc() && parsedEnd == end;
+#else
+        char* parsedEnd = nullptr;
+        value           = std::strtod(text, &parsedEnd);
+        return parsedEnd == end;
+#endif
+    }
+
+    /**
+     * @brief Determine the column number of a cell node from the letters of its r attribute, without constructing an XLCellReference
+     * @param cellNode a <c> node
+     * @return the column number, or 0 if cellNode is empty or has no r attribute
+     */
+    inline uint16_t cellNodeColumn(const XMLNode& cellNode)
+    {
+        uint32_t column = 0;
+        for (const char* ref = cellNode.attribute("r").value(); *ref >= 'A' && *ref <= 'Z'; ++ref) column = column * 26 + (*ref - 'A' + 1);
+        return static_cast<uint16_t>(column);
+    }
+
+    /**
+     * @brief get the heap memory held by a string
+     * @return the allocated capacity, 0 if the string is short enough to be stored within the string object
+     */
+    inline size_t heapSize(const std::string& str)
+    {
+        const char* data   = str.data();
+        const char* object = reinterpret_cast<const char*>(&str);
+        return (data >= object && data < object + sizeof(std::string)) ? 0 : str.capacity() + 1;
+    }
+
+    /**
+     * @brief get the heap memory held by the elements of a vector (not counting memory owned by the elements)
+     */
+    template<typename T>
+    inline size_t heapSize(const std::vector<T>& vec) { return vec.capacity() * sizeof(T); }
+
+    /**
+     * @brief get the heap memory held by a std::vector<bool>, which packs its elements into bits
+     */
+    inline size_t heapSize(const std::vector<bool>& vec) { return vec.capacity() / 8; }
 }    // namespace OpenXLSX
 
 #endif    // OPENXLSX_XLUTILITIES_HPP
@@ -0,0 +1,39 @@
+//
+// Counts the calls to the global allocation functions, see XLAllocationCounter.cpp
+//
+
+#ifndef OPENXLSX_XLALLOCATIONCOUNTER_HPP
+#define OPENXLSX_XLALLOCATIONCOUNTER_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief Get the number of calls to the global operator new (all forms) since the start of the process
+ * @note pugixml allocates the XML nodes through its own allocation functions (malloc by default), so the count is the
+ *  allocations made by OpenXLSX and the standard library: the XMLNode wrappers, strings, vectors and maps.
+ */
+uint64_t allocationCount();
+
+/**
+ * @brief Get the number of bytes requested from the global operator new since the start of the process
+ */
+uint64_t allocatedBytes();
+
+/**
+ * @brief Counts the allocations made on any thread between its construction and the calls to its accessors
+ */
+class XLAllocationScope
+{
+public:
+    XLAllocationScope() : m_count(allocationCount()), m_bytes(allocatedBytes()) {}
+
+    uint64_t count() const { return allocationCount() - m_count; }
+    uint64_t bytes() const { return allocatedBytes() - m_bytes; }
+
+private:
+    uint64_t m_count;
+    uint64_t m_bytes;
+};
+
+#endif    // OPENXLSX_XLALLOCATIONCOUNTER_HPP
@@ -0,0 +1,91 @@
+#include <OpenXLSX.hpp>
+#include <catch.hpp>
+#include <vector>
+
+#include "XLAllocationCounter.hpp"
+
+using namespace OpenXLSX;
+
+// ===== The allocation budgets of the canonical loops, as measured when the tests were written. When an optimization removes
+// ===== allocations, lower the budget, so that the improvement cannot silently regress.
+namespace
+{
+    constexpr uint64_t perCellIterated  = 1;     // the XLCell held by the range iterator wraps its node in a std::unique_ptr
+    constexpr uint64_t perCellAssigned  = 1;     // as above; the nodes themselves are allocated by pugixml
+    constexpr uint64_t perRowRead       = 12;    // the vector, the row data range and its iterators, one XLCell per cell
+    constexpr uint64_t perCellLookup    = 2;     // XLWorksheet::cell creates an XLCell and the row lookup an XLRow
+    constexpr uint64_t rowViewsSetup    = 32;    // XLWorksheet::parallelForRows: the row index, independent of the row count
+    constexpr uint64_t loopOverhead     = 8;     // begin / end iterators and the like, once per loop
+}    // namespace
+
+TEST_CASE("XLAllocation Tests", "[XLAllocations]")
+{
+    XLDocument doc;
+    doc.create("./testXLAllocations.xlsx", XLForceOverwrite);
+    XLWorksheet wks = doc.workbook().worksheet("Sheet1");
+
+    constexpr uint32_t rows  = 100000;
+    constexpr uint16_t cols  = 10;
+    constexpr uint64_t cells = uint64_t { rows } * cols;    // 1M
+    XLCellRange        range = wks.range(XLCellReference(1, 1), XLCellReference(rows, cols));
+
+    // ===== Set 1M numeric values, creating the cells
+    {
+        XLAllocationScope scope;
+        for (auto& cell : range) cell.value() = 1.5;
+        REQUIRE(scope.count() <= cells * perCellAssigned + loopOverhead);
+    }
+
+    SECTION("Iterate a range")
+    {
+        XLAllocationScope scope;
+        uint64_t          floats = 0;
+        for (auto& cell : range) floats += cell.value().type() == XLValueType::Float;
+        REQUIRE(floats == cells);
+        REQUIRE(scope.count() <= cells * perCellIterated + loopOverhead);
+    }
+
+    SECTION("Overwrite existing values")
+    {
+        XLAllocationScope scope;
+        for (auto& cell : range) cell.value() = 2.5;
+        REQUIRE(scope.count() <= cells * perCellAssigned + loopOverhead);
+        REQUIRE(wks.cell(rows, cols).value().get<double>() == Approx(2.5));
+    }
+
+    SECTION("Read rows into std::vector<XLCellValue>")
+    {
+        constexpr uint32_t readRows = 1000;
+        XLAllocationScope  scope;
+        size_t             values = 0;
+        for (auto& row : wks.rows(readRows)) {
+            std::vector<XLCellValue> rowValues = row.values();
+            values += rowValues.size();
+        }
+        REQUIRE(values == uint64_t { readRows } * cols);
+        REQUIRE(scope.count() <= readRows * perRowRead + loopOverhead);
+    }
+
+    SECTION("Look up single cells")
+    {
+        constexpr uint32_t lookups = 10000;
+        XLAllocationScope  scope;
+        double             sum = 0;
+        for (uint32_t row = 1; row <= lookups; ++row) sum += wks.cell(row, 3).value().get<double>();
+        REQUIRE(sum == Approx(lookups * 1.5));
+        REQUIRE(scope.count() <= lookups * perCellLookup);
+    }
+
+    SECTION("Row views do not allocate per row or cell")
+    {
+        for (uint32_t lastRow : { rows / 100, rows }) {
+            XLAllocationScope scope;
+            double            sum = 0;
+            wks.parallelForRows(1, lastRow, [&](XLRowView& row) { for (auto& cell : row) sum += cell.number(); }, 1);
+            REQUIRE(sum == Approx(lastRow * cols * 1.5));
+            REQUIRE(scope.count() <= rowViewsSetup);
+        }
+    }
+
+    doc.close();
+}
@@ -177,4 +177,78 @@ TEST_CASE("XLCellRange Tests", "[XLCellRange]")
 
     }
 
-}
\ No newline at end of file
+    SECTION("setFormat")
+    {
+        // ===== Partial range: all cells are created and formatted, existing values are kept
+        wks.cell("C3").value() = "Value";
+        auto rng = wks.range(XLCellReference("B2"), XLCellReference("D4"));
+        REQUIRE(rng.setFormat(3));
+        for (auto cl : rng) REQUIRE(cl.cellFormat() == 3);
+        REQUIRE(wks.cell("C3").value().get<std::string>() == "Value");
+        REQUIRE(wks.findCell("E3").empty());
+
+        // ===== Whole rows: the row format is set, only existing cells are formatted
+        wks.cell("C7").value() = 7;
+        REQUIRE(wks.range(XLCellReference(6, 1), XLCellReference(7, MAX_COLS)).setFormat(4));
+        REQUIRE(wks.row(6).format() == 4);
+        REQUIRE(wks.row(7).format() == 4);
+        REQUIRE(wks.row(6).cellCount() == 0);
+        REQUIRE(wks.row(7).cellCount() == 3);
+        REQUIRE(wks.cell("C7").cellFormat() == 4);
+        REQUIRE(wks.findCell("B7").empty());
+
+        // ===== Whole columns: the column style is set, cells are only created in rows with a custom format
+        wks.cell("F10").value() = 10;
+        wks.row(9).setFormat(2);
+        wks.column(7).setWidth(20);
+        REQUIRE(wks.range(XLCellReference(1, 6), XLCellReference(MAX_ROWS, 7)).setFormat(5));
+        REQUIRE(wks.column(6).format() == 5);
+        REQUIRE(wks.column(7).format() == 5);
+        REQUIRE(wks.column(7).width() == Approx(20));
+        REQUIRE(wks.column(8).format() == XLDefaultCellFormat);
+        REQUIRE(wks.cell("F10").cellFormat() == 5);
+        REQUIRE(wks.findCell("F9").cellFormat() == 5);
+        REQUIRE(wks.findCell("G9").cellFormat() == 5);
+        REQUIRE(wks.findCell("F11").empty());
+        REQUIRE(wks.cell("D4").cellFormat() == 3);
+    }
+
+    SECTION("Aggregates")
+    {
+        wks.cell("B20").value() = 10;
+        wks.cell("B21").value() = -2.5;
+        wks.cell("B22").value() = 1.5e-3;
+        wks.cell("C20").value() = 1234567890123456.0;    // exercises the 8-digit parser
+        wks.cell("C21").value() = 1e300;                 // decoded by the fallback parser
+        wks.cell("C22").value() = "text";
+        wks.cell("D20").value() = true;
+        wks.cell("D21").formula() = "B20*2";             // the cached value of a formula counts
+        wks.cell("D21").value() = 20;
+        wks.cell("E21").value() = 1000;                  // outside of the range
+
+        XLRangeAggregate agg = wks.range(XLCellReference("B20"), XLCellReference("D23")).aggregate();
+        REQUIRE(agg.count == 6);
+        REQUIRE(agg.nonNumericCount == 2);
+        REQUIRE(agg.min == Approx(-2.5));
+        REQUIRE(agg.max == Approx(1e300));
+        REQUIRE(agg.mean() == Approx(agg.sum / 6));
+
+        auto numbers = wks.range(XLCellReference("B20"), XLCellReference("B22"));
+        REQUIRE(numbers.sum() == Approx(7.5015));
+        REQUIRE(numbers.count() == 3);
+        REQUIRE(numbers.mean() == Approx(2.5005));
+        REQUIRE(numbers.countNonNumeric() == 0);
+
+        // ===== Sums over more values than one reduction block, with a remainder
+        for (uint32_t row = 1; row <= 1001; ++row) wks.cell(row, 10).value() = row;
+        auto column = wks.range(XLCellReference(1, 10), XLCellReference(1001, 10));
+        agg         = column.aggregate();
+        REQUIRE(agg.sum == Approx(501501.0));
+        REQUIRE(agg.min == Approx(1.0));
+        REQUIRE(agg.max == Approx(1001.0));
+
+        XLRangeAggregate empty = wks.range(XLCellReference("X1"), XLCellReference("Y5")).aggregate();
+        REQUIRE(empty.count == 0);
+        REQUIRE(empty.mean() == 0.0);
+    }
+}
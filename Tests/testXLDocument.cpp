@@ -3,11 +3,27 @@
 //
 
 #include <OpenXLSX.hpp>
+#include <algorithm>
 #include <catch.hpp>
+#include <cstdio>
 #include <fstream>
+#include <future>
+#include <thread>
+#include <vector>
 
 using namespace OpenXLSX;
 
+namespace
+{
+    /**
+     * @brief Indent xml like other producers do, by inserting whitespace before each occurrence of tag
+     */
+    void indentXml(std::string& xml, std::string const& tag, std::string const& whitespace)
+    {
+        for (size_t pos = xml.find(tag); pos != std::string::npos; pos = xml.find(tag, pos + whitespace.size() + 1)) xml.insert(pos, whitespace);
+    }
+}    // namespace
+
 /**
  * @brief The purpose of this test case is to test the creation of XLDocument objects. Each section section
  * tests document creation using a different method. In addition, saving, closing and copying is tested.
@@ -194,4 +210,735 @@ TEST_CASE("XLDocument Tests", "[XLDocument]")
     //        const XLDocument doc(file);
     //        REQUIRE(doc.name() == file);
     //    }
-}
\ No newline at end of file
+
+    /**
+     * @test Save a document in which only some worksheets were accessed
+     *
+     * @details Worksheets that were never accessed are copied from the original archive without being parsed
+     */
+    SECTION("Save with untouched worksheets")
+    {
+        {
+            XLDocument doc;
+            doc.create(file, XLForceOverwrite);
+            doc.workbook().addWorksheet("Sheet2");
+            doc.workbook().worksheet("Sheet2").cell("B2").value() = "untouched";
+            doc.workbook().worksheet("Sheet1").cell("A1").value() = 1;
+            doc.save();
+            doc.close();
+        }
+        {
+            XLDocument doc;
+            doc.open(file);
+            doc.workbook().worksheet("Sheet1").cell("A1").value() = 2;
+            doc.saveAs(newfile, XLForceOverwrite);
+            doc.close();
+        }
+        XLDocument doc;
+        doc.open(newfile);
+        REQUIRE(doc.workbook().worksheet("Sheet1").cell("A1").value().get<int>() == 2);
+        REQUIRE(doc.workbook().worksheet("Sheet2").cell("B2").value().get<std::string>() == "untouched");
+        doc.close();
+    }
+
+    /**
+     * @test Add, delete and re-add worksheets, so that parts are looked up by path after each change
+     *
+     * @details The part lookups of XLDocument and of the zip archive are indexed by path and must follow every add and delete
+     */
+    SECTION("Add and delete parts")
+    {
+        {
+            XLDocument doc;
+            doc.create(file, XLForceOverwrite);
+            doc.workbook().addWorksheet("Sheet2");
+            doc.workbook().worksheet("Sheet2").cell("A1").value() = "first";
+            doc.workbook().cloneSheet("Sheet2", "Clone");
+            doc.workbook().deleteSheet("Sheet2");
+            doc.workbook().addWorksheet("Sheet2");
+            doc.workbook().worksheet("Sheet2").cell("A1").value() = "second";
+            doc.save();
+            doc.close();
+        }
+        XLDocument doc;
+        doc.open(file);
+        REQUIRE(doc.workbook().sheetCount() == 3);
+        REQUIRE(doc.workbook().worksheet("Clone").cell("A1").value().get<std::string>() == "first");
+        REQUIRE(doc.workbook().worksheet("Sheet2").cell("A1").value().get<std::string>() == "second");
+        doc.close();
+    }
+
+    /**
+     * @test Keep xl/calcChain.xml valid over saves
+     *
+     * @details The chain lists formula cells only: entries are dropped for removed formulas and deleted worksheets, and added for new
+     *  formulas, while worksheets that were not parsed keep their entries
+     */
+    SECTION("Calculation chain")
+    {
+        auto readChain = [&]() {
+            XLZipArchive archive;
+            archive.open(file);
+            std::string chain = archive.hasEntry("xl/calcChain.xml") ? archive.getEntry("xl/calcChain.xml") : "";
+            archive.close();
+            return chain;
+        };
+        {
+            XLDocument doc;
+            doc.create(file, XLForceOverwrite);
+            doc.workbook().addWorksheet("Sheet2");
+            XLWorksheet wks = doc.workbook().worksheet("Sheet1");
+            wks.cell("A1").formula() = "1+1";
+            wks.cell("A2").formula() = "A1*2";
+            doc.workbook().worksheet("Sheet2").cell("B1").formula() = "Sheet1!A1";
+            doc.save();
+            doc.close();
+        }
+        std::string chain = readChain();
+        REQUIRE(chain.find("<c r=\"A1\" i=\"1\"/><c r=\"A2\"/><c r=\"B1\" i=\"2\"/>") != std::string::npos);
+
+        {
+            XLDocument doc;
+            doc.open(file);
+            XLWorksheet wks = doc.workbook().worksheet("Sheet1");    // Sheet2 is not parsed
+            wks.cell("A1").formula().clear();
+            wks.cell("A3").formula() = "A2+1";
+            doc.save();
+            doc.close();
+        }
+        chain = readChain();
+        REQUIRE(chain.find("<c r=\"A2\" i=\"1\"/><c r=\"B1\" i=\"2\"/><c r=\"A3\" i=\"1\"/>") != std::string::npos);
+        REQUIRE(chain.find("\"A1\"") == std::string::npos);
+
+        {
+            XLDocument doc;
+            doc.open(file);
+            doc.workbook().deleteSheet("Sheet2");
+            XLWorksheet wks = doc.workbook().worksheet("Sheet1");
+            wks.cell("A2").formula().clear();
+            doc.save();
+            doc.close();
+        }
+        chain = readChain();
+        REQUIRE(chain.find("<c r=\"A3\" i=\"1\"/></calcChain>") != std::string::npos);
+        REQUIRE(chain.find("\"B1\"") == std::string::npos);
+
+        {
+            XLDocument doc;
+            doc.open(file);
+            doc.workbook().worksheet("Sheet1").cell("A3").formula().clear();
+            doc.save();
+            doc.close();
+        }
+        REQUIRE(readChain().empty());    // a chain without entries is removed
+        XLDocument doc;
+        doc.open(file);
+        REQUIRE(doc.workbook().worksheet("Sheet1").cell("A3").formula().get().empty());
+        doc.close();
+    }
+
+    /**
+     * @test Open a document with XLOpenMode::ReadOnly
+     *
+     * @details A read-only document reads pretty-printed XML and column ranges as they are, can not be saved, and leaves the
+     *  file untouched
+     */
+    SECTION("Read-only mode")
+    {
+        {
+            XLDocument doc;
+            doc.create(file, XLForceOverwrite);
+            XLWorksheet wks = doc.workbook().worksheet("Sheet1");
+            wks.cell("A1").value() = 1.5;
+            wks.cell("B2").value() = "text";
+            doc.save();
+            doc.close();
+        }
+        {
+            // ===== Rewrite the worksheet like other producers do: indented, with a <col> spanning several columns
+            XLZipArchive archive;
+            archive.open(file);
+            std::string sheet = archive.getEntry("xl/worksheets/sheet1.xml");
+            sheet.insert(sheet.find("<sheetData"), "<cols><col min=\"1\" max=\"3\" width=\"20\" customWidth=\"1\"/></cols>");
+            indentXml(sheet, "<row", "\n    ");
+            indentXml(sheet, "<c ", "\n        ");
+            archive.addEntry("xl/worksheets/sheet1.xml", sheet);
+            archive.save(newfile);
+            archive.close();
+        }
+
+        XLDocument doc;
+        doc.open(newfile, XLOpenMode::ReadOnly);
+        REQUIRE(doc.isReadOnly());
+        REQUIRE(doc.xmlParseOptions() == pugi_lean_parse_settings);
+        XLWorksheet wks = doc.workbook().worksheet("Sheet1");
+        REQUIRE(wks.cell("A1").value().get<double>() == Approx(1.5));
+        REQUIRE(wks.cell("B2").value().get<std::string>() == "text");
+        REQUIRE(wks.column(2).width() == Approx(20));
+        REQUIRE(wks.rowCount() == 2);
+        REQUIRE_THROWS_AS(doc.save(), XLException);
+        REQUIRE_THROWS_AS(doc.saveAs(file, XLForceOverwrite), XLException);
+        REQUIRE_THROWS_AS(doc.compactStyles(), XLException);
+        doc.close();
+
+        // ===== The mode only applies to the document it was opened with
+        doc.open(newfile);
+        REQUIRE_FALSE(doc.isReadOnly());
+        REQUIRE(doc.xmlParseOptions() == pugi_parse_settings);
+        doc.workbook().worksheet("Sheet1").cell("C3").value() = 3;
+        doc.save();
+        doc.close();
+    }
+
+    /**
+     * @test Parse XML parts without the whitespace between elements
+     *
+     * @details Indentation is dropped, while whitespace-only cell text is kept; entries added to a lean part are not indented
+     */
+    SECTION("Lean XML parsing")
+    {
+        {
+            XLDocument doc;
+            doc.create(file, XLForceOverwrite);
+            XLWorksheet wks = doc.workbook().worksheet("Sheet1");
+            wks.cell("A1").value() = " ";
+            wks.cell("B1").value() = 2;
+            wks.cell("A2").value() = 3;
+            doc.save();
+            doc.close();
+        }
+        {
+            XLZipArchive archive;
+            archive.open(file);
+            std::string sheet = archive.getEntry("xl/worksheets/sheet1.xml");
+            indentXml(sheet, "<row", "\n    ");
+            indentXml(sheet, "<c ", "\n        ");
+            indentXml(sheet, "</row", "\n    ");
+            archive.addEntry("xl/worksheets/sheet1.xml", sheet);
+            archive.save(newfile);
+            archive.close();
+        }
+
+        XLDocument doc;
+        doc.setLeanXmlParsing();
+        doc.open(newfile);
+        REQUIRE(doc.xmlParseOptions() == pugi_lean_parse_settings);
+        XLWorksheet wks = doc.workbook().worksheet("Sheet1");
+        REQUIRE(wks.cell("A1").value().get<std::string>() == " ");
+        REQUIRE(wks.cell("B1").value().get<int>() == 2);
+        REQUIRE(wks.row(1).cellCount() == 2);
+        REQUIRE(wks.range().aggregate().sum == Approx(5.0));
+
+        XLFonts& fonts = doc.styles().fonts();
+        fonts.create(fonts[0]);
+        const size_t fontCount = fonts.count();
+        doc.save();
+        doc.close();
+        doc.setLeanXmlParsing(false);
+
+        XLZipArchive archive;
+        archive.open(newfile);
+        REQUIRE(archive.getEntry("xl/worksheets/sheet1.xml").find("\n    <row") == std::string::npos);
+        REQUIRE(archive.getEntry("xl/styles.xml").find('\t') == std::string::npos);
+        archive.close();
+
+        doc.open(newfile);
+        REQUIRE(doc.xmlParseOptions() == pugi_parse_settings);
+        REQUIRE(doc.workbook().worksheet("Sheet1").cell("A1").value().get<std::string>() == " ");
+        REQUIRE(doc.styles().fonts().count() == fontCount);
+        doc.close();
+    }
+
+    SECTION("Memory budget")
+    {
+        const std::string file = "./testXLDocumentBudget.xlsx";
+        XLDocument        doc;
+        doc.create(file, XLForceOverwrite);
+        for (int sheet = 2; sheet <= 4; ++sheet) doc.workbook().addWorksheet("Sheet" + std::to_string(sheet));
+        for (int sheet = 1; sheet <= 4; ++sheet) {
+            XLWorksheet wks = doc.workbook().worksheet("Sheet" + std::to_string(sheet));
+            for (int row = 1; row <= 200; ++row) wks.cell(row, 1).value() = sheet * 1000 + row;
+        }
+
+        // ===== With a budget of 1 byte, only the last accessed sheet stays parsed - the others are held compressed
+        doc.setMemoryBudget(1);
+        REQUIRE(doc.memoryBudget() == 1);
+        const size_t spilled = doc.residentSize("xl/worksheets/sheet4.xml");
+        REQUIRE(spilled > 0);
+        REQUIRE(doc.workbook().worksheet("Sheet4").cell("A1").value().get<int>() == 4001);
+        const size_t parsed = doc.residentSize("xl/worksheets/sheet4.xml");
+        REQUIRE(parsed > 4 * spilled);
+        REQUIRE(doc.residentSize("xl/worksheets/sheet1.xml") > 0);
+        REQUIRE(doc.residentSize("xl/worksheets/sheet1.xml") < parsed / 4);
+
+        // ===== Edits survive eviction, and a held worksheet is not evicted
+        {
+            XLWorksheet wks = doc.workbook().worksheet("Sheet1");
+            wks.cell("B1").value() = "kept";
+            REQUIRE(doc.residentSize("xl/worksheets/sheet1.xml") > parsed / 2);
+            REQUIRE(doc.workbook().worksheet("Sheet2").cell("A1").value().get<int>() == 2001);
+            REQUIRE(doc.residentSize("xl/worksheets/sheet1.xml") > parsed / 2);
+            REQUIRE(wks.cell("B1").value().get<std::string>() == "kept");
+        }
+        REQUIRE(doc.workbook().worksheet("Sheet3").cell("A200").value().get<int>() == 3200);
+        REQUIRE(doc.residentSize("xl/worksheets/sheet1.xml") < parsed / 4);
+        REQUIRE(doc.workbook().worksheet("Sheet1").cell("B1").value().get<std::string>() == "kept");
+        doc.save();
+        doc.close();
+        REQUIRE(doc.memoryBudget() == 1);
+
+        doc.setMemoryBudget(0);
+        doc.open(file);
+        for (int sheet = 1; sheet <= 4; ++sheet)
+            REQUIRE(doc.workbook().worksheet("Sheet" + std::to_string(sheet)).cell(200, 1).value().get<int>() == sheet * 1000 + 200);
+        REQUIRE(doc.workbook().worksheet("Sheet1").cell("B1").value().get<std::string>() == "kept");
+        REQUIRE(doc.residentSize("xl/worksheets/sheet1.xml") >= parsed);
+        doc.close();
+
+        // ===== Whole-document operations sweep all sheets within the budget: the calculation chain is updated on save
+        doc.setMemoryBudget(1);
+        doc.open(file);
+        for (int sheet = 1; sheet <= 4; ++sheet)
+            doc.workbook().worksheet("Sheet" + std::to_string(sheet)).cell("C1").formula() = "A1*2";
+        doc.save();
+        doc.close();
+        doc.setMemoryBudget(0);
+        {
+            XLZipArchive archive;
+            archive.open(file);
+            const std::string chain = archive.getEntry("xl/calcChain.xml");
+            archive.close();
+            REQUIRE(chain.find("<c r=\"C1\" i=\"1\"/><c r=\"C1\" i=\"2\"/><c r=\"C1\" i=\"3\"/><c r=\"C1\" i=\"4\"/>") != std::string::npos);
+        }
+        doc.open(file);
+        REQUIRE(doc.workbook().worksheet("Sheet4").cell("C1").formula().get() == "A1*2");
+        REQUIRE(doc.workbook().worksheet("Sheet1").cell("B1").value().get<std::string>() == "kept");
+        doc.close();
+
+        // ===== The style references collected from all sheets stay valid until compactStyles has renumbered them
+        doc.setMemoryBudget(1);
+        doc.open(file);
+        XLCellFormats& cellFormats = doc.styles().cellFormats();
+        XLStyleIndex   unused      = cellFormats.create(cellFormats[0]);
+        XLStyleIndex   used        = cellFormats.findOrCreate(cellFormats[0], [](XLCellFormat& fmt) { fmt.setApplyFont(true); });
+        REQUIRE(used == unused + 1);
+        for (int sheet = 1; sheet <= 4; ++sheet)
+            doc.workbook().worksheet("Sheet" + std::to_string(sheet)).cell("A1").setCellFormat(used);
+        doc.compactStyles();
+        for (int sheet = 1; sheet <= 4; ++sheet)
+            REQUIRE(doc.workbook().worksheet("Sheet" + std::to_string(sheet)).cell("A1").cellFormat() == unused);
+        REQUIRE(doc.residentSize("xl/worksheets/sheet1.xml") < parsed / 4);    // the budget applies again afterwards
+        doc.close();
+        doc.setMemoryBudget(0);
+
+        // ===== In a read-only document, evicted sheets are dropped and re-read from the archive
+        doc.setMemoryBudget(1);
+        doc.open(file, XLOpenMode::ReadOnly);
+        REQUIRE(doc.workbook().worksheet("Sheet1").cell("A1").value().get<int>() == 1001);
+        REQUIRE(doc.workbook().worksheet("Sheet2").cell("A1").value().get<int>() == 2001);
+        REQUIRE(doc.residentSize("xl/worksheets/sheet1.xml") == 0);
+        REQUIRE(doc.residentSize("xl/worksheets/sheet2.xml") > 0);
+        REQUIRE(doc.workbook().worksheet("Sheet1").cell("B1").value().get<std::string>() == "kept");
+        doc.close();
+        doc.setMemoryBudget(0);
+    }
+
+    SECTION("Memory usage")
+    {
+        const std::string file = "./testXLDocumentMemory.xlsx";
+        XLDocument        doc;
+        doc.create(file, XLForceOverwrite);
+        doc.workbook().addWorksheet("Sheet2");
+        XLWorksheet wks = doc.workbook().worksheet("Sheet1");
+        for (int row = 1; row <= 500; ++row) {
+            wks.cell(row, 1).value() = row;
+            wks.cell(row, 2).value() = "a string that is too long for the short string buffer " + std::to_string(row);
+        }
+
+        auto partUsage = [](const XLMemoryUsage& usage, const std::string& path) {
+            auto found = std::find_if(usage.parts.begin(), usage.parts.end(), [&](const XLPartMemoryUsage& p) { return p.part == path; });
+            return found == usage.parts.end() ? XLPartMemoryUsage { path, 0, 0 } : *found;
+        };
+
+        XLMemoryUsage usage = doc.memoryUsage();
+        REQUIRE(partUsage(usage, "xl/worksheets/sheet1.xml").dom > 1000 * 8 * sizeof(void*));    // at least the <c> nodes
+        REQUIRE(partUsage(usage, "xl/worksheets/sheet1.xml").spilled == 0);
+        REQUIRE(usage.sharedStrings > 500 * 50);
+        REQUIRE(usage.styles > 0);
+        REQUIRE(usage.zipEntries > 0);    // the entry added for Sheet2 is held until the archive is saved
+        size_t parts = 0;
+        for (const auto& part : usage.parts) parts += part.dom + part.spilled;
+        REQUIRE(usage.xmlParts == parts);
+        REQUIRE(usage.total() == usage.xmlParts + usage.zipEntries + usage.sharedStrings + usage.styles + usage.xmlArenaRetained);
+
+        doc.save();
+        REQUIRE(doc.memoryUsage().zipEntries == 0);
+        doc.close();
+
+        // ===== Parts are only listed once parsed, and evicted parts are listed with their compressed size
+        doc.open(file);
+        usage = doc.memoryUsage();
+        REQUIRE(partUsage(usage, "xl/worksheets/sheet1.xml").dom == 0);
+        REQUIRE(doc.workbook().worksheet("Sheet1").cell("A500").value().get<int>() == 500);
+        doc.workbook().worksheet("Sheet1").cell("A1").value() = 0;
+        const size_t dom = partUsage(doc.memoryUsage(), "xl/worksheets/sheet1.xml").dom;
+        REQUIRE(dom > 0);
+        doc.setMemoryBudget(1);
+        REQUIRE(doc.workbook().worksheet("Sheet2").cell("A1").value().type() == XLValueType::Empty);
+        usage = doc.memoryUsage();
+        REQUIRE(partUsage(usage, "xl/worksheets/sheet1.xml").dom == 0);
+        REQUIRE(partUsage(usage, "xl/worksheets/sheet1.xml").spilled > 0);
+        REQUIRE(partUsage(usage, "xl/worksheets/sheet1.xml").spilled < dom);
+        doc.close();
+        doc.setMemoryBudget(0);
+    }
+
+    SECTION("XML arena")
+    {
+        const std::string file = "./testXLDocumentArena.xlsx";
+        {
+            XLDocument doc;
+            doc.create(file, XLForceOverwrite);
+            XLWorksheet wks = doc.workbook().worksheet("Sheet1");
+            for (int row = 1; row <= 2000; ++row) wks.cell(row, 1).value() = row;
+            doc.save();
+            doc.close();
+        }
+
+        // ===== The pages of a closed document are retained, and reused by the next open
+        XLDocument doc;
+        REQUIRE(doc.xmlArenaRetainedSize() == 0);
+        doc.open(file);
+        REQUIRE(doc.workbook().worksheet("Sheet1").cell("A2000").value().get<int>() == 2000);
+        doc.close();
+        const size_t retained = doc.xmlArenaRetainedSize();
+        REQUIRE(retained > 0);
+
+        doc.open(file);
+        REQUIRE(doc.workbook().worksheet("Sheet1").cell("A2000").value().get<int>() == 2000);
+        REQUIRE(doc.xmlArenaRetainedSize() < retained);
+        doc.close();
+        REQUIRE(doc.xmlArenaRetainedSize() == retained);
+
+        // ===== Without the arena, the retained pages are freed
+        doc.setXmlArena(false);
+        REQUIRE(doc.xmlArenaRetainedSize() == 0);
+        doc.open(file);
+        REQUIRE(doc.workbook().worksheet("Sheet1").cell("A1").value().get<int>() == 1);
+        doc.close();
+        REQUIRE(doc.xmlArenaRetainedSize() == 0);
+
+        // ===== Move assigning to an open document releases its parts into its own arena before the arena is replaced
+        doc.setXmlArena(true);
+        doc.open(file);
+        REQUIRE(doc.workbook().worksheet("Sheet1").cell("A2000").value().get<int>() == 2000);
+        doc = XLDocument();
+        REQUIRE_FALSE(doc.isOpen());
+        REQUIRE(doc.xmlArenaRetainedSize() == 0);
+        doc.open(file);
+        REQUIRE(doc.workbook().worksheet("Sheet1").cell("A1999").value().get<int>() == 1999);
+        XLDocument other;
+        other.create("./testXLDocumentArena2.xlsx", XLForceOverwrite);
+        other.close();
+        doc = std::move(other);
+        REQUIRE_FALSE(doc.isOpen());
+        doc.open(file);
+        REQUIRE(doc.workbook().worksheet("Sheet1").cell("A1").value().get<int>() == 1);
+        doc.close();
+    }
+
+    SECTION("Concurrent reads")
+    {
+        const std::string file     = "./testXLDocumentConcurrent.xlsx";
+        constexpr int     sheets   = 4;
+        constexpr int     rowCount = 1000;
+        {
+            XLDocument doc;
+            doc.create(file, XLForceOverwrite);
+            for (int s = 2; s <= sheets; ++s) doc.workbook().addWorksheet("Sheet" + std::to_string(s));
+            for (int s = 1; s <= sheets; ++s) {
+                XLWorksheet wks = doc.workbook().worksheet("Sheet" + std::to_string(s));
+                for (int row = 1; row <= rowCount; ++row) {
+                    wks.cell(row, 1).value() = row * s;
+                    wks.cell(row, 2).value() = "S" + std::to_string(row % 10);
+                }
+            }
+            doc.save();
+            doc.close();
+        }
+
+        // ===== Each thread scans one half of one sheet, in several ways; the sheets are parsed by whichever thread gets there first
+        auto expectedSum = [](int sheet, int first, int last) { return static_cast<double>(sheet) * (first + last) * (last - first + 1) / 2; };
+        auto scan        = [&](XLDocument const& doc, int sheet, int first, int last) {
+            XLWorksheet wks   = doc.workbook().worksheet("Sheet" + std::to_string(sheet));
+            const std::string firstRef = "A" + std::to_string(first);
+            const std::string lastRef  = "B" + std::to_string(last);
+            bool        ok    = true;
+            double      sum   = 0.0;
+            int         texts = 0;
+            for (auto& cell : wks.range(firstRef, lastRef)) {
+                if (cell.value().type() == XLValueType::Integer) sum += cell.value().get<double>();
+                else if (cell.value().get<std::string>() == "S" + std::to_string(cell.cellReference().row() % 10)) ++texts;
+            }
+            ok = ok && sum == expectedSum(sheet, first, last) && texts == last - first + 1;
+            ok = ok && wks.range(firstRef, lastRef).sum() == expectedSum(sheet, first, last);
+
+            sum = 0.0;
+            for (auto& row : wks.rows(first, last)) sum += static_cast<std::vector<XLCellValue>>(row.values())[0].get<double>();
+            ok = ok && sum == expectedSum(sheet, first, last);
+
+            sum = 0.0;
+            for (int row = first; row <= last; ++row) sum += wks.findCell(row, 1).value().get<double>() + wks.cell(row, 1).value().get<double>();
+            ok = ok && sum == 2 * expectedSum(sheet, first, last);
+
+            // ===== Reading missing entries does not create them
+            ok = ok && wks.cell(rowCount + 1, 1).value().type() == XLValueType::Empty && wks.findCell(rowCount + 1, 1).empty();
+            ok = ok && wks.row(rowCount + 1).cellCount() == 0 && wks.column(10).width() == wks.column(11).width();
+            return ok;
+        };
+
+        for (size_t budget : { size_t(0), size_t(1) }) {
+            XLDocument doc;
+            doc.setMemoryBudget(budget);
+            doc.open(file, XLOpenMode::ReadOnly);
+            for (int pass = 0; pass < 2; ++pass) {
+                std::vector<std::thread> threads;
+                std::vector<char>        results(sheets * 2, 0);
+                for (int t = 0; t < sheets * 2; ++t) {
+                    threads.emplace_back([&, t] {
+                        const int sheet = t / 2 + 1;
+                        const int first = t % 2 == 0 ? 1 : rowCount / 2 + 1;
+                        results[t]      = scan(doc, sheet, first, t % 2 == 0 ? rowCount / 2 : rowCount);
+                    });
+                }
+                for (auto& thread : threads) thread.join();
+                for (int t = 0; t < sheets * 2; ++t) REQUIRE(results[t]);
+            }
+            REQUIRE(doc.workbook().worksheet("Sheet1").findCell(rowCount + 1, 1).empty());
+            doc.close();
+        }
+    }
+
+    SECTION("Asynchronous open and save")
+    {
+        const std::string file  = "./testXLDocumentAsync.xlsx";
+        const std::string file2 = "./testXLDocumentAsync2.xlsx";
+        std::remove(file2.c_str());
+        {
+            XLDocument doc;
+            doc.create(file, XLForceOverwrite);
+            doc.workbook().addWorksheet("Sheet2");
+            doc.workbook().addWorksheet("Sheet3");
+            for (int row = 1; row <= 500; ++row) doc.workbook().worksheet("Sheet3").cell(row, 1).value() = row;
+            doc.save();
+            doc.close();
+        }
+
+        // ===== Open: every parsed part is reported, the sheets included
+        XLDocument               doc;
+        std::vector<XLProgress> reports;
+        XLAsyncResult            result = doc.openAsync(file, XLOpenMode::ReadWrite, [&](const XLProgress& p) { reports.push_back(p); });
+        REQUIRE(result.valid());
+        REQUIRE(result.get() == XLAsyncStatus::Completed);
+        REQUIRE(result.ready());
+        REQUIRE(doc.isOpen());
+        REQUIRE_FALSE(reports.empty());
+        REQUIRE(reports.back().partIndex == reports.back().partCount);
+        REQUIRE(std::count_if(reports.begin(), reports.end(), [](const XLProgress& p) {
+                    return p.stage == XLProgressStage::Parse && p.part.find("worksheets/sheet") != std::string::npos && p.bytes > 0;
+                }) == 3);
+        REQUIRE(doc.workbook().worksheet("Sheet3").cell("A500").value().get<int>() == 500);
+
+        // ===== Save with a new name: the serialized parts, then the written file are reported
+        doc.workbook().worksheet("Sheet2").cell("B2").value() = "async";
+        reports.clear();
+        REQUIRE(doc.saveAsAsync(file2, XLDoNotOverwrite, [&](const XLProgress& p) { reports.push_back(p); }).get() == XLAsyncStatus::Completed);
+        REQUIRE(reports.back().stage == XLProgressStage::Compress);
+        REQUIRE(reports.back().part == file2);
+        REQUIRE(reports.back().bytes > 0);
+        REQUIRE(reports.front().stage == XLProgressStage::Serialize);
+        REQUIRE_THROWS_AS(doc.saveAsAsync(file2, XLDoNotOverwrite).get(), XLException);
+        doc.close();
+
+        // ===== Cancelling a save leaves the file on disk as it was, and the document usable
+        std::promise<void>       release;
+        std::shared_future<void> gate = release.get_future().share();
+        doc.open(file2);
+        doc.workbook().worksheet("Sheet2").cell("B2").value() = "changed";
+        result = doc.saveAsync([gate](const XLProgress&) { gate.wait(); });
+        REQUIRE_THROWS_AS(doc.openAsync(file), XLException);    // one operation at a time
+        result.cancel();
+        release.set_value();
+        REQUIRE(result.get() == XLAsyncStatus::Cancelled);
+        REQUIRE(doc.path() == file2);
+        REQUIRE(doc.workbook().worksheet("Sheet2").cell("B2").value().get<std::string>() == "changed");
+        doc.close();
+        doc.open(file2);
+        REQUIRE(doc.workbook().worksheet("Sheet2").cell("B2").value().get<std::string>() == "async");
+        doc.close();
+
+        // ===== Cancelling an open closes the document
+        std::promise<void> release2;
+        gate   = release2.get_future().share();
+        result = doc.openAsync(file, XLOpenMode::ReadOnly, [gate](const XLProgress&) { gate.wait(); });
+        result.cancel();
+        release2.set_value();
+        REQUIRE(result.get() == XLAsyncStatus::Cancelled);
+        REQUIRE_FALSE(doc.isOpen());
+
+        // ===== Errors are passed on by get(), and leave the document closed
+        REQUIRE_THROWS(doc.openAsync("./doesNotExist.xlsx").get());
+        REQUIRE_FALSE(doc.isOpen());
+    }
+
+    SECTION("Statistics")
+    {
+        const std::string file = "./testXLDocumentStats.xlsx";
+        XLDocument        doc;
+        doc.create(file, XLForceOverwrite);
+        XLWorksheet wks = doc.workbook().worksheet("Sheet1");
+        for (int row = 1; row <= 100; ++row) {
+            wks.cell(row, 1).value() = row;
+            wks.cell(row, 2).value() = "text";
+        }
+        REQUIRE(wks.cell("B7").value().get<std::string>() == "text");
+        doc.save();
+
+        XLStats stats = doc.stats();
+        if (not XLStats::enabled()) {
+            // ===== Without the instrumentation, nothing is recorded
+            REQUIRE(stats.events().empty());
+            REQUIRE(stats.parts().empty());
+            REQUIRE(stats.counters().cellNodesCreated == 0);
+            REQUIRE(stats.phase(XLStatsPhase::Parse).count == 0);
+        }
+        else {
+            REQUIRE(stats.counters().rowNodesCreated >= 100);
+            REQUIRE(stats.counters().cellNodesCreated >= 200);
+            REQUIRE(stats.counters().sharedStringLookups > 0);
+            REQUIRE(stats.counters().cacheHits > 0);
+
+            const XLPartStats* sheet = stats.part("xl/worksheets/sheet1.xml");
+            REQUIRE(sheet != nullptr);
+            REQUIRE(sheet->phase(XLStatsPhase::Inflate).count == 1);
+            REQUIRE(sheet->phase(XLStatsPhase::Parse).count == 1);
+            REQUIRE(sheet->phase(XLStatsPhase::Serialize).count == 1);
+            REQUIRE(sheet->phase(XLStatsPhase::Serialize).bytes > sheet->phase(XLStatsPhase::Parse).bytes);
+            REQUIRE(stats.part(file)->phase(XLStatsPhase::Deflate).count == 1);
+            REQUIRE(stats.part(file)->phase(XLStatsPhase::Validate).count == 1);
+            REQUIRE(stats.phase(XLStatsPhase::Cleanup).count == 1);    // the calculation chain update of the save
+            size_t runs = 0;
+            for (size_t p = 0; p < XLStatsPhaseCount; ++p) runs += stats.phase(static_cast<XLStatsPhase>(p)).count;
+            REQUIRE(runs == stats.events().size());
+
+            const std::string trace = stats.chromeTrace();
+            REQUIRE(trace.find("\"traceEvents\"") != std::string::npos);
+            REQUIRE(trace.find("{\"name\":\"xl/worksheets/sheet1.xml\",\"cat\":\"Serialize\",\"ph\":\"X\"") != std::string::npos);
+            REQUIRE(trace.find("\"cellNodesCreated\":" + std::to_string(stats.counters().cellNodesCreated)) != std::string::npos);
+
+            // ===== Resetting, and re-opening, restart the recording
+            doc.resetStats();
+            REQUIRE(doc.stats().events().empty());
+            REQUIRE(doc.stats().counters().cellNodesCreated == 0);
+            doc.close();
+            doc.open(file, XLOpenMode::ReadOnly);
+            REQUIRE(doc.workbook().worksheet("Sheet1").cell("A100").value().get<int>() == 100);
+            stats = doc.stats();
+            REQUIRE(stats.part("xl/worksheets/sheet1.xml")->phase(XLStatsPhase::Parse).count == 1);
+            REQUIRE(stats.phase(XLStatsPhase::Serialize).count == 0);
+            REQUIRE(stats.counters().cellNodesCreated == 0);
+        }
+        doc.close();
+    }
+
+    SECTION("Template forks")
+    {
+        const std::string file = "./testXLDocumentTemplate.xlsx";
+        {
+            XLDocument doc;
+            doc.create(file, XLForceOverwrite);
+            doc.workbook().addWorksheet("Sheet2");
+            for (int row = 1; row <= 100; ++row) {
+                doc.workbook().worksheet("Sheet1").cell(row, 1).value() = "template";
+                doc.workbook().worksheet("Sheet2").cell(row, 1).value() = row;
+            }
+            doc.save();
+            doc.close();
+        }
+        auto entry = [](const std::string& path, const std::string& name) {
+            XLZipArchive archive;
+            archive.open(path);
+            std::string result = archive.getEntry(name);
+            archive.close();
+            return result;
+        };
+
+        XLDocument doc;
+        REQUIRE_THROWS_AS(doc.open(XLTemplate()), XLInputError);
+
+        const std::string out = "./testXLDocumentTemplateOut.xlsx";
+        {
+            XLTemplate source(file);
+            REQUIRE(source.valid());
+            REQUIRE(source.name() == file);
+            REQUIRE(source.packageSize() == static_cast<size_t>(std::ifstream(file, std::ios::binary | std::ios::ate).tellg()));
+
+            // ===== A fork starts out as the template, and has no file name
+            doc.open(source);
+            REQUIRE(doc.isOpen());
+            REQUIRE_THROWS_AS(doc.save(), XLException);
+            REQUIRE(doc.workbook().worksheetNames() == std::vector<std::string> { "Sheet1", "Sheet2" });
+            REQUIRE(doc.workbook().worksheet("Sheet1").cell("A100").value().get<std::string>() == "template");
+
+            // ===== Forks are independent of each other, and of the template
+            doc.workbook().worksheet("Sheet1").cell("A1").value() = "fork";
+            doc.workbook().worksheet("Sheet1").cell("B1").value() = "new string";
+            XLDocument other;
+            other.open(source);
+            REQUIRE(other.workbook().worksheet("Sheet1").cell("A1").value().get<std::string>() == "template");
+            REQUIRE(other.workbook().worksheet("Sheet1").cell("B1").value().type() == XLValueType::Empty);
+            other.close();
+
+            // ===== Forks can be taken on several threads at once
+            constexpr int            threadCount = 4;
+            std::vector<std::thread> threads;
+            for (int t = 0; t < threadCount; ++t) {
+                threads.emplace_back([&source, t] {
+                    XLDocument fork;
+                    fork.open(source);
+                    fork.workbook().worksheet("Sheet1").cell("C1").value() = t;
+                    fork.saveAs("./testXLDocumentTemplate" + std::to_string(t) + ".xlsx", XLForceOverwrite);
+                    fork.close();
+                });
+            }
+            for (auto& thread : threads) thread.join();
+            for (int t = 0; t < threadCount; ++t) {
+                XLDocument copy("./testXLDocumentTemplate" + std::to_string(t) + ".xlsx");
+                REQUIRE(copy.workbook().worksheet("Sheet1").cell("C1").value().get<int>() == t);
+                REQUIRE(copy.workbook().worksheet("Sheet2").cell("A100").value().get<int>() == 100);
+                copy.close();
+            }
+        }
+
+        // ===== The fork outlives its template. Worksheets it never accessed are saved with the template's compressed data
+        doc.saveAs(out, XLForceOverwrite);
+        REQUIRE(doc.path() == out);
+        doc.save();
+        doc.close();
+        REQUIRE(entry(out, "xl/worksheets/sheet2.xml") == entry(file, "xl/worksheets/sheet2.xml"));
+        REQUIRE(entry(file, "xl/sharedStrings.xml").find("new string") == std::string::npos);
+
+        // ===== After closing a fork, the document opens files again
+        doc.open(out);
+        REQUIRE(doc.workbook().worksheet("Sheet1").cell("A1").value().get<std::string>() == "fork");
+        REQUIRE(doc.workbook().worksheet("Sheet1").cell("B1").value().get<std::string>() == "new string");
+        REQUIRE(doc.workbook().worksheet("Sheet1").cell("A2").value().get<std::string>() == "template");
+        REQUIRE(doc.workbook().worksheet("Sheet2").cell("A50").value().get<int>() == 50);
+        doc.workbook().worksheet("Sheet2").cell("A50").value() = 51;
+        doc.save();
+        doc.close();
+        doc.open(out);
+        REQUIRE(doc.workbook().worksheet("Sheet2").cell("A50").value().get<int>() == 51);
+        doc.close();
+    }
+}
@@ -128,4 +128,60 @@ TEST_CASE("XLFormula Tests", "[XLFormula]")
         REQUIRE(wks.cell("B2").formula() == XLFormula("=1+1"));
 
     }
-}
\ No newline at end of file
+
+    SECTION("Shared formulas")
+    {
+        XLDocument doc;
+        doc.create("./testXLFormula.xlsx", XLForceOverwrite);
+        auto wks = doc.workbook().worksheet("Sheet1");
+
+        wks.cell("C2").formula().setSharedMaster(0, "C2:D5", "A2*$B$1+'My Sheet'!A2&\"A1\"+LOG10(B2)+SUM(A2:B2)");
+        wks.cell("E2").formula().setSharedMaster(1, "E2:E5", "Sheet1!E1+1");
+        for (uint32_t row = 2; row <= 5; ++row) {
+            if (row > 2) wks.cell(row, 3).formula().setSharedRef(0);
+            wks.cell(row, 4).formula().setSharedRef(0);
+            if (row > 2) wks.cell(row, 5).formula().setSharedRef(1);
+        }
+
+        REQUIRE(wks.cell("C2").formula().get() == "A2*$B$1+'My Sheet'!A2&\"A1\"+LOG10(B2)+SUM(A2:B2)");
+        REQUIRE(wks.cell("C4").formula().get() == "A4*$B$1+'My Sheet'!A4&\"A1\"+LOG10(B4)+SUM(A4:B4)");
+        REQUIRE(wks.cell("D5").formula().get() == "B5*$B$1+'My Sheet'!B5&\"A1\"+LOG10(C5)+SUM(B5:C5)");
+        REQUIRE(wks.cell("E5").formula().get() == "Sheet1!E4+1");
+        REQUIRE(wks.cell("E5").formula().getRawFormula().get().empty());
+
+        // ===== A changed master is picked up by the dependents
+        wks.cell("E2").formula().setSharedMaster(1, "E2:E5", "E1*2");
+        REQUIRE(wks.cell("E3").formula().get() == "E2*2");
+
+        // ===== Without a master, a dependent has no formula
+        wks.cell("E2").formula() = "1";
+        REQUIRE(wks.cell("E3").formula().get().empty());
+        REQUIRE(wks.cell("E4").formula().get().empty());
+
+        // ===== A master written for an index that had none is found by its dependents
+        wks.cell("F3").formula().setSharedRef(2);
+        REQUIRE(wks.cell("F3").formula().get().empty());
+        wks.cell("F2").formula().setSharedMaster(2, "F2:F3", "F1+E2");
+        REQUIRE(wks.cell("F3").formula().get() == "F2+E3");
+
+        // ===== Each worksheet has its own masters
+        doc.workbook().addWorksheet("Sheet2");
+        auto wks2 = doc.workbook().worksheet("Sheet2");
+        wks2.cell("A1").formula().setSharedMaster(0, "A1:A2", "B1");
+        wks2.cell("A2").formula().setSharedRef(0);
+        REQUIRE(wks2.cell("A2").formula().get() == "B2");
+        REQUIRE(wks.cell("D3").formula().get() == "B3*$B$1+'My Sheet'!B3&\"A1\"+LOG10(C3)+SUM(B3:C3)");
+
+        // ===== The masters are found again after the worksheets were reloaded
+        doc.save();
+        doc.close();
+        doc.open("./testXLFormula.xlsx");
+        wks = doc.workbook().worksheet("Sheet1");
+        REQUIRE(wks.cell("D5").formula().get() == "B5*$B$1+'My Sheet'!B5&\"A1\"+LOG10(C5)+SUM(B5:C5)");
+        REQUIRE(wks.cell("F3").formula().get() == "F2+E3");
+        REQUIRE(wks.cell("E3").formula().get().empty());
+        REQUIRE(doc.workbook().worksheet("Sheet2").cell("A2").formula().get() == "B2");
+
+        doc.close();
+    }
+}
@@ -0,0 +1,132 @@
+#include <OpenXLSX.hpp>
+#include <catch.hpp>
+
+using namespace OpenXLSX;
+
+TEST_CASE("XLFormulaEngine Tests", "[XLFormulaEngine]")
+{
+    SECTION("Arithmetic and functions")
+    {
+        XLDocument doc;
+        doc.create("./testXLFormulaEngine.xlsx", XLForceOverwrite);
+        XLWorksheet wks = doc.workbook().worksheet("Sheet1");
+
+        for (int row = 1; row <= 5; ++row) {
+            wks.cell(row, 1).value() = row * 10;                     // A1:A5 = 10..50
+            wks.cell(row, 2).value() = "Item" + std::to_string(row);    // B1:B5 = Item1..Item5
+        }
+        wks.cell("A6").value() = "text";
+        wks.cell("C1").formula() = "A1+A2*2-A3/3";
+        wks.cell("C2").formula() = "(A1+A2)*2^2";
+        wks.cell("C3").formula() = "SUM(A1:A6)";
+        wks.cell("C4").formula() = "AVERAGE(A1:A5)";
+        wks.cell("C5").formula() = "MIN(A1:A5)+MAX(A1:A5)";
+        wks.cell("C6").formula() = "COUNT(A:A)";
+        wks.cell("C7").formula() = "IF(A1>A2,\"big\",\"small\")";
+        wks.cell("C8").formula() = "VLOOKUP(30,A1:B5,2,FALSE)";
+        wks.cell("C9").formula() = "INDEX(B1:B5,MATCH(\"item4\",B1:B5,0))";
+        wks.cell("C10").formula() = "A1/0";
+        wks.cell("C11").formula() = "\"n=\"&A1&\"!\"";
+        wks.cell("C12").formula() = "MATCH(35,A1:A5)";
+        wks.cell("C13").formula() = "A2=20";
+        wks.cell("C14").formula() = "_xlfn.CONCAT(A1,A2)";    // not supported: left as is
+
+        XLFormulaEngine engine(doc);
+        REQUIRE(engine.formulaCount() == 13);
+        REQUIRE(engine.recalculateAll() == 13);
+
+        REQUIRE(wks.cell("C1").value().get<double>() == Approx(40.0));
+        REQUIRE(wks.cell("C2").value().get<double>() == Approx(120.0));
+        REQUIRE(wks.cell("C3").value().get<double>() == Approx(150.0));
+        REQUIRE(wks.cell("C4").value().get<double>() == Approx(30.0));
+        REQUIRE(wks.cell("C5").value().get<double>() == Approx(60.0));
+        REQUIRE(wks.cell("C6").value().get<double>() == Approx(5.0));
+        REQUIRE(wks.cell("C7").value().get<std::string>() == "small");
+        REQUIRE(wks.cell("C8").value().get<std::string>() == "Item3");
+        REQUIRE(wks.cell("C9").value().get<std::string>() == "Item4");
+        REQUIRE(wks.cell("C10").value().type() == XLValueType::Error);
+        REQUIRE(wks.cell("C11").value().get<std::string>() == "n=10!");
+        REQUIRE(wks.cell("C12").value().get<double>() == Approx(3.0));
+        REQUIRE(wks.cell("C13").value().get<bool>());
+        REQUIRE(wks.cell("C14").formula().get() == "_xlfn.CONCAT(A1,A2)");
+
+        doc.close();
+    }
+
+    SECTION("Dependencies and incremental recalculation")
+    {
+        XLDocument doc;
+        doc.create("./testXLFormulaEngine.xlsx", XLForceOverwrite);
+        doc.workbook().addWorksheet("Data Sheet");
+        XLWorksheet wks  = doc.workbook().worksheet("Sheet1");
+        XLWorksheet data = doc.workbook().worksheet("Data Sheet");
+
+        data.cell("A1").value() = 2;
+        data.cell("A2").value() = 3;
+        wks.cell("A1").formula() = "'Data Sheet'!A1*'Data Sheet'!A2";
+        wks.cell("A2").formula() = "A1+1";
+        wks.cell("A3").formula() = "SUM(A1:A2)";
+        wks.cell("B1").formula() = "B2+1";    // circular reference
+        wks.cell("B2").formula() = "B1+1";
+        wks.cell("C1").formula() = "NoSheet!A1";
+
+        XLFormulaEngine engine(doc);
+        engine.recalculateAll();
+        REQUIRE(wks.cell("A1").value().get<double>() == Approx(6.0));
+        REQUIRE(wks.cell("A2").value().get<double>() == Approx(7.0));
+        REQUIRE(wks.cell("A3").value().get<double>() == Approx(13.0));
+        REQUIRE(wks.cell("B1").value().get<double>() == Approx(0.0));
+        REQUIRE(wks.cell("C1").value().type() == XLValueType::Error);
+
+        // ===== Only the formulas depending on the edited cell are recalculated
+        engine.setValue("Data Sheet", "A2", XLCellValue(10));
+        REQUIRE(engine.recalculate() == 3);
+        REQUIRE(wks.cell("A1").value().get<double>() == Approx(20.0));
+        REQUIRE(wks.cell("A2").value().get<double>() == Approx(21.0));
+        REQUIRE(wks.cell("A3").value().get<double>() == Approx(41.0));
+        REQUIRE(engine.recalculate() == 0);
+
+        // ===== Replacing a formula rewires its precedents
+        engine.setFormula("Sheet1", "A2", "A1*10");
+        REQUIRE(engine.recalculate() == 2);
+        REQUIRE(wks.cell("A2").value().get<double>() == Approx(200.0));
+        REQUIRE(wks.cell("A3").value().get<double>() == Approx(220.0));
+
+        // ===== Edits made outside of the engine are picked up by markDirty
+        data.cell("A1").value() = 1;
+        engine.markDirty("Data Sheet", "A1");
+        REQUIRE(engine.recalculate() == 3);
+        REQUIRE(wks.cell("A3").value().get<double>() == Approx(110.0));
+
+        REQUIRE_THROWS_AS(engine.setValue("Missing", "A1", XLCellValue(1)), XLInputError);
+
+        doc.save();
+        doc.close();
+        doc.open("./testXLFormulaEngine.xlsx");
+        REQUIRE(doc.workbook().worksheet("Sheet1").cell("A3").value().get<double>() == Approx(110.0));
+        doc.close();
+    }
+
+    SECTION("Shared formulas")
+    {
+        XLDocument doc;
+        doc.create("./testXLFormulaEngine.xlsx", XLForceOverwrite);
+        XLWorksheet wks = doc.workbook().worksheet("Sheet1");
+
+        for (int row = 1; row <= 4; ++row) wks.cell(row, 1).value() = row;
+        wks.cell("B1").formula().setSharedMaster(0, "B1:B4", "A1*$A$1*2");
+        for (int row = 2; row <= 4; ++row) wks.cell(row, 2).formula().setSharedRef(0);
+
+        XLFormulaEngine engine(doc);
+        REQUIRE(engine.formulaCount() == 4);
+        engine.recalculateAll();
+        REQUIRE(wks.cell("B1").value().get<double>() == Approx(2.0));
+        REQUIRE(wks.cell("B4").value().get<double>() == Approx(8.0));
+
+        engine.setValue("Sheet1", "A3", XLCellValue(100));
+        REQUIRE(engine.recalculate() == 1);
+        REQUIRE(wks.cell("B3").value().get<double>() == Approx(200.0));
+
+        doc.close();
+    }
+}
@@ -3,6 +3,7 @@
 //
 
 #include <OpenXLSX.hpp>
+#include <atomic>
 #include <catch.hpp>
 
 using namespace OpenXLSX;
@@ -74,4 +75,177 @@ TEST_CASE("XLSheet Tests", "[XLSheet]")
 
         doc.save();
     }
-}
\ No newline at end of file
+
+    SECTION("XLMergeCells") {
+        XLDocument doc;
+        doc.create("./testXLSheet2.xlsx", XLForceOverwrite);
+        XLWorksheet   wks    = doc.workbook().worksheet("Sheet1");
+        XLMergeCells& merges = wks.merges();
+
+        for (uint32_t row = 1; row <= 2000; row += 2) merges.appendMerge("A" + std::to_string(row) + ":C" + std::to_string(row + 1));
+        REQUIRE(merges.count() == 1000);
+        REQUIRE(merges.findMergeByCell("B4") == 1);
+        REQUIRE(merges.findMergeByCell("D4") == XLMergeNotFound);
+        REQUIRE(merges.findMerge("A3:C4") == 1);
+        REQUIRE(merges.findMerge("A3:C5") == XLMergeNotFound);
+        REQUIRE_THROWS_AS(merges.appendMerge("C2000:D2001"), XLInputError);
+        REQUIRE(merges.appendMerge("D1:D2000") == 1000);
+
+        // ===== Deleting a merge shifts the indexes of all later merges and frees its cells
+        merges.deleteMerge(0);
+        merges.deleteMerge(0);
+        REQUIRE(merges.findMergeByCell("B4") == XLMergeNotFound);
+        REQUIRE(merges.findMergeByCell("B5") == 0);
+        REQUIRE(merges.findMergeByCell("D5") == 998);
+        REQUIRE(std::string(merges[0]) == "A5:C6");
+        REQUIRE(merges.appendMerge("A1:B4") == 999);
+        REQUIRE(merges.findMergeByCell("A2") == 999);
+
+        doc.save();
+        doc.close();
+
+        doc.open("./testXLSheet2.xlsx");
+        XLWorksheet   reopened = doc.workbook().worksheet("Sheet1");
+        XLMergeCells& reloaded = reopened.merges();
+        REQUIRE(reloaded.count() == 1000);
+        REQUIRE(reloaded.findMergeByCell("B1") == 999);
+        REQUIRE(reloaded.findMergeByCell("C2000") == 997);
+        doc.close();
+    }
+
+    SECTION("XLMergeCells with sheet-wide merges") {
+        XLDocument doc;
+        doc.create("./testXLSheet2.xlsx", XLForceOverwrite);
+        XLWorksheet   wks    = doc.workbook().worksheet("Sheet1");
+        XLMergeCells& merges = wks.merges();
+
+        // ===== The cost of appending, finding and deleting merges does not depend on their width or height
+        for (uint32_t row = 1; row <= 4000; row += 2) merges.appendMerge("A" + std::to_string(row) + ":XFD" + std::to_string(row + 1));
+        REQUIRE(merges.appendMerge("A4001:A1048576") == 2000);
+        REQUIRE(merges.appendMerge("C6000:D6001") == 2001);
+        REQUIRE(merges.count() == 2002);
+        REQUIRE(merges.findMergeByCell("XFD4000") == 1999);
+        REQUIRE(merges.findMergeByCell(XLCellReference(1000, 8000)) == 499);
+        REQUIRE(merges.findMergeByCell("A1048576") == 2000);
+        REQUIRE(merges.findMergeByCell("B4001") == XLMergeNotFound);
+        REQUIRE_THROWS_AS(merges.appendMerge("B3:B3000"), XLInputError);       // crosses many merges
+        REQUIRE_THROWS_AS(merges.appendMerge("XFC3999:XFD4001"), XLInputError); // overlaps the bottom right corner of a merge
+        REQUIRE_THROWS_AS(merges.appendMerge("B5999:XFD6002"), XLInputError);   // contains a merge
+        REQUIRE(merges.appendMerge("B8000:XFD8001") == 2002);
+
+        // ===== Deleting merges from the front shifts the indexes of all later merges
+        for (uint32_t index = 0; index < 1000; ++index) merges.deleteMerge(0);
+        REQUIRE(merges.count() == 1003);
+        REQUIRE(merges.findMergeByCell("B2") == XLMergeNotFound);
+        REQUIRE(merges.findMergeByCell("XFD2001") == 0);
+        REQUIRE(std::string(merges[0]) == "A2001:XFD2002");
+        REQUIRE(std::string(merges[999]) == "A3999:XFD4000");
+        REQUIRE(merges.findMergeByCell("A500000") == 1000);
+        REQUIRE(merges.findMerge("C6000:D6001") == 1001);
+        REQUIRE(merges.findMergeByCell("XFD8001") == 1002);
+        REQUIRE(merges.appendMerge("B1:XFD2000") == 1003);
+        doc.close();
+    }
+
+    SECTION("XLComments") {
+        XLDocument doc;
+        doc.create("./testXLSheet3.xlsx", XLForceOverwrite);
+        XLWorksheet wks      = doc.workbook().worksheet("Sheet1");
+        XLComments& comments = wks.comments();
+        comments.addAuthor("author");
+
+        comments.set("C3", "c3");
+        comments.set("A1", "a1");
+        comments.set("B2", "b2");
+        std::vector<XLCommentData> batch;
+        for (uint32_t row = 10; row > 4; --row) batch.push_back({ "B" + std::to_string(row), "batch" + std::to_string(row), 0 });
+        batch.push_back({ "A2", "a2", 0 });
+        batch.push_back({ "B2", "b2 replaced", 0 });
+        batch.push_back({ "A2", "a2 replaced", 0 });
+        comments.setMany(batch);
+
+        // ===== The comment list stays sorted by row, then column, and each cell has exactly one comment and one shape
+        REQUIRE(comments.count() == 10);
+        REQUIRE(comments.get(0).ref() == "A1");
+        REQUIRE(comments.get(1).ref() == "A2");
+        REQUIRE(comments.get(2).ref() == "B2");
+        REQUIRE(comments.get(3).ref() == "C3");
+        REQUIRE(comments.get(4).ref() == "B5");
+        REQUIRE(comments.get(9).ref() == "B10");
+        REQUIRE(comments.get("A2") == "a2 replaced");
+        REQUIRE(comments.get("B2") == "b2 replaced");
+        REQUIRE(comments.get("B7") == "batch7");
+        REQUIRE(comments.shape("B7").clientData().row() == 6);
+        REQUIRE(comments.shape("B2").clientData().column() == 1);
+
+        REQUIRE(comments.deleteComment("B2"));
+        REQUIRE_FALSE(comments.deleteComment("B2"));
+        REQUIRE(comments.get("B2") == "");
+        REQUIRE_THROWS_AS(comments.shape("B2"), XLException);
+        REQUIRE(comments.count() == 9);
+
+        doc.save();
+        doc.close();
+
+        doc.open("./testXLSheet3.xlsx");
+        XLWorksheet reopened = doc.workbook().worksheet("Sheet1");
+        REQUIRE(reopened.comments().count() == 9);
+        REQUIRE(reopened.vmlDrawing().shapeCount() == 9);
+        REQUIRE(reopened.comments().get("B10") == "batch10");
+        REQUIRE(reopened.comments().shape("C3").clientData().column() == 2);
+        doc.close();
+    }
+
+    SECTION("parallelForRows") {
+        XLDocument doc;
+        doc.create("./testXLSheet4.xlsx", XLForceOverwrite);
+        XLWorksheet wks = doc.workbook().worksheet("Sheet1");
+        for (int row = 1; row <= 3000; ++row) {
+            if (row % 100 == 0) continue;    // missing rows are skipped
+            wks.cell(row, 1).value() = row;
+            wks.cell(row, 3).value() = "R" + std::to_string(row % 7);
+            wks.cell(row, 4).value() = row % 2 == 0;
+        }
+
+        // ===== Read the band 101..2900 on 4 threads
+        std::atomic<int64_t> sum {0};
+        std::atomic<int>     rows {0};
+        std::atomic<int>     mismatches {0};
+        wks.parallelForRows(101, 2900, [&](XLRowView& row) {
+            ++rows;
+            sum += static_cast<int64_t>(row.cell(1).number());
+            if (not row.cell(2).empty() || row.cell(2).type() != XLValueType::Empty) ++mismatches;
+            if (std::string(row.cell(3).text()) != "R" + std::to_string(row.rowNumber() % 7)) ++mismatches;
+            if (row.cell(4).boolean() != (row.rowNumber() % 2 == 0) || row.cellCount() != 4) ++mismatches;
+            int cells = 0;
+            for (const auto& cell : row) cells += cell.column();
+            if (cells != 1 + 3 + 4) ++mismatches;
+        }, 4);
+        REQUIRE(rows == 2800 - 28);
+        REQUIRE(sum == (101 + 2900) * 2800 / 2 - (2 + 29) * 28 * 100 / 2);
+        REQUIRE(mismatches == 0);
+
+        // ===== Update the values of existing cells in place
+        wks.parallelForRows(1, 3000, [](XLRowView& row) {
+            row.cell(1).setValue(row.cell(1).number() * 2);
+            row.cell(4).setValue(XLCellValue(row.rowNumber() % 3 == 0));
+        }, 0, XLParallelMode::UpdateValues);
+        REQUIRE(wks.cell("A2999").value().get<int64_t>() == 5998);
+        REQUIRE(wks.cell("D2997").value().get<bool>());
+        REQUIRE(wks.cell("D2998").value().get<bool>() == false);
+        REQUIRE(wks.range("A1:A3000").sum() == Approx(2.0 * (3000 * 3001 / 2 - 100 * (30 * 31) / 2)));
+        REQUIRE(wks.rowCount() == 2999);    // row 3000 was not created
+
+        // ===== Cells are not inserted, strings and read-only views are refused, and worker exceptions reach the caller
+        REQUIRE_THROWS_AS(wks.parallelForRows(1, 10, [](XLRowView& row) { row.cell(2).setValue(XLCellValue(1)); }, 2, XLParallelMode::UpdateValues),
+                          XLException);
+        REQUIRE_THROWS_AS(wks.parallelForRows(1, 10, [](XLRowView& row) { row.cell(1).setValue(XLCellValue("text")); }, 2, XLParallelMode::UpdateValues),
+                          XLInputError);
+        REQUIRE_THROWS_AS(wks.parallelForRows(1, 10, [](XLRowView& row) { row.cell(1).setValue(XLCellValue(1)); }), XLException);
+        REQUIRE_THROWS_AS(wks.parallelForRows(1, 3000, [](XLRowView& row) { row.cell(3).number(); }), XLValueTypeError);
+        REQUIRE_THROWS_AS(wks.parallelForRows(10, 1, [](XLRowView&) {}), XLInputError);
+        REQUIRE(wks.findCell("B1").empty());
+
+        doc.close();
+    }
+}
@@ -0,0 +1,255 @@
+#include <OpenXLSX.hpp>
+#include <catch.hpp>
+
+using namespace OpenXLSX;
+
+TEST_CASE("XLStyles Tests", "[XLStyles]")
+{
+    SECTION("findOrCreate")
+    {
+        XLDocument doc;
+        doc.create("./testXLStyles.xlsx", XLForceOverwrite);
+        XLFonts&       fonts       = doc.styles().fonts();
+        XLFills&       fills       = doc.styles().fills();
+        XLBorders&     borders     = doc.styles().borders();
+        XLCellFormats& cellFormats = doc.styles().cellFormats();
+
+        // ===== An existing entry is found instead of being duplicated
+        size_t fontCount = fonts.count();
+        REQUIRE(fonts.findOrCreate(fonts[0]) == 0);
+        REQUIRE(fonts.count() == fontCount);
+        REQUIRE(fills.findOrCreate(fills[0]) == 0);
+        REQUIRE(borders.findOrCreate(borders[0]) == 0);
+        REQUIRE(cellFormats.findOrCreate(cellFormats[0]) == 0);
+
+        // ===== A modified entry is created once, and found thereafter
+        XLStyleIndex bold = fonts.findOrCreate(fonts[0], [](XLFont& font) { font.setBold(); });
+        REQUIRE(bold == fontCount);
+        REQUIRE(fonts.count() == fontCount + 1);
+        REQUIRE(fonts[bold].bold());
+        REQUIRE(fonts.findOrCreate(fonts[0], [](XLFont& font) { font.setBold(); }) == bold);
+        REQUIRE(fonts.count() == fontCount + 1);
+
+        size_t          formatCount = cellFormats.count();
+        XLStyleIndex    boldFormat  = cellFormats.findOrCreate(cellFormats[0], [&](XLCellFormat& fmt) { fmt.setFontIndex(bold); });
+        REQUIRE(boldFormat == formatCount);
+        for (int i = 0; i < 1000; ++i)
+            REQUIRE(cellFormats.findOrCreate(cellFormats[0], [&](XLCellFormat& fmt) { fmt.setFontIndex(bold); }) == boldFormat);
+        REQUIRE(cellFormats.count() == formatCount + 1);
+
+        // ===== Entries that are edited after being indexed are looked up by their new content
+        XLStyleIndex italic = fonts.create(fonts[0]);
+        REQUIRE(fonts.findOrCreate(fonts[0]) == 0);    // index the new (still identical) font
+        fonts[italic].setItalic();
+        REQUIRE(fonts.findOrCreate(fonts[0], [](XLFont& font) { font.setItalic(); }) == italic);
+        REQUIRE(fonts.findOrCreate(fonts[bold]) == bold);
+        REQUIRE(fonts.count() == fontCount + 2);
+
+        // ===== Edits through handles that were kept from before the last lookup are seen as well
+        XLFont       keptFont    = fonts[fonts.create(fonts[0])];
+        XLStyleIndex keptBorder  = borders.create(borders[0]);
+        XLBorder     border      = borders[keptBorder];
+        border.setLeft(XLLineStyleThin, XLColor("ff000000"));
+        XLLine       line        = border.left();
+        size_t       borderCount = borders.count();
+        REQUIRE(fonts.findOrCreate(fonts[0]) == 0);
+        REQUIRE(borders.findOrCreate(borders[0]) == 0);
+        keptFont.setStrikethrough();
+        line.color().setRgb(XLColor("ff112233"));    // through a sub-object of a kept handle
+        REQUIRE(fonts.findOrCreate(fonts[0]) == 0);
+        REQUIRE(fonts.findOrCreate(fonts[0], [](XLFont& font) { font.setStrikethrough(); }) == fontCount + 2);
+        REQUIRE(fonts.count() == fontCount + 3);
+        REQUIRE(borders.findOrCreate(borders[keptBorder]) == keptBorder);
+        REQUIRE(borders.count() == borderCount);
+
+        doc.save();
+        doc.close();
+    }
+
+    SECTION("compactStyles")
+    {
+        XLDocument doc;
+        doc.create("./testXLStyles.xlsx", XLForceOverwrite);
+        XLWorksheet        wks             = doc.workbook().worksheet("Sheet1");
+        XLFonts&           fonts           = doc.styles().fonts();
+        XLCellFormats&     cellFormats     = doc.styles().cellFormats();
+        XLDiffCellFormats& diffCellFormats = doc.styles().diffCellFormats();
+
+        size_t       fontCount   = fonts.count();
+        size_t       formatCount = cellFormats.count();
+        XLStyleIndex unusedFont  = fonts.findOrCreate(fonts[0], [](XLFont& font) { font.setItalic(); });
+        XLStyleIndex boldFont    = fonts.findOrCreate(fonts[0], [](XLFont& font) { font.setBold(); });
+        XLStyleIndex unused      = cellFormats.findOrCreate(cellFormats[0], [&](XLCellFormat& fmt) { fmt.setFontIndex(unusedFont); });
+        XLStyleIndex cellFormat  = cellFormats.findOrCreate(cellFormats[0], [&](XLCellFormat& fmt) { fmt.setFontIndex(boldFont); });
+        XLStyleIndex rowFormat   = cellFormats.findOrCreate(cellFormats[0], [&](XLCellFormat& fmt) { fmt.setApplyFont(true); });
+        XLStyleIndex colFormat   = cellFormats.findOrCreate(cellFormats[0], [&](XLCellFormat& fmt) { fmt.setApplyFill(true); });
+        REQUIRE(unused == formatCount);
+        diffCellFormats.create();
+        XLStyleIndex dxf = diffCellFormats.create();
+        diffCellFormats[dxf].font().setBold();
+
+        wks.cell("B2").setCellFormat(cellFormat);
+        wks.row(5).setFormat(rowFormat);
+        wks.column(4).setFormat(colFormat);
+        XLConditionalFormats cfs = wks.conditionalFormats();
+        XLConditionalFormat  cf  = cfs[cfs.create()];
+        cf.setSqref("A1:A10");
+        XLCfRules rules = cf.cfRules();
+        rules[rules.create()].setDxfId(dxf);
+
+        doc.compactStyles();
+
+        // ===== The unused cell format, the font only referenced by it and the unused differential format are dropped
+        REQUIRE(cellFormats.count() == formatCount + 3);
+        REQUIRE(fonts.count() == fontCount + 1);
+        REQUIRE(diffCellFormats.count() == 1);
+
+        // ===== All references have been renumbered
+        REQUIRE(wks.cell("B2").cellFormat() == cellFormat - 1);
+        REQUIRE(wks.row(5).format() == rowFormat - 1);
+        REQUIRE(wks.column(4).format() == colFormat - 1);
+        REQUIRE(wks.conditionalFormats()[0].cfRules()[0].dxfId() == 0);
+        REQUIRE(cellFormats[wks.cell("B2").cellFormat()].fontIndex() == boldFont - 1);
+        REQUIRE(fonts[boldFont - 1].bold());
+        REQUIRE(diffCellFormats[0].font().bold());
+
+        // ===== A second pass finds nothing to drop
+        doc.compactStyles();
+        REQUIRE(cellFormats.count() == formatCount + 3);
+        REQUIRE(wks.cell("B2").cellFormat() == cellFormat - 1);
+
+        doc.save();
+        doc.close();
+    }
+
+    SECTION("cellFormatTable")
+    {
+        XLDocument doc;
+        doc.create("./testXLStyles.xlsx", XLForceOverwrite);
+        XLStyles&              styles  = doc.styles();
+        XLCellFormatTable const& table = styles.cellFormatTable();
+        REQUIRE(table.size() == styles.cellFormats().count());
+
+        // ===== Created entries are appended, entries modified through a handle are re-decoded on the next call
+        XLStyleIndex numFmt = styles.numberFormats().create();
+        styles.numberFormats()[numFmt].setNumberFormatId(164);
+        styles.numberFormats()[numFmt].setFormatCode("yyyy-mm-dd");
+        XLStyleIndex fmt = styles.cellFormats().create(styles.cellFormats()[0]);
+        styles.cellFormats()[fmt].setNumberFormatId(164);
+        styles.cellFormats()[fmt].setFontIndex(0);
+        REQUIRE(&styles.cellFormatTable() == &table);
+        REQUIRE(table.size() == fmt + 1);
+        REQUIRE(table.numberFormatId[fmt] == 164);
+        REQUIRE(table.fontIndex[fmt] == 0);
+
+        XLCellFormat handle = styles.cellFormats()[fmt];
+        handle.setNumberFormatId(14);
+        REQUIRE(styles.cellFormatTable().numberFormatId[fmt] == 14);
+
+        XLNumberFormatTable const& numFmts = styles.numberFormatTable();
+        REQUIRE(numFmts.indexOf(164) == numFmt);
+        REQUIRE(numFmts.formatCode[numFmt] == "yyyy-mm-dd");
+        REQUIRE(numFmts.indexOf(165) == XLInvalidStyleIndex);
+        styles.numberFormats()[numFmt].setNumberFormatId(165);
+        REQUIRE(styles.numberFormatTable().indexOf(164) == XLInvalidStyleIndex);
+        REQUIRE(styles.numberFormatTable().indexOf(165) == numFmt);
+
+        // ===== Edits through handles that were kept from before the last refresh are decoded as well
+        XLCellFormat   keptFormat = styles.cellFormats()[fmt];
+        XLNumberFormat keptNumFmt = styles.numberFormats()[numFmt];
+        REQUIRE(styles.cellFormatTable().fontIndex[fmt] == 0);
+        REQUIRE(styles.numberFormatTable().formatCode[numFmt] == "yyyy-mm-dd");
+        keptFormat.setFontIndex(1);
+        keptFormat.setNumberFormatId(165);
+        keptNumFmt.setFormatCode("hh:mm");
+        REQUIRE(table.fontIndex[fmt] == 0);    // only updated on the next call
+        REQUIRE(styles.cellFormatTable().fontIndex[fmt] == 1);
+        REQUIRE(styles.cellFormatTable().numberFormatId[fmt] == 165);
+        REQUIRE(styles.numberFormatTable().formatCode[numFmt] == "hh:mm");
+        REQUIRE(styles.cellFormatType(fmt) == XLNumberFormatType::Time);
+
+        doc.close();
+    }
+
+    SECTION("cellFormatType")
+    {
+        XLDocument doc;
+        doc.create("./testXLStyles.xlsx", XLForceOverwrite);
+        XLStyles&        styles      = doc.styles();
+        XLNumberFormats& numFmts     = styles.numberFormats();
+        XLCellFormats&   cellFormats = styles.cellFormats();
+        XLWorksheet      wks         = doc.workbook().worksheet("Sheet1");
+
+        auto formatWithCode = [&](uint32_t id, std::string const& code) {
+            XLStyleIndex numFmt = numFmts.create();
+            numFmts[numFmt].setNumberFormatId(id);
+            numFmts[numFmt].setFormatCode(code);
+            XLStyleIndex fmt = cellFormats.create(cellFormats[0]);
+            cellFormats[fmt].setNumberFormatId(id);
+            return fmt;
+        };
+        auto formatWithId = [&](uint32_t id) {
+            XLStyleIndex fmt = cellFormats.create(cellFormats[0]);
+            cellFormats[fmt].setNumberFormatId(id);
+            return fmt;
+        };
+
+        // ===== Built-in formats
+        REQUIRE(styles.cellFormatType(0)                 == XLNumberFormatType::General);
+        REQUIRE(styles.cellFormatType(formatWithId(2))   == XLNumberFormatType::Number);
+        REQUIRE(styles.cellFormatType(formatWithId(10))  == XLNumberFormatType::Percent);
+        REQUIRE(styles.cellFormatType(formatWithId(14))  == XLNumberFormatType::Date);
+        REQUIRE(styles.cellFormatType(formatWithId(21))  == XLNumberFormatType::Time);
+        REQUIRE(styles.cellFormatType(formatWithId(22))  == XLNumberFormatType::DateTime);
+        REQUIRE(styles.cellFormatType(formatWithId(49))  == XLNumberFormatType::Text);
+        REQUIRE(styles.cellFormatType(cellFormats.count()) == XLNumberFormatType::General);
+
+        // ===== Custom format codes
+        REQUIRE(styles.cellFormatType(formatWithCode(164, "yyyy-mm-dd"))                 == XLNumberFormatType::Date);
+        REQUIRE(styles.cellFormatType(formatWithCode(165, "[$-409]d-mmm;@"))             == XLNumberFormatType::Date);
+        REQUIRE(styles.cellFormatType(formatWithCode(166, "hh:mm:ss AM/PM"))             == XLNumberFormatType::Time);
+        REQUIRE(styles.cellFormatType(formatWithCode(167, "[h]:mm"))                     == XLNumberFormatType::Time);
+        REQUIRE(styles.cellFormatType(formatWithCode(168, "mm:ss.0"))                    == XLNumberFormatType::Time);
+        REQUIRE(styles.cellFormatType(formatWithCode(169, "dd/mm/yyyy hh:mm"))           == XLNumberFormatType::DateTime);
+        REQUIRE(styles.cellFormatType(formatWithCode(170, "0.00%"))                      == XLNumberFormatType::Percent);
+        REQUIRE(styles.cellFormatType(formatWithCode(171, "0.00E+00"))                   == XLNumberFormatType::Number);
+        REQUIRE(styles.cellFormatType(formatWithCode(172, "[Red]#,##0.00\\ \"days\""))  == XLNumberFormatType::Number);
+        REQUIRE(styles.cellFormatType(formatWithCode(173, "@"))                          == XLNumberFormatType::Text);
+        REQUIRE(styles.cellFormatType(formatWithCode(174, "General"))                    == XLNumberFormatType::General);
+        REQUIRE(styles.cellFormatType(formatWithCode(176, "[Magenta]0.00"))              == XLNumberFormatType::Number);
+        REQUIRE(styles.cellFormatType(formatWithCode(177, "[mm]:ss"))                    == XLNumberFormatType::Time);
+        REQUIRE(styles.cellFormatType(formatWithCode(178, "[>=100][Magenta]0"))          == XLNumberFormatType::Number);
+
+        // ===== Re-classification after a number format is edited
+        XLStyleIndex fmt = formatWithCode(175, "0.0");
+        REQUIRE(styles.cellFormatType(fmt) == XLNumberFormatType::Number);
+        numFmts[numFmts.count() - 1].setFormatCode("yyyy");
+        REQUIRE(styles.cellFormatType(fmt) == XLNumberFormatType::Date);
+
+        // ===== Typed date reads from cells
+        XLStyleIndex dateFormat = formatWithId(14);
+        wks.cell("A1").value() = 45000.0;
+        wks.cell("A1").setCellFormat(dateFormat);
+        wks.cell("A2").value() = 45000.0;
+        wks.cell("A3").value() = "text";
+        wks.cell("A3").setCellFormat(dateFormat);
+        REQUIRE(wks.cell("A1").isDateTime(styles));
+        REQUIRE(wks.cell("A1").dateTimeValue(styles).serial() == Approx(45000.0));
+        REQUIRE_FALSE(wks.cell("A2").isDateTime(styles));
+        REQUIRE_FALSE(wks.cell("A3").isDateTime(styles));
+        REQUIRE_THROWS_AS(wks.cell("A3").dateTimeValue(styles), XLValueTypeError);
+
+        // ===== A time of day without date (h:mm) is read on day 1
+        wks.cell("A4").value() = 0.5;
+        wks.cell("A4").setCellFormat(formatWithId(20));
+        REQUIRE(wks.cell("A4").isDateTime(styles));
+        REQUIRE(wks.cell("A4").dateTimeValue(styles).serial() == Approx(1.5));
+        REQUIRE(wks.cell("A4").dateTimeValue(styles).tm().tm_hour == 12);
+        REQUIRE(wks.cell("A4").dateTimeValue(styles).tm().tm_min == 0);
+        wks.cell("A5").value() = 0.5;
+        wks.cell("A5").setCellFormat(dateFormat);
+        REQUIRE_THROWS_AS(wks.cell("A5").dateTimeValue(styles), XLDateTimeError);
+
+        doc.close();
+    }
+}